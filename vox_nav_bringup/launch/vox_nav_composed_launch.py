@@ -0,0 +1,76 @@
+# Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Runs the map server, planner server, controller server and the perception
+# nodes as components of one multi threaded container. The nodes enable
+# intra-process communication on the large topics themselves (map cloud,
+# traversable cloud, detections), so inside the container those are handed
+# over without being serialized. It is not enabled container wide, the other
+# topics use QoS profiles intra-process communication does not support.
+# Nodes outside the container, e.g. rviz, still get every topic through DDS.
+
+from launch import LaunchDescription
+from launch.actions import DeclareLaunchArgument
+from launch.substitutions import LaunchConfiguration
+from launch_ros.actions import ComposableNodeContainer
+from launch_ros.descriptions import ComposableNode
+
+
+def generate_launch_description():
+    params = LaunchConfiguration('params')
+    container_name = LaunchConfiguration('container_name')
+
+    declare_params = DeclareLaunchArgument(
+        'params',
+        description='Parameter file of the navigation stack, the same one the separate executables use')
+    declare_container_name = DeclareLaunchArgument(
+        'container_name', default_value='vox_nav_container',
+        description='Name of the component container')
+
+    def component(package, plugin, name):
+        return ComposableNode(
+            package=package,
+            plugin=plugin,
+            name=name,
+            parameters=[params])
+
+    container = ComposableNodeContainer(
+        name=container_name,
+        namespace='',
+        package='rclcpp_components',
+        # The planner server blocks one callback group while planning
+        executable='component_container_mt',
+        output='screen',
+        composable_node_descriptions=[
+            component('vox_nav_map_server', 'vox_nav_map_server::MapManager',
+                      'vox_nav_map_manager_rclcpp_node'),
+            component('vox_nav_planning', 'vox_nav_planning::PlannerServer',
+                      'vox_nav_planning_server_rclcpp_node'),
+            component('vox_nav_control', 'vox_nav_control::ControllerServer',
+                      'vox_nav_controller_server_rclcpp_node'),
+            component('vox_nav_misc', 'vox_nav_misc::TraversabilityEstimator',
+                      'traversability_estimator_rclcpp_node'),
+            component('vox_nav_misc', 'vox_nav_misc::NaiveLIDARClustering',
+                      'cloud_clustering_rclcpp_node'),
+            component('vox_nav_misc', 'vox_nav_misc::UKFTracker',
+                      'ukf_tracking_rclcpp_node'),
+            component('vox_nav_misc', 'vox_nav_misc::PCLCPUNDT',
+                      'pcl_cpu_ndt_rclcpp_node'),
+        ])
+
+    return LaunchDescription([
+        declare_params,
+        declare_container_name,
+        container,
+    ])
@@ -39,7 +39,9 @@
 #include "vox_nav_utilities/pcl_helpers.hpp"
 #include "vox_nav_utilities/planner_helpers.hpp"
 
+#include <atomic>
 #include <chrono>
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
@@ -125,7 +127,7 @@ namespace vox_nav_control
      * @brief Construct a new Controller Server object
      *
      */
-    ControllerServer();
+    explicit ControllerServer(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
 
     /**
      * @brief Destroy the Controller Server object
@@ -162,8 +164,12 @@ namespace vox_nav_control
 
     /**
      * @brief The action server callback which computes control effort
+     *
+     * @param goal_handle
+     * @param goal_generation value of goal_generation_ when the goal was accepted,
+     * the goal is preempted as soon as a newer goal is accepted
      */
-    void followPath(const std::shared_ptr<GoalHandleFollowPath> goal_handle);
+    void followPath(const std::shared_ptr<GoalHandleFollowPath> goal_handle, std::uint64_t goal_generation);
 
     /**
     * @brief A dedicated thread to run MQTT.
@@ -224,6 +230,10 @@ namespace vox_nav_control
     // Mutex for global path
     std::mutex global_path_mutex_;
 
+    // Incremented for every accepted goal, a goal loop whose generation is
+    // behind it has been preempted and hands the robot over without stopping it
+    std::atomic<std::uint64_t> goal_generation_{0};
+
   };
 
 }  // namespace vox_nav_control
@@ -119,6 +119,8 @@ private:
   rclcpp::Publisher<vision_msgs::msg::Detection3D>::SharedPtr traversability_map_bbox_publisher_;
   // Keep a copy of the traversability map, it is used by /link vox_nav_utilities::getTraversabilityMap
   sensor_msgs::msg::PointCloud2::SharedPtr traversability_map_;
+  // The same map in the odom frame, converted once when it arrives rather than on every refinePlan
+  pcl::PointCloud<pcl::PointXYZRGBA>::Ptr traversability_map_pcl_;
 
   // For transforming traversability map to the "map" frame
   std::shared_ptr<tf2_ros::Buffer> tf_buffer_ptr_;
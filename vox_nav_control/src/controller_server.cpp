@@ -16,6 +16,7 @@
 
 #include "builtin_interfaces/msg/duration.hpp"
 #include "vox_nav_control/controller_server.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 #include <chrono>
 #include <cmath>
@@ -29,8 +30,8 @@
 
 namespace vox_nav_control
 {
-ControllerServer::ControllerServer()
-  : Node("vox_nav_controller_server_rclcpp_node")
+ControllerServer::ControllerServer(const rclcpp::NodeOptions& options)
+  : Node("vox_nav_controller_server_rclcpp_node", options)
   , pc_loader_("vox_nav_control", "vox_nav_control::ControllerCore")
   , controller_id_("MPCControllerCasadiROS")
   , controller_type_("mpc_controller::MPCControllerCasadiROS")
@@ -242,12 +243,19 @@ rclcpp_action::CancelResponse ControllerServer::handle_cancel(const std::shared_
 
 void ControllerServer::handle_accepted(const std::shared_ptr<GoalHandleFollowPath> goal_handle)
 {
+  // A new goal preempts the one being followed, its loop takes over the robot
+  // without the velocity being reset in between
+  std::uint64_t goal_generation = ++goal_generation_;
   // this needs to return quickly to avoid blocking the executor, so spin up a new thread
-  std::thread{ std::bind(&ControllerServer::followPath, this, std::placeholders::_1), goal_handle }.detach();
+  std::thread{ std::bind(&ControllerServer::followPath, this, std::placeholders::_1, std::placeholders::_2),
+               goal_handle, goal_generation }
+      .detach();
 }
 
-void ControllerServer::followPath(const std::shared_ptr<GoalHandleFollowPath> goal_handle)
+void ControllerServer::followPath(const std::shared_ptr<GoalHandleFollowPath> goal_handle,
+                                  std::uint64_t goal_generation)
 {
+  VOX_NAV_TRACE_FUNCTION("control");
   auto start_time = steady_clock_.now();
   rclcpp::Rate loop_rate(controller_frequency_);
 
@@ -269,19 +277,24 @@ void ControllerServer::followPath(const std::shared_ptr<GoalHandleFollowPath> go
   }
   geometry_msgs::msg::PoseStamped initial_robot_pose;
   vox_nav_utilities::getCurrentPose(initial_robot_pose, *tf_buffer_, "odom", "base_link", transform_timeout_);
-  global_path_ = std::make_shared<nav_msgs::msg::Path>();
-  global_path_->header = goal->path.header;
-  initial_robot_pose.pose.position.z = goal->path.poses.front().pose.position.z;
-  global_path_->poses.push_back(initial_robot_pose);
-
-  for (auto&& i : goal->path.poses)
   {
-    global_path_->poses.push_back(i);
+    // A preempted goal may still be in its loop
+    std::lock_guard<std::mutex> guard(global_path_mutex_);
+    global_path_ = std::make_shared<nav_msgs::msg::Path>();
+    global_path_->header = goal->path.header;
+    initial_robot_pose.pose.position.z = goal->path.poses.front().pose.position.z;
+    global_path_->poses.push_back(initial_robot_pose);
+
+    for (auto&& i : goal->path.poses)
+    {
+      global_path_->poses.push_back(i);
+    }
+
+    // set Plan
+    controller_->setPlan(*global_path_);
   }
 
   geometry_msgs::msg::Twist computed_velocity_commands;
-  // set Plan
-  controller_->setPlan(*global_path_);
 
   rclcpp::WallRate rate(controller_frequency_);
 
@@ -298,6 +311,13 @@ void ControllerServer::followPath(const std::shared_ptr<GoalHandleFollowPath> go
     auto& clock = *this->get_clock();
 
     auto loop_start_time = steady_clock_.now();
+    // Check if a newer goal took over, the robot keeps moving on its path
+    if (goal_generation != goal_generation_)
+    {
+      goal_handle->abort(result);
+      RCLCPP_INFO(get_logger(), "Goal was preempted by a newer goal.");
+      return;
+    }
     // Check if there is a cancel request
     if (goal_handle->is_canceling())
     {
@@ -339,6 +359,12 @@ void ControllerServer::followPath(const std::shared_ptr<GoalHandleFollowPath> go
 
       while (rclcpp::ok() && !is_goal_orientation_tolerance_satisfied)
       {
+        if (goal_generation != goal_generation_)
+        {
+          goal_handle->abort(result);
+          RCLCPP_INFO(get_logger(), "Goal was preempted by a newer goal.");
+          return;
+        }
         if (goal_handle->is_canceling())
         {
           RCLCPP_INFO(get_logger(), "Goal was canceled. Canceling planning action.");
@@ -372,7 +398,10 @@ void ControllerServer::followPath(const std::shared_ptr<GoalHandleFollowPath> go
     }
 
     auto control_cycle_start_time = steady_clock_.now();
-    computed_velocity_commands = controller_->computeVelocityCommands(curr_robot_pose);
+    {
+      VOX_NAV_TRACE_SCOPE("computeVelocityCommands", "control");
+      computed_velocity_commands = controller_->computeVelocityCommands(curr_robot_pose);
+    }
     auto control_cycle_duration = steady_clock_.now() - control_cycle_start_time;
 
     average_time_taken_by_controller_loop += control_cycle_duration.seconds();
@@ -407,18 +436,15 @@ void ControllerServer::followPath(const std::shared_ptr<GoalHandleFollowPath> go
     cycle_duration = steady_clock_.now() - start_time;
     result->total_time = cycle_duration;
     goal_handle->succeed(result);
-    cmd_vel_publisher_->publish(geometry_msgs::msg::Twist());
+    if (goal_generation == goal_generation_)
+    {
+      cmd_vel_publisher_->publish(geometry_msgs::msg::Twist());
+    }
     RCLCPP_INFO(this->get_logger(), "Follow Path Succeeded!");
   }
 }
 
 }  // namespace vox_nav_control
 
-int main(int argc, char** argv)
-{
-  rclcpp::init(argc, argv);
-  auto node = std::make_shared<vox_nav_control::ControllerServer>();
-  rclcpp::spin(node->get_node_base_interface());
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_control::ControllerServer)
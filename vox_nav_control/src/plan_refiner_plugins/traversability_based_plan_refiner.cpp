@@ -37,9 +37,12 @@ void TraversabilityBasedPlanRefiner::initialize(rclcpp::Node* parent, const std:
   tf_listener_ptr_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_ptr_);
 
   // Bind to traversability map and marker topics
+  rclcpp::SubscriptionOptions intra_process_options;
+  intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   traversability_map_subscriber_ = node_->create_subscription<sensor_msgs::msg::PointCloud2>(
       "traversable_cloud", rclcpp::SensorDataQoS(),
-      std::bind(&TraversabilityBasedPlanRefiner::traversabilityMapCallback, this, std::placeholders::_1));
+      std::bind(&TraversabilityBasedPlanRefiner::traversabilityMapCallback, this, std::placeholders::_1),
+      intra_process_options);
 
   local_goal_publisher_ =
       node_->create_publisher<geometry_msgs::msg::PoseStamped>("local_goal", rclcpp::SensorDataQoS());
@@ -80,23 +83,19 @@ void TraversabilityBasedPlanRefiner::initialize(rclcpp::Node* parent, const std:
 bool TraversabilityBasedPlanRefiner::refinePlan(const geometry_msgs::msg::PoseStamped& curr_pose,
                                                 nav_msgs::msg::Path& plan_to_refine)
 {
-  if (traversability_map_->data.empty())
+  std::lock_guard<std::mutex> guard(global_mutex_);
+  if (!traversability_map_pcl_ || traversability_map_pcl_->points.empty())
   {
     RCLCPP_WARN(node_->get_logger(), "Traversability map is empty, cannot refine plan");
     return false;
   }
 
-  // Convert most recent traversability map to pcl pointcloud
-  std::lock_guard<std::mutex> guard(global_mutex_);
-  pcl::PointCloud<pcl::PointXYZ>::Ptr traversability_map_pcl(new pcl::PointCloud<pcl::PointXYZ>);
-  pcl::fromROSMsg(*traversability_map_, *traversability_map_pcl);
-
   // Fit a box around the traversability map
   vox_nav_msgs::msg::Object traversability_map_box;
   // vox_nav_utilities::fitBoxtoPointCloud(traversability_map_pcl, traversability_map_box);
   //  get min and max values of the traversability map
-  pcl::PointXYZ min_pt, max_pt;
-  pcl::getMinMax3D(*traversability_map_pcl, min_pt, max_pt);
+  pcl::PointXYZRGBA min_pt, max_pt;
+  pcl::getMinMax3D(*traversability_map_pcl_, min_pt, max_pt);
   // get the center of the traversability map
   geometry_msgs::msg::Point center;
   center.x = (min_pt.x + max_pt.x) / 2.0;
@@ -307,6 +306,7 @@ void TraversabilityBasedPlanRefiner::traversabilityMapCallback(const sensor_msgs
 {
   std::lock_guard<std::mutex> guard(global_mutex_);
   traversability_map_ = msg;
+  traversability_map_pcl_.reset();
 
   // Transform the traversability map to the map frame
   geometry_msgs::msg::TransformStamped map_to_traversability_map_transform;
@@ -324,6 +324,7 @@ void TraversabilityBasedPlanRefiner::traversabilityMapCallback(const sensor_msgs
 
   pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud_xyzrgba(new pcl::PointCloud<pcl::PointXYZRGBA>);
   pcl::fromROSMsg(*traversability_map_, *cloud_xyzrgba);
+  traversability_map_pcl_ = cloud_xyzrgba;
 
   // remove non-traversable points
   auto pure_traversable_pcl = vox_nav_utilities::get_traversable_points(cloud_xyzrgba);
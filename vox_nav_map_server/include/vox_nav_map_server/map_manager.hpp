@@ -35,6 +35,7 @@
 #include <robot_localization/srv/from_ll.hpp>
 #include <vox_nav_msgs/msg/oriented_nav_sat_fix.hpp>
 #include <vox_nav_msgs/srv/get_traversability_map.hpp>
+#include <vox_nav_utilities/geodetic_conversions.hpp>
 #include <vox_nav_utilities/pcl_helpers.hpp>
 #include <vox_nav_utilities/tf_helpers.hpp>
 #include <vox_nav_utilities/map_manager_helpers.hpp>
@@ -125,7 +126,7 @@ namespace vox_nav_map_server
      * @brief Construct a new Map Manager object
      *
      */
-    MapManager();
+    explicit MapManager(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
     /**
      * @brief Destroy the Map Manager object
@@ -148,6 +149,15 @@ namespace vox_nav_map_server
      */
     void transfromPCDfromGPS2Map();
 
+    /**
+     * @brief One /fromLL call, used for the datum when there is no utm -> map transform
+     *
+     * @param geo
+     * @param map_point
+     * @return true if the service answered
+     */
+    bool fromLLToMapPoint(const vox_nav_utilities::GeoPoint & geo, Eigen::Vector3d & map_point);
+
     /**
      * @brief Given preprocessed and cost regressed point cloud of PCD Map
      * this methed, constructs an octomap from this point cloud.
@@ -215,7 +225,8 @@ namespace vox_nav_map_server
     rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr
       elevated_surfel_octomap_markers_publisher_;
     // robot_localization package provides a service to convert
-    // lat,long,al GPS cooordinates to x,y,z map points
+    // lat,long,al GPS cooordinates to x,y,z map points, only used for the datum
+    // when the utm -> map transform is not broadcast
     rclcpp::Client<robot_localization::srv::FromLL>::SharedPtr robot_localization_fromLL_client_;
     // clint node used for spinning the service callback of robot_localization_fromLL_client_
     rclcpp::Node::SharedPtr robot_localization_fromLL_client_node_;
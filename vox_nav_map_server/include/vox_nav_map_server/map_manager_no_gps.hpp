@@ -128,7 +128,7 @@ public:
    * @brief Construct a new Map Manager object
    *
    */
-  MapManagerNoGPS();
+  explicit MapManagerNoGPS(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
 
   /**
    * @brief Destroy the Map Manager object
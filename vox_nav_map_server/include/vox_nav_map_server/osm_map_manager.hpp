@@ -90,7 +90,7 @@ namespace vox_nav_map_server
      * @brief Construct a new Map Manager object
      *
      */
-    OSMMapManager();
+    explicit OSMMapManager(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
     /**
      * @brief Destroy the Map Manager object
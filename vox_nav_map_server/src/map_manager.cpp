@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "vox_nav_map_server/map_manager.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 #include <string>
 #include <vector>
@@ -21,8 +22,8 @@
 
 namespace vox_nav_map_server
 {
-  MapManager::MapManager()
-  : Node("vox_nav_map_manager_rclcpp_node"),
+  MapManager::MapManager(const rclcpp::NodeOptions & options)
+  : Node("vox_nav_map_manager_rclcpp_node", options),
     map_configured_(false)
   {
     RCLCPP_INFO(this->get_logger(), "Creating..");
@@ -141,7 +142,8 @@ namespace vox_nav_map_server
         std::placeholders::_2,
         std::placeholders::_3));
 
-    // service hooks for robot localization fromll service
+    // service hooks for robot localization fromll service, the datum falls back to it when
+    // navsat_transform does not broadcast its utm frame
     robot_localization_fromLL_client_node_ = std::make_shared
       <rclcpp::Node>("map_manager_fromll_client_node");
 
@@ -154,8 +156,13 @@ namespace vox_nav_map_server
       std::chrono::milliseconds(static_cast<int>(1000 / octomap_publish_frequency_)),
       std::bind(&MapManager::timerCallback, this));
 
+    // Localization nodes composed into the same container take the map cloud intra-process,
+    // which needs an explicit keep last, volatile QoS
+    rclcpp::PublisherOptions intra_process_options;
+    intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
     octomap_pointloud_publisher_ = this->create_publisher<sensor_msgs::msg::PointCloud2>(
-      octomap_point_cloud_publish_topic_, rclcpp::SystemDefaultsQoS());
+      octomap_point_cloud_publish_topic_, rclcpp::QoS(rclcpp::KeepLast(1)).reliable(),
+      intra_process_options);
 
     elevated_surfel_pcl_publisher_ = this->create_publisher<sensor_msgs::msg::PointCloud2>(
       "vox_nav/map_server/elevated_surfel_pointcloud", rclcpp::SystemDefaultsQoS());
@@ -191,12 +198,17 @@ namespace vox_nav_map_server
     std::call_once(
       align_static_map_once_, [this]()
       {
-        while (!tf_buffer_->canTransform(utm_frame_id_, map_frame_id_, rclcpp::Time(0))) {
+        // navsat_transform only broadcasts its utm frame when told to, after a few seconds
+        // without it the datum is converted with /fromLL instead
+        for (int attempt = 0;
+          attempt < 10 && rclcpp::ok() &&
+          !tf_buffer_->canTransform(utm_frame_id_, map_frame_id_, rclcpp::Time(0));
+          attempt++)
+        {
           std::this_thread::sleep_for(std::chrono::milliseconds(500));
           RCLCPP_INFO(
             this->get_logger(), "Waiting for %s to %s Transform to be available.",
             utm_frame_id_.c_str(), map_frame_id_.c_str());
-
         }
         RCLCPP_INFO(
           get_logger(), "Configuring pcd map with given parameters,"
@@ -216,41 +228,39 @@ namespace vox_nav_map_server
 
   void MapManager::transfromPCDfromGPS2Map()
   {
-    auto request = std::make_shared<robot_localization::srv::FromLL::Request>();
-    auto response = std::make_shared<robot_localization::srv::FromLL::Response>();
-    request->ll_point.latitude = pcd_map_gps_pose_->position.latitude;
-    request->ll_point.longitude = pcd_map_gps_pose_->position.longitude;
-    request->ll_point.altitude = pcd_map_gps_pose_->position.altitude;
-
-    while (!robot_localization_fromLL_client_->wait_for_service(std::chrono::seconds(1))) {
-      if (!rclcpp::ok()) {
-        RCLCPP_ERROR(
-          this->get_logger(),
-          "Interrupted while waiting for the /fromLL service.Exiting");
+    // navsat_transform maps a gps coordinate to the map frame through its utm frame, the datum
+    // is converted in process with the same utm -> map transform instead of a /fromLL round trip
+    vox_nav_utilities::GeoPoint datum;
+    datum.latitude = pcd_map_gps_pose_->position.latitude;
+    datum.longitude = pcd_map_gps_pose_->position.longitude;
+    datum.altitude = pcd_map_gps_pose_->position.altitude;
+    Eigen::Vector3d datum_in_map;
+    try {
+      geometry_msgs::msg::TransformStamped utm_to_map =
+        tf_buffer_->lookupTransform(map_frame_id_, utm_frame_id_, rclcpp::Time(0));
+      vox_nav_utilities::GeodeticConverter geodetic_converter;
+      geodetic_converter.setUTMToMap(
+        vox_nav_utilities::utmZone(datum.latitude, datum.longitude),
+        datum.latitude >= 0.0,
+        tf2::transformToEigen(utm_to_map));
+      datum_in_map = geodetic_converter.geoToMap(datum);
+    } catch (tf2::TransformException & ex) {
+      RCLCPP_WARN(
+        this->get_logger(),
+        "Could not get %s to %s transform: %s, converting the datum with /fromLL",
+        utm_frame_id_.c_str(), map_frame_id_.c_str(), ex.what());
+      if (!fromLLToMapPoint(datum, datum_in_map)) {
         return;
       }
-      RCLCPP_INFO(
-        this->get_logger(), "/fromLL service not available, waiting and trying again");
     }
 
-    auto result_future = robot_localization_fromLL_client_->async_send_request(request);
-    if (rclcpp::spin_until_future_complete(
-        robot_localization_fromLL_client_node_,
-        result_future) !=
-      rclcpp::FutureReturnCode::SUCCESS)
-    {
-      RCLCPP_ERROR(this->get_logger(), "/fromLL service call failed");
-    }
-    auto result = result_future.get();
-    response->map_point = result->map_point;
-
     // The translation from static_map origin to map is basically inverse of this transform
     tf2::Transform static_map_to_map_transfrom;
     static_map_to_map_transfrom.setOrigin(
       tf2::Vector3(
-        response->map_point.x,
-        response->map_point.y,
-        response->map_point.z));
+        datum_in_map.x(),
+        datum_in_map.y(),
+        datum_in_map.z()));
 
     tf2::Quaternion static_map_quaternion;
     tf2::fromMsg(pcd_map_gps_pose_->orientation, static_map_quaternion);
@@ -262,9 +272,9 @@ namespace vox_nav_map_server
     stamped.header.stamp = this->get_clock()->now();
     stamped.transform.rotation = pcd_map_gps_pose_->orientation;
     geometry_msgs::msg::Vector3 translation;
-    translation.x = response->map_point.x;
-    translation.y = response->map_point.y;
-    translation.z = response->map_point.z;
+    translation.x = datum_in_map.x();
+    translation.y = datum_in_map.y();
+    translation.z = datum_in_map.z();
     stamped.transform.translation = translation;
     static_transform_broadcaster_->sendTransform(stamped);
 
@@ -273,6 +283,40 @@ namespace vox_nav_map_server
     );
   }
 
+  bool MapManager::fromLLToMapPoint(
+    const vox_nav_utilities::GeoPoint & geo,
+    Eigen::Vector3d & map_point)
+  {
+    auto request = std::make_shared<robot_localization::srv::FromLL::Request>();
+    request->ll_point.latitude = geo.latitude;
+    request->ll_point.longitude = geo.longitude;
+    request->ll_point.altitude = geo.altitude;
+
+    while (!robot_localization_fromLL_client_->wait_for_service(std::chrono::seconds(1))) {
+      if (!rclcpp::ok()) {
+        RCLCPP_ERROR(
+          this->get_logger(),
+          "Interrupted while waiting for the /fromLL service.Exiting");
+        return false;
+      }
+      RCLCPP_INFO(
+        this->get_logger(), "/fromLL service not available, waiting and trying again");
+    }
+
+    auto result_future = robot_localization_fromLL_client_->async_send_request(request);
+    if (rclcpp::spin_until_future_complete(
+        robot_localization_fromLL_client_node_,
+        result_future) !=
+      rclcpp::FutureReturnCode::SUCCESS)
+    {
+      RCLCPP_ERROR(this->get_logger(), "/fromLL service call failed");
+      return false;
+    }
+    auto result = result_future.get();
+    map_point = Eigen::Vector3d(result->map_point.x, result->map_point.y, result->map_point.z);
+    return true;
+  }
+
   void MapManager::preProcessPCDMap()
   {
     if (preprocess_params_.pcd_map_downsample_voxel_size > 0.0) {
@@ -331,6 +375,7 @@ namespace vox_nav_map_server
 
   void MapManager::regressCosts()
   {
+    VOX_NAV_TRACE_FUNCTION("map_server");
     // seperate traversble points from non-traversable ones
     auto pure_traversable_pcl = vox_nav_utilities::get_traversable_points(pcd_map_pointcloud_);
     auto pure_non_traversable_pcl = vox_nav_utilities::get_non_traversable_points(
@@ -632,19 +677,5 @@ namespace vox_nav_map_server
   }
 }   // namespace vox_nav_map_server
 
-/**
- * @brief
- *
- * @param argc
- * @param argv
- * @return int
- */
-int main(int argc, char const * argv[])
-{
-  rclcpp::init(argc, argv);
-  auto map_manager_node = std::make_shared
-    <vox_nav_map_server::MapManager>();
-  rclcpp::spin(map_manager_node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_map_server::MapManager)
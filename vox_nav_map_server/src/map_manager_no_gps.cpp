@@ -13,6 +13,7 @@
 // limitations under the License.
 
 #include "vox_nav_map_server/map_manager_no_gps.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 #include <string>
 #include <vector>
@@ -21,7 +22,8 @@
 
 namespace vox_nav_map_server
 {
-MapManagerNoGPS::MapManagerNoGPS() : Node("vox_nav_map_manager_no_gps_rclcpp_node"), map_configured_(false)
+MapManagerNoGPS::MapManagerNoGPS(const rclcpp::NodeOptions& options)
+  : Node("vox_nav_map_manager_no_gps_rclcpp_node", options), map_configured_(false)
 {
   RCLCPP_INFO(this->get_logger(), "Creating..");
   // initialize shared pointers asap
@@ -114,8 +116,10 @@ MapManagerNoGPS::MapManagerNoGPS() : Node("vox_nav_map_manager_no_gps_rclcpp_nod
   timer_ = this->create_wall_timer(std::chrono::milliseconds(static_cast<int>(1000 / octomap_publish_frequency_)),
                                    std::bind(&MapManagerNoGPS::timerCallback, this));
 
+  rclcpp::PublisherOptions intra_process_options;
+  intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   octomap_pointloud_publisher_ = this->create_publisher<sensor_msgs::msg::PointCloud2>(
-      octomap_point_cloud_publish_topic_, rclcpp::SystemDefaultsQoS());
+      octomap_point_cloud_publish_topic_, rclcpp::QoS(rclcpp::KeepLast(1)).reliable(), intra_process_options);
 
   elevated_surfel_pcl_publisher_ = this->create_publisher<sensor_msgs::msg::PointCloud2>(
       "vox_nav/map_server/elevated_surfel_pointcloud", rclcpp::SystemDefaultsQoS());
@@ -214,6 +218,7 @@ void MapManagerNoGPS::preProcessPCDMap()
 
 void MapManagerNoGPS::regressCosts()
 {
+  VOX_NAV_TRACE_FUNCTION("map_server");
   // seperate traversble points from non-traversable ones
   auto pure_traversable_pcl = vox_nav_utilities::get_traversable_points(pcd_map_pointcloud_);
   auto pure_non_traversable_pcl = vox_nav_utilities::get_non_traversable_points(pcd_map_pointcloud_);
@@ -491,18 +496,5 @@ void MapManagerNoGPS::getGetTraversabilityMapCallback(
 }
 }  // namespace vox_nav_map_server
 
-/**
- * @brief
- *
- * @param argc
- * @param argv
- * @return int
- */
-int main(int argc, char const* argv[])
-{
-  rclcpp::init(argc, argv);
-  auto map_manager_node = std::make_shared<vox_nav_map_server::MapManagerNoGPS>();
-  rclcpp::spin(map_manager_node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_map_server::MapManagerNoGPS)
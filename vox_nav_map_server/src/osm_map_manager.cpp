@@ -16,8 +16,8 @@
 
 namespace vox_nav_map_server
 {
-  OSMMapManager::OSMMapManager()
-  : Node("vox_nav_osm_map_manager_rclcpp_node"),
+  OSMMapManager::OSMMapManager(const rclcpp::NodeOptions & options)
+  : Node("vox_nav_osm_map_manager_rclcpp_node", options),
     map_configured_(false)
   {
 
@@ -433,19 +433,5 @@ namespace vox_nav_map_server
 
 }   // namespace vox_nav_map_server
 
-/**
- * @brief
- *
- * @param argc
- * @param argv
- * @return int
- */
-int main(int argc, char const * argv[])
-{
-  rclcpp::init(argc, argv);
-  auto map_manager_node = std::make_shared
-    <vox_nav_map_server::OSMMapManager>();
-  rclcpp::spin(map_manager_node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_map_server::OSMMapManager)
@@ -0,0 +1,282 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__CLOUD_RECORDER_HPP_
+#define VOX_NAV_MISC__CLOUD_RECORDER_HPP_
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_cloud.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace vox_nav_misc
+{
+enum class PCDFormat
+{
+  ASCII,
+  BINARY,
+  BINARY_COMPRESSED
+};
+
+enum class RecorderDropPolicy
+{
+  DROP_NEWEST,  // reject the incoming cloud when the queue is full
+  DROP_OLDEST,  // evict the oldest queued cloud to make room
+  BLOCK         // wait on the caller thread until there is room
+};
+
+struct CloudRecorderParams
+{
+  std::string directory;
+  PCDFormat format;
+  size_t queue_size;
+  RecorderDropPolicy drop_policy;
+  CloudRecorderParams()
+    : directory("."), format(PCDFormat::BINARY_COMPRESSED), queue_size(8), drop_policy(RecorderDropPolicy::DROP_OLDEST)
+  {
+  }
+};
+
+inline PCDFormat pcdFormatFromString(const std::string& format)
+{
+  if (format == "ascii")
+  {
+    return PCDFormat::ASCII;
+  }
+  if (format == "binary")
+  {
+    return PCDFormat::BINARY;
+  }
+  if (format == "binary_compressed")
+  {
+    return PCDFormat::BINARY_COMPRESSED;
+  }
+  throw std::invalid_argument("Unknown PCD format: " + format);
+}
+
+inline RecorderDropPolicy dropPolicyFromString(const std::string& policy)
+{
+  if (policy == "drop_newest")
+  {
+    return RecorderDropPolicy::DROP_NEWEST;
+  }
+  if (policy == "drop_oldest")
+  {
+    return RecorderDropPolicy::DROP_OLDEST;
+  }
+  if (policy == "block")
+  {
+    return RecorderDropPolicy::BLOCK;
+  }
+  throw std::invalid_argument("Unknown drop policy: " + policy);
+}
+
+/**
+ * @brief Writes point clouds to PCD files on a background thread.
+ * record() only pushes a shared pointer into a bounded queue, so the caller
+ * never waits on disk unless the BLOCK policy is selected. Clouds handed over
+ * must not be modified afterwards.
+ *
+ * @tparam PointT
+ */
+template <typename PointT>
+class AsyncCloudRecorder
+{
+public:
+  using CloudConstPtr = typename pcl::PointCloud<PointT>::ConstPtr;
+
+  explicit AsyncCloudRecorder(const CloudRecorderParams& params = CloudRecorderParams())
+    : params_(params), stop_(false), written_(0), dropped_(0), failed_(0)
+  {
+    if (params_.queue_size == 0)
+    {
+      params_.queue_size = 1;
+    }
+    writer_ = std::thread(&AsyncCloudRecorder::writerLoop, this);
+  }
+
+  ~AsyncCloudRecorder()
+  {
+    stop();
+  }
+
+  AsyncCloudRecorder(const AsyncCloudRecorder&) = delete;
+  AsyncCloudRecorder& operator=(const AsyncCloudRecorder&) = delete;
+
+  /**
+   * @brief Queue a cloud to be written as <directory>/<name>.pcd
+   *
+   * @param name file name without extension
+   * @param cloud
+   * @return true if queued, false if it was dropped
+   */
+  bool record(const std::string& name, CloudConstPtr cloud)
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stop_)
+    {
+      dropped_++;
+      return false;
+    }
+    if (queue_.size() >= params_.queue_size)
+    {
+      switch (params_.drop_policy)
+      {
+        case RecorderDropPolicy::DROP_NEWEST:
+          dropped_++;
+          return false;
+        case RecorderDropPolicy::DROP_OLDEST:
+          queue_.pop_front();
+          dropped_++;
+          break;
+        case RecorderDropPolicy::BLOCK:
+          not_full_.wait(lock, [this] { return stop_ || queue_.size() < params_.queue_size; });
+          if (stop_)
+          {
+            return false;
+          }
+          break;
+      }
+    }
+    queue_.emplace_back(name, std::move(cloud));
+    lock.unlock();
+    not_empty_.notify_one();
+    return true;
+  }
+
+  /**
+   * @brief Block until every queued cloud has been written
+   */
+  void flush()
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    idle_.wait(lock, [this] { return queue_.empty() && !writing_; });
+  }
+
+  /**
+   * @brief Stop taking clouds, write everything queued, then join the writer
+   * thread. Clouds recorded afterwards are dropped. Called by the destructor.
+   */
+  void stop()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+    if (writer_.joinable())
+    {
+      writer_.join();
+    }
+  }
+
+  size_t written() const
+  {
+    return written_;
+  }
+  size_t dropped() const
+  {
+    return dropped_;
+  }
+  size_t failed() const
+  {
+    return failed_;
+  }
+
+private:
+  void writerLoop()
+  {
+    while (true)
+    {
+      std::pair<std::string, CloudConstPtr> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+        if (queue_.empty())
+        {
+          return;  // stop requested and everything flushed
+        }
+        job = std::move(queue_.front());
+        queue_.pop_front();
+        writing_ = true;
+      }
+      not_full_.notify_one();
+
+      if (write(params_.directory + "/" + job.first + ".pcd", *job.second))
+      {
+        written_++;
+      }
+      else
+      {
+        failed_++;
+      }
+
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        writing_ = false;
+      }
+      idle_.notify_all();
+    }
+  }
+
+  bool write(const std::string& path, const pcl::PointCloud<PointT>& cloud)
+  {
+    if (cloud.empty())
+    {
+      return false;
+    }
+    try
+    {
+      switch (params_.format)
+      {
+        case PCDFormat::ASCII:
+          return pcl::io::savePCDFileASCII(path, cloud) == 0;
+        case PCDFormat::BINARY:
+          return pcl::io::savePCDFileBinary(path, cloud) == 0;
+        case PCDFormat::BINARY_COMPRESSED:
+          return pcl::io::savePCDFileBinaryCompressed(path, cloud) == 0;
+      }
+    }
+    catch (const pcl::IOException&)
+    {
+    }
+    return false;
+  }
+
+  CloudRecorderParams params_;
+  std::deque<std::pair<std::string, CloudConstPtr>> queue_;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::condition_variable idle_;
+  std::thread writer_;
+  bool stop_;
+  bool writing_ = false;
+  std::atomic<size_t> written_;
+  std::atomic<size_t> dropped_;
+  std::atomic<size_t> failed_;
+};
+
+}  // namespace vox_nav_misc
+
+#endif  // VOX_NAV_MISC__CLOUD_RECORDER_HPP_
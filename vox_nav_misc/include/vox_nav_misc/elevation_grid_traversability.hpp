@@ -0,0 +1,133 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__ELEVATION_GRID_TRAVERSABILITY_HPP_
+#define VOX_NAV_MISC__ELEVATION_GRID_TRAVERSABILITY_HPP_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <vector>
+
+#include "vox_nav_misc/traversability_cost_params.hpp"
+
+namespace vox_nav_misc
+{
+struct ElevationGridParams
+{
+  // Cell edge length, plays the role of uniform_sample_radius
+  double resolution;
+  // Half width of the square filter window, plays the role of surfel_radius
+  double window_radius;
+  // Minimum number of points in a window to regress a cost
+  int min_points;
+  ElevationGridParams() : resolution(0.2), window_radius(0.8), min_points(3)
+  {
+  }
+};
+
+/**
+ * @brief Dense 2.5D elevation grid alternative to the surfel based cost
+ * regression. Points are binned once into count, mean and min/max height per
+ * cell, then every critic is a separable image filter over the grid:
+ * slope by central differences of the window mean height, roughness by the
+ * window height variance with the slope contribution removed, and step height
+ * by window max minus window min. Costs and colors follow
+ * TraversabilityEstimator::regressCosts.
+ *
+ */
+class ElevationGridTraversability
+{
+public:
+  ElevationGridTraversability(const ElevationGridParams& grid_params, const CostRegressionParams& cost_params);
+
+  /**
+   * @brief Rebuild the grid over the bounding box of cloud and regress costs
+   * of all cells.
+   *
+   * @param cloud
+   */
+  void compute(const pcl::PointCloud<pcl::PointXYZRGB>& cloud);
+
+  /**
+   * @brief Cost of the cell containing x, y from the last compute()
+   *
+   * @param x
+   * @param y
+   * @param total_cost
+   * @param traversable
+   * @return true if the cell had enough points to regress a cost
+   */
+  bool costAt(double x, double y, double& total_cost, bool& traversable) const;
+
+  /**
+   * @brief One point per cell with a regressed cost, placed at the cell mean
+   * and colored like TraversabilityEstimator::regressCosts does.
+   *
+   * @return pcl::PointCloud<pcl::PointXYZRGB>::Ptr
+   */
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr getTraversableCloud() const;
+
+  int rows() const
+  {
+    return rows_;
+  }
+  int cols() const
+  {
+    return cols_;
+  }
+
+private:
+  // Running window sum along rows then along columns, in place
+  void boxFilter(std::vector<double>& data) const;
+  // Running window min or max along rows then along columns, in place
+  void extremumFilter(std::vector<float>& data, bool take_max) const;
+  bool cellIndex(double x, double y, int& r, int& c) const;
+
+  ElevationGridParams params_;
+  CostRegressionParams cost_params_;
+  int window_cells_;
+  double origin_x_;
+  double origin_y_;
+  // Heights are accumulated relative to this to keep sums of squares well conditioned
+  double z_ref_;
+  int rows_;
+  int cols_;
+
+  // Per cell layers, row major rows_ x cols_
+  std::vector<double> count_;
+  std::vector<double> sum_x_;
+  std::vector<double> sum_y_;
+  std::vector<double> sum_z_;
+  std::vector<double> sum_zz_;
+  std::vector<float> min_z_;
+  std::vector<float> max_z_;
+  // Window layers, filtered copies of the above
+  std::vector<double> window_count_;
+  std::vector<double> window_mean_z_;
+  std::vector<double> window_var_z_;
+  std::vector<float> window_min_z_;
+  std::vector<float> window_max_z_;
+  // Results
+  std::vector<float> total_cost_;
+  std::vector<unsigned char> traversable_;
+  std::vector<unsigned char> has_cost_;
+  // Scratch line for the separable filters
+  mutable std::vector<double> line_;
+  mutable std::vector<float> line_f_;
+};
+
+}  // namespace vox_nav_misc
+
+#endif  // VOX_NAV_MISC__ELEVATION_GRID_TRAVERSABILITY_HPP_
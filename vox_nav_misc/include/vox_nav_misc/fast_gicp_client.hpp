@@ -91,7 +91,7 @@ public:
    * @brief Construct a new Fast G I C P Client object
    *
    */
-  FastGICPClient();
+  explicit FastGICPClient(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
 
   /**
    * @brief Destroy the Fast G I C P Client object
@@ -94,7 +94,7 @@ public:
    * @brief  Construct a new Fast GICP Client No GPS object
    *
    */
-  FastGICPClientNoGPS();
+  explicit FastGICPClientNoGPS(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
 
   /**
    * @brief Destroy the Fast GICP Client No G P S object
@@ -0,0 +1,115 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__LIDAR_CAMERA_FUSION_HPP_
+#define VOX_NAV_MISC__LIDAR_CAMERA_FUSION_HPP_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "vox_nav_misc/lidar_camera_projection.hpp"
+
+namespace vox_nav_misc
+{
+// Per point validity flags of a fusion result
+enum FusionPointFlags : std::uint8_t
+{
+  FUSION_IN_IMAGE = 1,  // projected in front of the camera and inside the image
+  FUSION_VISIBLE = 2    // not occluded, its color was sampled from the image
+};
+
+struct LidarCameraFusionParams
+{
+  // Half width of the min filter that fills empty depth pixels, 0 disables hole filling
+  int hole_filling_radius;
+  // A point is still visible if it is at most this far behind the nearest point of its pixel [m]
+  float occlusion_tolerance;
+  LidarCameraFusionParams() : hole_filling_radius(0), occlusion_tolerance(0.1f)
+  {
+  }
+};
+
+/**
+ * @brief Turns one LidarCameraProjector pass into reusable products:
+ * a float depth image aligned to the camera with nearest depth per pixel
+ * (empty pixels optionally filled from their nearest neighbour depth by a
+ * separable min filter), a cloud with the layout of the input cloud
+ * colorized from the image, and a validity mask per point.
+ *
+ */
+class LidarCameraFusion
+{
+public:
+  explicit LidarCameraFusion(const LidarCameraFusionParams& params = LidarCameraFusionParams());
+
+  /**
+   * @brief Build all products from a projection of cloud
+   *
+   * @param projector must have projected cloud
+   * @param cloud
+   * @param image interleaved 8 bit RGB image of projector.width() x projector.height()
+   * @param image_step bytes per image row
+   */
+  void fuse(const LidarCameraProjector& projector, const CloudSoA& cloud, const std::uint8_t* image,
+            size_t image_step);
+
+  /**
+   * @brief Row major depth image in meters, 0 where no depth is known
+   *
+   * @return const std::vector<float>&
+   */
+  const std::vector<float>& depthImage() const
+  {
+    return depth_image_;
+  }
+
+  /**
+   * @brief Input points in input order and layout, colored from the image
+   * where FUSION_VISIBLE is set and black elsewhere
+   *
+   * @return pcl::PointCloud<pcl::PointXYZRGB>::Ptr
+   */
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr colorizedCloud() const
+  {
+    return colorized_cloud_;
+  }
+
+  /**
+   * @brief FusionPointFlags of each input point
+   *
+   * @return const std::vector<std::uint8_t>&
+   */
+  const std::vector<std::uint8_t>& pointFlags() const
+  {
+    return point_flags_;
+  }
+
+private:
+  void fillHoles(int width, int height);
+
+  LidarCameraFusionParams params_;
+  std::vector<float> depth_image_;
+  // Scratch images of the hole filling
+  std::vector<float> rows_filtered_;
+  std::vector<float> dilated_;
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr colorized_cloud_;
+  std::vector<std::uint8_t> point_flags_;
+};
+
+}  // namespace vox_nav_misc
+
+#endif  // VOX_NAV_MISC__LIDAR_CAMERA_FUSION_HPP_
@@ -0,0 +1,189 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__LIDAR_CAMERA_PROJECTION_HPP_
+#define VOX_NAV_MISC__LIDAR_CAMERA_PROJECTION_HPP_
+
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <Eigen/Core>
+
+#include <cstdint>
+#include <vector>
+
+namespace vox_nav_misc
+{
+/**
+ * @brief Structure of arrays view of a point cloud, one contiguous array per
+ * coordinate so that projection loops vectorize.
+ *
+ */
+struct CloudSoA
+{
+  std::vector<float> x;
+  std::vector<float> y;
+  std::vector<float> z;
+  // Packed 0x00RRGGBB, all zero if the cloud has no rgb field
+  std::vector<std::uint32_t> rgb;
+  // Layout of the source cloud, height is 1 for unorganized clouds
+  std::uint32_t width = 0;
+  std::uint32_t height = 1;
+
+  size_t size() const
+  {
+    return x.size();
+  }
+
+  void resize(size_t n)
+  {
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    rgb.resize(n);
+    width = static_cast<std::uint32_t>(n);
+    height = 1;
+  }
+};
+
+/**
+ * @brief Unpack x, y, z and, if present, rgb (or rgba) straight from the
+ * PointCloud2 buffer without going through a pcl cloud.
+ * Throws std::runtime_error if x, y or z is missing or not FLOAT32, if the
+ * byte order is not the host's, or if data is smaller than row_step * height
+ * or the steps are too small for the fields.
+ *
+ * @param msg
+ * @param soa
+ */
+void pointCloud2ToSoA(const sensor_msgs::msg::PointCloud2& msg, CloudSoA& soa);
+
+/**
+ * @brief Projects lidar points into a camera image with a single fused
+ * K * T matrix, and keeps a per pixel depth buffer so that only the nearest
+ * point of each pixel is visible.
+ *
+ */
+class LidarCameraProjector
+{
+public:
+  LidarCameraProjector(int image_width, int image_height);
+
+  /**
+   * @brief Set camera intrinsics and the lidar to camera extrinsics,
+   * both are fused into one 3x4 projection.
+   *
+   * @param K 3x4 camera matrix
+   * @param T 4x4 transform from lidar frame to camera optical frame
+   */
+  void setProjection(const Eigen::Matrix<float, 3, 4>& K, const Eigen::Matrix4f& T);
+
+  /**
+   * @brief Resize the image, depth buffer is reallocated on next project()
+   *
+   * @param image_width
+   * @param image_height
+   */
+  void setImageSize(int image_width, int image_height);
+
+  /**
+   * @brief Project all points and resolve occlusions.
+   *
+   * @param cloud
+   * @return size_t number of pixels that received a point
+   */
+  size_t project(const CloudSoA& cloud);
+
+  /**
+   * @brief Pixel index (v * width + u) of each point, -1 if it falls
+   * outside of the image or behind the camera
+   *
+   * @return const std::vector<int>&
+   */
+  const std::vector<int>& pointPixels() const
+  {
+    return point_pixel_;
+  }
+
+  /**
+   * @brief Index of the nearest point of each pixel, -1 for empty pixels
+   *
+   * @return const std::vector<int>&
+   */
+  const std::vector<int>& pixelPoints() const
+  {
+    return pixel_point_;
+  }
+
+  /**
+   * @brief Depth along the camera axis of the nearest point of each pixel,
+   * +inf for empty pixels
+   *
+   * @return const std::vector<float>&
+   */
+  const std::vector<float>& depthBuffer() const
+  {
+    return depth_;
+  }
+
+  /**
+   * @brief Depth of each point along the camera axis, valid where pointPixels() is not -1
+   *
+   * @return const std::vector<float>&
+   */
+  const std::vector<float>& pointDepths() const
+  {
+    return w_;
+  }
+
+  // True if point i projected into the image and was not occluded
+  bool visible(size_t i) const
+  {
+    return point_pixel_[i] >= 0 && pixel_point_[point_pixel_[i]] == static_cast<int>(i);
+  }
+
+  int width() const
+  {
+    return width_;
+  }
+  int height() const
+  {
+    return height_;
+  }
+
+  // Points closer than this to the camera plane are discarded
+  void setMinDepth(float min_depth)
+  {
+    min_depth_ = min_depth;
+  }
+
+private:
+  int width_;
+  int height_;
+  float min_depth_;
+  Eigen::Matrix<float, 3, 4> P_;
+  // Per point
+  std::vector<float> u_;
+  std::vector<float> v_;
+  std::vector<float> w_;
+  std::vector<int> point_pixel_;
+  // Per pixel
+  std::vector<float> depth_;
+  std::vector<int> pixel_point_;
+  // Pixels written by the last project(), reset instead of clearing the whole image
+  std::vector<int> touched_pixels_;
+};
+
+}  // namespace vox_nav_misc
+
+#endif  // VOX_NAV_MISC__LIDAR_CAMERA_PROJECTION_HPP_
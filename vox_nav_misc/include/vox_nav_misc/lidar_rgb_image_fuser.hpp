@@ -40,6 +40,9 @@
 #include <cv_bridge/cv_bridge.h>
 #include <Eigen/Dense>
 
+#include "vox_nav_misc/lidar_camera_fusion.hpp"
+#include "vox_nav_misc/lidar_camera_projection.hpp"
+
 namespace vox_nav_misc
 {
 
@@ -60,6 +63,9 @@ private:
   std::shared_ptr<LidarCamApprxTimeSyncer> time_syncher_;
 
   rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr fusion_image_pub_;
+  // Fusion products, camera aligned depth image and the cloud colorized from the camera
+  rclcpp::Publisher<sensor_msgs::msg::Image>::SharedPtr depth_image_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr colorized_cloud_pub_;
 
   // Camera model parameters are ;
   // fx 0 cx 0
@@ -80,6 +86,12 @@ private:
   // This will come from tf
   Eigen::Matrix4f T_{ Eigen::Matrix4f::Identity() };
 
+  // Cloud unpacked from the message buffer and the fused projection with its depth buffer,
+  // both kept across callbacks to reuse their allocations
+  CloudSoA cloud_soa_;
+  LidarCameraProjector projector_{ 1280, 720 };
+  std::unique_ptr<LidarCameraFusion> fusion_;
+
 public:
   lidar_rgb_image_fuser();
   ~lidar_rgb_image_fuser();
@@ -92,17 +104,6 @@ public:
    */
   void ousterCamCallback(const sensor_msgs::msg::Image::ConstSharedPtr& image,
                          const sensor_msgs::msg::PointCloud2::ConstSharedPtr& cloud);
-
-  /**
-   * @brief transform3DPointsToImage
-   * @param points
-   * @param TRANS_TO_IMAGE
-   * @param uv
-   * Use Homogenous transformation matrix to transform 3D points to image plane
-   * normilized image plane coordinates are filled in uv matrix
-   */
-  void transform3DPointsToImage(const Eigen::MatrixXf& points,  // NOLINT
-                                const Eigen::MatrixXf& TRANS_TO_IMAGE, Eigen::MatrixXf& uv);
 };
 
 }  // namespace vox_nav_misc
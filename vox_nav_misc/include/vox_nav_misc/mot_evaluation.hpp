@@ -0,0 +1,175 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__MOT_EVALUATION_HPP_
+#define VOX_NAV_MISC__MOT_EVALUATION_HPP_
+
+#include "vox_nav_msgs/msg/object.hpp"
+#include "vox_nav_msgs/msg/object_array.hpp"
+
+#include <map>
+#include <ostream>
+#include <random>
+#include <vector>
+
+namespace vox_nav_misc
+{
+
+    enum class ScenarioObjectType
+    {
+        VEHICLE,
+        PEDESTRIAN
+    };
+
+    struct MOTScenarioConfig
+    {
+        unsigned int seed{42};
+        int num_frames{600};
+        double dt{0.1};
+        int num_vehicles{8};
+        int num_pedestrians{16};
+        // Objects are spawned in a square of this half size around the sensor
+        double area_half_size{40.0};
+        // Detections beyond this range from the sensor are dropped
+        double sensor_range{50.0};
+        // Probability that a visible object is detected in a frame
+        double detection_probability{0.9};
+        // Mean number of false positives per frame (Poisson)
+        double clutter_rate{2.0};
+        // Std of position and box size noise of detections [m]
+        double position_noise{0.1};
+        double size_noise{0.05};
+        // Fraction of vehicles following CTRV, the rest move with CV
+        double ctrv_fraction{0.5};
+    };
+
+    struct GroundTruthObject
+    {
+        int id;
+        ScenarioObjectType type;
+        double x;
+        double y;
+        double z;
+        double yaw;
+        double v;
+        double yaw_rate;
+        double length;
+        double width;
+        double height;
+        bool occluded;
+    };
+
+    struct MOTFrame
+    {
+        double stamp;
+        std::vector<GroundTruthObject> truth;
+        vox_nav_msgs::msg::ObjectArray detections;
+    };
+
+    /**
+     * @brief Deterministic generator of multi object tracking scenarios.
+     * Vehicles drive along lanes with CV or CTRV motion, pedestrians walk across
+     * the lanes with CV motion. An object is occluded if a closer object covers
+     * its bearing as seen from the sensor at the origin. Visible objects are
+     * missed with 1 - detection_probability and clutter is added uniformly.
+     * The same config and seed always produce the same frames.
+     *
+     */
+    class MOTScenarioGenerator
+    {
+    public:
+        explicit MOTScenarioGenerator(const MOTScenarioConfig &config);
+
+        /**
+         * @brief Generate all frames of the scenario.
+         *
+         * @return std::vector<MOTFrame>
+         */
+        std::vector<MOTFrame> generate();
+
+    private:
+        void spawn(GroundTruthObject &object, bool initial);
+        void step(GroundTruthObject &object);
+        void computeOcclusions(std::vector<GroundTruthObject> &objects) const;
+        vox_nav_msgs::msg::Object toDetection(
+            double x, double y, double z, double yaw,
+            double length, double width, double height);
+
+        MOTScenarioConfig config_;
+        std::mt19937 rng_;
+        int next_id_;
+    };
+
+    struct MOTFrameStats
+    {
+        int frame;
+        int num_truth;
+        int num_tracks;
+        int matches;
+        int false_positives;
+        int misses;
+        int id_switches;
+        double distance_sum;
+        double latency_ms;
+    };
+
+    /**
+     * @brief CLEAR MOT metrics (MOTA, MOTP, ID switches) accumulated over frames.
+     * Ground truth and hypotheses are matched per frame within match_threshold,
+     * correspondences of the previous frame are kept while still valid and the
+     * rest is matched greedily by increasing distance.
+     *
+     */
+    class MOTMetrics
+    {
+    public:
+        explicit MOTMetrics(double match_threshold = 2.0);
+
+        /**
+         * @brief Match tracks to ground truth of one frame and accumulate.
+         *
+         * @param truth
+         * @param tracks
+         * @param latency_ms time the tracker took for this frame
+         * @return const MOTFrameStats&
+         */
+        const MOTFrameStats &update(
+            const std::vector<GroundTruthObject> &truth,
+            const vox_nav_msgs::msg::ObjectArray &tracks,
+            double latency_ms);
+
+        double mota() const;
+        double motp() const;
+        int idSwitches() const;
+
+        /**
+         * @brief Write one CSV row per frame, with header.
+         */
+        void writeFramesCSV(std::ostream &os) const;
+
+        /**
+         * @brief Write a single CSV row of totals, with header.
+         */
+        void writeSummaryCSV(std::ostream &os) const;
+
+    private:
+        double match_threshold_;
+        std::vector<MOTFrameStats> frames_;
+        // Ground truth id -> track id of last match
+        std::map<int, int> last_match_;
+    };
+
+} // namespace vox_nav_misc
+
+#endif // VOX_NAV_MISC__MOT_EVALUATION_HPP_
@@ -85,7 +85,7 @@ namespace vox_nav_misc
      * @brief Construct a new NaiveLIDARClustering object
      *
      */
-    NaiveLIDARClustering();
+    explicit NaiveLIDARClustering(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
     /**
      * @brief Destroy the NaiveLIDARClustering object
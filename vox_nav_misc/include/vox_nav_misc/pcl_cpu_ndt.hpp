@@ -86,7 +86,7 @@ namespace vox_nav_misc
      * @brief Construct a new Raw Cloud Clustering Tracking object
      *
      */
-    PCLCPUNDT();
+    explicit PCLCPUNDT(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
     /**
      * @brief Destroy the Raw Cloud Clustering Tracking object
      *
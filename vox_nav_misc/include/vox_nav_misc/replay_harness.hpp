@@ -0,0 +1,194 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__REPLAY_HARNESS_HPP_
+#define VOX_NAV_MISC__REPLAY_HARNESS_HPP_
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <rclcpp/rclcpp.hpp>
+#include <rosgraph_msgs/msg/clock.hpp>
+#include <nav_msgs/msg/odometry.hpp>
+#include <sensor_msgs/msg/imu.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+#include <tf2_ros/static_transform_broadcaster.h>
+#include <tf2_ros/transform_broadcaster.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace vox_nav_misc
+{
+struct ReplayImuSample
+{
+  int64_t stamp_ns;
+  Eigen::Quaterniond orientation;
+  Eigen::Vector3d angular_velocity;
+  Eigen::Vector3d linear_acceleration;
+};
+
+struct ReplayOdomSample
+{
+  int64_t stamp_ns;
+  Eigen::Vector3d position;
+  Eigen::Quaterniond orientation;
+  Eigen::Vector3d linear_velocity;
+  Eigen::Vector3d angular_velocity;
+};
+
+/**
+ * @brief Sensor data of a replay directory, everything sorted by stamp.
+ * Layout of the directory:
+ *   clouds/<stamp_ns>.pcd  one file per lidar scan, in the lidar frame
+ *   imu.csv                stamp_ns,qx,qy,qz,qw,wx,wy,wz,ax,ay,az
+ *   odom.csv               stamp_ns,x,y,z,qx,qy,qz,qw,vx,vy,vz,wx,wy,wz
+ *   map.pcd                optional prior map, in the map frame
+ * Both csv files are optional and may start with a header line.
+ */
+struct ReplayDataset
+{
+  std::vector<std::pair<int64_t, std::string>> clouds;
+  std::vector<ReplayImuSample> imu;
+  std::vector<ReplayOdomSample> odom;
+  std::string map_cloud;
+};
+
+/**
+ * @brief Index a replay directory, clouds are only loaded while replaying
+ *
+ * @param directory
+ * @return ReplayDataset
+ * @throws std::runtime_error if the directory has no clouds or a csv line can not be parsed
+ */
+ReplayDataset loadReplayDataset(const std::string& directory);
+
+void writeReplayImuCsv(const std::string& path, const std::vector<ReplayImuSample>& imu);
+
+void writeReplayOdomCsv(const std::string& path, const std::vector<ReplayOdomSample>& odom);
+
+// 64 bit FNV-1a, used for output digests
+uint64_t fnv1a64(const uint8_t* data, size_t size, uint64_t hash = 0xcbf29ce484222325ULL);
+
+enum class ReplayMode
+{
+  LOCKSTEP,  // publish a scan only after the output of the previous one arrived
+  RATE       // publish at rate times the recorded rate, 0 for as fast as possible
+};
+
+struct ReplayParams
+{
+  ReplayMode mode;
+  double rate;
+  // How long to wait for the output of a scan, in lockstep mode and after the last scan
+  std::chrono::milliseconds output_timeout;
+  std::string cloud_topic;
+  std::string imu_topic;
+  std::string odom_topic;
+  std::string map_topic;
+  std::string output_topic;
+  std::string output_type;
+  std::string map_frame;
+  std::string odom_frame;
+  std::string base_frame;
+  std::string cloud_frame;
+  ReplayParams()
+    : mode(ReplayMode::LOCKSTEP)
+    , rate(0.0)
+    , output_timeout(5000)
+    , cloud_topic("points")
+    , imu_topic("imu")
+    , odom_topic("odometry/global")
+    , output_topic("detections")
+    , output_type("vox_nav_msgs/msg/ObjectArray")
+    , map_frame("map")
+    , odom_frame("odom")
+    , base_frame("base_link")
+    , cloud_frame("base_link")
+  {
+  }
+};
+
+struct ReplayRecord
+{
+  size_t index;
+  int64_t stamp_ns;
+  // From publishing the scan until its output was received, negative if no output came
+  double latency_ms;
+  // Digest of the serialized output message, 0 if no output came
+  uint64_t digest;
+};
+
+/**
+ * @brief Replays a dataset into nodes under test in the same process. The
+ * harness publishes /clock, so nodes under test have to be created with
+ * use_sim_time, the sensor topics and the map -> odom -> base_link -> lidar
+ * transforms, and subscribes to one output topic of any type. /clock follows
+ * the stamps of the replayed messages and never goes back. The n-th
+ * output message is attributed to the oldest scan that has no output yet,
+ * which holds for nodes that publish once per scan. The nodes under test and
+ * the harness must be spun by an executor on another thread than run().
+ */
+class ReplayHarness : public rclcpp::Node
+{
+public:
+  explicit ReplayHarness(const ReplayParams& params, const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
+
+  /**
+   * @brief Replay the whole dataset, blocks until done
+   *
+   * @param dataset
+   * @return std::vector<ReplayRecord> one record per scan
+   */
+  std::vector<ReplayRecord> run(const ReplayDataset& dataset);
+
+private:
+  void outputCallback(std::shared_ptr<rclcpp::SerializedMessage> msg);
+  void publishClock(int64_t stamp_ns);
+  void publishImu(const ReplayImuSample& sample);
+  void publishOdom(const ReplayOdomSample& sample);
+  bool publishCloud(size_t index, const std::string& path, int64_t stamp_ns);
+  void publishMap(const std::string& path);
+  bool waitForOutput(size_t index, std::chrono::milliseconds timeout);
+
+  ReplayParams params_;
+
+  rclcpp::Publisher<rosgraph_msgs::msg::Clock>::SharedPtr clock_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr cloud_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::PointCloud2>::SharedPtr map_pub_;
+  rclcpp::Publisher<sensor_msgs::msg::Imu>::SharedPtr imu_pub_;
+  rclcpp::Publisher<nav_msgs::msg::Odometry>::SharedPtr odom_pub_;
+  rclcpp::GenericSubscription::SharedPtr output_sub_;
+  std::shared_ptr<tf2_ros::TransformBroadcaster> tf_broadcaster_;
+  std::shared_ptr<tf2_ros::StaticTransformBroadcaster> static_tf_broadcaster_;
+
+  std::mutex mutex_;
+  std::condition_variable output_cv_;
+  std::vector<ReplayRecord> records_;
+  std::vector<std::chrono::steady_clock::time_point> publish_times_;
+  std::deque<size_t> awaiting_output_;
+  size_t outputs_{ 0 };
+  // Last stamp published on /clock, only run() publishes it
+  int64_t clock_ns_{ 0 };
+};
+
+}  // namespace vox_nav_misc
+
+#endif  // VOX_NAV_MISC__REPLAY_HARNESS_HPP_
@@ -0,0 +1,163 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__ROLLING_TRAVERSABILITY_GRID_HPP_
+#define VOX_NAV_MISC__ROLLING_TRAVERSABILITY_GRID_HPP_
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <Eigen/Core>
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "vox_nav_misc/traversability_cost_params.hpp"
+
+namespace vox_nav_misc
+{
+struct RollingGridParams
+{
+  // Cell edge length, plays the role of uniform_sample_radius
+  double resolution;
+  // Grid covers [-half_size, half_size] around the robot in x and y
+  double half_size;
+  // Neighbourhood used for plane fitting, plays the role of surfel_radius
+  double window_radius;
+  // Accumulated counts are clamped to this so that old scans fade out
+  double max_points_per_cell;
+  // Minimum number of points in a window to regress a cost
+  int min_points;
+  // A touched cell only becomes dirty if its height statistics moved more than this [m]
+  double change_threshold;
+  RollingGridParams()
+    : resolution(0.2)
+    , half_size(10.0)
+    , window_radius(0.8)
+    , max_points_per_cell(50.0)
+    , min_points(3)
+    , change_threshold(0.01)
+  {
+  }
+};
+
+/**
+ * @brief Robot centric 2D grid of height statistics that rolls with the robot.
+ * Cells are addressed by world cell index modulo the grid size, so moving the
+ * robot only changes the window origin; a cell that is reused for a new world
+ * index is reset lazily when touched. Each cell keeps count, mean and scatter
+ * of its points (Welford). A touched cell is dirty when its mean, spread or
+ * extent of height moved by more than change_threshold since it was last
+ * regressed, and updateCosts() re-regresses slope, roughness and step costs
+ * only for cells whose window contains a dirty cell.
+ *
+ */
+class RollingTraversabilityGrid
+{
+public:
+  RollingTraversabilityGrid(const RollingGridParams& grid_params, const CostRegressionParams& cost_params);
+
+  /**
+   * @brief Move the window center to the robot position, cells that fall out
+   * of the window are invalidated without touching memory.
+   *
+   * @param x
+   * @param y
+   */
+  void moveTo(double x, double y);
+
+  /**
+   * @brief Accumulate points into their cells and mark those cells touched,
+   * points outside the window are ignored.
+   *
+   * @param cloud
+   */
+  void insert(const pcl::PointCloud<pcl::PointXYZRGB>& cloud);
+
+  /**
+   * @brief Find dirty cells among the touched ones and recompute costs of
+   * every cell affected by them.
+   *
+   * @return size_t number of cells whose cost was recomputed
+   */
+  size_t updateCosts();
+
+  /**
+   * @brief One point per cell with a regressed cost, placed at the cell mean
+   * and colored like TraversabilityEstimator::regressCosts does.
+   *
+   * @return pcl::PointCloud<pcl::PointXYZRGB>::Ptr
+   */
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr getTraversableCloud() const;
+
+  int cellsPerSide() const
+  {
+    return size_;
+  }
+
+private:
+  struct Cell
+  {
+    // world cell index the statistics belong to
+    int wx = INT32_MIN;
+    int wy = INT32_MIN;
+    double count = 0.0;
+    Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+    Eigen::Matrix3d scatter = Eigen::Matrix3d::Zero();
+    float min_z = 0.0f;
+    float max_z = 0.0f;
+    bool touched = false;
+    // Height statistics when the cell was last found dirty
+    bool has_snapshot = false;
+    float snapshot_mean_z = 0.0f;
+    float snapshot_std_z = 0.0f;
+    float snapshot_min_z = 0.0f;
+    float snapshot_max_z = 0.0f;
+    bool has_cost = false;
+    bool traversable = false;
+    float total_cost = 0.0f;
+    // Scan stamp of the last cost recompute, used to deduplicate windows
+    std::uint32_t recomputed_at = 0;
+  };
+
+  bool inWindow(int wx, int wy) const;
+  size_t storageIndex(int wx, int wy) const;
+  // Cell for a world index, reset if its storage held another world index
+  Cell& cellAt(int wx, int wy);
+  // Cell for a world index if it holds data for it, nullptr otherwise
+  Cell* findCell(int wx, int wy);
+  // Compare against the snapshot and refresh it if the cell changed
+  bool checkDirty(Cell& cell) const;
+  void regressCell(int wx, int wy, Cell& cell);
+
+  RollingGridParams params_;
+  CostRegressionParams cost_params_;
+  int size_;
+  int window_cells_;
+  // World cell index of the lower left cell of the window
+  int origin_x_;
+  int origin_y_;
+  std::uint32_t stamp_;
+  std::vector<Cell> cells_;
+  // Offsets of cells within window_radius
+  std::vector<std::pair<int, int>> window_offsets_;
+  std::vector<std::pair<int, int>> touched_cells_;
+  // Scratch list of populated cells in the window being regressed
+  std::vector<const Cell*> window_;
+};
+
+}  // namespace vox_nav_misc
+
+#endif  // VOX_NAV_MISC__ROLLING_TRAVERSABILITY_GRID_HPP_
@@ -0,0 +1,379 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__TRACK_STORE_HPP_
+#define VOX_NAV_MISC__TRACK_STORE_HPP_
+
+#include <Eigen/Core>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace vox_nav_misc
+{
+
+    /**
+     * @brief Container of tracks with stable slot indices.
+     * Tracks never move in memory once inserted, removed slots are recycled
+     * through a free list and the iteration order is kept as a separate list of
+     * slot indices, so sorting and deleting never copy a Track around.
+     *
+     * @tparam T track type
+     */
+    template <typename T>
+    class TrackStore
+    {
+    public:
+        /**
+         * @brief Insert a track, reusing a free slot if there is one.
+         *
+         * @param track
+         * @return int slot index of the inserted track
+         */
+        int push_back(T track)
+        {
+            int slot;
+            if (!free_.empty())
+            {
+                slot = free_.back();
+                free_.pop_back();
+                slots_[slot] = std::move(track);
+                alive_[slot] = 1;
+            }
+            else
+            {
+                slot = static_cast<int>(slots_.size());
+                slots_.push_back(std::move(track));
+                alive_.push_back(1);
+            }
+            order_.push_back(slot);
+            return slot;
+        }
+
+        /**
+         * @brief Remove every track for which pred returns true.
+         * The relative order of the remaining tracks is preserved.
+         *
+         * @tparam Pred bool(const T &)
+         * @param pred
+         * @return size_t number of removed tracks
+         */
+        template <typename Pred>
+        size_t remove_if(Pred pred)
+        {
+            size_t removed = 0;
+            size_t write = 0;
+            for (size_t read = 0; read < order_.size(); ++read)
+            {
+                int slot = order_[read];
+                if (pred(slots_[slot]))
+                {
+                    release(slot);
+                    removed++;
+                }
+                else
+                {
+                    order_[write++] = slot;
+                }
+            }
+            order_.resize(write);
+            return removed;
+        }
+
+        /**
+         * @brief Remove tracks at the given positions of the iteration order,
+         * flags must have size() entries.
+         *
+         * @param flags non zero entries are removed
+         * @return size_t number of removed tracks
+         */
+        size_t remove_flagged(const std::vector<char> &flags)
+        {
+            size_t removed = 0;
+            size_t write = 0;
+            for (size_t read = 0; read < order_.size(); ++read)
+            {
+                if (flags[read])
+                {
+                    release(order_[read]);
+                    removed++;
+                }
+                else
+                {
+                    order_[write++] = order_[read];
+                }
+            }
+            order_.resize(write);
+            return removed;
+        }
+
+        /**
+         * @brief Stable sort of the iteration order, tracks are not moved.
+         *
+         * @tparam Compare bool(const T &, const T &)
+         * @param comp
+         */
+        template <typename Compare>
+        void sort(Compare comp)
+        {
+            std::stable_sort(
+                order_.begin(), order_.end(), [&](int a, int b)
+                { return comp(slots_[a], slots_[b]); });
+        }
+
+        T &operator[](size_t i) { return slots_[order_[i]]; }
+        const T &operator[](size_t i) const { return slots_[order_[i]]; }
+        T &at(size_t i) { return slots_[order_.at(i)]; }
+        const T &at(size_t i) const { return slots_[order_.at(i)]; }
+
+        /**
+         * @brief Slot index of the i'th track in iteration order.
+         */
+        int slot(size_t i) const { return order_[i]; }
+
+        T &fromSlot(int slot) { return slots_[slot]; }
+        const T &fromSlot(int slot) const { return slots_[slot]; }
+
+        size_t size() const { return order_.size(); }
+        bool empty() const { return order_.empty(); }
+
+        /**
+         * @brief Number of allocated slots including free ones.
+         */
+        size_t capacity() const { return slots_.size(); }
+
+        void clear()
+        {
+            slots_.clear();
+            alive_.clear();
+            free_.clear();
+            order_.clear();
+        }
+
+    private:
+        void release(int slot)
+        {
+            // Drop heavy members (clusters, histories) but keep the slot around
+            slots_[slot] = T();
+            alive_[slot] = 0;
+            free_.push_back(slot);
+        }
+
+        std::vector<T> slots_;
+        std::vector<char> alive_;
+        std::vector<int> free_;
+        std::vector<int> order_;
+    };
+
+    /**
+     * @brief Per-frame uniform grid hash over the x/y of 3D positions.
+     * Tracks live on the ground, so cells are columns and z is left to the
+     * distance check of the caller. Indices are bucketed by cell into one contiguous array and an open
+     * addressing table maps a cell key to its bucket, both are rebuilt every
+     * frame without reallocating once warmed up.
+     *
+     */
+    class TrackSpatialHash
+    {
+    public:
+        /**
+         * @brief Rebuild the hash from positions.
+         *
+         * @param positions
+         * @param cell_size edge length of a cell, should be >= the query radius
+         */
+        void build(const std::vector<Eigen::Vector3f> &positions, float cell_size)
+        {
+            inv_cell_size_ = 1.0f / cell_size;
+            entries_.resize(positions.size());
+            for (size_t i = 0; i < positions.size(); ++i)
+            {
+                entries_[i] = {key(cell(positions[i])), static_cast<int>(i)};
+            }
+            std::sort(entries_.begin(), entries_.end());
+
+            size_t table_size = 16;
+            while (table_size < 2 * entries_.size())
+            {
+                table_size <<= 1;
+            }
+            table_.assign(table_size, Bucket());
+            table_mask_ = table_size - 1;
+
+            for (size_t begin = 0; begin < entries_.size();)
+            {
+                size_t end = begin + 1;
+                while (end < entries_.size() && entries_[end].first == entries_[begin].first)
+                {
+                    end++;
+                }
+                std::uint64_t k = entries_[begin].first;
+                size_t h = mix(k) & table_mask_;
+                while (table_[h].begin != table_[h].end)
+                {
+                    h = (h + 1) & table_mask_;
+                }
+                table_[h] = {k, static_cast<int>(begin), static_cast<int>(end)};
+                begin = end;
+            }
+        }
+
+        /**
+         * @brief Call fn(index) for every entry in the 9 cells around p.
+         *
+         * @tparam Fn void(int)
+         * @param p
+         * @param fn
+         */
+        template <typename Fn>
+        void forEachNeighbour(const Eigen::Vector3f &p, Fn fn) const
+        {
+            Eigen::Vector2i c = cell(p);
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                for (int dy = -1; dy <= 1; ++dy)
+                {
+                    std::uint64_t k = key(c + Eigen::Vector2i(dx, dy));
+                    for (size_t h = mix(k) & table_mask_;
+                         table_[h].begin != table_[h].end;
+                         h = (h + 1) & table_mask_)
+                    {
+                        if (table_[h].key == k)
+                        {
+                            for (int e = table_[h].begin; e < table_[h].end; ++e)
+                            {
+                                fn(entries_[e].second);
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+    private:
+        struct Bucket
+        {
+            std::uint64_t key{0};
+            int begin{0};
+            int end{0};
+        };
+
+        Eigen::Vector2i cell(const Eigen::Vector3f &p) const
+        {
+            return Eigen::Vector2i(
+                static_cast<int>(std::floor(p.x() * inv_cell_size_)),
+                static_cast<int>(std::floor(p.y() * inv_cell_size_)));
+        }
+
+        static std::uint64_t key(const Eigen::Vector2i &c)
+        {
+            return (static_cast<std::uint64_t>(static_cast<std::uint32_t>(c.x())) << 32) |
+                   static_cast<std::uint64_t>(static_cast<std::uint32_t>(c.y()));
+        }
+
+        static size_t mix(std::uint64_t k)
+        {
+            k ^= k >> 33;
+            k *= 0xff51afd7ed558ccdull;
+            k ^= k >> 33;
+            return static_cast<size_t>(k);
+        }
+
+        float inv_cell_size_{1.0f};
+        std::vector<std::pair<std::uint64_t, int>> entries_;
+        std::vector<Bucket> table_;
+        size_t table_mask_{0};
+    };
+
+    /**
+     * @brief O(T^2) version of findDuplicateTracks, used for small track counts
+     * and as reference when cross checking merge decisions.
+     *
+     */
+    inline size_t findDuplicateTracksBruteForce(
+        const std::vector<Eigen::Vector3f> &positions,
+        float min_dist,
+        std::vector<int> &duplicate_of)
+    {
+        duplicate_of.assign(positions.size(), -1);
+        size_t num_duplicates = 0;
+        for (int i = static_cast<int>(positions.size()) - 1; i >= 0; --i)
+        {
+            for (int j = i - 1; j >= 0; --j)
+            {
+                if ((positions[i] - positions[j]).norm() < min_dist)
+                {
+                    duplicate_of[i] = j;
+                    num_duplicates++;
+                    break;
+                }
+            }
+        }
+        return num_duplicates;
+    }
+
+    /**
+     * @brief Find duplicated tracks. positions must be ordered by priority
+     * (oldest track first), track i is a duplicate if any track j < i lies closer
+     * than min_dist. duplicate_of[i] is set to the largest such j, -1 otherwise.
+     * Only tracks in neighbouring cells of the spatial hash are compared.
+     *
+     * @param positions
+     * @param min_dist
+     * @param hash scratch hash, reused across frames
+     * @param duplicate_of
+     * @return size_t number of duplicates
+     */
+    inline size_t findDuplicateTracks(
+        const std::vector<Eigen::Vector3f> &positions,
+        float min_dist,
+        TrackSpatialHash &hash,
+        std::vector<int> &duplicate_of)
+    {
+        duplicate_of.assign(positions.size(), -1);
+        if (!(min_dist > 0.0f) || positions.size() < 2)
+        {
+            return 0;
+        }
+        // Building the hash does not pay off for a handful of tracks
+        if (positions.size() < 400)
+        {
+            return findDuplicateTracksBruteForce(positions, min_dist, duplicate_of);
+        }
+        hash.build(positions, min_dist);
+
+        size_t num_duplicates = 0;
+        for (int i = 0; i < static_cast<int>(positions.size()); ++i)
+        {
+            int best = -1;
+            hash.forEachNeighbour(
+                positions[i], [&](int j)
+                {
+                    if (j < i && j > best && (positions[i] - positions[j]).norm() < min_dist)
+                    {
+                        best = j;
+                    } });
+            duplicate_of[i] = best;
+            num_duplicates += (best != -1);
+        }
+        return num_duplicates;
+    }
+
+} // namespace vox_nav_misc
+
+#endif // VOX_NAV_MISC__TRACK_STORE_HPP_
@@ -0,0 +1,53 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_MISC__TRAVERSABILITY_COST_PARAMS_HPP_
+#define VOX_NAV_MISC__TRAVERSABILITY_COST_PARAMS_HPP_
+
+#include <vector>
+
+namespace vox_nav_misc
+{
+struct CostRegressionParams
+{
+  double uniform_sample_radius;
+  double surfel_radius;
+  double max_allowed_tilt;
+  double max_allowed_point_deviation;
+  double max_allowed_energy_gap;
+  double node_elevation_distance;
+  double plane_fit_threshold;
+  double robot_mass;
+  double average_speed;
+  double max_color_range;
+  std::vector<double> cost_critic_weights;
+  CostRegressionParams()
+    : uniform_sample_radius(0.2)
+    , surfel_radius(0.1)
+    , max_allowed_tilt(10)
+    , max_allowed_point_deviation(0.1)
+    , max_allowed_energy_gap(0.1)
+    , node_elevation_distance(1)
+    , plane_fit_threshold(10)
+    , robot_mass(0.1)
+    , average_speed(0.1)
+    , max_color_range(255.0)
+    , cost_critic_weights({ 0.33, 0.33, 0.33 })
+  {
+  }
+};
+
+}  // namespace vox_nav_misc
+
+#endif  // VOX_NAV_MISC__TRAVERSABILITY_COST_PARAMS_HPP_
@@ -35,41 +35,17 @@
 #include <vox_nav_utilities/tf_helpers.hpp>
 #include <vox_nav_utilities/map_manager_helpers.hpp>
 
+#include "vox_nav_misc/cloud_recorder.hpp"
+#include "vox_nav_misc/elevation_grid_traversability.hpp"
+#include "vox_nav_misc/rolling_traversability_grid.hpp"
+#include "vox_nav_misc/traversability_cost_params.hpp"
+
 namespace vox_nav_misc
 {
-struct CostRegressionParams
-{
-  double uniform_sample_radius;
-  double surfel_radius;
-  double max_allowed_tilt;
-  double max_allowed_point_deviation;
-  double max_allowed_energy_gap;
-  double node_elevation_distance;
-  double plane_fit_threshold;
-  double robot_mass;
-  double average_speed;
-  double max_color_range;
-  std::vector<double> cost_critic_weights;
-  CostRegressionParams()
-    : uniform_sample_radius(0.2)
-    , surfel_radius(0.1)
-    , max_allowed_tilt(10)
-    , max_allowed_point_deviation(0.1)
-    , max_allowed_energy_gap(0.1)
-    , node_elevation_distance(1)
-    , plane_fit_threshold(10)
-    , robot_mass(0.1)
-    , average_speed(0.1)
-    , max_color_range(255.0)
-    , cost_critic_weights({ 0.33, 0.33, 0.33 })
-  {
-  }
-};
-
 class TraversabilityEstimator : public rclcpp::Node
 {
 public:
-  TraversabilityEstimator();
+  explicit TraversabilityEstimator(const rclcpp::NodeOptions& options = rclcpp::NodeOptions());
 
   ~TraversabilityEstimator();
 
@@ -88,6 +64,18 @@ private:
   //  see the struct, it is used to keep cost regression params orginzed
   CostRegressionParams cost_params_;
 
+  // Incremental alternative to regressCosts, rolls with the robot
+  bool use_rolling_grid_;
+  std::unique_ptr<RollingTraversabilityGrid> rolling_grid_;
+
+  // Dense 2.5D alternative to regressCosts, recomputed from each scan with image filters
+  bool use_elevation_grid_;
+  std::unique_ptr<ElevationGridTraversability> elevation_grid_;
+
+  // Optional recording of input and cost regressed clouds, written off the callback thread
+  bool recording_enabled_;
+  std::unique_ptr<AsyncCloudRecorder<pcl::PointXYZRGB>> recorder_;
+
   pcl::PointCloud<pcl::PointXYZRGB>::Ptr regressCosts(const pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud,
                                                       const std_msgs::msg::Header& header);
 };
@@ -35,6 +35,7 @@ Credits to author: Simon Appel, https://github.com/appinho
 #include "vox_nav_utilities/map_manager_helpers.hpp"
 #include "vox_nav_utilities/pcl_helpers.hpp"
 #include "vox_nav_utilities/tf_helpers.hpp"
+#include "vox_nav_misc/ukf_tracking_core.hpp"
 #include "vox_nav_msgs/msg/object.hpp"
 #include "vox_nav_msgs/msg/object_array.hpp"
 #include "vision_msgs/msg/detection3_d_array.hpp"
@@ -50,79 +51,6 @@ Credits to author: Simon Appel, https://github.com/appinho
 namespace vox_nav_misc
 {
 
-    struct UKTrackerParameters
-    {
-        float da_ped_dist_pos;
-        float da_ped_dist_form;
-        float da_car_dist_pos;
-        float da_car_dist_form;
-        int tra_dim_z;
-        int tra_dim_x;
-        int tra_dim_x_aug;
-        float tra_std_lidar_x;
-        float tra_std_lidar_y;
-        float tra_std_acc;
-        float tra_std_yaw_rate;
-        float tra_lambda;
-        int tra_aging_bad;
-        float tra_occ_factor;
-        float tra_min_dist_between_tracks;
-        float p_init_x;
-        float p_init_y;
-        float p_init_v;
-        float p_init_yaw;
-        float p_init_yaw_rate;
-    };
-
-    struct History
-    {
-        int good_age;
-        int bad_age;
-        std::vector<Eigen::Vector3f> historic_positions;
-    };
-
-    struct Geometry
-    {
-        float width;
-        float length;
-        float height;
-        float roll;
-        float pitch;
-        float yaw;
-    };
-
-    struct Semantic
-    {
-        int id;
-        std::string name;
-        float confidence;
-    };
-
-    struct State
-    {
-        Eigen::VectorXd x;
-        float z;
-        Eigen::MatrixXd P;
-        Eigen::VectorXd x_aug;
-        Eigen::VectorXd P_aug;
-        Eigen::MatrixXd Xsig_pred;
-    };
-
-    struct Track
-    {
-        // Attributes
-        int id;
-        State sta;
-        Geometry geo;
-        Semantic sem;
-        History hist;
-        int r;
-        int g;
-        int b;
-        float prob_existence;
-        sensor_msgs::msg::PointCloud2 cluster;
-    };
-
     struct VizObject
     {
         visualization_msgs::msg::Marker cyl;
@@ -143,8 +71,9 @@ namespace vox_nav_misc
         /**
          * @brief Construct a new UKFTracker object
          *
+         * @param options
          */
-        UKFTracker();
+        explicit UKFTracker(const rclcpp::NodeOptions &options = rclcpp::NodeOptions());
 
         /**
          * @brief Destroy the UKFTracker object
@@ -179,36 +108,8 @@ namespace vox_nav_misc
         // Parameters
         UKTrackerParameters params_;
 
-        // Processing
-        bool is_initialized_;
-        int track_id_counter_;
-        int time_frame_;
-
-        // UKF
-        Eigen::MatrixXd R_laser_;
-        Eigen::VectorXd weights_;
-        std::vector<Track> tracks_;
-
-        // Prediction
-
-        void Prediction(const double delta_t);
-        void Update(const vox_nav_msgs::msg::ObjectArray &detected_objects);
-        void TrackManagement(const vox_nav_msgs::msg::ObjectArray &detected_objects);
-        void initTrack(const vox_nav_msgs::msg::Object &obj);
-
-        // Data Association members
-        std::vector<int> da_tracks_;
-        std::vector<int> da_objects_;
-
-        // Data Association functions
-        void GlobalNearestNeighbor(const vox_nav_msgs::msg::ObjectArray &detected_objects);
-        float CalculateDistance(const Track &track, const vox_nav_msgs::msg::Object &object);
-        float CalculateBoxMismatch(const Track &track, const vox_nav_msgs::msg::Object &object);
-        float CalculateEuclideanAndBoxOffset(
-            const Track &track,
-            const vox_nav_msgs::msg::Object &object);
-        float CalculateEuclideanDistanceBetweenTracks(const Track &t1, const Track &t2);
-        bool compareGoodAge(Track t1, Track t2);
+        // Tracking, built once the parameters are read
+        std::unique_ptr<UKFTrackingCore> tracker_;
     };
 
 } // namespace vox_nav_misc
@@ -0,0 +1,206 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+DISCLAIMER: some parts of code has been taken from; https://github.com/appinho/SARosPerceptionKitti
+Credits to author: Simon Appel, https://github.com/appinho
+*/
+
+#ifndef VOX_NAV_MISC__UKF_TRACKING_CORE_HPP_
+#define VOX_NAV_MISC__UKF_TRACKING_CORE_HPP_
+
+#include <rclcpp/logger.hpp>
+#include <rclcpp/logging.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include "vox_nav_misc/track_store.hpp"
+#include "vox_nav_msgs/msg/object.hpp"
+#include "vox_nav_msgs/msg/object_array.hpp"
+
+#include <vector>
+#include <string>
+
+#include <Eigen/Core>
+
+namespace vox_nav_misc
+{
+
+    struct UKTrackerParameters
+    {
+        float da_ped_dist_pos;
+        float da_ped_dist_form;
+        float da_car_dist_pos;
+        float da_car_dist_form;
+        int tra_dim_z;
+        int tra_dim_x;
+        int tra_dim_x_aug;
+        float tra_std_lidar_x;
+        float tra_std_lidar_y;
+        float tra_std_acc;
+        float tra_std_yaw_rate;
+        float tra_lambda;
+        int tra_aging_bad;
+        float tra_occ_factor;
+        float tra_min_dist_between_tracks;
+        float p_init_x;
+        float p_init_y;
+        float p_init_v;
+        float p_init_yaw;
+        float p_init_yaw_rate;
+    };
+
+    struct History
+    {
+        int good_age;
+        int bad_age;
+        std::vector<Eigen::Vector3f> historic_positions;
+    };
+
+    struct Geometry
+    {
+        float width;
+        float length;
+        float height;
+        float roll;
+        float pitch;
+        float yaw;
+    };
+
+    struct Semantic
+    {
+        int id;
+        std::string name;
+        float confidence;
+    };
+
+    struct State
+    {
+        Eigen::VectorXd x;
+        float z;
+        Eigen::MatrixXd P;
+        Eigen::VectorXd x_aug;
+        Eigen::VectorXd P_aug;
+        Eigen::MatrixXd Xsig_pred;
+    };
+
+    struct Track
+    {
+        // Attributes
+        int id;
+        State sta;
+        Geometry geo;
+        Semantic sem;
+        History hist;
+        int r;
+        int g;
+        int b;
+        float prob_existence;
+        sensor_msgs::msg::PointCloud2 cluster;
+    };
+
+    /**
+     * @brief UKF tracking of detected objects: predict, global nearest neighbor
+     * association, update and track management. Needs neither a node nor an
+     * initialized rclcpp context, the UKFTracker node feeds it with its
+     * subscription and offline tools drive it directly.
+     *
+     */
+    class UKFTrackingCore
+    {
+
+    public:
+        /**
+         * @brief Construct a new UKFTrackingCore object
+         *
+         * @param params
+         * @param logger association and track management warnings are logged to it
+         */
+        UKFTrackingCore(
+            const UKTrackerParameters &params,
+            const rclcpp::Logger &logger = rclcpp::get_logger("ukf_tracking_core"));
+
+        /**
+         * @brief Run one predict, associate, update and track management step
+         * on detections.
+         *
+         * @param detections
+         * @param dt seconds elapsed since the previous call
+         * @return vox_nav_msgs::msg::ObjectArray current tracks
+         */
+        vox_nav_msgs::msg::ObjectArray processDetections(
+            const vox_nav_msgs::msg::ObjectArray &detections, const double dt);
+
+        /**
+         * @brief Current tracks as message.
+         *
+         * @param header
+         * @return vox_nav_msgs::msg::ObjectArray
+         */
+        vox_nav_msgs::msg::ObjectArray getTracks(const std_msgs::msg::Header &header) const;
+
+        /**
+         * @brief Current tracks, in the order of getTracks()
+         *
+         * @return const TrackStore<Track>&
+         */
+        const TrackStore<Track> &tracks() const { return tracks_; }
+
+        // Number of processed detection frames
+        int frame() const { return time_frame_; }
+
+    private:
+        // Parameters
+        UKTrackerParameters params_;
+        rclcpp::Logger logger_;
+
+        // Processing
+        bool is_initialized_;
+        int track_id_counter_;
+        int time_frame_;
+
+        // UKF
+        Eigen::MatrixXd R_laser_;
+        Eigen::VectorXd weights_;
+        TrackStore<Track> tracks_;
+
+        // Scratch buffers for duplicate track search, reused across frames
+        TrackSpatialHash track_hash_;
+        std::vector<Eigen::Vector3f> track_positions_;
+        std::vector<int> duplicate_of_;
+
+        // Prediction
+
+        void Prediction(const double delta_t);
+        void Update(const vox_nav_msgs::msg::ObjectArray &detected_objects);
+        void TrackManagement(const vox_nav_msgs::msg::ObjectArray &detected_objects);
+        void initTrack(const vox_nav_msgs::msg::Object &obj);
+
+        // Data Association members
+        std::vector<int> da_tracks_;
+        std::vector<int> da_objects_;
+
+        // Data Association functions
+        void GlobalNearestNeighbor(const vox_nav_msgs::msg::ObjectArray &detected_objects);
+        float CalculateDistance(const Track &track, const vox_nav_msgs::msg::Object &object);
+        float CalculateBoxMismatch(const Track &track, const vox_nav_msgs::msg::Object &object);
+        float CalculateEuclideanAndBoxOffset(
+            const Track &track,
+            const vox_nav_msgs::msg::Object &object);
+        float CalculateEuclideanDistanceBetweenTracks(const Track &t1, const Track &t2);
+        bool compareGoodAge(Track t1, Track t2);
+    };
+
+} // namespace vox_nav_misc
+
+#endif // VOX_NAV_MISC__UKF_TRACKING_CORE_HPP_
@@ -0,0 +1,317 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_misc/elevation_grid_traversability.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace vox_nav_misc
+{
+namespace
+{
+// Sliding window sum of half width k over n strided elements, zero outside
+void slidingSum(double* data, int n, int stride, int k, std::vector<double>& line)
+{
+  line.resize(n);
+  for (int i = 0; i < n; ++i)
+  {
+    line[i] = data[i * stride];
+  }
+  double sum = 0.0;
+  for (int i = 0; i < std::min(k, n); ++i)
+  {
+    sum += line[i];
+  }
+  for (int i = 0; i < n; ++i)
+  {
+    if (i + k < n)
+    {
+      sum += line[i + k];
+    }
+    if (i - k - 1 >= 0)
+    {
+      sum -= line[i - k - 1];
+    }
+    data[i * stride] = sum;
+  }
+}
+
+// Sliding window min or max of half width k over n strided elements with a
+// monotonic queue of indices, amortized O(1) per element
+void slidingExtremum(float* data, int n, int stride, int k, bool take_max, std::vector<float>& line,
+                     std::vector<int>& queue)
+{
+  line.resize(n);
+  queue.resize(n);
+  for (int i = 0; i < n; ++i)
+  {
+    line[i] = data[i * stride];
+  }
+  auto dominates = [take_max](float a, float b) { return take_max ? a >= b : a <= b; };
+  int head = 0, tail = 0;
+  int next = 0;
+  for (int i = 0; i < n; ++i)
+  {
+    // push everything up to i + k
+    for (; next < n && next <= i + k; ++next)
+    {
+      while (tail > head && dominates(line[next], line[queue[tail - 1]]))
+      {
+        tail--;
+      }
+      queue[tail++] = next;
+    }
+    while (queue[head] < i - k)
+    {
+      head++;
+    }
+    data[i * stride] = line[queue[head]];
+  }
+}
+}  // namespace
+
+ElevationGridTraversability::ElevationGridTraversability(const ElevationGridParams& grid_params,
+                                                         const CostRegressionParams& cost_params)
+  : params_(grid_params), cost_params_(cost_params), origin_x_(0.0), origin_y_(0.0), z_ref_(0.0), rows_(0), cols_(0)
+{
+  window_cells_ = static_cast<int>(std::ceil(params_.window_radius / params_.resolution));
+}
+
+void ElevationGridTraversability::boxFilter(std::vector<double>& data) const
+{
+  for (int r = 0; r < rows_; ++r)
+  {
+    slidingSum(data.data() + static_cast<size_t>(r) * cols_, cols_, 1, window_cells_, line_);
+  }
+  for (int c = 0; c < cols_; ++c)
+  {
+    slidingSum(data.data() + c, rows_, cols_, window_cells_, line_);
+  }
+}
+
+void ElevationGridTraversability::extremumFilter(std::vector<float>& data, bool take_max) const
+{
+  std::vector<int> queue;
+  for (int r = 0; r < rows_; ++r)
+  {
+    slidingExtremum(data.data() + static_cast<size_t>(r) * cols_, cols_, 1, window_cells_, take_max, line_f_, queue);
+  }
+  for (int c = 0; c < cols_; ++c)
+  {
+    slidingExtremum(data.data() + c, rows_, cols_, window_cells_, take_max, line_f_, queue);
+  }
+}
+
+bool ElevationGridTraversability::cellIndex(double x, double y, int& r, int& c) const
+{
+  c = static_cast<int>(std::floor((x - origin_x_) / params_.resolution));
+  r = static_cast<int>(std::floor((y - origin_y_) / params_.resolution));
+  return r >= 0 && r < rows_ && c >= 0 && c < cols_;
+}
+
+void ElevationGridTraversability::compute(const pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+{
+  // Bounding box and a reference height, sums of squares are taken relative to it
+  double min_x = std::numeric_limits<double>::max(), min_y = min_x;
+  double max_x = std::numeric_limits<double>::lowest(), max_y = max_x;
+  size_t num_finite = 0;
+  z_ref_ = 0.0;
+  for (const auto& p : cloud.points)
+  {
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+    {
+      continue;
+    }
+    min_x = std::min<double>(min_x, p.x);
+    min_y = std::min<double>(min_y, p.y);
+    max_x = std::max<double>(max_x, p.x);
+    max_y = std::max<double>(max_y, p.y);
+    z_ref_ += p.z;
+    num_finite++;
+  }
+  if (num_finite == 0)
+  {
+    rows_ = cols_ = 0;
+    return;
+  }
+  z_ref_ /= num_finite;
+  origin_x_ = min_x;
+  origin_y_ = min_y;
+  cols_ = static_cast<int>(std::floor((max_x - min_x) / params_.resolution)) + 1;
+  rows_ = static_cast<int>(std::floor((max_y - min_y) / params_.resolution)) + 1;
+  const size_t num_cells = static_cast<size_t>(rows_) * cols_;
+
+  count_.assign(num_cells, 0.0);
+  sum_x_.assign(num_cells, 0.0);
+  sum_y_.assign(num_cells, 0.0);
+  sum_z_.assign(num_cells, 0.0);
+  sum_zz_.assign(num_cells, 0.0);
+  min_z_.assign(num_cells, std::numeric_limits<float>::max());
+  max_z_.assign(num_cells, std::numeric_limits<float>::lowest());
+
+  // Single pass over the points
+  for (const auto& p : cloud.points)
+  {
+    int r, c;
+    if (!std::isfinite(p.z) || !cellIndex(p.x, p.y, r, c))
+    {
+      continue;
+    }
+    size_t i = static_cast<size_t>(r) * cols_ + c;
+    double z = p.z - z_ref_;
+    count_[i] += 1.0;
+    sum_x_[i] += p.x;
+    sum_y_[i] += p.y;
+    sum_z_[i] += z;
+    sum_zz_[i] += z * z;
+    min_z_[i] = std::min(min_z_[i], p.z);
+    max_z_[i] = std::max(max_z_[i], p.z);
+  }
+
+  // Window statistics, all separable
+  window_count_ = count_;
+  window_mean_z_ = sum_z_;
+  window_var_z_ = sum_zz_;
+  window_min_z_ = min_z_;
+  window_max_z_ = max_z_;
+  boxFilter(window_count_);
+  boxFilter(window_mean_z_);
+  boxFilter(window_var_z_);
+  extremumFilter(window_min_z_, false);
+  extremumFilter(window_max_z_, true);
+  for (size_t i = 0; i < num_cells; ++i)
+  {
+    if (window_count_[i] > 0.0)
+    {
+      double mean = window_mean_z_[i] / window_count_[i];
+      window_var_z_[i] = std::max(window_var_z_[i] / window_count_[i] - mean * mean, 0.0);
+      window_mean_z_[i] = mean;
+    }
+  }
+
+  // Points spread uniformly over the square window have this variance in x and in y
+  const double window_width = (2 * window_cells_ + 1) * params_.resolution;
+  const double window_var_xy = window_width * window_width / 12.0;
+  const double kinetic_energy = 0.5 * cost_params_.robot_mass * std::pow(cost_params_.average_speed, 2);
+
+  total_cost_.assign(num_cells, 0.0f);
+  traversable_.assign(num_cells, 0);
+  has_cost_.assign(num_cells, 0);
+
+  auto valid = [this](int r, int c) {
+    return r >= 0 && r < rows_ && c >= 0 && c < cols_ &&
+           window_count_[static_cast<size_t>(r) * cols_ + c] >= params_.min_points;
+  };
+  // Central difference of the window mean height, one sided at holes and borders
+  auto derivative = [&](int r, int c, int dr, int dc) {
+    size_t i = static_cast<size_t>(r) * cols_ + c;
+    bool fwd = valid(r + dr, c + dc), bwd = valid(r - dr, c - dc);
+    double zf = fwd ? window_mean_z_[i + dr * cols_ + dc] : window_mean_z_[i];
+    double zb = bwd ? window_mean_z_[i - dr * cols_ - dc] : window_mean_z_[i];
+    int steps = static_cast<int>(fwd) + static_cast<int>(bwd);
+    return steps ? (zf - zb) / (steps * params_.resolution) : 0.0;
+  };
+
+  for (int r = 0; r < rows_; ++r)
+  {
+    for (int c = 0; c < cols_; ++c)
+    {
+      size_t i = static_cast<size_t>(r) * cols_ + c;
+      if (count_[i] == 0.0 || window_count_[i] < params_.min_points)
+      {
+        continue;
+      }
+      double gx = derivative(r, c, 0, 1);
+      double gy = derivative(r, c, 1, 0);
+
+      // Same critics as TraversabilityEstimator::regressCosts. The plane normal
+      // is (-gx, -gy, 1), so roll and pitch from rpy_from_plane reduce to atan
+      double max_tilt = std::max(std::atan(std::abs(gy)), std::atan(std::abs(gx)));
+      // Remove what the slope contributes to the height variance over the window
+      double residual_var = std::max(window_var_z_[i] - (gx * gx + gy * gy) * window_var_xy, 0.0);
+      // Mean absolute deviation of a normal distribution is sigma * sqrt(2 / pi)
+      double average_point_deviation = std::sqrt(residual_var) * std::sqrt(2.0 / M_PI);
+      double max_energy_gap =
+          cost_params_.robot_mass * 9.82 * std::abs(window_max_z_[i] - window_min_z_[i]) + kinetic_energy;
+
+      double slope_cost = std::min(max_tilt / cost_params_.max_allowed_tilt, 1.0) * cost_params_.max_color_range;
+      double energy_gap_cost =
+          std::min(max_energy_gap / cost_params_.max_allowed_energy_gap, 1.0) * cost_params_.max_color_range;
+      double deviation_of_points_cost =
+          std::min(average_point_deviation / cost_params_.max_allowed_point_deviation, 1.0) *
+          cost_params_.max_color_range;
+
+      total_cost_[i] = cost_params_.cost_critic_weights[0] * slope_cost +
+                       cost_params_.cost_critic_weights[1] * deviation_of_points_cost +
+                       cost_params_.cost_critic_weights[2] * energy_gap_cost;
+      traversable_[i] = max_tilt <= cost_params_.max_allowed_tilt;
+      has_cost_[i] = 1;
+    }
+  }
+}
+
+bool ElevationGridTraversability::costAt(double x, double y, double& total_cost, bool& traversable) const
+{
+  int r, c;
+  if (!cellIndex(x, y, r, c))
+  {
+    return false;
+  }
+  size_t i = static_cast<size_t>(r) * cols_ + c;
+  if (!has_cost_[i])
+  {
+    return false;
+  }
+  total_cost = total_cost_[i];
+  traversable = traversable_[i];
+  return true;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr ElevationGridTraversability::getTraversableCloud() const
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  const size_t num_cells = static_cast<size_t>(rows_) * cols_;
+  cloud->points.reserve(num_cells);
+  for (size_t i = 0; i < num_cells; ++i)
+  {
+    if (!has_cost_[i])
+    {
+      continue;
+    }
+    pcl::PointXYZRGB p;
+    p.x = sum_x_[i] / count_[i];
+    p.y = sum_y_[i] / count_[i];
+    p.z = sum_z_[i] / count_[i] + z_ref_;
+    if (traversable_[i])
+    {
+      p.r = 0;
+      p.g = cost_params_.max_color_range - total_cost_[i];
+      p.b = total_cost_[i];
+    }
+    else
+    {
+      p.r = 255;
+      p.g = 0;
+      p.b = 0;
+    }
+    cloud->points.push_back(p);
+  }
+  cloud->width = cloud->points.size();
+  cloud->height = 1;
+  return cloud;
+}
+
+}  // namespace vox_nav_misc
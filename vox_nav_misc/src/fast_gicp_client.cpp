@@ -13,19 +13,22 @@
 // limitations under the License.
 
 #include "vox_nav_misc/fast_gicp_client.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 namespace vox_nav_misc
 {
 
-FastGICPClient::FastGICPClient() : Node("fast_gicp_client_rclcpp_node")
+FastGICPClient::FastGICPClient(const rclcpp::NodeOptions& options) : Node("fast_gicp_client_rclcpp_node", options)
 {
   live_cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
       "/ouster/points", rclcpp::SensorDataQoS(),
       std::bind(&FastGICPClient::liveCloudCallback, this, std::placeholders::_1));
 
+  rclcpp::SubscriptionOptions intra_process_options;
+  intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   map_cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
       "vox_nav/map_server/octomap_pointcloud", rclcpp::SensorDataQoS(),
-      std::bind(&FastGICPClient::mapCloudCallback, this, std::placeholders::_1));
+      std::bind(&FastGICPClient::mapCloudCallback, this, std::placeholders::_1), intra_process_options);
 
   gps_odom_subscriber_ = this->create_subscription<nav_msgs::msg::Odometry>(
       "odometry/gps", rclcpp::SensorDataQoS(),
@@ -159,7 +162,10 @@ void FastGICPClient::liveCloudCallback(const sensor_msgs::msg::PointCloud2::Cons
     reg->setMaximumIterations(params_.max_icp_iter);
     reg->setInputSource(croppped_live_cloud);
     reg->setInputTarget(croppped_map_cloud);
-    reg->align(*aligned);
+    {
+      VOX_NAV_TRACE_SCOPE("registration", "perception");
+      reg->align(*aligned);
+    }
 
     auto res_transformation = reg->getFinalTransformation();
 
@@ -201,17 +207,18 @@ void FastGICPClient::liveCloudCallback(const sensor_msgs::msg::PointCloud2::Cons
     icp_pose.pose.pose = a.pose;
     base_to_map_pose_pub_->publish(icp_pose);
 
-    sensor_msgs::msg::PointCloud2 live_cloud_crop_msg, map_cloud_crop_msg;
+    auto live_cloud_crop_msg = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    auto map_cloud_crop_msg = std::make_unique<sensor_msgs::msg::PointCloud2>();
 
-    pcl::toROSMsg(*aligned, live_cloud_crop_msg);
-    pcl::toROSMsg(*croppped_map_cloud, map_cloud_crop_msg);
-    live_cloud_crop_msg.header = cloud->header;
-    live_cloud_crop_msg.header.frame_id = "base_link";
-    map_cloud_crop_msg.header = cloud->header;
-    map_cloud_crop_msg.header.frame_id = "base_link";
+    pcl::toROSMsg(*aligned, *live_cloud_crop_msg);
+    pcl::toROSMsg(*croppped_map_cloud, *map_cloud_crop_msg);
+    live_cloud_crop_msg->header = cloud->header;
+    live_cloud_crop_msg->header.frame_id = "base_link";
+    map_cloud_crop_msg->header = cloud->header;
+    map_cloud_crop_msg->header.frame_id = "base_link";
 
-    live_cloud_pub_->publish(live_cloud_crop_msg);
-    map_cloud_pub_->publish(map_cloud_crop_msg);
+    live_cloud_pub_->publish(std::move(live_cloud_crop_msg));
+    map_cloud_pub_->publish(std::move(map_cloud_crop_msg));
 
     last_transform_estimate_ = res_transformation;
 
@@ -277,11 +284,5 @@ pcl::Registration<pcl::PointXYZ, pcl::PointXYZ>::Ptr FastGICPClient::createRegis
 
 }  // namespace vox_nav_misc
 
-int main(int argc, char const* argv[])
-{
-  rclcpp::init(argc, argv);
-  auto node = std::make_shared<vox_nav_misc::FastGICPClient>();
-  rclcpp::spin(node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_misc::FastGICPClient)
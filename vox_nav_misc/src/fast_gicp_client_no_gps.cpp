@@ -13,19 +13,22 @@
 // limitations under the License.
 
 #include "vox_nav_misc/fast_gicp_client_no_gps.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 namespace vox_nav_misc
 {
 
-FastGICPClientNoGPS::FastGICPClientNoGPS() : Node("fast_gicp_client_rclcpp_node")
+FastGICPClientNoGPS::FastGICPClientNoGPS(const rclcpp::NodeOptions& options) : Node("fast_gicp_client_rclcpp_node", options)
 {
   live_cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
       "/ouster/points", rclcpp::SensorDataQoS(),
       std::bind(&FastGICPClientNoGPS::liveCloudCallback, this, std::placeholders::_1));
 
+  rclcpp::SubscriptionOptions intra_process_options;
+  intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   map_cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
       "vox_nav/map_server/octomap_pointcloud", rclcpp::SensorDataQoS(),
-      std::bind(&FastGICPClientNoGPS::mapCloudCallback, this, std::placeholders::_1));
+      std::bind(&FastGICPClientNoGPS::mapCloudCallback, this, std::placeholders::_1), intra_process_options);
 
   // reliable qos with keep last 5
   auto qos = rclcpp::QoS(rclcpp::KeepLast(5)).reliable();
@@ -165,7 +168,10 @@ void FastGICPClientNoGPS::liveCloudCallback(const sensor_msgs::msg::PointCloud2:
     reg->setInputSource(croppped_live_cloud);
     reg->setInputTarget(croppped_map_cloud);
 
-    reg->align(*aligned);
+    {
+      VOX_NAV_TRACE_SCOPE("registration", "perception");
+      reg->align(*aligned);
+    }
 
     auto res_transformation = reg->getFinalTransformation();
 
@@ -192,18 +198,19 @@ void FastGICPClientNoGPS::liveCloudCallback(const sensor_msgs::msg::PointCloud2:
     icp_pose.pose.pose = resulting_pose.pose;
     base_to_map_pose_pub_->publish(icp_pose);
 
-    sensor_msgs::msg::PointCloud2 live_cloud_crop_msg, map_cloud_crop_msg;
+    auto live_cloud_crop_msg = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    auto map_cloud_crop_msg = std::make_unique<sensor_msgs::msg::PointCloud2>();
 
-    pcl::toROSMsg(*aligned, live_cloud_crop_msg);
-    pcl::toROSMsg(*croppped_map_cloud, map_cloud_crop_msg);
+    pcl::toROSMsg(*aligned, *live_cloud_crop_msg);
+    pcl::toROSMsg(*croppped_map_cloud, *map_cloud_crop_msg);
 
-    live_cloud_crop_msg.header = cloud->header;
-    live_cloud_crop_msg.header.frame_id = "map";
-    map_cloud_crop_msg.header = cloud->header;
-    map_cloud_crop_msg.header.frame_id = "map";
+    live_cloud_crop_msg->header = cloud->header;
+    live_cloud_crop_msg->header.frame_id = "map";
+    map_cloud_crop_msg->header = cloud->header;
+    map_cloud_crop_msg->header.frame_id = "map";
 
-    live_cloud_pub_->publish(live_cloud_crop_msg);
-    map_cloud_pub_->publish(map_cloud_crop_msg);
+    live_cloud_pub_->publish(std::move(live_cloud_crop_msg));
+    map_cloud_pub_->publish(std::move(map_cloud_crop_msg));
 
     // initial_pose_->pose = resulting_pose.pose;
 
@@ -262,11 +269,5 @@ pcl::Registration<pcl::PointXYZ, pcl::PointXYZ>::Ptr FastGICPClientNoGPS::create
 }
 }  // namespace vox_nav_misc
 
-int main(int argc, char const* argv[])
-{
-  rclcpp::init(argc, argv);
-  auto node = std::make_shared<vox_nav_misc::FastGICPClientNoGPS>();
-  rclcpp::spin(node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_misc::FastGICPClientNoGPS)
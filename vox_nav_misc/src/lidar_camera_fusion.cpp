@@ -0,0 +1,122 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_misc/lidar_camera_fusion.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <limits>
+
+#include <Eigen/Core>
+
+namespace vox_nav_misc
+{
+LidarCameraFusion::LidarCameraFusion(const LidarCameraFusionParams& params)
+  : params_(params), colorized_cloud_(new pcl::PointCloud<pcl::PointXYZRGB>)
+{
+}
+
+void LidarCameraFusion::fillHoles(int width, int height)
+{
+  // Separable min filter of the sparse depth, a hole takes the nearest depth
+  // around it so that foreground edges are not smeared into the background.
+  // Each pass takes the minimum over shifted copies of whole rows with Eigen
+  // arrays, which keeps memory access contiguous and explicitly vectorized
+  using RowMap = Eigen::Map<Eigen::ArrayXf>;
+  using ConstRowMap = Eigen::Map<const Eigen::ArrayXf>;
+  const float inf = std::numeric_limits<float>::infinity();
+  const int k = params_.hole_filling_radius;
+  rows_filtered_.assign(depth_image_.size(), inf);
+  for (int r = 0; r < height; ++r)
+  {
+    ConstRowMap in(depth_image_.data() + static_cast<size_t>(r) * width, width);
+    RowMap out(rows_filtered_.data() + static_cast<size_t>(r) * width, width);
+    for (int dc = -k; dc <= k; ++dc)
+    {
+      const int begin = std::max(0, -dc), length = width - std::abs(dc);
+      if (length > 0)
+      {
+        out.segment(begin, length) = out.segment(begin, length).min(in.segment(begin + dc, length));
+      }
+    }
+  }
+  dilated_.assign(depth_image_.size(), inf);
+  for (int r = 0; r < height; ++r)
+  {
+    RowMap out(dilated_.data() + static_cast<size_t>(r) * width, width);
+    for (int n = std::max(r - k, 0); n <= std::min(r + k, height - 1); ++n)
+    {
+      out = out.min(ConstRowMap(rows_filtered_.data() + static_cast<size_t>(n) * width, width));
+    }
+  }
+  RowMap depth(depth_image_.data(), depth_image_.size());
+  depth = (depth == inf).select(RowMap(dilated_.data(), dilated_.size()), depth);
+}
+
+void LidarCameraFusion::fuse(const LidarCameraProjector& projector, const CloudSoA& cloud, const std::uint8_t* image,
+                             size_t image_step)
+{
+  const int width = projector.width();
+  const int height = projector.height();
+
+  // Depth image, empty pixels are +inf in the depth buffer and 0 in the output
+  depth_image_ = projector.depthBuffer();
+  if (params_.hole_filling_radius > 0)
+  {
+    fillHoles(width, height);
+  }
+  Eigen::Map<Eigen::ArrayXf> depth(depth_image_.data(), depth_image_.size());
+  depth = (depth == std::numeric_limits<float>::infinity()).select(0.0f, depth);
+
+  // Colorized cloud and validity flags, same order and layout as the input cloud
+  const size_t n = cloud.size();
+  const auto& pixels = projector.pointPixels();
+  const auto& point_depths = projector.pointDepths();
+  const auto& depth_buffer = projector.depthBuffer();
+  point_flags_.assign(n, 0);
+  // Reuse the previous cloud unless a caller still holds on to it
+  if (colorized_cloud_.use_count() > 1)
+  {
+    colorized_cloud_.reset(new pcl::PointCloud<pcl::PointXYZRGB>);
+  }
+  colorized_cloud_->points.resize(n);
+  colorized_cloud_->width = cloud.width;
+  colorized_cloud_->height = cloud.height;
+  colorized_cloud_->is_dense = false;
+  for (size_t i = 0; i < n; ++i)
+  {
+    auto& p = colorized_cloud_->points[i];
+    p.x = cloud.x[i];
+    p.y = cloud.y[i];
+    p.z = cloud.z[i];
+    p.r = p.g = p.b = 0;
+    const int pixel = pixels[i];
+    if (pixel < 0)
+    {
+      continue;
+    }
+    point_flags_[i] = FUSION_IN_IMAGE;
+    if (point_depths[i] > depth_buffer[pixel] + params_.occlusion_tolerance)
+    {
+      continue;
+    }
+    point_flags_[i] |= FUSION_VISIBLE;
+    const std::uint8_t* rgb = image + static_cast<size_t>(pixel / width) * image_step + (pixel % width) * 3;
+    p.r = rgb[0];
+    p.g = rgb[1];
+    p.b = rgb[2];
+  }
+}
+
+}  // namespace vox_nav_misc
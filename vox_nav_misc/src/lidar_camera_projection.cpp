@@ -0,0 +1,234 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_misc/lidar_camera_projection.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace vox_nav_misc
+{
+namespace
+{
+const sensor_msgs::msg::PointField* findField(const sensor_msgs::msg::PointCloud2& msg, const std::string& name)
+{
+  for (const auto& field : msg.fields)
+  {
+    if (field.name == name)
+    {
+      return &field;
+    }
+  }
+  return nullptr;
+}
+
+std::uint32_t floatFieldOffset(const sensor_msgs::msg::PointCloud2& msg, const std::string& name)
+{
+  auto field = findField(msg, name);
+  if (!field || field->datatype != sensor_msgs::msg::PointField::FLOAT32)
+  {
+    throw std::runtime_error("PointCloud2 has no FLOAT32 field " + name);
+  }
+  return field->offset;
+}
+
+bool hostIsBigEndian()
+{
+  const std::uint16_t one = 1;
+  std::uint8_t first_byte;
+  std::memcpy(&first_byte, &one, 1);
+  return first_byte == 0;
+}
+
+// Every point has to lie inside data, fields are read with native byte order
+void checkLayout(const sensor_msgs::msg::PointCloud2& msg, std::uint32_t last_field_end)
+{
+  if (msg.is_bigendian != hostIsBigEndian())
+  {
+    throw std::runtime_error("PointCloud2 byte order differs from the host byte order");
+  }
+  if (msg.width == 0 || msg.height == 0)
+  {
+    return;
+  }
+  if (msg.point_step < last_field_end)
+  {
+    throw std::runtime_error("PointCloud2 point_step " + std::to_string(msg.point_step) +
+                             " is smaller than its fields");
+  }
+  if (msg.row_step < static_cast<size_t>(msg.width) * msg.point_step)
+  {
+    throw std::runtime_error("PointCloud2 row_step " + std::to_string(msg.row_step) + " is smaller than width " +
+                             std::to_string(msg.width) + " * point_step " + std::to_string(msg.point_step));
+  }
+  if (msg.data.size() < static_cast<size_t>(msg.row_step) * msg.height)
+  {
+    throw std::runtime_error("PointCloud2 has " + std::to_string(msg.data.size()) +
+                             " bytes of data, row_step * height is " +
+                             std::to_string(static_cast<size_t>(msg.row_step) * msg.height));
+  }
+}
+}  // namespace
+
+void pointCloud2ToSoA(const sensor_msgs::msg::PointCloud2& msg, CloudSoA& soa)
+{
+  const std::uint32_t x_offset = floatFieldOffset(msg, "x");
+  const std::uint32_t y_offset = floatFieldOffset(msg, "y");
+  const std::uint32_t z_offset = floatFieldOffset(msg, "z");
+  auto rgb_field = findField(msg, "rgb");
+  if (!rgb_field)
+  {
+    rgb_field = findField(msg, "rgba");
+  }
+  std::uint32_t last_field_end = std::max({ x_offset, y_offset, z_offset }) + sizeof(float);
+  if (rgb_field)
+  {
+    last_field_end = std::max<std::uint32_t>(last_field_end, rgb_field->offset + sizeof(std::uint32_t));
+  }
+  checkLayout(msg, last_field_end);
+
+  const size_t n = static_cast<size_t>(msg.width) * msg.height;
+  soa.resize(n);
+  soa.width = msg.width;
+  soa.height = msg.height;
+  const std::uint8_t* data = msg.data.data();
+  for (std::uint32_t row = 0; row < msg.height; ++row)
+  {
+    const std::uint8_t* point = data + static_cast<size_t>(row) * msg.row_step;
+    size_t i = static_cast<size_t>(row) * msg.width;
+    for (std::uint32_t col = 0; col < msg.width; ++col, ++i, point += msg.point_step)
+    {
+      // memcpy keeps this free of unaligned and aliasing issues and compiles to plain loads
+      std::memcpy(&soa.x[i], point + x_offset, sizeof(float));
+      std::memcpy(&soa.y[i], point + y_offset, sizeof(float));
+      std::memcpy(&soa.z[i], point + z_offset, sizeof(float));
+    }
+  }
+
+  if (rgb_field)
+  {
+    for (std::uint32_t row = 0; row < msg.height; ++row)
+    {
+      const std::uint8_t* point = data + static_cast<size_t>(row) * msg.row_step + rgb_field->offset;
+      size_t i = static_cast<size_t>(row) * msg.width;
+      for (std::uint32_t col = 0; col < msg.width; ++col, ++i, point += msg.point_step)
+      {
+        std::uint32_t rgb;
+        std::memcpy(&rgb, point, sizeof(rgb));
+        soa.rgb[i] = rgb & 0x00FFFFFF;
+      }
+    }
+  }
+  else
+  {
+    std::fill(soa.rgb.begin(), soa.rgb.end(), 0);
+  }
+}
+
+LidarCameraProjector::LidarCameraProjector(int image_width, int image_height)
+  : width_(image_width), height_(image_height), min_depth_(0.1f)
+{
+  P_.setZero();
+  P_.block<3, 3>(0, 0).setIdentity();
+}
+
+void LidarCameraProjector::setProjection(const Eigen::Matrix<float, 3, 4>& K, const Eigen::Matrix4f& T)
+{
+  P_ = K * T;
+}
+
+void LidarCameraProjector::setImageSize(int image_width, int image_height)
+{
+  if (image_width != width_ || image_height != height_)
+  {
+    width_ = image_width;
+    height_ = image_height;
+    depth_.clear();
+    pixel_point_.clear();
+    touched_pixels_.clear();
+  }
+}
+
+size_t LidarCameraProjector::project(const CloudSoA& cloud)
+{
+  const size_t n = cloud.size();
+  const size_t num_pixels = static_cast<size_t>(width_) * height_;
+  if (depth_.size() != num_pixels)
+  {
+    depth_.assign(num_pixels, std::numeric_limits<float>::infinity());
+    pixel_point_.assign(num_pixels, -1);
+    touched_pixels_.clear();
+  }
+  for (int pixel : touched_pixels_)
+  {
+    depth_[pixel] = std::numeric_limits<float>::infinity();
+    pixel_point_[pixel] = -1;
+  }
+  touched_pixels_.clear();
+
+  u_.resize(n);
+  v_.resize(n);
+  w_.resize(n);
+  point_pixel_.resize(n);
+
+  // Fused extrinsic and intrinsic projection, branch free over plain float
+  // arrays so that the compiler vectorizes it
+  const float p00 = P_(0, 0), p01 = P_(0, 1), p02 = P_(0, 2), p03 = P_(0, 3);
+  const float p10 = P_(1, 0), p11 = P_(1, 1), p12 = P_(1, 2), p13 = P_(1, 3);
+  const float p20 = P_(2, 0), p21 = P_(2, 1), p22 = P_(2, 2), p23 = P_(2, 3);
+  const float* x = cloud.x.data();
+  const float* y = cloud.y.data();
+  const float* z = cloud.z.data();
+  float* u = u_.data();
+  float* v = v_.data();
+  float* w = w_.data();
+  for (size_t i = 0; i < n; ++i)
+  {
+    float wi = p20 * x[i] + p21 * y[i] + p22 * z[i] + p23;
+    float inv_w = 1.0f / wi;
+    u[i] = (p00 * x[i] + p01 * y[i] + p02 * z[i] + p03) * inv_w;
+    v[i] = (p10 * x[i] + p11 * y[i] + p12 * z[i] + p13) * inv_w;
+    w[i] = wi;
+  }
+
+  // Depth test, nearest point of each pixel wins
+  const float width = static_cast<float>(width_);
+  const float height = static_cast<float>(height_);
+  for (size_t i = 0; i < n; ++i)
+  {
+    // NaN coordinates fail all of these comparisons
+    if (!(w[i] > min_depth_ && u[i] >= 0.0f && u[i] < width && v[i] >= 0.0f && v[i] < height))
+    {
+      point_pixel_[i] = -1;
+      continue;
+    }
+    int pixel = static_cast<int>(v[i]) * width_ + static_cast<int>(u[i]);
+    point_pixel_[i] = pixel;
+    if (w[i] < depth_[pixel])
+    {
+      if (pixel_point_[pixel] < 0)
+      {
+        touched_pixels_.push_back(pixel);
+      }
+      depth_[pixel] = w[i];
+      pixel_point_[pixel] = static_cast<int>(i);
+    }
+  }
+  return touched_pixels_.size();
+}
+
+}  // namespace vox_nav_misc
@@ -32,6 +32,15 @@ lidar_rgb_image_fuser::lidar_rgb_image_fuser() : rclcpp::Node("lidar_rgb_image_f
       std::bind(&lidar_rgb_image_fuser::ousterCamCallback, this, std::placeholders::_1, std::placeholders::_2));
 
   fusion_image_pub_ = this->create_publisher<sensor_msgs::msg::Image>("/ouster/image", 1);
+  depth_image_pub_ = this->create_publisher<sensor_msgs::msg::Image>("depth_image", 1);
+  colorized_cloud_pub_ = this->create_publisher<sensor_msgs::msg::PointCloud2>("colorized_points", 1);
+
+  LidarCameraFusionParams fusion_params;
+  declare_parameter("fusion.hole_filling_radius", fusion_params.hole_filling_radius);
+  declare_parameter("fusion.occlusion_tolerance", static_cast<double>(fusion_params.occlusion_tolerance));
+  fusion_params.hole_filling_radius = get_parameter("fusion.hole_filling_radius").as_int();
+  fusion_params.occlusion_tolerance = get_parameter("fusion.occlusion_tolerance").as_double();
+  fusion_ = std::make_unique<LidarCameraFusion>(fusion_params);
 
   // TODO: get these from yaml file
 
@@ -45,36 +54,16 @@ lidar_rgb_image_fuser::~lidar_rgb_image_fuser()
   RCLCPP_INFO(get_logger(), "lidar_rgb_image_fuser_rclcpp_node has shutdown.");
 }
 
-void lidar_rgb_image_fuser::transform3DPointsToImage(const Eigen::MatrixXf& points,  // NOLINT
-                                                     const Eigen::MatrixXf& TRANS_TO_IMAGE, Eigen::MatrixXf& uv)
-{
-  Eigen::MatrixXf image_points = TRANS_TO_IMAGE * points;
-  uv.row(0) = image_points.row(0).array() / image_points.row(2).array();
-  uv.row(1) = image_points.row(1).array() / image_points.row(2).array();
-  uv.row(2) = image_points.row(2);
-}
-
 void lidar_rgb_image_fuser::ousterCamCallback(const sensor_msgs::msg::Image::ConstSharedPtr& image,
                                               const sensor_msgs::msg::PointCloud2::ConstSharedPtr& cloud)
 {
-  // convert cloud to os_sensor if it is not already
-  sensor_msgs::msg::PointCloud2::SharedPtr output(new sensor_msgs::msg::PointCloud2);
-
-  if (cloud->header.frame_id != "os_sensor")
-  {
-    pcl_ros::transformPointCloud("os_sensor", *cloud, *output, *tf_buffer_);
-  }
-  else
-  {
-    output = std::make_shared<sensor_msgs::msg::PointCloud2>(*cloud);
-  }
-
-  // get the camera LIDAR extrinsic transformation
+  // get the camera LIDAR extrinsic transformation, straight from the cloud frame so that
+  // it is fused into the projection instead of transforming the cloud first
   try
   {
     geometry_msgs::msg::TransformStamped transform_stamped;
     transform_stamped =
-        tf_buffer_->lookupTransform(image->header.frame_id, output->header.frame_id, image->header.stamp);
+        tf_buffer_->lookupTransform(image->header.frame_id, cloud->header.frame_id, image->header.stamp);
     Eigen::Isometry3d eigenT = tf2::transformToEigen(transform_stamped.transform);
     T_ = eigenT.matrix().cast<float>();
   }
@@ -84,42 +73,15 @@ void lidar_rgb_image_fuser::ousterCamCallback(const sensor_msgs::msg::Image::Con
     return;
   }
 
-  Eigen::MatrixXf points = Eigen::MatrixXf::Zero(4, cloud->height * cloud->width);
-  Eigen::MatrixXf colors = Eigen::MatrixXf::Zero(3, cloud->height * cloud->width);
-
-  // Convert to pcl pointcloud XYZRGB
-  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pcl_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
-  // pcl::PointCloud<pcl::PointXYZI>::Ptr pcl_cloud(new pcl::PointCloud<pcl::PointXYZI>);
-
-  pcl::fromROSMsg(*output, *pcl_cloud);
-
-  int index_of_iterator = 0;
-  for (auto& point : pcl_cloud->points)
+  try
   {
-    // discard points with x < 0 (behind the sensor)
-    if (point.x < 0)
-    {
-      continue;
-    }
-    points(0, index_of_iterator) = point.x;
-    points(1, index_of_iterator) = point.y;
-    points(2, index_of_iterator) = point.z;
-    points(3, index_of_iterator) = 1;
-    colors(0, index_of_iterator) = point.r;
-    colors(1, index_of_iterator) = point.g;
-    colors(2, index_of_iterator) = point.b;
-
-    // colors(0, index_of_iterator) = point.intensity * 10;
-    // colors(1, index_of_iterator) = point.intensity;
-    // colors(2, index_of_iterator) = point.intensity * 10;
-
-    index_of_iterator++;
+    pointCloud2ToSoA(*cloud, cloud_soa_);
+  }
+  catch (const std::runtime_error& e)
+  {
+    RCLCPP_ERROR(get_logger(), "%s", e.what());
+    return;
   }
-
-  Eigen::MatrixXf uv = Eigen::MatrixXf::Zero(3, points.cols());
-  auto TRANS_TO_IMAGE = K_ * T_;
-
-  transform3DPointsToImage(points, TRANS_TO_IMAGE, uv);
 
   cv_bridge::CvImagePtr cv_ptr;
   try
@@ -132,23 +94,39 @@ void lidar_rgb_image_fuser::ousterCamCallback(const sensor_msgs::msg::Image::Con
     return;
   }
 
-  // Draw the points on the image
-  for (int i = 0; i < uv.cols(); i++)
+  // Project all points at once, points behind others on the same pixel are dropped
+  projector_.setImageSize(cv_ptr->image.cols, cv_ptr->image.rows);
+  projector_.setProjection(K_, T_);
+  projector_.project(cloud_soa_);
+
+  // Sample colors and depths from the same projection before the image is drawn on
+  fusion_->fuse(projector_, cloud_soa_, cv_ptr->image.data, cv_ptr->image.step);
+
+  cv_bridge::CvImage depth_image(image->header, sensor_msgs::image_encodings::TYPE_32FC1,
+                                 cv::Mat(cv_ptr->image.rows, cv_ptr->image.cols, CV_32FC1,
+                                         const_cast<float*>(fusion_->depthImage().data())));
+  depth_image_pub_->publish(*depth_image.toImageMsg());
+
+  sensor_msgs::msg::PointCloud2 colorized_cloud_msg;
+  pcl::toROSMsg(*fusion_->colorizedCloud(), colorized_cloud_msg);
+  colorized_cloud_msg.header = cloud->header;
+  colorized_cloud_pub_->publish(colorized_cloud_msg);
+
+  // Draw the visible points on the image
+  const auto& pixels = projector_.pointPixels();
+  for (size_t i = 0; i < cloud_soa_.size(); i++)
   {
-    int u = uv(0, i);
-    int v = uv(1, i);
-    if (u > 0 && u < cv_ptr->image.cols && v > 0 && v < cv_ptr->image.rows)
+    if (!projector_.visible(i))
     {
-      // get the color of the point from the pointcloud
-      auto r = colors(0, i);
-      auto g = colors(1, i);
-      auto b = colors(2, i);
-      // colorize based on point x y z
-      /*auto r = points(0, i) * 20;
-      auto g = points(1, i) * 0;
-      auto b = points(2, i) * 20;*/
-      cv::circle(cv_ptr->image, cv::Point(u, v), 2, cv::Scalar(r, g, b), 2);
+      continue;
     }
+    int u = pixels[i] % cv_ptr->image.cols;
+    int v = pixels[i] / cv_ptr->image.cols;
+    // get the color of the point from the pointcloud
+    auto r = (cloud_soa_.rgb[i] >> 16) & 0xFF;
+    auto g = (cloud_soa_.rgb[i] >> 8) & 0xFF;
+    auto b = cloud_soa_.rgb[i] & 0xFF;
+    cv::circle(cv_ptr->image, cv::Point(u, v), 2, cv::Scalar(r, g, b), 2);
   }
 
   // Publish the image
@@ -0,0 +1,399 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_misc/mot_evaluation.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <tuple>
+
+using namespace vox_nav_misc;
+
+namespace
+{
+    double normalizeAngle(double a)
+    {
+        while (a > M_PI)
+        {
+            a -= 2.0 * M_PI;
+        }
+        while (a < -M_PI)
+        {
+            a += 2.0 * M_PI;
+        }
+        return a;
+    }
+} // namespace
+
+MOTScenarioGenerator::MOTScenarioGenerator(const MOTScenarioConfig &config)
+    : config_(config),
+      rng_(config.seed),
+      next_id_(0)
+{
+}
+
+void MOTScenarioGenerator::spawn(GroundTruthObject &object, bool initial)
+{
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    const double L = config_.area_half_size;
+
+    object.id = next_id_++;
+    object.occluded = false;
+
+    // Position along the travel direction, anywhere in the area at start,
+    // otherwise on the entry edge
+    double along = initial ? (2.0 * unit(rng_) - 1.0) * L : -L;
+    bool along_x = unit(rng_) < 0.5;
+    double direction = unit(rng_) < 0.5 ? 1.0 : -1.0;
+
+    if (object.type == ScenarioObjectType::VEHICLE)
+    {
+        // Lanes are parallel to the axes, 3.5 m apart
+        double lane = (std::floor(unit(rng_) * 6.0) - 2.5) * 3.5;
+        object.v = 5.0 + 7.0 * unit(rng_);
+        object.yaw_rate = unit(rng_) < config_.ctrv_fraction ? (unit(rng_) - 0.5) * 0.3 : 0.0;
+        object.length = 4.5;
+        object.width = 1.8;
+        object.height = 1.5;
+        object.z = 0.75;
+        object.x = along_x ? direction * along : lane;
+        object.y = along_x ? lane : direction * along;
+        object.yaw = along_x ? (direction > 0 ? 0.0 : M_PI) : (direction > 0 ? M_PI_2 : -M_PI_2);
+    }
+    else
+    {
+        // Pedestrians cross the lanes at a random point
+        double offset = (2.0 * unit(rng_) - 1.0) * L;
+        object.v = 0.8 + 1.0 * unit(rng_);
+        object.yaw_rate = 0.0;
+        object.length = 0.6;
+        object.width = 0.6;
+        object.height = 1.7;
+        object.z = 0.85;
+        object.x = along_x ? direction * along : offset;
+        object.y = along_x ? offset : direction * along;
+        object.yaw = along_x ? (direction > 0 ? 0.0 : M_PI) : (direction > 0 ? M_PI_2 : -M_PI_2);
+        object.yaw = normalizeAngle(object.yaw + (unit(rng_) - 0.5) * 0.5);
+    }
+}
+
+void MOTScenarioGenerator::step(GroundTruthObject &object)
+{
+    const double dt = config_.dt;
+    if (std::fabs(object.yaw_rate) > 1e-3)
+    {
+        object.x += object.v / object.yaw_rate * (std::sin(object.yaw + object.yaw_rate * dt) - std::sin(object.yaw));
+        object.y += object.v / object.yaw_rate * (std::cos(object.yaw) - std::cos(object.yaw + object.yaw_rate * dt));
+    }
+    else
+    {
+        object.x += object.v * dt * std::cos(object.yaw);
+        object.y += object.v * dt * std::sin(object.yaw);
+    }
+    object.yaw = normalizeAngle(object.yaw + object.yaw_rate * dt);
+
+    // Leaving the area, replace it with a new object entering
+    const double L = config_.area_half_size;
+    if (std::fabs(object.x) > L || std::fabs(object.y) > L)
+    {
+        spawn(object, false);
+    }
+}
+
+void MOTScenarioGenerator::computeOcclusions(std::vector<GroundTruthObject> &objects) const
+{
+    for (auto &a : objects)
+    {
+        a.occluded = false;
+        double range_a = std::hypot(a.x, a.y);
+        double bearing_a = std::atan2(a.y, a.x);
+        for (const auto &b : objects)
+        {
+            double range_b = std::hypot(b.x, b.y);
+            if (&a == &b || range_b >= range_a || range_b < 1e-3)
+            {
+                continue;
+            }
+            double half_width_b = std::atan2(0.5 * std::max(b.length, b.width), range_b);
+            if (std::fabs(normalizeAngle(bearing_a - std::atan2(b.y, b.x))) < half_width_b)
+            {
+                a.occluded = true;
+                break;
+            }
+        }
+    }
+}
+
+vox_nav_msgs::msg::Object MOTScenarioGenerator::toDetection(
+    double x, double y, double z, double yaw,
+    double length, double width, double height)
+{
+    vox_nav_msgs::msg::Object object;
+    object.header.frame_id = "map";
+    object.pose.position.x = x;
+    object.pose.position.y = y;
+    object.pose.position.z = z;
+    object.pose.orientation.z = std::sin(0.5 * yaw);
+    object.pose.orientation.w = std::cos(0.5 * yaw);
+    object.shape.type = shape_msgs::msg::SolidPrimitive::BOX;
+    object.shape.dimensions = {length, width, height};
+    object.detection_level = vox_nav_msgs::msg::Object::OBJECT_DETECTED;
+    object.classification_label = vox_nav_msgs::msg::Object::CLASSIFICATION_UNKNOWN;
+    object.classification_probability = 1.0;
+    return object;
+}
+
+std::vector<MOTFrame> MOTScenarioGenerator::generate()
+{
+    rng_.seed(config_.seed);
+    next_id_ = 0;
+
+    std::vector<GroundTruthObject> objects(config_.num_vehicles + config_.num_pedestrians);
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        objects[i].type = i < static_cast<size_t>(config_.num_vehicles) ?
+                              ScenarioObjectType::VEHICLE :
+                              ScenarioObjectType::PEDESTRIAN;
+        spawn(objects[i], true);
+    }
+
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::uniform_real_distribution<double> area(-config_.area_half_size, config_.area_half_size);
+    std::normal_distribution<double> position_noise(0.0, config_.position_noise);
+    std::normal_distribution<double> size_noise(0.0, config_.size_noise);
+    std::poisson_distribution<int> clutter(config_.clutter_rate);
+
+    std::vector<MOTFrame> frames;
+    frames.reserve(config_.num_frames);
+    for (int f = 0; f < config_.num_frames; ++f)
+    {
+        if (f > 0)
+        {
+            for (auto &object : objects)
+            {
+                step(object);
+            }
+        }
+        computeOcclusions(objects);
+
+        MOTFrame frame;
+        frame.stamp = f * config_.dt;
+        frame.detections.header.frame_id = "map";
+        frame.detections.header.stamp.sec = static_cast<int32_t>(std::floor(frame.stamp));
+        frame.detections.header.stamp.nanosec =
+            static_cast<uint32_t>((frame.stamp - std::floor(frame.stamp)) * 1e9);
+
+        for (const auto &object : objects)
+        {
+            if (std::hypot(object.x, object.y) > config_.sensor_range)
+            {
+                continue;
+            }
+            frame.truth.push_back(object);
+            if (object.occluded || unit(rng_) > config_.detection_probability)
+            {
+                continue;
+            }
+            frame.detections.objects.push_back(
+                toDetection(
+                    object.x + position_noise(rng_), object.y + position_noise(rng_), object.z,
+                    object.yaw, object.length + size_noise(rng_), object.width + size_noise(rng_),
+                    object.height + size_noise(rng_)));
+        }
+
+        int num_clutter = clutter(rng_);
+        for (int c = 0; c < num_clutter; ++c)
+        {
+            double size = 0.3 + 1.5 * unit(rng_);
+            frame.detections.objects.push_back(
+                toDetection(area(rng_), area(rng_), 0.5, (unit(rng_) - 0.5) * 2.0 * M_PI, size, size, 1.0));
+        }
+        std::shuffle(frame.detections.objects.begin(), frame.detections.objects.end(), rng_);
+
+        frames.push_back(std::move(frame));
+    }
+    return frames;
+}
+
+MOTMetrics::MOTMetrics(double match_threshold)
+    : match_threshold_(match_threshold)
+{
+}
+
+const MOTFrameStats &MOTMetrics::update(
+    const std::vector<GroundTruthObject> &truth,
+    const vox_nav_msgs::msg::ObjectArray &tracks,
+    double latency_ms)
+{
+    MOTFrameStats stats{};
+    stats.frame = static_cast<int>(frames_.size());
+    stats.num_truth = static_cast<int>(truth.size());
+    stats.num_tracks = static_cast<int>(tracks.objects.size());
+    stats.latency_ms = latency_ms;
+
+    auto distance = [&](size_t g, size_t h)
+    {
+        return std::hypot(
+            truth[g].x - tracks.objects[h].pose.position.x,
+            truth[g].y - tracks.objects[h].pose.position.y);
+    };
+
+    std::vector<int> truth_to_track(truth.size(), -1);
+    std::vector<char> track_used(tracks.objects.size(), 0);
+
+    // Keep correspondences of the previous frame while they are still valid
+    for (size_t g = 0; g < truth.size(); ++g)
+    {
+        auto last = last_match_.find(truth[g].id);
+        if (last == last_match_.end())
+        {
+            continue;
+        }
+        for (size_t h = 0; h < tracks.objects.size(); ++h)
+        {
+            if (!track_used[h] && static_cast<int>(tracks.objects[h].id) == last->second &&
+                distance(g, h) < match_threshold_)
+            {
+                truth_to_track[g] = static_cast<int>(h);
+                track_used[h] = 1;
+                break;
+            }
+        }
+    }
+
+    // Greedy assignment of the rest by increasing distance
+    std::vector<std::tuple<double, size_t, size_t>> candidates;
+    for (size_t g = 0; g < truth.size(); ++g)
+    {
+        if (truth_to_track[g] != -1)
+        {
+            continue;
+        }
+        for (size_t h = 0; h < tracks.objects.size(); ++h)
+        {
+            double d = distance(g, h);
+            if (!track_used[h] && d < match_threshold_)
+            {
+                candidates.emplace_back(d, g, h);
+            }
+        }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (const auto &[d, g, h] : candidates)
+    {
+        if (truth_to_track[g] == -1 && !track_used[h])
+        {
+            truth_to_track[g] = static_cast<int>(h);
+            track_used[h] = 1;
+        }
+    }
+
+    for (size_t g = 0; g < truth.size(); ++g)
+    {
+        if (truth_to_track[g] == -1)
+        {
+            stats.misses++;
+            continue;
+        }
+        int h = truth_to_track[g];
+        int track_id = static_cast<int>(tracks.objects[h].id);
+        stats.matches++;
+        stats.distance_sum += distance(g, h);
+
+        auto last = last_match_.find(truth[g].id);
+        if (last != last_match_.end() && last->second != track_id)
+        {
+            stats.id_switches++;
+        }
+        last_match_[truth[g].id] = track_id;
+    }
+    stats.false_positives = stats.num_tracks - stats.matches;
+
+    frames_.push_back(stats);
+    return frames_.back();
+}
+
+double MOTMetrics::mota() const
+{
+    double errors = 0.0, num_truth = 0.0;
+    for (const auto &f : frames_)
+    {
+        errors += f.misses + f.false_positives + f.id_switches;
+        num_truth += f.num_truth;
+    }
+    return num_truth > 0.0 ? 1.0 - errors / num_truth : 0.0;
+}
+
+double MOTMetrics::motp() const
+{
+    double distance_sum = 0.0, matches = 0.0;
+    for (const auto &f : frames_)
+    {
+        distance_sum += f.distance_sum;
+        matches += f.matches;
+    }
+    return matches > 0.0 ? distance_sum / matches : 0.0;
+}
+
+int MOTMetrics::idSwitches() const
+{
+    int id_switches = 0;
+    for (const auto &f : frames_)
+    {
+        id_switches += f.id_switches;
+    }
+    return id_switches;
+}
+
+void MOTMetrics::writeFramesCSV(std::ostream &os) const
+{
+    os << "frame,num_truth,num_tracks,matches,false_positives,misses,id_switches,motp,latency_ms\n";
+    for (const auto &f : frames_)
+    {
+        os << f.frame << "," << f.num_truth << "," << f.num_tracks << "," << f.matches << ","
+           << f.false_positives << "," << f.misses << "," << f.id_switches << ","
+           << (f.matches > 0 ? f.distance_sum / f.matches : 0.0) << "," << f.latency_ms << "\n";
+    }
+}
+
+void MOTMetrics::writeSummaryCSV(std::ostream &os) const
+{
+    int num_truth = 0, matches = 0, false_positives = 0, misses = 0;
+    std::vector<double> latencies;
+    for (const auto &f : frames_)
+    {
+        num_truth += f.num_truth;
+        matches += f.matches;
+        false_positives += f.false_positives;
+        misses += f.misses;
+        latencies.push_back(f.latency_ms);
+    }
+    double mean_latency = 0.0, p95_latency = 0.0, max_latency = 0.0;
+    if (!latencies.empty())
+    {
+        for (double l : latencies)
+        {
+            mean_latency += l / latencies.size();
+        }
+        std::sort(latencies.begin(), latencies.end());
+        p95_latency = latencies[static_cast<size_t>(0.95 * (latencies.size() - 1))];
+        max_latency = latencies.back();
+    }
+
+    os << "frames,num_truth,matches,false_positives,misses,id_switches,mota,motp,"
+          "mean_latency_ms,p95_latency_ms,max_latency_ms\n";
+    os << frames_.size() << "," << num_truth << "," << matches << "," << false_positives << ","
+       << misses << "," << idSwitches() << "," << mota() << "," << motp() << ","
+       << mean_latency << "," << p95_latency << "," << max_latency << "\n";
+}
@@ -13,12 +13,13 @@
 // limitations under the License.
 
 #include "vox_nav_misc/naive_lidar_clustering.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 #include <geometry_msgs/msg/transform_stamped.hpp>
 
 using namespace vox_nav_misc;
 
-NaiveLIDARClustering::NaiveLIDARClustering()
-    : Node("cloud_clustering_rclcpp_node")
+NaiveLIDARClustering::NaiveLIDARClustering(const rclcpp::NodeOptions & options)
+    : Node("cloud_clustering_rclcpp_node", options)
 {
   cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
       "points",
@@ -27,8 +28,12 @@ NaiveLIDARClustering::NaiveLIDARClustering()
           &NaiveLIDARClustering::cloudCallback,
           this, std::placeholders::_1));
 
+  // Detections carry the cluster clouds, the tracker takes them intra-process when composed.
+  // Intra-process needs keep last and volatile, which the system defaults do not guarantee
+  rclcpp::PublisherOptions intra_process_options;
+  intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   detection_objects_pub_ = this->create_publisher<vox_nav_msgs::msg::ObjectArray>(
-      "detections", rclcpp::SystemDefaultsQoS());
+      "detections", rclcpp::QoS(rclcpp::KeepLast(10)).reliable(), intra_process_options);
 
   declare_parameter("clustering.x_bound",
                     clustering_params_.x_bound);
@@ -120,6 +125,7 @@ NaiveLIDARClustering::~NaiveLIDARClustering()
 void NaiveLIDARClustering::cloudCallback(
     const sensor_msgs::msg::PointCloud2::ConstSharedPtr cloud)
 {
+  VOX_NAV_TRACE_FUNCTION("perception");
   pcl::PointCloud<pcl::PointXYZI>::Ptr pcl_curr(new pcl::PointCloud<pcl::PointXYZI>());
   pcl::fromROSMsg(*cloud, *pcl_curr);
 
@@ -164,22 +170,26 @@ void NaiveLIDARClustering::cloudCallback(
       true);
 
   // Cluster the cloud with euclidean clustering
-  auto clusters = vox_nav_utilities::euclideanClustering<pcl::PointXYZI>(
-      pcl_curr,
-      clustering_params_.clustering_min_points,
-      clustering_params_.clustering_max_points,
-      clustering_params_.clustering_max_step_size);
+  std::vector<pcl::PointCloud<pcl::PointXYZI>::Ptr> clusters;
+  {
+    VOX_NAV_TRACE_SCOPE("clustering", "perception");
+    clusters = vox_nav_utilities::euclideanClustering<pcl::PointXYZI>(
+        pcl_curr,
+        clustering_params_.clustering_min_points,
+        clustering_params_.clustering_max_points,
+        clustering_params_.clustering_max_step_size);
+  }
   std_msgs::msg::Header header = cloud->header;
   header.frame_id = "map";
 
   // Populate the object array
-  vox_nav_msgs::msg::ObjectArray object_array;
+  auto object_array = std::make_unique<vox_nav_msgs::msg::ObjectArray>();
   for (auto &&cluster : clusters)
   {
     vox_nav_msgs::msg::Object object;
     object.header.frame_id = "map";
     object.header.stamp = cloud->header.stamp;
-    object.id = object_array.objects.size();
+    object.id = object_array->objects.size();
     object.detection_level = vox_nav_msgs::msg::Object::OBJECT_DETECTED;
     object.classification_label = vox_nav_msgs::msg::Object::CLASSIFICATION_UNKNOWN;
     object.classification_probability = 0.0;
@@ -204,18 +214,12 @@ void NaiveLIDARClustering::cloudCallback(
 
     // We dont know whether the object is dynamic or not
     object.is_dynamic = false;
-    object_array.header = object.header;
-    object_array.objects.push_back(object);
+    object_array->header = object.header;
+    object_array->objects.push_back(object);
   }
 
-  detection_objects_pub_->publish(object_array);
+  detection_objects_pub_->publish(std::move(object_array));
 }
 
-int main(int argc, char const *argv[])
-{
-  rclcpp::init(argc, argv);
-  auto node = std::make_shared<NaiveLIDARClustering>();
-  rclcpp::spin(node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_misc::NaiveLIDARClustering)
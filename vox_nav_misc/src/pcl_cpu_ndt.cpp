@@ -14,6 +14,7 @@
 
 
 #include "vox_nav_misc/pcl_cpu_ndt.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 #include <string>
 #include <vector>
@@ -22,8 +23,8 @@
 
 using namespace vox_nav_misc;
 
-PCLCPUNDT::PCLCPUNDT()
-: Node("pcl_cpu_ndt_rclcpp_node")
+PCLCPUNDT::PCLCPUNDT(const rclcpp::NodeOptions & options)
+: Node("pcl_cpu_ndt_rclcpp_node", options)
 {
 
   live_cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
@@ -32,11 +33,15 @@ PCLCPUNDT::PCLCPUNDT()
     std::bind(
       &PCLCPUNDT::liveCloudCallback, this, std::placeholders::_1));
 
+  // The map cloud is large, take it intra-process when composed with the map server
+  rclcpp::SubscriptionOptions intra_process_options;
+  intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
   map_cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
     "vox_nav/map_server/octomap_pointcloud",
     rclcpp::SensorDataQoS(),
     std::bind(
-      &PCLCPUNDT::mapCloudCallback, this, std::placeholders::_1));
+      &PCLCPUNDT::mapCloudCallback, this, std::placeholders::_1),
+    intra_process_options);
 
   gps_odom_subscriber_ = this->create_subscription<nav_msgs::msg::Odometry>(
     "odometry/gps",
@@ -186,7 +191,10 @@ void PCLCPUNDT::liveCloudCallback(
 
     // Calculating required rigid transform to align the input cloud to the target cloud.
     pcl::PointCloud<pcl::PointXYZRGB>::Ptr output_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
-    ndt.align(*output_cloud, Eigen::Matrix4f::Identity());
+    {
+      VOX_NAV_TRACE_SCOPE("registration", "perception");
+      ndt.align(*output_cloud, Eigen::Matrix4f::Identity());
+    }
 
     Eigen::Affine3f T;
     T.matrix() = ndt.getFinalTransformation();
@@ -218,17 +226,19 @@ void PCLCPUNDT::liveCloudCallback(
     icp_pose.pose.pose = a.pose;
     base_to_map_pose_pub_->publish(icp_pose);
 
-    sensor_msgs::msg::PointCloud2 live_cloud_crop_msg, map_cloud_crop_msg;
+    // Moved into the publishers, so subscribers in the same container get them without a copy
+    auto live_cloud_crop_msg = std::make_unique<sensor_msgs::msg::PointCloud2>();
+    auto map_cloud_crop_msg = std::make_unique<sensor_msgs::msg::PointCloud2>();
 
-    pcl::toROSMsg(*output_cloud, live_cloud_crop_msg);
-    pcl::toROSMsg(*croppped_map_cloud, map_cloud_crop_msg);
-    live_cloud_crop_msg.header = cloud->header;
-    live_cloud_crop_msg.header.frame_id = "base_link";
-    map_cloud_crop_msg.header = cloud->header;
-    map_cloud_crop_msg.header.frame_id = "base_link";
+    pcl::toROSMsg(*output_cloud, *live_cloud_crop_msg);
+    pcl::toROSMsg(*croppped_map_cloud, *map_cloud_crop_msg);
+    live_cloud_crop_msg->header = cloud->header;
+    live_cloud_crop_msg->header.frame_id = "base_link";
+    map_cloud_crop_msg->header = cloud->header;
+    map_cloud_crop_msg->header.frame_id = "base_link";
 
-    live_cloud_pub_->publish(live_cloud_crop_msg);
-    map_cloud_pub_->publish(map_cloud_crop_msg);
+    live_cloud_pub_->publish(std::move(live_cloud_crop_msg));
+    map_cloud_pub_->publish(std::move(map_cloud_crop_msg));
 
     last_transform_estimate_ = ndt.getFinalTransformation();
 
@@ -256,11 +266,5 @@ void PCLCPUNDT::mapCloudCallback(
     });
 }
 
-int main(int argc, char const * argv[])
-{
-  rclcpp::init(argc, argv);
-  auto node = std::make_shared<PCLCPUNDT>();
-  rclcpp::spin(node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_misc::PCLCPUNDT)
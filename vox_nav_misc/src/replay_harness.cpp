@@ -0,0 +1,473 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_misc/replay_harness.hpp"
+
+#include <pcl/io/pcd_io.h>
+#include <pcl/PCLPointCloud2.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace vox_nav_misc
+{
+namespace
+{
+// Parses a csv line of numbers, returns false for a header or a malformed line
+bool parseCsvLine(const std::string& line, size_t expected, int64_t& stamp_ns, std::vector<double>& values)
+{
+  std::stringstream ss(line);
+  std::string cell;
+  values.clear();
+  if (!std::getline(ss, cell, ','))
+  {
+    return false;
+  }
+  try
+  {
+    size_t consumed = 0;
+    stamp_ns = std::stoll(cell, &consumed);
+    if (consumed != cell.size())
+    {
+      return false;
+    }
+    while (std::getline(ss, cell, ','))
+    {
+      values.push_back(std::stod(cell));
+    }
+  }
+  catch (const std::exception&)
+  {
+    return false;
+  }
+  return values.size() == expected;
+}
+
+template <typename SampleT>
+std::vector<SampleT> readCsv(const std::string& path, size_t expected,
+                             void (*fill)(SampleT&, const std::vector<double>&))
+{
+  std::vector<SampleT> samples;
+  std::ifstream file(path);
+  if (!file)
+  {
+    return samples;
+  }
+  std::string line;
+  int64_t stamp_ns;
+  std::vector<double> values;
+  size_t line_number = 0;
+  while (std::getline(file, line))
+  {
+    line_number++;
+    if (line.empty())
+    {
+      continue;
+    }
+    if (!parseCsvLine(line, expected, stamp_ns, values))
+    {
+      if (line_number == 1)
+      {
+        continue;  // header
+      }
+      throw std::runtime_error("Malformed line " + std::to_string(line_number) + " in " + path);
+    }
+    SampleT sample;
+    sample.stamp_ns = stamp_ns;
+    fill(sample, values);
+    samples.push_back(sample);
+  }
+  std::stable_sort(samples.begin(), samples.end(),
+                   [](const SampleT& a, const SampleT& b) { return a.stamp_ns < b.stamp_ns; });
+  return samples;
+}
+
+void fillImu(ReplayImuSample& s, const std::vector<double>& v)
+{
+  s.orientation = Eigen::Quaterniond(v[3], v[0], v[1], v[2]);
+  s.angular_velocity = Eigen::Vector3d(v[4], v[5], v[6]);
+  s.linear_acceleration = Eigen::Vector3d(v[7], v[8], v[9]);
+}
+
+void fillOdom(ReplayOdomSample& s, const std::vector<double>& v)
+{
+  s.position = Eigen::Vector3d(v[0], v[1], v[2]);
+  s.orientation = Eigen::Quaterniond(v[6], v[3], v[4], v[5]);
+  s.linear_velocity = Eigen::Vector3d(v[7], v[8], v[9]);
+  s.angular_velocity = Eigen::Vector3d(v[10], v[11], v[12]);
+}
+
+builtin_interfaces::msg::Time toStamp(int64_t stamp_ns)
+{
+  return rclcpp::Time(stamp_ns, RCL_ROS_TIME);
+}
+}  // namespace
+
+ReplayDataset loadReplayDataset(const std::string& directory)
+{
+  namespace fs = std::filesystem;
+  ReplayDataset dataset;
+  fs::path root(directory);
+  fs::path clouds_dir = root / "clouds";
+  if (!fs::is_directory(clouds_dir))
+  {
+    throw std::runtime_error("No clouds directory in " + directory);
+  }
+  for (const auto& entry : fs::directory_iterator(clouds_dir))
+  {
+    if (entry.path().extension() != ".pcd")
+    {
+      continue;
+    }
+    try
+    {
+      dataset.clouds.emplace_back(std::stoll(entry.path().stem().string()), entry.path().string());
+    }
+    catch (const std::exception&)
+    {
+      throw std::runtime_error("Cloud file name is not a stamp in nanoseconds: " + entry.path().string());
+    }
+  }
+  if (dataset.clouds.empty())
+  {
+    throw std::runtime_error("No clouds in " + clouds_dir.string());
+  }
+  std::sort(dataset.clouds.begin(), dataset.clouds.end());
+
+  dataset.imu = readCsv<ReplayImuSample>((root / "imu.csv").string(), 10, fillImu);
+  dataset.odom = readCsv<ReplayOdomSample>((root / "odom.csv").string(), 13, fillOdom);
+  if (fs::exists(root / "map.pcd"))
+  {
+    dataset.map_cloud = (root / "map.pcd").string();
+  }
+  return dataset;
+}
+
+void writeReplayImuCsv(const std::string& path, const std::vector<ReplayImuSample>& imu)
+{
+  std::ofstream file(path);
+  file << "stamp_ns,qx,qy,qz,qw,wx,wy,wz,ax,ay,az\n";
+  file.precision(9);
+  for (const auto& s : imu)
+  {
+    file << s.stamp_ns << "," << s.orientation.x() << "," << s.orientation.y() << "," << s.orientation.z() << ","
+         << s.orientation.w() << "," << s.angular_velocity.x() << "," << s.angular_velocity.y() << ","
+         << s.angular_velocity.z() << "," << s.linear_acceleration.x() << "," << s.linear_acceleration.y() << ","
+         << s.linear_acceleration.z() << "\n";
+  }
+}
+
+void writeReplayOdomCsv(const std::string& path, const std::vector<ReplayOdomSample>& odom)
+{
+  std::ofstream file(path);
+  file << "stamp_ns,x,y,z,qx,qy,qz,qw,vx,vy,vz,wx,wy,wz\n";
+  file.precision(9);
+  for (const auto& s : odom)
+  {
+    file << s.stamp_ns << "," << s.position.x() << "," << s.position.y() << "," << s.position.z() << ","
+         << s.orientation.x() << "," << s.orientation.y() << "," << s.orientation.z() << "," << s.orientation.w()
+         << "," << s.linear_velocity.x() << "," << s.linear_velocity.y() << "," << s.linear_velocity.z() << ","
+         << s.angular_velocity.x() << "," << s.angular_velocity.y() << "," << s.angular_velocity.z() << "\n";
+  }
+}
+
+uint64_t fnv1a64(const uint8_t* data, size_t size, uint64_t hash)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    hash ^= data[i];
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+ReplayHarness::ReplayHarness(const ReplayParams& params, const rclcpp::NodeOptions& options)
+  : Node("replay_harness_rclcpp_node", options), params_(params)
+{
+  // Reliable publishers match both reliable and best effort subscriptions of the nodes under test
+  auto sensor_qos = rclcpp::QoS(rclcpp::KeepLast(10)).reliable();
+  clock_pub_ = this->create_publisher<rosgraph_msgs::msg::Clock>("/clock", rclcpp::ClockQoS());
+  cloud_pub_ = this->create_publisher<sensor_msgs::msg::PointCloud2>(params_.cloud_topic, sensor_qos);
+  imu_pub_ = this->create_publisher<sensor_msgs::msg::Imu>(params_.imu_topic, sensor_qos);
+  odom_pub_ = this->create_publisher<nav_msgs::msg::Odometry>(params_.odom_topic, sensor_qos);
+  if (!params_.map_topic.empty())
+  {
+    map_pub_ = this->create_publisher<sensor_msgs::msg::PointCloud2>(params_.map_topic, sensor_qos);
+  }
+  // Best effort matches both reliable and best effort publishers, the depth covers the rate mode
+  output_sub_ = this->create_generic_subscription(
+      params_.output_topic, params_.output_type, rclcpp::QoS(rclcpp::KeepLast(100)).best_effort(),
+      std::bind(&ReplayHarness::outputCallback, this, std::placeholders::_1));
+  tf_broadcaster_ = std::make_shared<tf2_ros::TransformBroadcaster>(*this);
+  static_tf_broadcaster_ = std::make_shared<tf2_ros::StaticTransformBroadcaster>(*this);
+}
+
+void ReplayHarness::outputCallback(std::shared_ptr<rclcpp::SerializedMessage> msg)
+{
+  auto received = std::chrono::steady_clock::now();
+  const rcl_serialized_message_t& raw = msg->get_rcl_serialized_message();
+  uint64_t digest = fnv1a64(raw.buffer, raw.buffer_length);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    outputs_++;
+    if (awaiting_output_.empty())
+    {
+      return;  // Output of a scan that already timed out
+    }
+    size_t index = awaiting_output_.front();
+    awaiting_output_.pop_front();
+    records_[index].latency_ms =
+        std::chrono::duration<double, std::milli>(received - publish_times_[index]).count();
+    records_[index].digest = digest;
+  }
+  output_cv_.notify_all();
+}
+
+void ReplayHarness::publishClock(int64_t stamp_ns)
+{
+  // Never back, timers and tf buffers of the nodes under test reset on a clock jump back
+  clock_ns_ = std::max(clock_ns_, stamp_ns);
+  rosgraph_msgs::msg::Clock clock;
+  clock.clock = toStamp(clock_ns_);
+  clock_pub_->publish(clock);
+}
+
+void ReplayHarness::publishImu(const ReplayImuSample& sample)
+{
+  sensor_msgs::msg::Imu imu;
+  imu.header.stamp = toStamp(sample.stamp_ns);
+  imu.header.frame_id = params_.base_frame;
+  imu.orientation.x = sample.orientation.x();
+  imu.orientation.y = sample.orientation.y();
+  imu.orientation.z = sample.orientation.z();
+  imu.orientation.w = sample.orientation.w();
+  imu.angular_velocity.x = sample.angular_velocity.x();
+  imu.angular_velocity.y = sample.angular_velocity.y();
+  imu.angular_velocity.z = sample.angular_velocity.z();
+  imu.linear_acceleration.x = sample.linear_acceleration.x();
+  imu.linear_acceleration.y = sample.linear_acceleration.y();
+  imu.linear_acceleration.z = sample.linear_acceleration.z();
+  imu_pub_->publish(imu);
+}
+
+void ReplayHarness::publishOdom(const ReplayOdomSample& sample)
+{
+  nav_msgs::msg::Odometry odom;
+  odom.header.stamp = toStamp(sample.stamp_ns);
+  odom.header.frame_id = params_.odom_frame;
+  odom.child_frame_id = params_.base_frame;
+  odom.pose.pose.position.x = sample.position.x();
+  odom.pose.pose.position.y = sample.position.y();
+  odom.pose.pose.position.z = sample.position.z();
+  odom.pose.pose.orientation.x = sample.orientation.x();
+  odom.pose.pose.orientation.y = sample.orientation.y();
+  odom.pose.pose.orientation.z = sample.orientation.z();
+  odom.pose.pose.orientation.w = sample.orientation.w();
+  odom.twist.twist.linear.x = sample.linear_velocity.x();
+  odom.twist.twist.linear.y = sample.linear_velocity.y();
+  odom.twist.twist.linear.z = sample.linear_velocity.z();
+  odom.twist.twist.angular.x = sample.angular_velocity.x();
+  odom.twist.twist.angular.y = sample.angular_velocity.y();
+  odom.twist.twist.angular.z = sample.angular_velocity.z();
+  odom_pub_->publish(odom);
+
+  geometry_msgs::msg::TransformStamped odom_to_base;
+  odom_to_base.header = odom.header;
+  odom_to_base.child_frame_id = params_.base_frame;
+  odom_to_base.transform.translation.x = sample.position.x();
+  odom_to_base.transform.translation.y = sample.position.y();
+  odom_to_base.transform.translation.z = sample.position.z();
+  odom_to_base.transform.rotation = odom.pose.pose.orientation;
+  tf_broadcaster_->sendTransform(odom_to_base);
+}
+
+bool ReplayHarness::publishCloud(size_t index, const std::string& path, int64_t stamp_ns)
+{
+  pcl::PCLPointCloud2 pcl_cloud;
+  if (pcl::io::loadPCDFile(path, pcl_cloud) != 0)
+  {
+    RCLCPP_ERROR(get_logger(), "Could not load %s", path.c_str());
+    return false;
+  }
+  // Every field in the file is kept, nodes convert to the point type they need
+  sensor_msgs::msg::PointCloud2 cloud;
+  pcl_conversions::moveFromPCL(pcl_cloud, cloud);
+  cloud.header.stamp = toStamp(stamp_ns);
+  cloud.header.frame_id = params_.cloud_frame;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    publish_times_[index] = std::chrono::steady_clock::now();
+    awaiting_output_.push_back(index);
+  }
+  cloud_pub_->publish(cloud);
+  return true;
+}
+
+void ReplayHarness::publishMap(const std::string& path)
+{
+  pcl::PCLPointCloud2 pcl_cloud;
+  if (pcl::io::loadPCDFile(path, pcl_cloud) != 0)
+  {
+    RCLCPP_ERROR(get_logger(), "Could not load %s", path.c_str());
+    return;
+  }
+  sensor_msgs::msg::PointCloud2 cloud;
+  pcl_conversions::moveFromPCL(pcl_cloud, cloud);
+  cloud.header.frame_id = params_.map_frame;
+  map_pub_->publish(cloud);
+}
+
+bool ReplayHarness::waitForOutput(size_t index, std::chrono::milliseconds timeout)
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  bool received = output_cv_.wait_for(lock, timeout, [this, index]() {
+    return std::find(awaiting_output_.begin(), awaiting_output_.end(), index) == awaiting_output_.end();
+  });
+  if (!received)
+  {
+    // Give up on this scan so that later outputs are not attributed to it
+    awaiting_output_.erase(std::remove(awaiting_output_.begin(), awaiting_output_.end(), index),
+                           awaiting_output_.end());
+  }
+  return received;
+}
+
+std::vector<ReplayRecord> ReplayHarness::run(const ReplayDataset& dataset)
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    records_.assign(dataset.clouds.size(), ReplayRecord());
+    for (size_t i = 0; i < records_.size(); i++)
+    {
+      records_[i] = ReplayRecord{ i, dataset.clouds[i].first, -1.0, 0 };
+    }
+    publish_times_.assign(dataset.clouds.size(), std::chrono::steady_clock::time_point());
+    awaiting_output_.clear();
+    outputs_ = 0;
+  }
+  clock_ns_ = std::numeric_limits<int64_t>::min();
+
+  // Wait until the nodes under test are connected, messages published earlier would be lost
+  auto connect_deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (rclcpp::ok() && std::chrono::steady_clock::now() < connect_deadline &&
+         (cloud_pub_->get_subscription_count() == 0 || output_sub_->get_publisher_count() == 0))
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  if (cloud_pub_->get_subscription_count() == 0 || output_sub_->get_publisher_count() == 0)
+  {
+    RCLCPP_WARN(get_logger(), "Nothing subscribes to %s or publishes %s, replaying anyway",
+                params_.cloud_topic.c_str(), params_.output_topic.c_str());
+  }
+
+  int64_t first_stamp = dataset.clouds.front().first;
+  if (!dataset.imu.empty())
+  {
+    first_stamp = std::min(first_stamp, dataset.imu.front().stamp_ns);
+  }
+  if (!dataset.odom.empty())
+  {
+    first_stamp = std::min(first_stamp, dataset.odom.front().stamp_ns);
+  }
+  publishClock(first_stamp);
+
+  std::vector<geometry_msgs::msg::TransformStamped> static_transforms(1);
+  static_transforms[0].header.stamp = toStamp(first_stamp);
+  static_transforms[0].header.frame_id = params_.map_frame;
+  static_transforms[0].child_frame_id = params_.odom_frame;
+  static_transforms[0].transform.rotation.w = 1.0;
+  if (params_.cloud_frame != params_.base_frame)
+  {
+    static_transforms.push_back(static_transforms[0]);
+    static_transforms[1].header.frame_id = params_.base_frame;
+    static_transforms[1].child_frame_id = params_.cloud_frame;
+  }
+  static_tf_broadcaster_->sendTransform(static_transforms);
+
+  auto wall_start = std::chrono::steady_clock::now();
+  size_t imu_i = 0, odom_i = 0;
+  for (size_t i = 0; i < dataset.clouds.size() && rclcpp::ok(); i++)
+  {
+    int64_t stamp_ns = dataset.clouds[i].first;
+
+    if (params_.mode == ReplayMode::RATE && params_.rate > 0.0)
+    {
+      std::this_thread::sleep_until(
+          wall_start + std::chrono::nanoseconds(static_cast<int64_t>((stamp_ns - first_stamp) / params_.rate)));
+    }
+
+    // Everything recorded up to the scan goes out first, so the transforms for it are there. Imu and odometry
+    // are merged by stamp, replaying one after the other would turn /clock back between them
+    while (true)
+    {
+      bool imu_due = imu_i < dataset.imu.size() && dataset.imu[imu_i].stamp_ns <= stamp_ns;
+      bool odom_due = odom_i < dataset.odom.size() && dataset.odom[odom_i].stamp_ns <= stamp_ns;
+      if (imu_due && (!odom_due || dataset.imu[imu_i].stamp_ns <= dataset.odom[odom_i].stamp_ns))
+      {
+        publishClock(dataset.imu[imu_i].stamp_ns);
+        publishImu(dataset.imu[imu_i++]);
+      }
+      else if (odom_due)
+      {
+        publishClock(dataset.odom[odom_i].stamp_ns);
+        publishOdom(dataset.odom[odom_i++]);
+      }
+      else
+      {
+        break;
+      }
+    }
+    publishClock(stamp_ns);
+
+    if (map_pub_ && !dataset.map_cloud.empty())
+    {
+      // The map subscriptions are best effort, so the map goes out until something came back
+      bool any_output;
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        any_output = outputs_ > 0;
+      }
+      if (!any_output)
+      {
+        publishMap(dataset.map_cloud);
+      }
+    }
+
+    if (!publishCloud(i, dataset.clouds[i].second, stamp_ns))
+    {
+      continue;
+    }
+    if (params_.mode == ReplayMode::LOCKSTEP)
+    {
+      waitForOutput(i, params_.output_timeout);
+    }
+  }
+
+  // Outputs of the last scans in rate mode
+  for (size_t i = 0; i < dataset.clouds.size(); i++)
+  {
+    waitForOutput(i, params_.output_timeout);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  return records_;
+}
+
+}  // namespace vox_nav_misc
@@ -0,0 +1,299 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_misc/rolling_traversability_grid.hpp"
+
+#include <Eigen/Eigenvalues>
+
+#include <algorithm>
+#include <cmath>
+
+namespace vox_nav_misc
+{
+RollingTraversabilityGrid::RollingTraversabilityGrid(const RollingGridParams& grid_params,
+                                                     const CostRegressionParams& cost_params)
+  : params_(grid_params), cost_params_(cost_params), origin_x_(0), origin_y_(0), stamp_(0)
+{
+  size_ = static_cast<int>(std::ceil(2.0 * params_.half_size / params_.resolution));
+  window_cells_ = static_cast<int>(std::ceil(params_.window_radius / params_.resolution));
+  cells_.resize(static_cast<size_t>(size_) * size_);
+  for (int dx = -window_cells_; dx <= window_cells_; ++dx)
+  {
+    for (int dy = -window_cells_; dy <= window_cells_; ++dy)
+    {
+      if (dx * dx + dy * dy <= window_cells_ * window_cells_)
+      {
+        window_offsets_.emplace_back(dx, dy);
+      }
+    }
+  }
+  moveTo(0.0, 0.0);
+}
+
+void RollingTraversabilityGrid::moveTo(double x, double y)
+{
+  origin_x_ = static_cast<int>(std::floor(x / params_.resolution)) - size_ / 2;
+  origin_y_ = static_cast<int>(std::floor(y / params_.resolution)) - size_ / 2;
+}
+
+bool RollingTraversabilityGrid::inWindow(int wx, int wy) const
+{
+  return wx >= origin_x_ && wx < origin_x_ + size_ && wy >= origin_y_ && wy < origin_y_ + size_;
+}
+
+size_t RollingTraversabilityGrid::storageIndex(int wx, int wy) const
+{
+  int ix = ((wx % size_) + size_) % size_;
+  int iy = ((wy % size_) + size_) % size_;
+  return static_cast<size_t>(ix) * size_ + iy;
+}
+
+RollingTraversabilityGrid::Cell& RollingTraversabilityGrid::cellAt(int wx, int wy)
+{
+  Cell& cell = cells_[storageIndex(wx, wy)];
+  if (cell.wx != wx || cell.wy != wy)
+  {
+    cell = Cell();
+    cell.wx = wx;
+    cell.wy = wy;
+  }
+  return cell;
+}
+
+RollingTraversabilityGrid::Cell* RollingTraversabilityGrid::findCell(int wx, int wy)
+{
+  Cell& cell = cells_[storageIndex(wx, wy)];
+  if (cell.wx != wx || cell.wy != wy || cell.count <= 0.0)
+  {
+    return nullptr;
+  }
+  return &cell;
+}
+
+void RollingTraversabilityGrid::insert(const pcl::PointCloud<pcl::PointXYZRGB>& cloud)
+{
+  const double inv_resolution = 1.0 / params_.resolution;
+  for (const auto& p : cloud.points)
+  {
+    if (!std::isfinite(p.x) || !std::isfinite(p.y) || !std::isfinite(p.z))
+    {
+      continue;
+    }
+    int wx = static_cast<int>(std::floor(p.x * inv_resolution));
+    int wy = static_cast<int>(std::floor(p.y * inv_resolution));
+    if (!inWindow(wx, wy))
+    {
+      continue;
+    }
+    Cell& cell = cellAt(wx, wy);
+
+    // Clamp the count so that new scans keep a fixed weight. The height
+    // extent shrinks towards the mean by the same factor, so extrema of old
+    // scans fade out with them and new points widen it again
+    if (cell.count >= params_.max_points_per_cell)
+    {
+      double keep = (params_.max_points_per_cell - 1.0) / cell.count;
+      cell.scatter *= keep;
+      cell.count = params_.max_points_per_cell - 1.0;
+      float mean_z = static_cast<float>(cell.mean.z());
+      cell.min_z = mean_z + (cell.min_z - mean_z) * static_cast<float>(keep);
+      cell.max_z = mean_z + (cell.max_z - mean_z) * static_cast<float>(keep);
+    }
+
+    // Welford update of mean and scatter
+    Eigen::Vector3d point(p.x, p.y, p.z);
+    if (cell.count <= 0.0)
+    {
+      cell.min_z = p.z;
+      cell.max_z = p.z;
+    }
+    cell.count += 1.0;
+    Eigen::Vector3d delta = point - cell.mean;
+    cell.mean += delta / cell.count;
+    cell.scatter += delta * (point - cell.mean).transpose();
+    cell.min_z = std::min(cell.min_z, p.z);
+    cell.max_z = std::max(cell.max_z, p.z);
+
+    if (!cell.touched)
+    {
+      cell.touched = true;
+      touched_cells_.emplace_back(wx, wy);
+    }
+  }
+}
+
+bool RollingTraversabilityGrid::checkDirty(Cell& cell) const
+{
+  float mean_z = cell.mean.z();
+  float std_z = std::sqrt(std::max(cell.scatter(2, 2) / cell.count, 0.0));
+  const float threshold = params_.change_threshold;
+  if (cell.has_snapshot && std::abs(mean_z - cell.snapshot_mean_z) <= threshold &&
+      std::abs(std_z - cell.snapshot_std_z) <= threshold && std::abs(cell.min_z - cell.snapshot_min_z) <= threshold &&
+      std::abs(cell.max_z - cell.snapshot_max_z) <= threshold)
+  {
+    return false;
+  }
+  cell.has_snapshot = true;
+  cell.snapshot_mean_z = mean_z;
+  cell.snapshot_std_z = std_z;
+  cell.snapshot_min_z = cell.min_z;
+  cell.snapshot_max_z = cell.max_z;
+  return true;
+}
+
+size_t RollingTraversabilityGrid::updateCosts()
+{
+  stamp_++;
+  size_t num_recomputed = 0;
+
+  for (const auto& touched : touched_cells_)
+  {
+    Cell* cell = findCell(touched.first, touched.second);
+    if (!cell)
+    {
+      continue;
+    }
+    cell->touched = false;
+    if (!inWindow(touched.first, touched.second) || !checkDirty(*cell))
+    {
+      continue;
+    }
+    // Every cell whose window contains the dirty cell is affected
+    for (const auto& offset : window_offsets_)
+    {
+      int wx = touched.first + offset.first;
+      int wy = touched.second + offset.second;
+      if (!inWindow(wx, wy))
+      {
+        continue;
+      }
+      Cell* affected = findCell(wx, wy);
+      if (affected && affected->recomputed_at != stamp_)
+      {
+        regressCell(wx, wy, *affected);
+        affected->recomputed_at = stamp_;
+        num_recomputed++;
+      }
+    }
+  }
+  touched_cells_.clear();
+  return num_recomputed;
+}
+
+void RollingTraversabilityGrid::regressCell(int wx, int wy, Cell& cell)
+{
+  // Merge statistics of the window, first the mean then the scatter (Chan et al.)
+  double count = 0.0;
+  Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+  float min_z = cell.min_z, max_z = cell.max_z;
+  window_.clear();
+  for (const auto& offset : window_offsets_)
+  {
+    int nx = wx + offset.first;
+    int ny = wy + offset.second;
+    const Cell* n = inWindow(nx, ny) ? findCell(nx, ny) : nullptr;
+    if (n)
+    {
+      window_.push_back(n);
+      count += n->count;
+      mean += n->count * n->mean;
+      min_z = std::min(min_z, n->min_z);
+      max_z = std::max(max_z, n->max_z);
+    }
+  }
+  if (count < params_.min_points)
+  {
+    cell.has_cost = false;
+    return;
+  }
+  mean /= count;
+
+  Eigen::Matrix3d scatter = Eigen::Matrix3d::Zero();
+  for (const Cell* n : window_)
+  {
+    Eigen::Vector3d d = n->mean - mean;
+    scatter += n->scatter + n->count * d * d.transpose();
+  }
+
+  // Plane normal is the direction of least variance
+  Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> solver;
+  solver.computeDirect(scatter / count);
+  Eigen::Vector3d normal = solver.eigenvectors().col(0);
+  if (normal.z() < 0.0)
+  {
+    normal = -normal;
+  }
+
+  // Same critics as TraversabilityEstimator::regressCosts, see rpy_from_plane,
+  // average_point_deviation_from_plane and max_energy_gap_in_cloud
+  double roll = std::atan2(normal.y(), normal.z());
+  double pitch = std::atan2(normal.x(), normal.z());
+  double max_tilt = std::max(std::abs(roll), std::abs(pitch));
+  // Mean absolute deviation of a normal distribution is sigma * sqrt(2 / pi)
+  double average_point_deviation = std::sqrt(std::max(solver.eigenvalues()(0), 0.0)) * std::sqrt(2.0 / M_PI);
+  double max_energy_gap = cost_params_.robot_mass * 9.82 * std::abs(max_z - min_z) +
+                          0.5 * cost_params_.robot_mass * std::pow(cost_params_.average_speed, 2);
+
+  double slope_cost = std::min(max_tilt / cost_params_.max_allowed_tilt, 1.0) * cost_params_.max_color_range;
+  double energy_gap_cost =
+      std::min(max_energy_gap / cost_params_.max_allowed_energy_gap, 1.0) * cost_params_.max_color_range;
+  double deviation_of_points_cost =
+      std::min(average_point_deviation / cost_params_.max_allowed_point_deviation, 1.0) *
+      cost_params_.max_color_range;
+
+  cell.total_cost = cost_params_.cost_critic_weights[0] * slope_cost +
+                    cost_params_.cost_critic_weights[1] * deviation_of_points_cost +
+                    cost_params_.cost_critic_weights[2] * energy_gap_cost;
+  cell.traversable = max_tilt <= cost_params_.max_allowed_tilt;
+  cell.has_cost = true;
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr RollingTraversabilityGrid::getTraversableCloud() const
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  cloud->points.reserve(cells_.size());
+  for (int wx = origin_x_; wx < origin_x_ + size_; ++wx)
+  {
+    for (int wy = origin_y_; wy < origin_y_ + size_; ++wy)
+    {
+      const Cell& cell = cells_[storageIndex(wx, wy)];
+      if (cell.wx != wx || cell.wy != wy || !cell.has_cost)
+      {
+        continue;
+      }
+      pcl::PointXYZRGB p;
+      p.x = cell.mean.x();
+      p.y = cell.mean.y();
+      p.z = cell.mean.z();
+      if (cell.traversable)
+      {
+        p.r = 0;
+        p.g = cost_params_.max_color_range - cell.total_cost;
+        p.b = cell.total_cost;
+      }
+      else
+      {
+        p.r = 255;
+        p.g = 0;
+        p.b = 0;
+      }
+      cloud->points.push_back(p);
+    }
+  }
+  cloud->width = cloud->points.size();
+  cloud->height = 1;
+  return cloud;
+}
+
+}  // namespace vox_nav_misc
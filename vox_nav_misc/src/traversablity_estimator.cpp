@@ -13,17 +13,22 @@
 // limitations under the License.
 
 #include "vox_nav_misc/traversablity_estimator.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 namespace vox_nav_misc
 {
-TraversabilityEstimator::TraversabilityEstimator() : rclcpp::Node("traversability_estimator_rclcpp_node")
+TraversabilityEstimator::TraversabilityEstimator(const rclcpp::NodeOptions& options)
+  : rclcpp::Node("traversability_estimator_rclcpp_node", options)
 {
   cloud_subscriber_ = this->create_subscription<sensor_msgs::msg::PointCloud2>(
       "points", rclcpp::QoS(rclcpp::KeepLast(1)).reliable(),
       std::bind(&TraversabilityEstimator::cloudCallback, this, std::placeholders::_1));
 
-  traversable_cloud_publisher_ =
-      this->create_publisher<sensor_msgs::msg::PointCloud2>("traversable_cloud", rclcpp::SensorDataQoS());
+  // The plan refiner takes the traversable cloud intra-process when composed with the controller server
+  rclcpp::PublisherOptions intra_process_options;
+  intra_process_options.use_intra_process_comm = rclcpp::IntraProcessSetting::Enable;
+  traversable_cloud_publisher_ = this->create_publisher<sensor_msgs::msg::PointCloud2>(
+      "traversable_cloud", rclcpp::SensorDataQoS(), intra_process_options);
 
   declare_parameter("uniform_sample_radius", 0.2);
   declare_parameter("surfel_radius", 0.8);
@@ -46,6 +51,54 @@ TraversabilityEstimator::TraversabilityEstimator() : rclcpp::Node("traversabilit
   get_parameter("robot_mass", cost_params_.robot_mass);
   get_parameter("average_speed", cost_params_.average_speed);
   get_parameter("cost_critic_weights", cost_params_.cost_critic_weights);
+
+  declare_parameter("rolling_grid.enabled", false);
+  declare_parameter("rolling_grid.half_size", 10.0);
+  declare_parameter("rolling_grid.max_points_per_cell", 50.0);
+  declare_parameter("rolling_grid.change_threshold", 0.01);
+
+  get_parameter("rolling_grid.enabled", use_rolling_grid_);
+  if (use_rolling_grid_)
+  {
+    RollingGridParams grid_params;
+    grid_params.resolution = cost_params_.uniform_sample_radius;
+    grid_params.window_radius = cost_params_.surfel_radius;
+    get_parameter("rolling_grid.half_size", grid_params.half_size);
+    get_parameter("rolling_grid.max_points_per_cell", grid_params.max_points_per_cell);
+    get_parameter("rolling_grid.change_threshold", grid_params.change_threshold);
+    rolling_grid_ = std::make_unique<RollingTraversabilityGrid>(grid_params, cost_params_);
+  }
+
+  declare_parameter("elevation_grid.enabled", false);
+  declare_parameter("elevation_grid.min_points", 3);
+
+  get_parameter("elevation_grid.enabled", use_elevation_grid_);
+  if (use_elevation_grid_)
+  {
+    ElevationGridParams elevation_params;
+    elevation_params.resolution = cost_params_.uniform_sample_radius;
+    elevation_params.window_radius = cost_params_.surfel_radius;
+    get_parameter("elevation_grid.min_points", elevation_params.min_points);
+    elevation_grid_ = std::make_unique<ElevationGridTraversability>(elevation_params, cost_params_);
+  }
+
+  declare_parameter("recording.enabled", false);
+  declare_parameter("recording.directory", ".");
+  declare_parameter("recording.format", "binary_compressed");
+  declare_parameter("recording.queue_size", 8);
+  declare_parameter("recording.drop_policy", "drop_oldest");
+
+  get_parameter("recording.enabled", recording_enabled_);
+  if (recording_enabled_)
+  {
+    CloudRecorderParams recorder_params;
+    recorder_params.directory = get_parameter("recording.directory").as_string();
+    recorder_params.format = pcdFormatFromString(get_parameter("recording.format").as_string());
+    recorder_params.queue_size = get_parameter("recording.queue_size").as_int();
+    recorder_params.drop_policy = dropPolicyFromString(get_parameter("recording.drop_policy").as_string());
+    recorder_ = std::make_unique<AsyncCloudRecorder<pcl::PointXYZRGB>>(recorder_params);
+    RCLCPP_INFO(get_logger(), "Recording clouds to %s", recorder_params.directory.c_str());
+  }
   // setup TF buffer and listerner to read transforms
   tf_buffer_ = std::make_shared<tf2_ros::Buffer>(this->get_clock());
   tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
@@ -55,12 +108,20 @@ TraversabilityEstimator::TraversabilityEstimator() : rclcpp::Node("traversabilit
 
 TraversabilityEstimator::~TraversabilityEstimator()
 {
+  if (recorder_)
+  {
+    // Counts are only final once the queue is written out
+    recorder_->stop();
+    RCLCPP_INFO(get_logger(), "Recorder flushed, %zu clouds written, %zu dropped, %zu failed", recorder_->written(),
+                recorder_->dropped(), recorder_->failed());
+  }
   RCLCPP_INFO(this->get_logger(), "Traversability Estimator Node is shutting down!");
 }
 
 pcl::PointCloud<pcl::PointXYZRGB>::Ptr TraversabilityEstimator::regressCosts(
     const pcl::PointCloud<pcl::PointXYZRGB>::Ptr cloud, const std_msgs::msg::Header& header)
 {
+  VOX_NAV_TRACE_FUNCTION("perception");
   auto input_cloud = vox_nav_utilities::set_cloud_color(cloud, std::vector<double>({ 0.0, 255.0, 0.0 }));
 
   auto pure_traversable_pcl = vox_nav_utilities::get_traversable_points(input_cloud);
@@ -163,32 +224,47 @@ void TraversabilityEstimator::cloudCallback(const sensor_msgs::msg::PointCloud2:
 
   cloud_xyzrgb = vox_nav_utilities::cropBox<pcl::PointXYZRGB>(cloud_xyzrgb, min_pt, max_pt);
 
-  // save both clouds to disk for comparison
-  pcl::io::savePCDFileASCII("original_cloud_" + std::to_string(traversable_cloud_publisher_counter_) + ".pcd",
-                            *cloud_xyzrgb);
+  // save both clouds to disk for comparison, regressCosts recolors its input so the original is copied
+  if (recorder_)
+  {
+    recorder_->record("original_cloud_" + std::to_string(traversable_cloud_publisher_counter_),
+                      std::make_shared<const pcl::PointCloud<pcl::PointXYZRGB>>(*cloud_xyzrgb));
+  }
 
   // regress cost to cloud;
-  cloud_xyzrgb = regressCosts(cloud_xyzrgb, msg->header);
+  if (rolling_grid_)
+  {
+    // Only cells whose statistics changed with this scan are regressed again
+    rolling_grid_->moveTo(curr_robot_pose.pose.position.x, curr_robot_pose.pose.position.y);
+    rolling_grid_->insert(*cloud_xyzrgb);
+    rolling_grid_->updateCosts();
+    cloud_xyzrgb = rolling_grid_->getTraversableCloud();
+  }
+  else if (elevation_grid_)
+  {
+    elevation_grid_->compute(*cloud_xyzrgb);
+    cloud_xyzrgb = elevation_grid_->getTraversableCloud();
+  }
+  else
+  {
+    cloud_xyzrgb = regressCosts(cloud_xyzrgb, msg->header);
+  }
 
   // Publish the cost regressor cloud
-  sensor_msgs::msg::PointCloud2::SharedPtr cost_regressed_cloud_msg(new sensor_msgs::msg::PointCloud2);
+  auto cost_regressed_cloud_msg = std::make_unique<sensor_msgs::msg::PointCloud2>();
   pcl::toROSMsg(*cloud_xyzrgb, *cost_regressed_cloud_msg);
   cost_regressed_cloud_msg->header = msg->header;
 
-  traversable_cloud_publisher_->publish(*cost_regressed_cloud_msg);
+  traversable_cloud_publisher_->publish(std::move(cost_regressed_cloud_msg));
 
-  pcl::io::savePCDFileASCII("traversable_cloud_" + std::to_string(traversable_cloud_publisher_counter_) + ".pcd",
-                            *cloud_xyzrgb);
+  if (recorder_)
+  {
+    recorder_->record("traversable_cloud_" + std::to_string(traversable_cloud_publisher_counter_), cloud_xyzrgb);
+  }
 
   traversable_cloud_publisher_counter_++;
 }
 }  // namespace vox_nav_misc
 
-int main(int argc, char** argv)
-{
-  rclcpp::init(argc, argv);
-  auto node = std::make_shared<vox_nav_misc::TraversabilityEstimator>();
-  rclcpp::spin(node);
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_misc::TraversabilityEstimator)
@@ -0,0 +1,34 @@
+# Replays a small synthetic dataset twice through the clustering pipeline in lockstep mode, the second run
+# checks its output digests against the first one and fails if any differs.
+# Usage: cmake -DDATASET_TOOL=<synthetic_replay_dataset> -DREPLAY_TOOL=<pipeline_replay> -DWORK_DIR=<dir>
+#        -P pipeline_replay_test.cmake
+
+foreach(var DATASET_TOOL REPLAY_TOOL WORK_DIR)
+  if(NOT DEFINED ${var})
+    message(FATAL_ERROR "${var} is not set")
+  endif()
+endforeach()
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR})
+
+execute_process(
+  COMMAND ${DATASET_TOOL} ${WORK_DIR}/dataset 20 42
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "synthetic_replay_dataset failed: ${result}")
+endif()
+
+execute_process(
+  COMMAND ${REPLAY_TOOL} ${WORK_DIR}/dataset clustering lockstep 0 ${WORK_DIR}/baseline.csv
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "pipeline_replay failed: ${result}")
+endif()
+
+execute_process(
+  COMMAND ${REPLAY_TOOL} ${WORK_DIR}/dataset clustering lockstep 0 ${WORK_DIR}/replay.csv ${WORK_DIR}/baseline.csv
+  RESULT_VARIABLE result)
+if(NOT result EQUAL 0)
+  message(FATAL_ERROR "pipeline_replay output differs from the first replay: ${result}")
+endif()
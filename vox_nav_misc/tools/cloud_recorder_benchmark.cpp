@@ -0,0 +1,126 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Callback latency of TraversabilityEstimator recording, the part of cloudCallback
+that stores the original and the traversable cloud per scan. Synchronous ASCII
+(old behaviour) and binary compressed writes are compared against the async
+recorder, which only copies the original cloud and queues both.
+Usage: cloud_recorder_benchmark [output_dir] [num_scans] [num_points]
+*/
+
+#include "vox_nav_misc/cloud_recorder.hpp"
+
+#include <pcl/point_types.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace vox_nav_misc;
+using Cloud = pcl::PointCloud<pcl::PointXYZRGB>;
+
+namespace
+{
+Cloud::Ptr denseScan(size_t num_points, std::mt19937& rng)
+{
+  std::uniform_real_distribution<float> xy(-10.0f, 10.0f);
+  std::normal_distribution<float> z(0.0f, 0.05f);
+  Cloud::Ptr cloud(new Cloud);
+  cloud->points.resize(num_points);
+  for (auto& p : cloud->points)
+  {
+    p.x = xy(rng);
+    p.y = xy(rng);
+    p.z = 0.1f * std::sin(p.x) + z(rng);
+    p.r = 0;
+    p.g = 255;
+    p.b = 0;
+  }
+  cloud->width = num_points;
+  cloud->height = 1;
+  return cloud;
+}
+
+struct Stats
+{
+  double mean_ms = 0.0;
+  double max_ms = 0.0;
+};
+
+template <typename F>
+Stats timeScans(const std::vector<Cloud::Ptr>& scans, F record_scan)
+{
+  Stats stats;
+  for (size_t i = 0; i < scans.size(); ++i)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    record_scan(i, scans[i]);
+    auto t1 = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    stats.mean_ms += ms / scans.size();
+    stats.max_ms = std::max(stats.max_ms, ms);
+  }
+  return stats;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::string dir = argc > 1 ? argv[1] : "/tmp";
+  size_t num_scans = argc > 2 ? std::stoul(argv[2]) : 20;
+  size_t num_points = argc > 3 ? std::stoul(argv[3]) : 150000;
+
+  std::mt19937 rng(7);
+  std::vector<Cloud::Ptr> scans;
+  for (size_t i = 0; i < num_scans; ++i)
+  {
+    scans.push_back(denseScan(num_points, rng));
+  }
+
+  std::cout << "mode,mean_callback_ms,max_callback_ms,written,dropped" << std::endl;
+
+  auto sync_ascii = timeScans(scans, [&](size_t i, const Cloud::Ptr& cloud) {
+    pcl::io::savePCDFileASCII(dir + "/original_cloud_" + std::to_string(i) + ".pcd", *cloud);
+    pcl::io::savePCDFileASCII(dir + "/traversable_cloud_" + std::to_string(i) + ".pcd", *cloud);
+  });
+  std::cout << "sync_ascii," << sync_ascii.mean_ms << "," << sync_ascii.max_ms << "," << 2 * num_scans << ",0"
+            << std::endl;
+
+  auto sync_compressed = timeScans(scans, [&](size_t i, const Cloud::Ptr& cloud) {
+    pcl::io::savePCDFileBinaryCompressed(dir + "/original_cloud_" + std::to_string(i) + ".pcd", *cloud);
+    pcl::io::savePCDFileBinaryCompressed(dir + "/traversable_cloud_" + std::to_string(i) + ".pcd", *cloud);
+  });
+  std::cout << "sync_binary_compressed," << sync_compressed.mean_ms << "," << sync_compressed.max_ms << ","
+            << 2 * num_scans << ",0" << std::endl;
+
+  for (auto policy : { RecorderDropPolicy::DROP_OLDEST, RecorderDropPolicy::BLOCK })
+  {
+    CloudRecorderParams params;
+    params.directory = dir;
+    params.drop_policy = policy;
+    AsyncCloudRecorder<pcl::PointXYZRGB> recorder(params);
+    auto async = timeScans(scans, [&](size_t i, const Cloud::Ptr& cloud) {
+      recorder.record("original_cloud_" + std::to_string(i), std::make_shared<const Cloud>(*cloud));
+      recorder.record("traversable_cloud_" + std::to_string(i), cloud);
+    });
+    recorder.flush();
+    std::cout << (policy == RecorderDropPolicy::BLOCK ? "async_block," : "async_drop_oldest,") << async.mean_ms
+              << "," << async.max_ms << "," << recorder.written() << "," << recorder.dropped() << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,278 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+End-to-end latency and CPU cost of moving map sized PointCloud2 messages
+through a source -> relay -> sink chain, the shape of map server ->
+traversability estimator -> plan refiner. "multi_process" runs the relay in a
+forked process, so both hops are serialized through DDS like separately
+launched nodes are. "composed" runs all three nodes in one process with
+intra-process communication, the relay moves the unique_ptr it receives
+into its publisher like the perception nodes do. CPU is user + system time
+of all processes involved. In composed mode every cloud has to reach the
+sink, and in the buffer the source allocated, otherwise the benchmark exits
+with 1.
+Usage: composition_benchmark [num_messages] [num_points] [rate_hz]
+*/
+
+#include <rclcpp/rclcpp.hpp>
+#include <sensor_msgs/msg/point_cloud2.hpp>
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using sensor_msgs::msg::PointCloud2;
+
+namespace
+{
+const char* kSourceTopic = "composition_benchmark/map_cloud";
+const char* kRelayTopic = "composition_benchmark/traversable_cloud";
+
+int64_t wallNs()
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+double cpuSeconds(const rusage& usage)
+{
+  return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+}
+
+rclcpp::QoS cloudQoS()
+{
+  return rclcpp::QoS(rclcpp::KeepLast(10)).reliable();
+}
+
+// Buffers the source allocated, keyed by stamp, to tell whether the sink got the same one
+struct BufferLedger
+{
+  std::mutex mutex;
+  std::map<int64_t, const uint8_t*> buffers;
+};
+
+class Relay : public rclcpp::Node
+{
+public:
+  explicit Relay(const rclcpp::NodeOptions& options) : Node("composition_benchmark_relay", options)
+  {
+    pub_ = create_publisher<PointCloud2>(kRelayTopic, cloudQoS());
+    sub_ = create_subscription<PointCloud2>(kSourceTopic, cloudQoS(), [this](std::unique_ptr<PointCloud2> msg) {
+      // Touch the cloud like a filter would, then hand it on
+      msg->header.frame_id = "base_link";
+      pub_->publish(std::move(msg));
+    });
+  }
+
+private:
+  rclcpp::Publisher<PointCloud2>::SharedPtr pub_;
+  rclcpp::Subscription<PointCloud2>::SharedPtr sub_;
+};
+
+struct Result
+{
+  std::vector<double> latencies_ms;
+  size_t zero_copy = 0;
+  double wall_s = 0.0;
+  double cpu_s = 0.0;
+};
+
+Result runChain(bool composed, size_t num_messages, size_t num_points, double rate_hz)
+{
+  Result result;
+  pid_t relay_pid = -1;
+  if (!composed)
+  {
+    relay_pid = fork();
+    if (relay_pid == 0)
+    {
+      rclcpp::init(0, nullptr);
+      rclcpp::spin(std::make_shared<Relay>(rclcpp::NodeOptions()));
+      rclcpp::shutdown();
+      _exit(0);
+    }
+  }
+
+  rusage usage_start;
+  getrusage(RUSAGE_SELF, &usage_start);
+  rclcpp::init(0, nullptr);
+  auto options = rclcpp::NodeOptions().use_intra_process_comms(composed);
+  auto source = std::make_shared<rclcpp::Node>("composition_benchmark_source", options);
+  auto sink = std::make_shared<rclcpp::Node>("composition_benchmark_sink", options);
+  auto cloud_pub = source->create_publisher<PointCloud2>(kSourceTopic, cloudQoS());
+
+  BufferLedger ledger;
+  std::mutex results_mutex;
+  auto cloud_sub = sink->create_subscription<PointCloud2>(
+      kRelayTopic, cloudQoS(), [&](std::unique_ptr<PointCloud2> msg) {
+        int64_t stamp = rclcpp::Time(msg->header.stamp).nanoseconds();
+        double latency_ms = (wallNs() - stamp) * 1e-6;
+        bool same_buffer = false;
+        {
+          std::lock_guard<std::mutex> lock(ledger.mutex);
+          auto it = ledger.buffers.find(stamp);
+          same_buffer = it != ledger.buffers.end() && it->second == msg->data.data();
+        }
+        std::lock_guard<std::mutex> lock(results_mutex);
+        result.latencies_ms.push_back(latency_ms);
+        result.zero_copy += same_buffer ? 1 : 0;
+      });
+
+  rclcpp::executors::SingleThreadedExecutor executor;
+  executor.add_node(source);
+  executor.add_node(sink);
+  std::shared_ptr<Relay> relay;
+  if (composed)
+  {
+    relay = std::make_shared<Relay>(options);
+    executor.add_node(relay);
+  }
+  std::thread spinner([&executor]() { executor.spin(); });
+
+  auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (std::chrono::steady_clock::now() < deadline &&
+         (cloud_pub->get_subscription_count() == 0 || cloud_sub->get_publisher_count() == 0))
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // x, y, z, rgb as float32, the layout the map server publishes
+  PointCloud2 layout;
+  layout.height = 1;
+  layout.width = num_points;
+  layout.point_step = 16;
+  layout.row_step = layout.point_step * num_points;
+  layout.is_dense = true;
+  const char* names[] = { "x", "y", "z", "rgb" };
+  for (uint32_t i = 0; i < 4; i++)
+  {
+    sensor_msgs::msg::PointField field;
+    field.name = names[i];
+    field.offset = 4 * i;
+    field.datatype = sensor_msgs::msg::PointField::FLOAT32;
+    field.count = 1;
+    layout.fields.push_back(field);
+  }
+
+  auto period = std::chrono::nanoseconds(static_cast<int64_t>(1e9 / rate_hz));
+  auto t0 = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < num_messages && rclcpp::ok(); i++)
+  {
+    std::this_thread::sleep_until(t0 + i * period);
+    auto msg = std::make_unique<PointCloud2>(layout);
+    msg->header.frame_id = "map";
+    msg->data.assign(layout.row_step, static_cast<uint8_t>(i));
+    int64_t stamp = wallNs();
+    msg->header.stamp = rclcpp::Time(stamp);
+    {
+      std::lock_guard<std::mutex> lock(ledger.mutex);
+      ledger.buffers[stamp] = msg->data.data();
+    }
+    cloud_pub->publish(std::move(msg));
+  }
+
+  // Let the last clouds through
+  deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+  while (std::chrono::steady_clock::now() < deadline)
+  {
+    {
+      std::lock_guard<std::mutex> lock(results_mutex);
+      if (result.latencies_ms.size() >= num_messages)
+      {
+        break;
+      }
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  result.wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+  executor.cancel();
+  spinner.join();
+  relay.reset();
+  cloud_sub.reset();
+  cloud_pub.reset();
+  sink.reset();
+  source.reset();
+  rclcpp::shutdown();
+
+  rusage usage_end;
+  getrusage(RUSAGE_SELF, &usage_end);
+  result.cpu_s = cpuSeconds(usage_end) - cpuSeconds(usage_start);
+  if (relay_pid > 0)
+  {
+    int status;
+    rusage relay_usage;
+    kill(relay_pid, SIGINT);
+    wait4(relay_pid, &status, 0, &relay_usage);
+    result.cpu_s += cpuSeconds(relay_usage);
+  }
+  return result;
+}
+
+double percentile(std::vector<double> values, double p)
+{
+  if (values.empty())
+  {
+    return 0.0;
+  }
+  size_t k = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+  std::nth_element(values.begin(), values.begin() + k, values.end());
+  return values[k];
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_messages = argc > 1 ? std::stoul(argv[1]) : 100;
+  size_t num_points = argc > 2 ? std::stoul(argv[2]) : 300000;
+  double rate_hz = argc > 3 ? std::stod(argv[3]) : 10.0;
+
+  std::cout << "mode,messages,received,zero_copy,mb_per_message,mean_ms,p50_ms,p95_ms,max_ms,cpu_s,cpu_percent"
+            << std::endl;
+  int failures = 0;
+  for (bool composed : { false, true })
+  {
+    Result result = runChain(composed, num_messages, num_points, rate_hz);
+    double mean = 0.0;
+    for (double latency : result.latencies_ms)
+    {
+      mean += latency / result.latencies_ms.size();
+    }
+    std::cout << (composed ? "composed" : "multi_process") << "," << num_messages << ","
+              << result.latencies_ms.size() << "," << result.zero_copy << "," << num_points * 16 / 1e6 << ","
+              << mean << "," << percentile(result.latencies_ms, 0.5) << "," << percentile(result.latencies_ms, 0.95)
+              << "," << percentile(result.latencies_ms, 1.0) << "," << result.cpu_s << ","
+              << 100.0 * result.cpu_s / result.wall_s << std::endl;
+
+    if (composed && (result.latencies_ms.size() != num_messages || result.zero_copy != num_messages))
+    {
+      std::cerr << "FAILED: composed chain delivered " << result.latencies_ms.size() << " of " << num_messages
+                << " clouds, " << result.zero_copy << " without a copy" << std::endl;
+      failures++;
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,222 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Run time and cost agreement of ElevationGridTraversability against the surfel
+cost regression of TraversabilityEstimator::regressCosts on synthetic terrain
+(flat ground, a ramp, rolling hills, a curb and a rough patch). For every
+surfel the reference cost is compared with the cost of the grid cell under the
+surfel center.
+Usage: elevation_grid_benchmark [num_points] [repetitions]
+*/
+
+#include "vox_nav_misc/elevation_grid_traversability.hpp"
+
+#include <vox_nav_utilities/map_manager_helpers.hpp>
+#include <vox_nav_utilities/pcl_helpers.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace vox_nav_misc;
+using Cloud = pcl::PointCloud<pcl::PointXYZRGB>;
+
+namespace
+{
+struct Terrain
+{
+  std::string name;
+  double (*height)(double x, double y);
+  double noise;
+};
+
+double flat(double, double)
+{
+  return 0.0;
+}
+double ramp(double x, double)
+{
+  // about 17 degrees
+  return 0.3 * x;
+}
+double hills(double x, double y)
+{
+  return 0.8 * std::sin(0.4 * x) * std::cos(0.3 * y);
+}
+double curb(double x, double)
+{
+  return x > 0.0 ? 0.15 : 0.0;
+}
+
+Cloud::Ptr sampleTerrain(const Terrain& terrain, size_t num_points, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> xy(-10.0, 10.0);
+  std::normal_distribution<double> noise(0.0, terrain.noise);
+  Cloud::Ptr cloud(new Cloud);
+  cloud->points.resize(num_points);
+  for (auto& p : cloud->points)
+  {
+    p.x = xy(rng);
+    p.y = xy(rng);
+    p.z = terrain.height(p.x, p.y) + noise(rng);
+    p.r = 0;
+    p.g = 255;
+    p.b = 0;
+  }
+  cloud->width = num_points;
+  cloud->height = 1;
+  return cloud;
+}
+
+struct SurfelCost
+{
+  pcl::PointXYZRGB center;
+  double total_cost;
+  bool traversable;
+};
+
+// Mirrors TraversabilityEstimator::regressCosts
+std::vector<SurfelCost> surfelCosts(const Cloud::Ptr& cloud, const CostRegressionParams& params)
+{
+  std::vector<SurfelCost> costs;
+  auto uniformly_sampled_nodes =
+      vox_nav_utilities::uniformlySampleCloud<pcl::PointXYZRGB>(cloud, params.uniform_sample_radius);
+  auto surfels =
+      vox_nav_utilities::surfelize_traversability_cloud(cloud, uniformly_sampled_nodes, params.surfel_radius);
+  for (auto&& i : surfels)
+  {
+    if (i.second->points.size() < 3)
+    {
+      continue;
+    }
+    pcl::ModelCoefficients::Ptr plane_model(new pcl::ModelCoefficients);
+    try
+    {
+      vox_nav_utilities::fit_plane_to_cloud(plane_model, i.second, params.plane_fit_threshold);
+    }
+    catch (...)
+    {
+      continue;
+    }
+    // The sign of a RANSAC plane normal is arbitrary, point it up so tilt is not read as ~pi
+    if (plane_model->values[2] < 0.0f)
+    {
+      for (auto& v : plane_model->values)
+      {
+        v = -v;
+      }
+    }
+    auto rpy = vox_nav_utilities::rpy_from_plane(*plane_model);
+    double average_point_deviation = vox_nav_utilities::average_point_deviation_from_plane(i.second, *plane_model);
+    double max_energy_gap =
+        vox_nav_utilities::max_energy_gap_in_cloud(i.second, params.robot_mass, params.average_speed);
+
+    double max_tilt = std::max(std::abs(rpy[0]), std::abs(rpy[1]));
+    double slope_cost = std::min(max_tilt / params.max_allowed_tilt, 1.0) * params.max_color_range;
+    double energy_gap_cost = std::min(max_energy_gap / params.max_allowed_energy_gap, 1.0) * params.max_color_range;
+    double deviation_of_points_cost =
+        std::min(average_point_deviation / params.max_allowed_point_deviation, 1.0) * params.max_color_range;
+    double total_cost = params.cost_critic_weights[0] * slope_cost +
+                        params.cost_critic_weights[1] * deviation_of_points_cost +
+                        params.cost_critic_weights[2] * energy_gap_cost;
+    costs.push_back({ i.first, total_cost, max_tilt <= params.max_allowed_tilt });
+  }
+  return costs;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_points = argc > 1 ? std::stoul(argv[1]) : 100000;
+  size_t repetitions = argc > 2 ? std::stoul(argv[2]) : 5;
+
+  CostRegressionParams cost_params;
+  cost_params.uniform_sample_radius = 0.2;
+  cost_params.surfel_radius = 0.8;
+  // rpy_from_plane is in radians, 0.4 keeps the slope critic in range on these terrains
+  cost_params.max_allowed_tilt = 0.4;
+  cost_params.max_allowed_point_deviation = 0.2;
+  cost_params.max_allowed_energy_gap = 0.2;
+  cost_params.plane_fit_threshold = 0.2;
+  cost_params.robot_mass = 0.1;
+  cost_params.average_speed = 1.0;
+  cost_params.cost_critic_weights = { 0.8, 0.1, 0.1 };
+
+  ElevationGridParams grid_params;
+  grid_params.resolution = cost_params.uniform_sample_radius;
+  grid_params.window_radius = cost_params.surfel_radius;
+  ElevationGridTraversability grid(grid_params, cost_params);
+
+  std::vector<Terrain> terrains = {
+    { "flat", flat, 0.02 }, { "ramp", ramp, 0.02 }, { "hills", hills, 0.02 },
+    { "curb", curb, 0.02 }, { "rough", flat, 0.12 },
+  };
+
+  std::mt19937 rng(11);
+  std::cout << "terrain,surfel_ms,grid_ms,speedup,compared,mean_abs_cost_diff,cost_correlation,label_agreement"
+            << std::endl;
+  for (const auto& terrain : terrains)
+  {
+    auto cloud = sampleTerrain(terrain, num_points, rng);
+
+    double surfel_ms = 0.0, grid_ms = 0.0;
+    std::vector<SurfelCost> reference;
+    for (size_t r = 0; r < repetitions; ++r)
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      reference = surfelCosts(cloud, cost_params);
+      auto t1 = std::chrono::steady_clock::now();
+      grid.compute(*cloud);
+      auto output = grid.getTraversableCloud();
+      auto t2 = std::chrono::steady_clock::now();
+      surfel_ms += std::chrono::duration<double, std::milli>(t1 - t0).count() / repetitions;
+      grid_ms += std::chrono::duration<double, std::milli>(t2 - t1).count() / repetitions;
+    }
+
+    // Agreement over surfels whose cell has a cost
+    size_t compared = 0, same_label = 0;
+    double abs_diff = 0.0, sum_a = 0.0, sum_b = 0.0, sum_aa = 0.0, sum_bb = 0.0, sum_ab = 0.0;
+    for (const auto& s : reference)
+    {
+      double grid_cost;
+      bool grid_traversable;
+      if (!grid.costAt(s.center.x, s.center.y, grid_cost, grid_traversable))
+      {
+        continue;
+      }
+      compared++;
+      same_label += grid_traversable == s.traversable;
+      abs_diff += std::abs(grid_cost - s.total_cost);
+      sum_a += s.total_cost;
+      sum_b += grid_cost;
+      sum_aa += s.total_cost * s.total_cost;
+      sum_bb += grid_cost * grid_cost;
+      sum_ab += s.total_cost * grid_cost;
+    }
+    double n = std::max<double>(compared, 1.0);
+    double cov = sum_ab / n - (sum_a / n) * (sum_b / n);
+    double var_a = sum_aa / n - (sum_a / n) * (sum_a / n);
+    double var_b = sum_bb / n - (sum_b / n) * (sum_b / n);
+    // Constant costs, e.g. on flat ground, have no meaningful correlation
+    double correlation = (var_a > 1e-9 && var_b > 1e-9) ? cov / std::sqrt(var_a * var_b) : 1.0;
+
+    std::cout << terrain.name << "," << surfel_ms << "," << grid_ms << "," << surfel_ms / grid_ms << "," << compared
+              << "," << abs_diff / n << "," << correlation << "," << static_cast<double>(same_label) / n << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,220 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Throughput of the lidar_rgb_image_fuser output stage: one projection pass
+followed by LidarCameraFusion (depth image, colorized cloud, validity flags),
+with and without hole filling, on 128x2048 organized clouds and a 1280x720
+image. Before timing, the products are checked on a synthetic camera/lidar
+rig whose image encodes the pixel coordinates in its colors; any mismatch
+makes the benchmark exit with 1.
+Usage: lidar_camera_fusion_benchmark [num_frames]
+*/
+
+#include "vox_nav_misc/lidar_camera_fusion.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace vox_nav_misc;
+
+namespace
+{
+const int kImageWidth = 1280;
+const int kImageHeight = 720;
+
+Eigen::Matrix<float, 3, 4> cameraMatrix()
+{
+  Eigen::Matrix<float, 3, 4> K;
+  K << 365.71429443359375, 0, 640.5, 0,  // NOLINT
+      0, 365.4822082519531, 360.5, 0,    // NOLINT
+      0, 0, 1, 0;                        // NOLINT
+  return K;
+}
+
+// Lidar x forward, y left, z up to camera optical x right, y down, z forward
+Eigen::Matrix4f lidarToCamera()
+{
+  Eigen::Matrix4f T = Eigen::Matrix4f::Zero();
+  T(0, 1) = -1.0f;
+  T(1, 2) = -1.0f;
+  T(2, 0) = 1.0f;
+  T(3, 3) = 1.0f;
+  return T;
+}
+
+// RGB8 image whose color at (u, v) is (u % 256, v % 256, 77)
+std::vector<std::uint8_t> coordinateImage()
+{
+  std::vector<std::uint8_t> image(static_cast<size_t>(kImageWidth) * kImageHeight * 3);
+  for (int v = 0; v < kImageHeight; ++v)
+  {
+    for (int u = 0; u < kImageWidth; ++u)
+    {
+      std::uint8_t* rgb = &image[(static_cast<size_t>(v) * kImageWidth + u) * 3];
+      rgb[0] = u % 256;
+      rgb[1] = v % 256;
+      rgb[2] = 77;
+    }
+  }
+  return image;
+}
+
+// Lidar point that lands on pixel (u, v) at the given depth
+void pointOnPixel(CloudSoA& cloud, size_t i, int u, int v, float depth)
+{
+  const auto K = cameraMatrix();
+  float cam_x = (u + 0.5f - K(0, 2)) / K(0, 0) * depth;
+  float cam_y = (v + 0.5f - K(1, 2)) / K(1, 1) * depth;
+  cloud.x[i] = depth;
+  cloud.y[i] = -cam_x;
+  cloud.z[i] = -cam_y;
+}
+
+// Ouster like scan of a ground plane and a surrounding wall
+CloudSoA organizedScan(int rows, int cols, std::mt19937& rng)
+{
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  CloudSoA cloud;
+  cloud.resize(static_cast<size_t>(rows) * cols);
+  cloud.width = cols;
+  cloud.height = rows;
+  for (int r = 0; r < rows; ++r)
+  {
+    float elevation = (22.5f - 45.0f * r / (rows - 1)) * static_cast<float>(M_PI) / 180.0f;
+    for (int c = 0; c < cols; ++c)
+    {
+      float azimuth = static_cast<float>(M_PI) - 2.0f * static_cast<float>(M_PI) * c / cols;
+      float range = elevation < 0.0f ? std::min(20.0f, 1.5f / std::sin(-elevation)) : 20.0f;
+      range += noise(rng);
+      size_t i = static_cast<size_t>(r) * cols + c;
+      cloud.x[i] = range * std::cos(elevation) * std::cos(azimuth);
+      cloud.y[i] = range * std::cos(elevation) * std::sin(azimuth);
+      cloud.z[i] = range * std::sin(elevation);
+    }
+  }
+  return cloud;
+}
+
+int failures = 0;
+
+void check(bool condition, const char* what)
+{
+  if (!condition)
+  {
+    std::cerr << "FAILED: " << what << std::endl;
+    failures++;
+  }
+}
+
+void checkSyntheticRig()
+{
+  auto image = coordinateImage();
+  LidarCameraProjector projector(kImageWidth, kImageHeight);
+  projector.setProjection(cameraMatrix(), lidarToCamera());
+  auto pixel = [](int u, int v) { return v * kImageWidth + u; };
+
+  CloudSoA cloud;
+  cloud.resize(6);
+  cloud.width = 3;
+  cloud.height = 2;
+  pointOnPixel(cloud, 0, 300, 200, 5.0f);   // visible
+  pointOnPixel(cloud, 1, 300, 200, 5.05f);  // behind 0 but within the occlusion tolerance
+  pointOnPixel(cloud, 2, 300, 200, 9.0f);   // occluded by 0
+  pointOnPixel(cloud, 3, 302, 200, 3.0f);   // two pixels right of 0, nearer
+  pointOnPixel(cloud, 4, 900, 600, 7.0f);   // isolated
+  cloud.x[5] = -4.0f;                       // behind the camera
+  projector.project(cloud);
+
+  LidarCameraFusionParams params;
+  params.occlusion_tolerance = 0.1f;
+  LidarCameraFusion fusion(params);
+  fusion.fuse(projector, cloud, image.data(), kImageWidth * 3);
+  const auto& flags = fusion.pointFlags();
+  const auto& depth = fusion.depthImage();
+  auto colored = fusion.colorizedCloud();
+
+  check(flags[0] == (FUSION_IN_IMAGE | FUSION_VISIBLE), "nearest point is visible");
+  check(flags[1] == (FUSION_IN_IMAGE | FUSION_VISIBLE), "point within the occlusion tolerance is visible");
+  check(flags[2] == FUSION_IN_IMAGE, "occluded point is only in image");
+  check(flags[5] == 0, "point behind the camera has no flags");
+  check(colored->points[0].r == 300 % 256 && colored->points[0].g == 200 && colored->points[0].b == 77,
+        "color is sampled at the projected pixel");
+  check(colored->points[4].r == 900 % 256 && colored->points[4].g == 600 % 256, "isolated point is colored");
+  check(colored->points[2].r == 0 && colored->points[2].g == 0 && colored->points[2].b == 0,
+        "occluded point is not colored");
+  check(colored->width == 3 && colored->height == 2, "cloud layout is kept");
+  check(colored->points[3].x == cloud.x[3], "cloud keeps input coordinates");
+  check(depth[pixel(300, 200)] == 5.0f, "depth image keeps the nearest depth");
+  check(depth[pixel(301, 200)] == 0.0f, "without hole filling empty pixels are 0");
+
+  params.hole_filling_radius = 2;
+  LidarCameraFusion filled(params);
+  filled.fuse(projector, cloud, image.data(), kImageWidth * 3);
+  const auto& filled_depth = filled.depthImage();
+  check(filled_depth[pixel(300, 200)] == 5.0f, "hole filling keeps measured depths");
+  check(filled_depth[pixel(301, 200)] == 3.0f, "a hole takes the nearest depth around it");
+  check(filled_depth[pixel(298, 198)] == 5.0f, "holes within the radius are filled");
+  check(filled_depth[pixel(297, 200)] == 0.0f, "holes outside the radius stay empty");
+  check(filled_depth[pixel(902, 602)] == 7.0f, "square window reaches the corners");
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_frames = argc > 1 ? std::stoul(argv[1]) : 50;
+
+  checkSyntheticRig();
+  if (failures)
+  {
+    std::cerr << failures << " synthetic rig checks failed" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(5);
+  auto cloud = organizedScan(128, 2048, rng);
+  auto image = coordinateImage();
+  LidarCameraProjector projector(kImageWidth, kImageHeight);
+  projector.setProjection(cameraMatrix(), lidarToCamera());
+
+  std::cout << "hole_filling_radius,mean_projection_ms,mean_fusion_ms,frames_per_second,visible_points" << std::endl;
+  for (int radius : { 0, 2, 4 })
+  {
+    LidarCameraFusionParams params;
+    params.hole_filling_radius = radius;
+    LidarCameraFusion fusion(params);
+    double projection_ms = 0.0, fusion_ms = 0.0;
+    for (size_t f = 0; f < num_frames; ++f)
+    {
+      auto t0 = std::chrono::steady_clock::now();
+      projector.project(cloud);
+      auto t1 = std::chrono::steady_clock::now();
+      fusion.fuse(projector, cloud, image.data(), kImageWidth * 3);
+      auto t2 = std::chrono::steady_clock::now();
+      projection_ms += std::chrono::duration<double, std::milli>(t1 - t0).count() / num_frames;
+      fusion_ms += std::chrono::duration<double, std::milli>(t2 - t1).count() / num_frames;
+    }
+    size_t visible = 0;
+    for (auto flag : fusion.pointFlags())
+    {
+      visible += (flag & FUSION_VISIBLE) != 0;
+    }
+    std::cout << radius << "," << projection_ms << "," << fusion_ms << "," << 1000.0 / (projection_ms + fusion_ms)
+              << "," << visible << std::endl;
+  }
+  return 0;
+}
@@ -0,0 +1,285 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Per frame projection time of lidar_rgb_image_fuser on organized 128x2048
+clouds: the old path (fromROSMsg, per point copy into a dynamic Eigen matrix,
+projection, bounds check) against pointCloud2ToSoA + LidarCameraProjector,
+which also resolves occlusions. Before timing, the projector is checked
+against synthetic points with known pixels and depths; any mismatch makes
+the benchmark exit with 1.
+Usage: lidar_camera_projection_benchmark [num_frames]
+*/
+
+#include "vox_nav_misc/lidar_camera_projection.hpp"
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace vox_nav_misc;
+
+namespace
+{
+const int kImageWidth = 1280;
+const int kImageHeight = 720;
+
+Eigen::Matrix<float, 3, 4> cameraMatrix()
+{
+  Eigen::Matrix<float, 3, 4> K;
+  K << 365.71429443359375, 0, 640.5, 0,  // NOLINT
+      0, 365.4822082519531, 360.5, 0,    // NOLINT
+      0, 0, 1, 0;                        // NOLINT
+  return K;
+}
+
+// Lidar x forward, y left, z up to camera optical x right, y down, z forward
+Eigen::Matrix4f lidarToCamera()
+{
+  Eigen::Matrix4f T = Eigen::Matrix4f::Zero();
+  T(0, 1) = -1.0f;
+  T(1, 2) = -1.0f;
+  T(2, 0) = 1.0f;
+  T(3, 3) = 1.0f;
+  return T;
+}
+
+// Ouster like scan of a ground plane, a surrounding wall and a pillar in front
+pcl::PointCloud<pcl::PointXYZRGB> organizedScan(int rows, int cols, std::mt19937& rng)
+{
+  std::normal_distribution<float> noise(0.0f, 0.01f);
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  cloud.width = cols;
+  cloud.height = rows;
+  cloud.points.resize(static_cast<size_t>(rows) * cols);
+  for (int r = 0; r < rows; ++r)
+  {
+    float elevation = (22.5f - 45.0f * r / (rows - 1)) * static_cast<float>(M_PI) / 180.0f;
+    for (int c = 0; c < cols; ++c)
+    {
+      float azimuth = static_cast<float>(M_PI) - 2.0f * static_cast<float>(M_PI) * c / cols;
+      float range = 20.0f;
+      if (elevation < 0.0f)
+      {
+        range = std::min(range, 1.5f / std::sin(-elevation));
+      }
+      if (std::abs(azimuth) < 0.1f)
+      {
+        range = std::min(range, 5.0f);
+      }
+      range += noise(rng);
+      auto& p = cloud.points[static_cast<size_t>(r) * cols + c];
+      p.x = range * std::cos(elevation) * std::cos(azimuth);
+      p.y = range * std::cos(elevation) * std::sin(azimuth);
+      p.z = range * std::sin(elevation);
+      p.r = static_cast<std::uint8_t>(r * 2);
+      p.g = static_cast<std::uint8_t>(c / 8);
+      p.b = 128;
+    }
+  }
+  return cloud;
+}
+
+// Previous lidar_rgb_image_fuser::ousterCamCallback projection, drawing excluded
+size_t legacyProjection(const sensor_msgs::msg::PointCloud2& msg, const Eigen::MatrixXf& K, const Eigen::Matrix4f& T)
+{
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr pcl_cloud(new pcl::PointCloud<pcl::PointXYZRGB>);
+  pcl::fromROSMsg(msg, *pcl_cloud);
+  Eigen::MatrixXf points = Eigen::MatrixXf::Zero(4, msg.height * msg.width);
+  Eigen::MatrixXf colors = Eigen::MatrixXf::Zero(3, msg.height * msg.width);
+  int index_of_iterator = 0;
+  for (auto& point : pcl_cloud->points)
+  {
+    if (point.x < 0)
+    {
+      continue;
+    }
+    points(0, index_of_iterator) = point.x;
+    points(1, index_of_iterator) = point.y;
+    points(2, index_of_iterator) = point.z;
+    points(3, index_of_iterator) = 1;
+    colors(0, index_of_iterator) = point.r;
+    colors(1, index_of_iterator) = point.g;
+    colors(2, index_of_iterator) = point.b;
+    index_of_iterator++;
+  }
+  Eigen::MatrixXf uv = Eigen::MatrixXf::Zero(3, points.cols());
+  Eigen::MatrixXf image_points = K * T * points;
+  uv.row(0) = image_points.row(0).array() / image_points.row(2).array();
+  uv.row(1) = image_points.row(1).array() / image_points.row(2).array();
+  uv.row(2) = image_points.row(2);
+  size_t in_image = 0;
+  for (int i = 0; i < uv.cols(); i++)
+  {
+    int u = uv(0, i);
+    int v = uv(1, i);
+    if (u > 0 && u < kImageWidth && v > 0 && v < kImageHeight)
+    {
+      in_image++;
+    }
+  }
+  return in_image;
+}
+
+int failures = 0;
+
+void check(bool condition, const char* what)
+{
+  if (!condition)
+  {
+    std::cerr << "FAILED: " << what << std::endl;
+    failures++;
+  }
+}
+
+void checkSyntheticProjections()
+{
+  LidarCameraProjector projector(kImageWidth, kImageHeight);
+  projector.setProjection(cameraMatrix(), lidarToCamera());
+  auto pixel = [](int u, int v) { return v * kImageWidth + u; };
+
+  CloudSoA cloud;
+  cloud.resize(5);
+  // 0: on the optical axis at 5 m, lands on the principal point
+  // 1: behind 0 on the same ray, occluded
+  // 2: behind the camera
+  // 3: far outside the field of view
+  // 4: 1 m left and 0.5 m up at 4 m
+  float xs[] = { 5.0f, 10.0f, -5.0f, 5.0f, 4.0f };
+  float ys[] = { 0.0f, 0.0f, 0.0f, -100.0f, 1.0f };
+  float zs[] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.5f };
+  for (size_t i = 0; i < 5; ++i)
+  {
+    cloud.x[i] = xs[i];
+    cloud.y[i] = ys[i];
+    cloud.z[i] = zs[i];
+  }
+  size_t filled = projector.project(cloud);
+  const auto& pixels = projector.pointPixels();
+
+  check(filled == 2, "two pixels are filled");
+  check(pixels[0] == pixel(640, 360), "point on the optical axis lands on the principal point");
+  check(projector.visible(0), "nearest point on a pixel is visible");
+  check(pixels[1] == pixels[0], "occluded point projects to the same pixel");
+  check(!projector.visible(1), "farther point on a pixel is occluded");
+  check(projector.depthBuffer()[pixels[0]] == 5.0f, "depth buffer keeps the nearest depth");
+  check(pixels[2] == -1, "point behind the camera is dropped");
+  check(pixels[3] == -1, "point outside of the image is dropped");
+  // u = fx * -y / x + cx, v = fy * -z / x + cy
+  int u4 = static_cast<int>(365.71429443359375 * -1.0 / 4.0 + 640.5);
+  int v4 = static_cast<int>(365.4822082519531 * -0.5 / 4.0 + 360.5);
+  check(pixels[4] == pixel(u4, v4), "off axis point lands on its pinhole pixel");
+  check(std::abs(projector.pointDepths()[4] - 4.0f) < 1e-6f, "depth is taken along the camera axis");
+
+  // The buffer is reset between frames, the occluded point alone is visible again
+  CloudSoA second;
+  second.resize(1);
+  second.x[0] = 10.0f;
+  projector.project(second);
+  check(projector.visible(0), "depth buffer is reset between frames");
+  check(projector.depthBuffer()[pixel(640, 360)] == 10.0f, "depth buffer holds the new depth");
+
+  // Unpacking a PointCloud2 keeps coordinates and colors
+  pcl::PointCloud<pcl::PointXYZRGB> pcl_cloud;
+  pcl::PointXYZRGB p;
+  p.x = 1.0f;
+  p.y = 2.0f;
+  p.z = 3.0f;
+  p.r = 10;
+  p.g = 20;
+  p.b = 30;
+  pcl_cloud.push_back(p);
+  sensor_msgs::msg::PointCloud2 msg;
+  pcl::toROSMsg(pcl_cloud, msg);
+  CloudSoA unpacked;
+  pointCloud2ToSoA(msg, unpacked);
+  check(unpacked.size() == 1 && unpacked.x[0] == 1.0f && unpacked.y[0] == 2.0f && unpacked.z[0] == 3.0f,
+        "coordinates are unpacked");
+  check(unpacked.rgb[0] == ((10u << 16) | (20u << 8) | 30u), "colors are unpacked");
+
+  // Truncated data or a foreign byte order is rejected instead of read past the buffer
+  auto rejected = [&unpacked](const sensor_msgs::msg::PointCloud2& bad) {
+    try
+    {
+      pointCloud2ToSoA(bad, unpacked);
+    }
+    catch (const std::runtime_error&)
+    {
+      return true;
+    }
+    return false;
+  };
+  sensor_msgs::msg::PointCloud2 truncated = msg;
+  truncated.data.pop_back();
+  check(rejected(truncated), "data shorter than row_step * height is rejected");
+  sensor_msgs::msg::PointCloud2 short_rows = msg;
+  short_rows.row_step = msg.point_step - 1;
+  check(rejected(short_rows), "row_step shorter than width * point_step is rejected");
+  sensor_msgs::msg::PointCloud2 swapped = msg;
+  swapped.is_bigendian = !msg.is_bigendian;
+  check(rejected(swapped), "foreign byte order is rejected");
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_frames = argc > 1 ? std::stoul(argv[1]) : 50;
+
+  checkSyntheticProjections();
+  if (failures)
+  {
+    std::cerr << failures << " synthetic projection checks failed" << std::endl;
+    return 1;
+  }
+
+  std::mt19937 rng(5);
+  sensor_msgs::msg::PointCloud2 msg;
+  pcl::toROSMsg(organizedScan(128, 2048, rng), msg);
+
+  Eigen::MatrixXf K = cameraMatrix();
+  Eigen::Matrix4f T = lidarToCamera();
+  LidarCameraProjector projector(kImageWidth, kImageHeight);
+  projector.setProjection(cameraMatrix(), T);
+  CloudSoA soa;
+
+  double legacy_ms = 0.0, soa_ms = 0.0;
+  size_t legacy_in_image = 0, filled_pixels = 0, in_image = 0;
+  for (size_t f = 0; f < num_frames; ++f)
+  {
+    auto t0 = std::chrono::steady_clock::now();
+    legacy_in_image = legacyProjection(msg, K, T);
+    auto t1 = std::chrono::steady_clock::now();
+    pointCloud2ToSoA(msg, soa);
+    filled_pixels = projector.project(soa);
+    auto t2 = std::chrono::steady_clock::now();
+    legacy_ms += std::chrono::duration<double, std::milli>(t1 - t0).count() / num_frames;
+    soa_ms += std::chrono::duration<double, std::milli>(t2 - t1).count() / num_frames;
+  }
+  for (int pixel : projector.pointPixels())
+  {
+    in_image += pixel >= 0;
+  }
+
+  std::cout << "method,mean_ms,points_in_image,points_drawn" << std::endl;
+  std::cout << "legacy," << legacy_ms << "," << legacy_in_image << "," << legacy_in_image << std::endl;
+  std::cout << "soa_zbuffer," << soa_ms << "," << in_image << "," << filled_pixels << std::endl;
+  return 0;
+}
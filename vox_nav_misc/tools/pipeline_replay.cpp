@@ -0,0 +1,221 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Replays a recorded dataset (see ReplayDataset, synthetic_replay_dataset
+writes one) through a perception node in the same process, on sim time, and
+reports the latency from each scan to its output. In lockstep mode a scan
+is only published after the output of the previous one arrived, so the
+output digests are reproducible and can be compared against a baseline csv
+of an earlier run; any digest that differs makes the tool exit with 1.
+"rate" mode publishes at <rate> times the recorded rate, 0 for as fast as
+possible, and measures latency under load.
+Usage: pipeline_replay <dataset_dir> <clustering|tracker|traversability|ndt> [lockstep|rate] [rate] [out.csv] [baseline.csv]
+*/
+
+#include "vox_nav_misc/naive_lidar_clustering.hpp"
+#include "vox_nav_misc/pcl_cpu_ndt.hpp"
+#include "vox_nav_misc/replay_harness.hpp"
+#include "vox_nav_misc/traversablity_estimator.hpp"
+#include "vox_nav_misc/ukf_tracker.hpp"
+
+#include <rcutils/logging.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+
+using namespace vox_nav_misc;
+
+namespace
+{
+    std::map<size_t, uint64_t> readBaseline(const std::string &path)
+    {
+        std::map<size_t, uint64_t> digests;
+        std::ifstream file(path);
+        std::string line;
+        std::getline(file, line); // header
+        while (std::getline(file, line))
+        {
+            std::stringstream ss(line);
+            std::string index, stamp, latency, digest;
+            if (std::getline(ss, index, ',') && std::getline(ss, stamp, ',') &&
+                std::getline(ss, latency, ',') && std::getline(ss, digest, ','))
+            {
+                digests[std::stoul(index)] = std::stoull(digest, nullptr, 16);
+            }
+        }
+        return digests;
+    }
+
+    double percentile(std::vector<double> values, double p)
+    {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        size_t k = std::min(values.size() - 1, static_cast<size_t>(p * (values.size() - 1) + 0.5));
+        std::nth_element(values.begin(), values.begin() + k, values.end());
+        return values[k];
+    }
+} // namespace
+
+int main(int argc, char const *argv[])
+{
+    if (argc < 3)
+    {
+        std::cerr << "Usage: pipeline_replay <dataset_dir> <clustering|tracker|traversability|ndt> "
+                     "[lockstep|rate] [rate] [out.csv] [baseline.csv]"
+                  << std::endl;
+        return 1;
+    }
+    std::string dataset_dir = argv[1];
+    std::string pipeline = argv[2];
+    ReplayParams params;
+    params.mode = (argc > 3 && std::string(argv[3]) == "rate") ? ReplayMode::RATE : ReplayMode::LOCKSTEP;
+    params.rate = argc > 4 ? std::stod(argv[4]) : 0.0;
+    std::string out_csv = argc > 5 ? argv[5] : "pipeline_replay.csv";
+    std::string baseline_csv = argc > 6 ? argv[6] : "";
+
+    ReplayDataset dataset;
+    try
+    {
+        dataset = loadReplayDataset(dataset_dir);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    rclcpp::init(argc, argv);
+    auto options = rclcpp::NodeOptions()
+                       .use_global_arguments(false)
+                       .parameter_overrides({rclcpp::Parameter("use_sim_time", true)});
+
+    // Nodes under test, the harness is configured for the topics they use
+    std::vector<rclcpp::Node::SharedPtr> nodes;
+    if (pipeline == "clustering" || pipeline == "tracker")
+    {
+        nodes.push_back(std::make_shared<NaiveLIDARClustering>(options));
+        if (pipeline == "tracker")
+        {
+            nodes.push_back(std::make_shared<UKFTracker>(options));
+            params.output_topic = "tracks";
+        }
+    }
+    else if (pipeline == "traversability")
+    {
+        nodes.push_back(std::make_shared<TraversabilityEstimator>(options));
+        params.output_topic = "traversable_cloud";
+        params.output_type = "sensor_msgs/msg/PointCloud2";
+    }
+    else if (pipeline == "ndt")
+    {
+        nodes.push_back(std::make_shared<PCLCPUNDT>(options));
+        params.cloud_topic = "/ouster/points";
+        params.odom_topic = "odometry/gps";
+        params.map_topic = "vox_nav/map_server/octomap_pointcloud";
+        params.output_topic = "vox_nav/cupoch/icp_base_to_map_pose";
+        params.output_type = "geometry_msgs/msg/PoseWithCovarianceStamped";
+    }
+    else
+    {
+        std::cerr << "Unknown pipeline " << pipeline << std::endl;
+        rclcpp::shutdown();
+        return 1;
+    }
+    for (const auto &node : nodes)
+    {
+        rcutils_logging_set_logger_level(node->get_logger().get_name(), RCUTILS_LOG_SEVERITY_ERROR);
+    }
+
+    auto harness = std::make_shared<ReplayHarness>(
+        params, rclcpp::NodeOptions().use_global_arguments(false));
+
+    // Everything is spun on one thread, like the nodes are when launched on their own
+    rclcpp::executors::SingleThreadedExecutor executor;
+    executor.add_node(harness);
+    for (const auto &node : nodes)
+    {
+        executor.add_node(node);
+    }
+    std::thread spinner([&executor]()
+                        { executor.spin(); });
+
+    auto t0 = std::chrono::steady_clock::now();
+    auto records = harness->run(dataset);
+    double wall_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    executor.cancel();
+    spinner.join();
+
+    std::ofstream csv(out_csv);
+    csv << "index,stamp_ns,latency_ms,digest" << std::endl;
+    std::vector<double> latencies;
+    uint64_t combined_digest = fnv1a64(nullptr, 0);
+    for (const auto &record : records)
+    {
+        std::stringstream digest;
+        digest << std::hex << record.digest;
+        csv << record.index << "," << record.stamp_ns << "," << record.latency_ms << "," << digest.str() << std::endl;
+        if (record.latency_ms >= 0.0)
+        {
+            latencies.push_back(record.latency_ms);
+        }
+        combined_digest = fnv1a64(reinterpret_cast<const uint8_t *>(&record.digest), sizeof(record.digest),
+                                  combined_digest);
+    }
+
+    double mean = 0.0;
+    for (double latency : latencies)
+    {
+        mean += latency / latencies.size();
+    }
+    double recorded_s = (dataset.clouds.back().first - dataset.clouds.front().first) * 1e-9;
+
+    std::cout << "pipeline,mode,scans,outputs,missing,mean_ms,p50_ms,p95_ms,max_ms,realtime_factor,digest"
+              << std::endl;
+    std::cout << pipeline << "," << (params.mode == ReplayMode::LOCKSTEP ? "lockstep" : "rate") << ","
+              << records.size() << "," << latencies.size() << "," << records.size() - latencies.size() << ","
+              << mean << "," << percentile(latencies, 0.5) << "," << percentile(latencies, 0.95) << ","
+              << percentile(latencies, 1.0) << "," << (wall_s > 0.0 ? recorded_s / wall_s : 0.0) << ","
+              << std::hex << combined_digest << std::dec << std::endl;
+
+    int failures = 0;
+    if (!baseline_csv.empty())
+    {
+        auto baseline = readBaseline(baseline_csv);
+        for (const auto &record : records)
+        {
+            auto it = baseline.find(record.index);
+            if (it == baseline.end() || it->second != record.digest)
+            {
+                std::cerr << "FAILED: output of scan " << record.index << " differs from " << baseline_csv
+                          << std::endl;
+                failures++;
+            }
+        }
+    }
+
+    nodes.clear();
+    harness.reset();
+    rclcpp::shutdown();
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Per scan update time of RollingTraversabilityGrid against the full surfel
+recomputation done by TraversabilityEstimator::regressCosts, on a replayed
+sequence of synthetic scans of a robot driving over hilly terrain with steps.
+Usage: rolling_grid_benchmark [num_scans] [points_per_scan]
+*/
+
+#include "vox_nav_misc/rolling_traversability_grid.hpp"
+
+#include <vox_nav_utilities/map_manager_helpers.hpp>
+#include <vox_nav_utilities/pcl_helpers.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace vox_nav_misc;
+using Cloud = pcl::PointCloud<pcl::PointXYZRGB>;
+
+namespace
+{
+double terrainHeight(double x, double y)
+{
+  double step = (std::fmod(std::abs(x), 12.0) > 6.0) ? 0.15 : 0.0;
+  return 0.5 * std::sin(0.2 * x) * std::cos(0.15 * y) + step;
+}
+
+Cloud::Ptr scanAt(double robot_x, double robot_y, size_t num_points, std::mt19937& rng)
+{
+  std::uniform_real_distribution<double> radius(0.0, 1.0);
+  std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+  std::normal_distribution<double> noise(0.0, 0.02);
+  Cloud::Ptr cloud(new Cloud);
+  cloud->points.resize(num_points);
+  for (auto& p : cloud->points)
+  {
+    // Denser close to the sensor, like a spinning lidar
+    double r = 10.0 * radius(rng) * radius(rng);
+    double a = angle(rng);
+    p.x = robot_x + r * std::cos(a);
+    p.y = robot_y + r * std::sin(a);
+    p.z = terrainHeight(p.x, p.y) + noise(rng);
+    p.r = 0;
+    p.g = 255;
+    p.b = 0;
+  }
+  cloud->width = num_points;
+  cloud->height = 1;
+  return cloud;
+}
+
+// Mirrors TraversabilityEstimator::regressCosts
+size_t fullRecompute(const Cloud::Ptr& cloud, const CostRegressionParams& params)
+{
+  auto uniformly_sampled_nodes =
+      vox_nav_utilities::uniformlySampleCloud<pcl::PointXYZRGB>(cloud, params.uniform_sample_radius);
+  auto surfels =
+      vox_nav_utilities::surfelize_traversability_cloud(cloud, uniformly_sampled_nodes, params.surfel_radius);
+  size_t regressed = 0;
+  for (auto&& i : surfels)
+  {
+    pcl::ModelCoefficients::Ptr plane_model(new pcl::ModelCoefficients);
+    try
+    {
+      vox_nav_utilities::fit_plane_to_cloud(plane_model, i.second, params.plane_fit_threshold);
+    }
+    catch (...)
+    {
+      continue;
+    }
+    vox_nav_utilities::rpy_from_plane(*plane_model);
+    vox_nav_utilities::average_point_deviation_from_plane(i.second, *plane_model);
+    vox_nav_utilities::max_energy_gap_in_cloud(i.second, params.robot_mass, params.average_speed);
+    regressed++;
+  }
+  return regressed;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  size_t num_scans = argc > 1 ? std::stoul(argv[1]) : 50;
+  size_t points_per_scan = argc > 2 ? std::stoul(argv[2]) : 60000;
+
+  CostRegressionParams cost_params;
+  cost_params.uniform_sample_radius = 0.2;
+  cost_params.surfel_radius = 0.8;
+  cost_params.max_allowed_tilt = 40.0;
+  cost_params.max_allowed_point_deviation = 0.2;
+  cost_params.max_allowed_energy_gap = 0.2;
+  cost_params.plane_fit_threshold = 0.2;
+  cost_params.robot_mass = 0.1;
+  cost_params.average_speed = 1.0;
+  cost_params.cost_critic_weights = { 0.8, 0.1, 0.1 };
+
+  RollingGridParams grid_params;
+  grid_params.resolution = cost_params.uniform_sample_radius;
+  grid_params.window_radius = cost_params.surfel_radius;
+  RollingTraversabilityGrid grid(grid_params, cost_params);
+
+  std::mt19937 rng(3);
+  std::cout << "scan,full_recompute_ms,full_surfels,rolling_grid_ms,rolling_recomputed_cells,rolling_output_cells"
+            << std::endl;
+  double full_total = 0.0, grid_total = 0.0;
+  for (size_t s = 0; s < num_scans; ++s)
+  {
+    // 0.3 m per scan, about 3 m/s at 10 Hz
+    double robot_x = 0.3 * s;
+    double robot_y = 0.5 * std::sin(0.05 * s);
+    auto scan = scanAt(robot_x, robot_y, points_per_scan, rng);
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t full_surfels = fullRecompute(scan, cost_params);
+    auto t1 = std::chrono::steady_clock::now();
+    grid.moveTo(robot_x, robot_y);
+    grid.insert(*scan);
+    size_t recomputed = grid.updateCosts();
+    auto output = grid.getTraversableCloud();
+    auto t2 = std::chrono::steady_clock::now();
+
+    double full_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    double grid_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    full_total += full_ms;
+    grid_total += grid_ms;
+    std::cout << s << "," << full_ms << "," << full_surfels << "," << grid_ms << "," << recomputed << ","
+              << output->points.size() << std::endl;
+  }
+  std::cerr << "mean full recompute " << full_total / num_scans << " ms, mean rolling grid "
+            << grid_total / num_scans << " ms" << std::endl;
+  return 0;
+}
@@ -0,0 +1,205 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Writes a replay dataset for pipeline_replay: a robot driving at 1 m/s along
+x over a slightly rolling ground plane, with a few boxes moving around it.
+Scans are 10 Hz in base_link, odometry 50 Hz and imu 100 Hz, and map.pcd
+holds the static ground around the whole trajectory. The output only
+depends on the seed, so baselines recorded on it stay comparable.
+Usage: synthetic_replay_dataset [output_dir] [num_scans] [seed]
+*/
+
+#include "vox_nav_misc/replay_harness.hpp"
+
+#define PCL_NO_PRECOMPILE
+#include <pcl/io/pcd_io.h>
+#include <pcl/point_types.h>
+
+#include <cmath>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+// Has the fields of both XYZI (clustering) and XYZRGB (the other nodes)
+struct EIGEN_ALIGN16 ReplayPoint
+{
+  PCL_ADD_POINT4D;
+  float intensity;
+  PCL_ADD_RGB;
+  EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+POINT_CLOUD_REGISTER_POINT_STRUCT(ReplayPoint,
+                                  (float, x, x)(float, y, y)(float, z, z)(float, intensity, intensity)(float, rgb, rgb))
+
+using namespace vox_nav_misc;
+using Cloud = pcl::PointCloud<ReplayPoint>;
+
+namespace
+{
+constexpr int64_t kStartNs = 1000000000LL;
+constexpr double kSpeed = 1.0;
+
+struct MovingBox
+{
+  Eigen::Vector2d start;
+  Eigen::Vector2d velocity;
+  Eigen::Vector3d size;
+};
+
+double groundHeight(double x, double y)
+{
+  return 0.1 * std::sin(0.3 * x) * std::cos(0.2 * y);
+}
+
+ReplayPoint makePoint(double x, double y, double z, float intensity, uint8_t r, uint8_t g, uint8_t b)
+{
+  ReplayPoint p;
+  p.x = x;
+  p.y = y;
+  p.z = z;
+  p.intensity = intensity;
+  p.r = r;
+  p.g = g;
+  p.b = b;
+  p.a = 255;
+  return p;
+}
+
+void finalize(Cloud& cloud)
+{
+  cloud.width = cloud.points.size();
+  cloud.height = 1;
+  cloud.is_dense = true;
+}
+}  // namespace
+
+int main(int argc, char const* argv[])
+{
+  std::string out_dir = argc > 1 ? argv[1] : "synthetic_replay_dataset";
+  int num_scans = argc > 2 ? std::stoi(argv[2]) : 100;
+  unsigned seed = argc > 3 ? std::stoul(argv[3]) : 42;
+
+  std::filesystem::create_directories(std::filesystem::path(out_dir) / "clouds");
+  std::mt19937 rng(seed);
+  std::normal_distribution<double> noise(0.0, 0.01);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+
+  std::vector<MovingBox> boxes;
+  for (int i = 0; i < 6; i++)
+  {
+    MovingBox box;
+    box.start = Eigen::Vector2d(4.0 + 3.0 * i, (i % 2 ? 1.0 : -1.0) * (2.0 + 2.0 * unit(rng)));
+    box.velocity = Eigen::Vector2d(0.5 * unit(rng), (i % 2 ? -0.3 : 0.3) * unit(rng));
+    box.size = Eigen::Vector3d(0.6 + unit(rng), 0.6 + unit(rng), 1.0 + unit(rng));
+    boxes.push_back(box);
+  }
+
+  double duration_s = 0.1 * num_scans;
+
+  // Prior map, ground only, in the map frame which equals odom at the start
+  Cloud map;
+  for (double x = -20.0; x < duration_s * kSpeed + 20.0; x += 0.2)
+  {
+    for (double y = -20.0; y < 20.0; y += 0.2)
+    {
+      map.points.push_back(makePoint(x, y, groundHeight(x, y), 10.0f, 0, 255, 0));
+    }
+  }
+  finalize(map);
+  pcl::io::savePCDFileBinaryCompressed((std::filesystem::path(out_dir) / "map.pcd").string(), map);
+
+  std::vector<ReplayOdomSample> odom;
+  for (int64_t t = 0; t <= static_cast<int64_t>(duration_s * 1e9); t += 20000000LL)
+  {
+    ReplayOdomSample s;
+    s.stamp_ns = kStartNs + t;
+    s.position = Eigen::Vector3d(kSpeed * t * 1e-9, 0.0, 0.0);
+    s.position.z() = groundHeight(s.position.x(), 0.0);
+    s.orientation = Eigen::Quaterniond::Identity();
+    s.linear_velocity = Eigen::Vector3d(kSpeed, 0.0, 0.0);
+    s.angular_velocity = Eigen::Vector3d::Zero();
+    odom.push_back(s);
+  }
+  writeReplayOdomCsv((std::filesystem::path(out_dir) / "odom.csv").string(), odom);
+
+  std::vector<ReplayImuSample> imu;
+  for (int64_t t = 0; t <= static_cast<int64_t>(duration_s * 1e9); t += 10000000LL)
+  {
+    ReplayImuSample s;
+    s.stamp_ns = kStartNs + t;
+    s.orientation = Eigen::Quaterniond::Identity();
+    s.angular_velocity = Eigen::Vector3d(noise(rng), noise(rng), noise(rng));
+    s.linear_acceleration = Eigen::Vector3d(noise(rng), noise(rng), 9.81 + noise(rng));
+    imu.push_back(s);
+  }
+  writeReplayImuCsv((std::filesystem::path(out_dir) / "imu.csv").string(), imu);
+
+  size_t total_points = 0;
+  for (int i = 0; i < num_scans; i++)
+  {
+    int64_t stamp_ns = kStartNs + i * 100000000LL;
+    double t = i * 0.1;
+    double robot_x = kSpeed * t;
+    double robot_z = groundHeight(robot_x, 0.0);
+
+    // Points are generated in the map frame and moved into base_link
+    Cloud scan;
+    for (double x = -15.0; x < 15.0; x += 0.25)
+    {
+      for (double y = -15.0; y < 15.0; y += 0.25)
+      {
+        double wx = robot_x + x;
+        scan.points.push_back(
+            makePoint(x, y, groundHeight(wx, y) - robot_z + noise(rng), 10.0f, 0, 255, 0));
+      }
+    }
+    for (const auto& box : boxes)
+    {
+      Eigen::Vector2d center = box.start + t * box.velocity;
+      Eigen::Vector2d local(center.x() - robot_x, center.y());
+      if (std::abs(local.x()) > 14.0 || std::abs(local.y()) > 14.0)
+      {
+        continue;
+      }
+      double base = groundHeight(center.x(), center.y()) - robot_z;
+      // The four sides, as a lidar would see a box around it
+      for (double h = 0.05; h < box.size.z(); h += 0.1)
+      {
+        for (double s = -0.5; s <= 0.5; s += 0.1)
+        {
+          for (double side = -0.5; side <= 0.5; side += 1.0)
+          {
+            scan.points.push_back(makePoint(local.x() + s * box.size.x() + noise(rng),
+                                            local.y() + side * box.size.y() + noise(rng), base + h, 80.0f, 255, 0, 0));
+            scan.points.push_back(makePoint(local.x() + side * box.size.x() + noise(rng),
+                                            local.y() + s * box.size.y() + noise(rng), base + h, 80.0f, 255, 0, 0));
+          }
+        }
+      }
+    }
+    finalize(scan);
+    total_points += scan.points.size();
+    pcl::io::savePCDFileBinary(
+        (std::filesystem::path(out_dir) / "clouds" / (std::to_string(stamp_ns) + ".pcd")).string(), scan);
+  }
+
+  std::cout << "scans,points_per_scan,odom,imu,map_points" << std::endl;
+  std::cout << num_scans << "," << (num_scans ? total_points / num_scans : 0) << "," << odom.size() << ","
+            << imu.size() << "," << map.points.size() << std::endl;
+  return 0;
+}
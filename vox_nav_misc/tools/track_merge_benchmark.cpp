@@ -0,0 +1,94 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Benchmark of duplicate track search used by UKFTracker::TrackManagement.
+Crowded scenes of 100-2000 tracks are generated, the spatially hashed search is
+timed against the O(T^2) double loop and merge decisions of both are compared.
+Usage: track_merge_benchmark [repetitions]
+*/
+
+#include "vox_nav_misc/track_store.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace vox_nav_misc;
+
+namespace
+{
+    // Tracks are spread over a square whose area grows with the count so that
+    // density, and therefore the number of close pairs, stays like a busy crossing
+    std::vector<Eigen::Vector3f> crowdedScene(int num_tracks, std::mt19937 &rng)
+    {
+        const float area_per_track = 4.0f; // m^2
+        const float half_extent = 0.5f * std::sqrt(area_per_track * num_tracks);
+        std::uniform_real_distribution<float> xy(-half_extent, half_extent);
+        std::uniform_real_distribution<float> z(-0.2f, 0.2f);
+        std::vector<Eigen::Vector3f> positions(num_tracks);
+        for (auto &p : positions)
+        {
+            p = Eigen::Vector3f(xy(rng), xy(rng), z(rng));
+        }
+        return positions;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int repetitions = argc > 1 ? std::atoi(argv[1]) : 50;
+    const float min_dist = 1.0f;
+    std::mt19937 rng(42);
+
+    TrackSpatialHash hash;
+    std::vector<int> hashed, brute;
+    bool all_match = true;
+
+    std::cout << "num_tracks,brute_force_us,find_duplicates_us,speedup,duplicates,mismatches" << std::endl;
+    for (int num_tracks : {100, 250, 500, 1000, 2000})
+    {
+        double brute_us = 0.0, hashed_us = 0.0;
+        size_t duplicates = 0, mismatches = 0;
+        for (int r = 0; r < repetitions; ++r)
+        {
+            auto positions = crowdedScene(num_tracks, rng);
+
+            auto t0 = std::chrono::steady_clock::now();
+            duplicates += findDuplicateTracksBruteForce(positions, min_dist, brute);
+            auto t1 = std::chrono::steady_clock::now();
+            findDuplicateTracks(positions, min_dist, hash, hashed);
+            auto t2 = std::chrono::steady_clock::now();
+
+            brute_us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+            hashed_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+            for (int i = 0; i < num_tracks; ++i)
+            {
+                mismatches += (hashed[i] != brute[i]);
+            }
+        }
+        all_match &= (mismatches == 0);
+        std::cout << num_tracks << "," << brute_us / repetitions << "," << hashed_us / repetitions << ","
+                  << brute_us / hashed_us << "," << duplicates / repetitions << "," << mismatches << std::endl;
+    }
+
+    if (!all_match)
+    {
+        std::cerr << "Merge decisions of spatial hash and brute force differ" << std::endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Offline accuracy and speed benchmark of the UKF tracking of UKFTracker on
+synthetic scenarios. Detections are fed straight into UKFTrackingCore, no node
+is created and rclcpp is not initialized, so only the tracking is timed.
+Usage: ukf_tracker_mot_benchmark [output_prefix] [seed] [num_frames]
+Writes <output_prefix>_frames.csv and <output_prefix>_summary.csv.
+*/
+
+#include "vox_nav_misc/mot_evaluation.hpp"
+#include "vox_nav_misc/ukf_tracking_core.hpp"
+
+#include <rcutils/logging.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+using namespace vox_nav_misc;
+
+namespace
+{
+    UKTrackerParameters trackerParameters()
+    {
+        UKTrackerParameters params;
+        params.da_ped_dist_pos = 2.0;
+        params.da_ped_dist_form = 2.5;
+        params.da_car_dist_pos = 3.0;
+        params.da_car_dist_form = 4.0;
+        params.tra_dim_z = 2;
+        params.tra_dim_x = 5;
+        params.tra_dim_x_aug = 7;
+        params.tra_std_lidar_x = 0.15;
+        params.tra_std_lidar_y = 0.15;
+        params.tra_std_acc = 2.0;
+        params.tra_std_yaw_rate = 0.3;
+        params.tra_lambda = -4.0;
+        params.tra_aging_bad = 5;
+        params.tra_occ_factor = 1.5;
+        params.tra_min_dist_between_tracks = 1.0;
+        params.p_init_x = 1.0;
+        params.p_init_y = 1.0;
+        params.p_init_v = 10.0;
+        params.p_init_yaw = 1.0;
+        params.p_init_yaw_rate = 0.1;
+        return params;
+    }
+} // namespace
+
+int main(int argc, char const *argv[])
+{
+    std::string prefix = argc > 1 ? argv[1] : "ukf_tracker_mot";
+    MOTScenarioConfig config;
+    if (argc > 2)
+    {
+        config.seed = std::stoul(argv[2]);
+    }
+    if (argc > 3)
+    {
+        config.num_frames = std::stoi(argv[3]);
+    }
+
+    rcutils_logging_initialize();
+    auto logger = rclcpp::get_logger("ukf_tracker_mot_benchmark");
+    rcutils_logging_set_logger_level(logger.get_name(), RCUTILS_LOG_SEVERITY_ERROR);
+    UKFTrackingCore tracker(trackerParameters(), logger);
+
+    MOTScenarioGenerator generator(config);
+    auto frames = generator.generate();
+
+    MOTMetrics metrics;
+    for (const auto &frame : frames)
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        auto tracks = tracker.processDetections(frame.detections, config.dt);
+        auto t1 = std::chrono::steady_clock::now();
+        metrics.update(
+            frame.truth, tracks, std::chrono::duration<double, std::milli>(t1 - t0).count());
+    }
+
+    std::ofstream frames_csv(prefix + "_frames.csv");
+    metrics.writeFramesCSV(frames_csv);
+    std::ofstream summary_csv(prefix + "_summary.csv");
+    metrics.writeSummaryCSV(summary_csv);
+    metrics.writeSummaryCSV(std::cout);
+    return 0;
+}
@@ -0,0 +1,77 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_NAVIGATORS__ASYNC_BT_LOGGER_HPP_
+#define VOX_NAV_NAVIGATORS__ASYNC_BT_LOGGER_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "behaviortree_cpp_v3/loggers/abstract_logger.h"
+
+namespace vox_nav_navigators
+{
+
+  /**
+   * @brief Status change logger with the output format of BT::StdCoutLogger.
+   * Transitions are only recorded in the ticking thread, formatting and
+   * writing to stdout happen in a background thread that drains the buffer
+   * every flush_period, so logging never blocks a tick on console I/O.
+   *
+   */
+  class AsyncBtLogger : public BT::StatusChangeLogger
+  {
+  public:
+    AsyncBtLogger(
+      const BT::Tree & tree,
+      std::chrono::milliseconds flush_period = std::chrono::milliseconds(100));
+
+    ~AsyncBtLogger() override;
+
+    void callback(
+      BT::Duration timestamp, const BT::TreeNode & node,
+      BT::NodeStatus prev_status, BT::NodeStatus status) override;
+
+    // Write out everything recorded so far, blocks until done
+    void flush() override;
+
+  private:
+    struct Record
+    {
+      BT::Duration timestamp;
+      const BT::TreeNode * node;
+      BT::NodeStatus prev_status;
+      BT::NodeStatus status;
+    };
+
+    void writerLoop();
+    void write(const std::vector<Record> & records);
+
+    std::chrono::milliseconds flush_period_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::vector<Record> buffer_;
+    bool stop_{false};
+    // Serializes writes of the background thread and flush()
+    std::mutex write_mutex_;
+    std::thread writer_;
+  };
+
+}  // namespace vox_nav_navigators
+
+#endif  // VOX_NAV_NAVIGATORS__ASYNC_BT_LOGGER_HPP_
@@ -22,6 +22,9 @@
 #include "behaviortree_cpp_v3/behavior_tree.h"
 #include "behaviortree_cpp_v3/bt_factory.h"
 #include "behaviortree_cpp_v3/xml_parsing.h"
+#include "vox_nav_navigators/async_bt_logger.hpp"
+#include "vox_nav_navigators/behavior_tree_cache.hpp"
+#include "vox_nav_navigators/tree_wake_up.hpp"
 
 namespace vox_nav_navigators
 {
@@ -41,23 +44,35 @@ namespace vox_nav_navigators
     BehaviorTree() = delete;
     virtual ~BehaviorTree() {}
 
+    // The tree is instantiated on the first call and reused by later calls,
+    // so one BehaviorTree can be executed once per waypoint. Blackboard values
+    // must be updated by the caller before each call.
+    // The tree is ticked whenever one of its nodes signals the wake up condition,
+    // and at the latest after max_idle_period, which also bounds how late should_halt is seen.
     BtStatus execute(
       std::function<bool()> should_halt = []() {return false;},
       std::function<void()> on_loop_iteration = []() {},
-      std::chrono::milliseconds tick_period = std::chrono::milliseconds(10));
+      std::chrono::milliseconds max_idle_period = std::chrono::milliseconds(100));
 
     BT::Blackboard::Ptr blackboard() {return blackboard_;}
-    BT::BehaviorTreeFactory & factory() {return factory_;}
+    TreeWakeUp::SharedPtr wakeUp() {return wake_up_;}
+    BT::BehaviorTreeFactory & factory() {return BehaviorTreeCache::instance().factory();}
 
   protected:
-    // The factory to use when dynamically constructing the Behavior Tree
-    BT::BehaviorTreeFactory factory_;
-
-    // XML parser to parse the supplied BT XML input
-    BT::XMLParser xml_parser_;
+    // The XML this tree is instantiated from, parsed once per process by BehaviorTreeCache
+    std::string bt_xml_;
 
     // The blackboard to be shared by all of the Behavior Tree's nodes
     BT::Blackboard::Ptr blackboard_;
+
+    // Signalled by the action nodes when their servers respond, also on the blackboard
+    TreeWakeUp::SharedPtr wake_up_;
+
+    // Instantiated on first execute()
+    std::unique_ptr<BT::Tree> tree_;
+
+    // Declared after tree_ so that it is destroyed before the nodes it refers to
+    std::unique_ptr<AsyncBtLogger> logger_;
   };
 
 }  // namespace vox_nav_navigators
@@ -0,0 +1,83 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_NAVIGATORS__BEHAVIOR_TREE_CACHE_HPP_
+#define VOX_NAV_NAVIGATORS__BEHAVIOR_TREE_CACHE_HPP_
+
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "behaviortree_cpp_v3/behavior_tree.h"
+#include "behaviortree_cpp_v3/bt_factory.h"
+#include "behaviortree_cpp_v3/xml_parsing.h"
+
+namespace vox_nav_navigators
+{
+
+  /**
+   * @brief Process wide store of the behavior tree factory and parsed trees.
+   * Every plugin library is loaded (dlopen + registration) only once per
+   * process and every distinct XML text is parsed only once, so that
+   * building a tree for a new goal or waypoint only instantiates nodes.
+   *
+   */
+  class BehaviorTreeCache
+  {
+  public:
+    static BehaviorTreeCache & instance();
+
+    /**
+     * @brief Register the libraries that were not registered yet
+     *
+     * @param plugin_library_names library names without "lib" prefix and ".so" suffix
+     */
+    void registerPlugins(const std::vector<std::string> & plugin_library_names);
+
+    /**
+     * @brief Instantiate a tree from the parsed template of bt_xml,
+     * the XML is parsed on first use only. Threads instantiate concurrently,
+     * only registration and the first parse of an XML are exclusive
+     *
+     * @param bt_xml
+     * @param blackboard
+     * @return BT::Tree
+     */
+    BT::Tree instantiateTree(const std::string & bt_xml, const BT::Blackboard::Ptr & blackboard);
+
+    BT::BehaviorTreeFactory & factory() {return factory_;}
+
+    size_t numRegisteredPlugins() const;
+    size_t numParsedTrees() const;
+
+  private:
+    BehaviorTreeCache() = default;
+    BehaviorTreeCache(const BehaviorTreeCache &) = delete;
+    BehaviorTreeCache & operator=(const BehaviorTreeCache &) = delete;
+
+    // Exclusive for registration and parsing, shared for instantiation
+    mutable std::shared_mutex mutex_;
+    BT::BehaviorTreeFactory factory_;
+    std::set<std::string> registered_plugins_;
+    // Keyed by the XML text itself, so two trees never share a template on a hash collision
+    std::unordered_map<std::string, std::unique_ptr<BT::XMLParser>> parsed_trees_;
+  };
+
+}  // namespace vox_nav_navigators
+
+#endif  // VOX_NAV_NAVIGATORS__BEHAVIOR_TREE_CACHE_HPP_
@@ -17,13 +17,19 @@
 
 #include <memory>
 #include <string>
+#include <vector>
 
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_action/rclcpp_action.hpp"
 #include "vox_nav_navigators/behavior_tree.hpp"
+#include "vox_nav_navigators/pipelined_mission_executor.hpp"
+#include "vox_nav_navigators/ros_mission_backend.hpp"
 #include "vox_nav_msgs/action/navigate_through_gps_poses.hpp"
+#include "vox_nav_utilities/geodetic_conversions.hpp"
 #include "vox_nav_utilities/tf_helpers.hpp"
 #include <robot_localization/srv/from_ll.hpp>
+#include <tf2_ros/buffer.h>
+#include <tf2_ros/transform_listener.h>
 
 
 namespace vox_nav_navigators
@@ -57,10 +63,32 @@ namespace vox_nav_navigators
     // The routine to run on the separate thread
     void navigate_through_gps_poses(const std::shared_ptr<GoalHandle> goal_handle);
 
+    // Anchors geodetic_converter_ with the utm -> map transform of navsat_transform,
+    // false if that is not broadcasted
+    bool updateGeodeticDatum(const sensor_msgs::msg::NavSatFix & gps_pose);
+
+    // Converts gps poses with one /fromLL call each, when there is no utm -> map transform
+    bool fromLLToMapPoints(
+      const std::vector<sensor_msgs::msg::NavSatFix> & gps_poses,
+      std::vector<Eigen::Vector3d> & map_points);
+
+    // Converts all gps waypoints of a goal to poses in the map frame, in process if possible
+    bool gpsToMapPoses(
+      const std::vector<sensor_msgs::msg::NavSatFix> & gps_poses,
+      std::vector<geometry_msgs::msg::PoseStamped> & map_poses);
+
     // The XML string that defines the Behavior Tree used to implement the print_message action
     static const char bt_xml_[];
 
     rclcpp::Client<robot_localization::srv::FromLL>::SharedPtr robot_localization_fromLL_client_;
+    std::shared_ptr<tf2_ros::Buffer> tf_buffer_;
+    std::shared_ptr<tf2_ros::TransformListener> tf_listener_;
+    vox_nav_utilities::GeodeticConverter geodetic_converter_;
+
+    // Plan the next leg while the current one is followed, instead of running the tree per waypoint
+    bool pipelined_planning_;
+    PipelinedMissionParams mission_params_;
+    std::shared_ptr<RosMissionBackend> mission_backend_;
 
   };
 }  // namespace vox_nav_navigators
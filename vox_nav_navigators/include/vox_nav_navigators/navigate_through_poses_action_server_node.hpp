@@ -21,6 +21,8 @@
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_action/rclcpp_action.hpp"
 #include "vox_nav_navigators/behavior_tree.hpp"
+#include "vox_nav_navigators/pipelined_mission_executor.hpp"
+#include "vox_nav_navigators/ros_mission_backend.hpp"
 #include "vox_nav_msgs/action/navigate_to_pose.hpp"
 #include "vox_nav_msgs/action/navigate_through_poses.hpp"
 
@@ -58,6 +60,11 @@ namespace vox_nav_navigators
 
     // The XML string that defines the Behavior Tree used to implement the print_message action
     static const char bt_xml_[];
+
+    // Plan the next leg while the current one is followed, instead of running the tree per waypoint
+    bool pipelined_planning_;
+    PipelinedMissionParams mission_params_;
+    std::shared_ptr<RosMissionBackend> mission_backend_;
   };
 }  // namespace vox_nav_navigators
 
@@ -0,0 +1,151 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_NAVIGATORS__PIPELINED_MISSION_EXECUTOR_HPP_
+#define VOX_NAV_NAVIGATORS__PIPELINED_MISSION_EXECUTOR_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <vector>
+
+#include "geometry_msgs/msg/pose_stamped.hpp"
+#include "nav_msgs/msg/path.hpp"
+
+namespace vox_nav_navigators
+{
+
+  enum class MissionStatus { SUCCEEDED, FAILED, CANCELED };
+
+  enum class FollowStatus { IDLE, RUNNING, SUCCEEDED, FAILED };
+
+  /**
+   * @brief What PipelinedMissionExecutor needs from the robot: a planner,
+   * a controller and the robot pose. Implemented on top of the planner and
+   * controller servers by RosMissionBackend, and by a simulation in the benchmark.
+   *
+   */
+  class MissionBackend
+  {
+  public:
+    virtual ~MissionBackend() = default;
+
+    /**
+     * @brief Request a plan from start to goal, the result is an empty path if planning failed
+     *
+     * @param start a start with an empty frame_id means the current robot pose
+     * @param goal
+     * @return std::shared_future<nav_msgs::msg::Path>
+     */
+    virtual std::shared_future<nav_msgs::msg::Path> requestPlan(
+      const geometry_msgs::msg::PoseStamped & start,
+      const geometry_msgs::msg::PoseStamped & goal) = 0;
+
+    // Start following path, preempting the path that is currently followed
+    virtual void followPath(const nav_msgs::msg::Path & path) = 0;
+
+    // Status of the path passed last to followPath
+    virtual FollowStatus followStatus() = 0;
+
+    // Stop following, the robot should come to a halt
+    virtual void cancel() = 0;
+
+    virtual bool getRobotPose(geometry_msgs::msg::PoseStamped & pose) = 0;
+
+    // Changes whenever the map the planner plans on changes
+    virtual std::uint64_t mapVersion() = 0;
+  };
+
+  struct PipelinedMissionParams
+  {
+    // Plan leg k+1 while leg k is followed, otherwise plan each leg once the previous one is finished
+    bool pipelined;
+    // Distance to the goal of the current leg at which the next leg is handed to the controller [m]
+    double switch_distance;
+    // Period at which the executor checks progress
+    std::chrono::milliseconds loop_period;
+    PipelinedMissionParams()
+    : pipelined(true),
+      switch_distance(1.0),
+      loop_period(20) {}
+  };
+
+  struct PipelinedMissionStats
+  {
+    // Legs whose plan was ready before the robot reached the switch distance
+    int prefetched_legs{0};
+    // Legs handed to the controller before the previous leg was finished
+    int seamless_handovers{0};
+    // Cached plans that were requested again because the map changed
+    int revalidations{0};
+  };
+
+  /**
+   * @brief Drives a robot through a list of waypoints one leg at a time.
+   * While the controller follows leg k, the plan of leg k+1 is requested
+   * from the goal of leg k, so that it is usually ready before the robot
+   * gets there. Once the robot is within switch_distance of the goal of
+   * leg k the controller is handed leg k+1 without stopping. A plan that
+   * was computed on an older map than the current one is requested again.
+   *
+   */
+  class PipelinedMissionExecutor
+  {
+  public:
+    explicit PipelinedMissionExecutor(
+      MissionBackend & backend,
+      const PipelinedMissionParams & params = PipelinedMissionParams());
+
+    /**
+     * @brief Blocks until all goals are reached, a leg fails or should_cancel returns true
+     *
+     * @param goals
+     * @param should_cancel
+     * @param on_leg_started called with the index of each leg handed to the controller
+     * @return MissionStatus
+     */
+    MissionStatus execute(
+      const std::vector<geometry_msgs::msg::PoseStamped> & goals,
+      std::function<bool()> should_cancel = []() {return false;},
+      std::function<void(size_t)> on_leg_started = [](size_t) {});
+
+    const PipelinedMissionStats & stats() const {return stats_;}
+
+  private:
+    struct PendingLeg
+    {
+      size_t index{0};
+      bool requested{false};
+      // Planned from the goal of the previous leg rather than from the robot
+      bool ahead{false};
+      geometry_msgs::msg::PoseStamped start;
+      std::shared_future<nav_msgs::msg::Path> plan;
+      std::uint64_t map_version{0};
+    };
+
+    // start is either the robot (empty frame_id) or the goal of the previous leg
+    void requestLeg(
+      PendingLeg & leg, size_t index, bool ahead,
+      const geometry_msgs::msg::PoseStamped & start,
+      const geometry_msgs::msg::PoseStamped & goal);
+
+    MissionBackend & backend_;
+    PipelinedMissionParams params_;
+    PipelinedMissionStats stats_;
+  };
+
+}  // namespace vox_nav_navigators
+
+#endif  // VOX_NAV_NAVIGATORS__PIPELINED_MISSION_EXECUTOR_HPP_
@@ -16,13 +16,18 @@
 #ifndef VOX_NAV_POSE_NAVIGATOR__PLUGINS__ACTIONS__BASE_ACTION_CLIENT_NODE_HPP_
 #define VOX_NAV_POSE_NAVIGATOR__PLUGINS__ACTIONS__BASE_ACTION_CLIENT_NODE_HPP_
 
+#include <atomic>
+#include <chrono>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #include "behaviortree_cpp_v3/action_node.h"
 #include "rclcpp/rclcpp.hpp"
 #include "rclcpp_action/rclcpp_action.hpp"
 #include "vox_nav_navigators/bt_conversions.hpp"
+#include "vox_nav_navigators/tree_wake_up.hpp"
 
 namespace vox_nav_navigators
 {
@@ -44,6 +49,11 @@ namespace vox_nav_navigators
         config().blackboard->template get<std::chrono::seconds>("server_timeout");
       getInput<std::chrono::seconds>("server_timeout", server_timeout_);
 
+      // Trees executed by BehaviorTree provide a wake up condition, ticked without one
+      // the node still works but the tree only notices responses on its next tick
+      config().blackboard->template get<TreeWakeUp::SharedPtr>(
+        TreeWakeUp::BLACKBOARD_KEY, wake_up_);
+
       // Initialize the input and output messages
       goal_ = typename ActionT::Goal();
       result_ = typename rclcpp_action::ClientGoalHandle<ActionT>::WrappedResult();
@@ -54,6 +64,18 @@ namespace vox_nav_navigators
       }
       createActionClient(action_name_);
 
+      // Responses of the action server are handled as they arrive instead of
+      // when the tree polls, so that they can wake the tree up
+      // executor_.cancel() is lost if it comes before spin() is entered, so the
+      // thread waits in bounded spin_once() calls and checks a stop flag instead
+      executor_.add_node(node_);
+      spin_thread_ = std::thread(
+        [this]() {
+          while (!stop_spinning_ && rclcpp::ok()) {
+            executor_.spin_once(std::chrono::milliseconds(100));
+          }
+        });
+
       // Give the derive class a chance to do any initialization
       RCLCPP_INFO(
         node_->get_logger(), "\"%s\" BaseActionClientNode initialized",
@@ -64,6 +86,12 @@ namespace vox_nav_navigators
 
     virtual ~BaseActionClientNode()
     {
+      stop_spinning_ = true;
+      // Wakes a spin_once() that is waiting, otherwise it returns on its timeout
+      executor_.cancel();
+      if (spin_thread_.joinable()) {
+        spin_thread_.join();
+      }
     }
 
     // Create instance of an action server
@@ -155,9 +183,8 @@ namespace vox_nav_navigators
           on_new_goal_received();
         }
 
-        rclcpp::spin_some(node_);
-
-        // check if, after invoking spin_some(), we finally received the result
+        // check if the spin thread has received the result of the current goal
+        take_result();
         if (!goal_result_available_) {
           // Yield this Action, returning RUNNING
           return BT::NodeStatus::RUNNING;
@@ -185,9 +212,7 @@ namespace vox_nav_navigators
     {
       if (should_cancel_goal()) {
         auto future_cancel = action_client_->async_cancel_goal(goal_handle_);
-        if (rclcpp::spin_until_future_complete(node_, future_cancel, server_timeout_) !=
-          rclcpp::FutureReturnCode::SUCCESS)
-        {
+        if (future_cancel.wait_for(server_timeout_) != std::future_status::ready) {
           RCLCPP_ERROR(
             node_->get_logger(),
             "Failed to cancel action server for %s", action_name_.c_str());
@@ -204,7 +229,6 @@ namespace vox_nav_navigators
         return false;
       }
 
-      rclcpp::spin_some(node_);
       auto status = goal_handle_->get_status();
 
       // Check if the goal is still executing
@@ -217,19 +241,26 @@ namespace vox_nav_navigators
     {
       goal_result_available_ = false;
       auto send_goal_options = typename rclcpp_action::Client<ActionT>::SendGoalOptions();
+      // Called on the spin thread, possibly before goal_handle_ is assigned below, so the
+      // result is parked and matched against the current goal by take_result() in tick()
       send_goal_options.result_callback =
         [this](const typename rclcpp_action::ClientGoalHandle<ActionT>::WrappedResult & result) {
-          if (this->goal_handle_->get_goal_id() == result.goal_id) {
-            goal_result_available_ = true;
-            result_ = result;
+          {
+            std::lock_guard<std::mutex> lock(result_mutex_);
+            pending_result_ = result;
+            has_pending_result_ = true;
           }
+          wake_up_tree();
+        };
+      send_goal_options.feedback_callback =
+        [this](typename rclcpp_action::ClientGoalHandle<ActionT>::SharedPtr,
+          const std::shared_ptr<const typename ActionT::Feedback>) {
+          wake_up_tree();
         };
 
       auto future_goal_handle = action_client_->async_send_goal(goal_, send_goal_options);
 
-      if (rclcpp::spin_until_future_complete(node_, future_goal_handle, server_timeout_) !=
-        rclcpp::FutureReturnCode::SUCCESS)
-      {
+      if (future_goal_handle.wait_for(server_timeout_) != std::future_status::ready) {
         throw std::runtime_error("send_goal failed");
       }
 
@@ -239,6 +270,25 @@ namespace vox_nav_navigators
       }
     }
 
+    void take_result()
+    {
+      std::lock_guard<std::mutex> lock(result_mutex_);
+      if (has_pending_result_ && goal_handle_ &&
+        pending_result_.goal_id == goal_handle_->get_goal_id())
+      {
+        result_ = pending_result_;
+        goal_result_available_ = true;
+        has_pending_result_ = false;
+      }
+    }
+
+    void wake_up_tree()
+    {
+      if (wake_up_) {
+        wake_up_->notify();
+      }
+    }
+
     void increment_recovery_count()
     {
       int recovery_count = 0;
@@ -256,9 +306,22 @@ namespace vox_nav_navigators
     typename rclcpp_action::ClientGoalHandle<ActionT>::SharedPtr goal_handle_;
     typename rclcpp_action::ClientGoalHandle<ActionT>::WrappedResult result_;
 
+    // Result received by the spin thread, not yet taken over by tick()
+    std::mutex result_mutex_;
+    bool has_pending_result_{false};
+    typename rclcpp_action::ClientGoalHandle<ActionT>::WrappedResult pending_result_;
+
     // The node that will be used for any ROS operations
     rclcpp::Node::SharedPtr node_;
 
+    // Spins node_ for the lifetime of this BT node
+    rclcpp::executors::SingleThreadedExecutor executor_;
+    std::thread spin_thread_;
+    std::atomic<bool> stop_spinning_{false};
+
+    // Notified whenever the action server responds, may be null
+    TreeWakeUp::SharedPtr wake_up_;
+
     // The timeout value while waiting for response from a server when a
     // new action goal is sent or canceled
     std::chrono::seconds server_timeout_;
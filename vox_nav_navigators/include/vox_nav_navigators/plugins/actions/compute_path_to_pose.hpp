@@ -58,16 +58,20 @@ namespace vox_nav_navigators
     {
       setOutput("path", result_.result->path);
 
-      if (first_time_) {
+      // Only a replan towards the same pose updates a path that is being followed,
+      // the tree is reused across waypoints and the first plan of a waypoint is a new path
+      if (first_time_ || !(goal_.pose == last_planned_pose_)) {
         first_time_ = false;
       } else {
         config().blackboard->set("path_updated", true);
       }
+      last_planned_pose_ = goal_.pose;
       return BT::NodeStatus::SUCCESS;
     }
 
   private:
     bool first_time_{true};
+    geometry_msgs::msg::PoseStamped last_planned_pose_;
   };
 }  // namespace vox_nav_navigators
 
@@ -0,0 +1,88 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_NAVIGATORS__ROS_MISSION_BACKEND_HPP_
+#define VOX_NAV_NAVIGATORS__ROS_MISSION_BACKEND_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "nav_msgs/srv/get_plan.hpp"
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_action/rclcpp_action.hpp"
+#include "sensor_msgs/msg/point_cloud2.hpp"
+#include "tf2_ros/buffer.h"
+#include "tf2_ros/transform_listener.h"
+#include "vox_nav_msgs/action/follow_path.hpp"
+#include "vox_nav_navigators/pipelined_mission_executor.hpp"
+
+namespace vox_nav_navigators
+{
+
+  /**
+   * @brief MissionBackend on top of the vox_nav servers: legs are planned with
+   * the get_plan service of the planner server, which accepts a start pose,
+   * followed with the follow_path action of the controller server, and the
+   * map version changes whenever the content of the map cloud changes.
+   * All callbacks are served by whatever spins the node that is passed in.
+   *
+   */
+  class RosMissionBackend : public MissionBackend
+  {
+  public:
+    using FollowPath = vox_nav_msgs::action::FollowPath;
+
+    RosMissionBackend(rclcpp::Node * node, const std::string & map_topic);
+
+    std::shared_future<nav_msgs::msg::Path> requestPlan(
+      const geometry_msgs::msg::PoseStamped & start,
+      const geometry_msgs::msg::PoseStamped & goal) override;
+
+    void followPath(const nav_msgs::msg::Path & path) override;
+
+    FollowStatus followStatus() override;
+
+    void cancel() override;
+
+    bool getRobotPose(geometry_msgs::msg::PoseStamped & pose) override;
+
+    std::uint64_t mapVersion() override {return map_version_;}
+
+  private:
+    void mapCallback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr msg);
+
+    rclcpp::Node * node_;
+    rclcpp::Client<nav_msgs::srv::GetPlan>::SharedPtr get_plan_client_;
+    rclcpp_action::Client<FollowPath>::SharedPtr follow_path_client_;
+    rclcpp::Subscription<sensor_msgs::msg::PointCloud2>::SharedPtr map_subscriber_;
+    std::shared_ptr<tf2_ros::Buffer> tf_buffer_;
+    std::shared_ptr<tf2_ros::TransformListener> tf_listener_;
+
+    // Status of the last followPath() call, responses to older goals are ignored
+    std::mutex follow_mutex_;
+    std::uint64_t follow_generation_{0};
+    FollowStatus follow_status_{FollowStatus::IDLE};
+    rclcpp_action::ClientGoalHandle<FollowPath>::SharedPtr follow_goal_handle_;
+
+    std::atomic<std::uint64_t> map_version_{0};
+    std::size_t map_hash_{0};
+  };
+
+}  // namespace vox_nav_navigators
+
+#endif  // VOX_NAV_NAVIGATORS__ROS_MISSION_BACKEND_HPP_
@@ -0,0 +1,72 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_NAVIGATORS__TREE_WAKE_UP_HPP_
+#define VOX_NAV_NAVIGATORS__TREE_WAKE_UP_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+
+namespace vox_nav_navigators
+{
+
+  /**
+   * @brief Wake up condition shared by a behavior tree and its nodes.
+   * Nodes notify it when something they wait for arrives (feedback, result,
+   * cancellation), the executing loop sleeps on it between ticks. A notify
+   * that happens while the tree is being ticked is kept, so no event is lost.
+   *
+   */
+  class TreeWakeUp
+  {
+  public:
+    using SharedPtr = std::shared_ptr<TreeWakeUp>;
+
+    // Blackboard key under which BehaviorTree shares its wake up condition with the nodes
+    static constexpr const char * BLACKBOARD_KEY = "tree_wake_up";
+
+    void notify()
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = true;
+      }
+      cv_.notify_all();
+    }
+
+    /**
+     * @brief Block until notified or max_idle_period elapsed, consumes the notification
+     *
+     * @param max_idle_period
+     * @return true if woken up by a notification
+     */
+    bool waitFor(std::chrono::nanoseconds max_idle_period)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      bool notified = cv_.wait_for(lock, max_idle_period, [this]() {return pending_;});
+      pending_ = false;
+      return notified;
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool pending_{false};
+  };
+
+}  // namespace vox_nav_navigators
+
+#endif  // VOX_NAV_NAVIGATORS__TREE_WAKE_UP_HPP_
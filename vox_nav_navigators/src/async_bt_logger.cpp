@@ -0,0 +1,105 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_navigators/async_bt_logger.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <utility>
+#include <vector>
+
+namespace vox_nav_navigators
+{
+
+  AsyncBtLogger::AsyncBtLogger(
+    const BT::Tree & tree,
+    std::chrono::milliseconds flush_period)
+  : BT::StatusChangeLogger(tree.rootNode()),
+    flush_period_(flush_period)
+  {
+    writer_ = std::thread(&AsyncBtLogger::writerLoop, this);
+  }
+
+  AsyncBtLogger::~AsyncBtLogger()
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+  }
+
+  void AsyncBtLogger::callback(
+    BT::Duration timestamp, const BT::TreeNode & node,
+    BT::NodeStatus prev_status, BT::NodeStatus status)
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    buffer_.push_back({timestamp, &node, prev_status, status});
+  }
+
+  void AsyncBtLogger::flush()
+  {
+    std::vector<Record> records;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      records.swap(buffer_);
+    }
+    write(records);
+  }
+
+  void AsyncBtLogger::writerLoop()
+  {
+    std::vector<Record> records;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      cv_.wait_for(lock, flush_period_, [this]() {return stop_;});
+      records.clear();
+      records.swap(buffer_);
+      bool stop = stop_;
+      lock.unlock();
+      write(records);
+      lock.lock();
+      if (stop) {
+        // Whatever arrived while the last batch was written
+        records.clear();
+        records.swap(buffer_);
+        lock.unlock();
+        write(records);
+        return;
+      }
+    }
+  }
+
+  void AsyncBtLogger::write(const std::vector<Record> & records)
+  {
+    if (records.empty()) {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(write_mutex_);
+    constexpr const char * whitespaces = "                         ";
+    constexpr size_t ws_count = 25;
+    for (const auto & record : records) {
+      double since_epoch = std::chrono::duration<double>(record.timestamp).count();
+      const std::string & name = record.node->name();
+      printf(
+        "[%.3f]: %s%s %s -> %s\n", since_epoch, name.c_str(),
+        &whitespaces[std::min(ws_count, name.size())],
+        BT::toStr(record.prev_status, true).c_str(),
+        BT::toStr(record.status, true).c_str());
+    }
+    fflush(stdout);
+  }
+
+}  // namespace vox_nav_navigators
@@ -19,7 +19,6 @@
 #include <vector>
 
 #include "behaviortree_cpp_v3/xml_parsing.h"
-#include "behaviortree_cpp_v3/loggers/bt_cout_logger.h"
 #include "rclcpp/rclcpp.hpp"
 
 namespace vox_nav_navigators
@@ -28,39 +27,42 @@ namespace vox_nav_navigators
   BehaviorTree::BehaviorTree(
     const std::string & bt_xml,
     const std::vector<std::string> & plugin_library_names)
-  : xml_parser_(factory_)
+  : bt_xml_(bt_xml)
   {
-    // Load any specified BT plugins
-    for (const auto & library_name : plugin_library_names) {
-      factory_.registerFromPlugin(std::string{"lib" + library_name + ".so"});
-    }
-
-    // Parse the input XML
-    xml_parser_.loadFromText(bt_xml);
+    // Load any specified BT plugins, libraries already loaded by this process are skipped
+    BehaviorTreeCache::instance().registerPlugins(plugin_library_names);
 
     // Create a blackboard for this Behavior Tree
     blackboard_ = BT::Blackboard::create();
+
+    // The action nodes pick the wake up condition from the blackboard when constructed
+    wake_up_ = std::make_shared<TreeWakeUp>();
+    blackboard_->set<TreeWakeUp::SharedPtr>(TreeWakeUp::BLACKBOARD_KEY, wake_up_);
   }
 
   BtStatus
   BehaviorTree::execute(
     std::function<bool()> should_halt,
     std::function<void()> on_loop_iteration,
-    std::chrono::milliseconds tick_period)
+    std::chrono::milliseconds max_idle_period)
   {
-    // Create the corresponding Behavior Tree
-    BT::Tree tree = xml_parser_.instantiateTree(blackboard_);
-
-    BT::StdCoutLogger logger(tree);
-
-    // Set up a loop rate controller based on the desired tick period
-    rclcpp::WallRate loop_rate(tick_period);
+    // Create the corresponding Behavior Tree from the cached template on first use,
+    // afterwards reset the existing one so that every node starts from IDLE
+    if (!tree_) {
+      tree_ = std::make_unique<BT::Tree>(
+        BehaviorTreeCache::instance().instantiateTree(bt_xml_, blackboard_));
+      logger_ = std::make_unique<AsyncBtLogger>(*tree_);
+    } else {
+      tree_->haltTree();
+    }
+    BT::Tree & tree = *tree_;
 
     // Loop until something happens with ROS or the node completes
     BT::NodeStatus result = BT::NodeStatus::RUNNING;
     while (rclcpp::ok() && result == BT::NodeStatus::RUNNING) {
       if (should_halt()) {
         tree.rootNode()->halt();
+        logger_->flush();
         return BtStatus::HALTED;
       }
 
@@ -70,10 +72,13 @@ namespace vox_nav_navigators
       // Give the caller a chance to do something on each loop iteration
       on_loop_iteration();
 
-      // Throttle the BT loop rate, based on the provided tick period value
-      loop_rate.sleep();
+      // Sleep until a node has news, e.g. an action result that lets the tree advance
+      if (result == BT::NodeStatus::RUNNING) {
+        wake_up_->waitFor(max_idle_period);
+      }
     }
 
+    logger_->flush();
     return (result == BT::NodeStatus::SUCCESS) ? BtStatus::SUCCEEDED : BtStatus::FAILED;
   }
 
@@ -0,0 +1,79 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_navigators/behavior_tree_cache.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vox_nav_navigators
+{
+
+  BehaviorTreeCache & BehaviorTreeCache::instance()
+  {
+    static BehaviorTreeCache cache;
+    return cache;
+  }
+
+  void BehaviorTreeCache::registerPlugins(const std::vector<std::string> & plugin_library_names)
+  {
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    for (const auto & library_name : plugin_library_names) {
+      if (registered_plugins_.count(library_name)) {
+        continue;
+      }
+      factory_.registerFromPlugin(std::string{"lib" + library_name + ".so"});
+      registered_plugins_.insert(library_name);
+    }
+  }
+
+  BT::Tree BehaviorTreeCache::instantiateTree(
+    const std::string & bt_xml,
+    const BT::Blackboard::Ptr & blackboard)
+  {
+    {
+      // Instantiation only reads the factory and the parsed XML, so trees of any number of
+      // threads are instantiated at once. The shared lock only keeps registration out
+      std::shared_lock<std::shared_mutex> lock(mutex_);
+      auto it = parsed_trees_.find(bt_xml);
+      if (it != parsed_trees_.end()) {
+        return it->second->instantiateTree(blackboard);
+      }
+    }
+
+    // First use of this XML, parse it. Another thread may have parsed it since the lookup above
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = parsed_trees_.find(bt_xml);
+    if (it == parsed_trees_.end()) {
+      auto parser = std::make_unique<BT::XMLParser>(factory_);
+      parser->loadFromText(bt_xml);
+      it = parsed_trees_.emplace(bt_xml, std::move(parser)).first;
+    }
+    return it->second->instantiateTree(blackboard);
+  }
+
+  size_t BehaviorTreeCache::numRegisteredPlugins() const
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return registered_plugins_.size();
+  }
+
+  size_t BehaviorTreeCache::numParsedTrees() const
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    return parsed_trees_.size();
+  }
+
+}  // namespace vox_nav_navigators
@@ -17,6 +17,7 @@
 #include <memory>
 #include <string>
 #include <set>
+#include <vector>
 
 #include "vox_nav_navigators/navigate_through_gps_poses_action_server_node.hpp"
 
@@ -55,6 +56,19 @@ namespace vox_nav_navigators
 
     robot_localization_fromLL_client_ =
       this->create_client<robot_localization::srv::FromLL>("/fromLL");
+    tf_buffer_ = std::make_shared<tf2_ros::Buffer>(get_clock());
+    tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
+    declare_parameter("utm_frame_id", "utm");
+
+    declare_parameter("pipelined_planning.enabled", false);
+    declare_parameter("pipelined_planning.switch_distance", 1.0);
+    declare_parameter("pipelined_planning.map_topic", "octomap_pointcloud");
+    get_parameter("pipelined_planning.enabled", pipelined_planning_);
+    get_parameter("pipelined_planning.switch_distance", mission_params_.switch_distance);
+    if (pipelined_planning_) {
+      mission_backend_ = std::make_shared<RosMissionBackend>(
+        this, get_parameter("pipelined_planning.map_topic").as_string());
+    }
 
     RCLCPP_INFO(get_logger(), "Creating ... ");
 
@@ -93,6 +107,114 @@ namespace vox_nav_navigators
     }.detach();
   }
 
+  bool NavigateThroughGPSPosesActionServer::updateGeodeticDatum(
+    const sensor_msgs::msg::NavSatFix & gps_pose)
+  {
+    // navsat_transform projects into the utm zone of its first fix, the robot is close to the
+    // waypoints so the zone of the first waypoint is the same one
+    int zone = vox_nav_utilities::utmZone(gps_pose.latitude, gps_pose.longitude);
+    std::string utm_frame_id = get_parameter("utm_frame_id").as_string();
+    if (tf_buffer_->canTransform(
+        "map", utm_frame_id, rclcpp::Time(0), rclcpp::Duration::from_seconds(1.0)))
+    {
+      auto utm_to_map =
+        tf_buffer_->lookupTransform("map", utm_frame_id, rclcpp::Time(0)).transform;
+      Eigen::Isometry3d map_from_utm =
+        Eigen::Translation3d(
+        utm_to_map.translation.x, utm_to_map.translation.y, utm_to_map.translation.z) *
+        Eigen::Quaterniond(
+        utm_to_map.rotation.w, utm_to_map.rotation.x, utm_to_map.rotation.y,
+        utm_to_map.rotation.z);
+      geodetic_converter_.setUTMToMap(zone, gps_pose.latitude >= 0.0, map_from_utm);
+      return true;
+    }
+
+    return false;
+  }
+
+  bool NavigateThroughGPSPosesActionServer::fromLLToMapPoints(
+    const std::vector<sensor_msgs::msg::NavSatFix> & gps_poses,
+    std::vector<Eigen::Vector3d> & map_points)
+  {
+    while (!robot_localization_fromLL_client_->wait_for_service(std::chrono::seconds(1))) {
+      if (!rclcpp::ok()) {
+        RCLCPP_ERROR(
+          this->get_logger(),
+          "Interrupted while waiting for the /fromLL service.Exiting");
+        return false;
+      }
+      RCLCPP_INFO(
+        this->get_logger(), "/fromLL service not available, waiting and trying again");
+    }
+
+    // All requests are sent before waiting, so the round trips overlap
+    using FromLLFuture = decltype(robot_localization_fromLL_client_->async_send_request(
+        std::make_shared<robot_localization::srv::FromLL::Request>()));
+    std::vector<FromLLFuture> futures;
+    futures.reserve(gps_poses.size());
+    for (const auto & gps_pose : gps_poses) {
+      auto request = std::make_shared<robot_localization::srv::FromLL::Request>();
+      request->ll_point.latitude = gps_pose.latitude;
+      request->ll_point.longitude = gps_pose.longitude;
+      request->ll_point.altitude = gps_pose.altitude;
+      futures.push_back(robot_localization_fromLL_client_->async_send_request(request));
+    }
+
+    map_points.resize(gps_poses.size());
+    for (size_t i = 0; i < futures.size(); i++) {
+      if (rclcpp::spin_until_future_complete(
+          this->shared_from_this(),
+          futures[i]) != rclcpp::FutureReturnCode::SUCCESS)
+      {
+        RCLCPP_ERROR(this->get_logger(), "/fromLL service call failed");
+        return false;
+      }
+      const auto map_point = futures[i].get()->map_point;
+      map_points[i] = Eigen::Vector3d(map_point.x, map_point.y, map_point.z);
+    }
+    return true;
+  }
+
+  bool NavigateThroughGPSPosesActionServer::gpsToMapPoses(
+    const std::vector<sensor_msgs::msg::NavSatFix> & gps_poses,
+    std::vector<geometry_msgs::msg::PoseStamped> & map_poses)
+  {
+    map_poses.clear();
+    if (gps_poses.empty()) {
+      return true;
+    }
+    std::vector<Eigen::Vector3d> map_points;
+    // The map may have been reset since the last goal, anchor once per goal
+    if (updateGeodeticDatum(gps_poses.front())) {
+      std::vector<vox_nav_utilities::GeoPoint> geo_points(gps_poses.size());
+      for (size_t i = 0; i < gps_poses.size(); i++) {
+        geo_points[i].latitude = gps_poses[i].latitude;
+        geo_points[i].longitude = gps_poses[i].longitude;
+        geo_points[i].altitude = gps_poses[i].altitude;
+      }
+      geodetic_converter_.geoToMap(geo_points, map_points);
+    } else {
+      // A single correspondence can not give the yaw between the map and the utm grid,
+      // navsat_transform applies the yaw offset itself when it answers /fromLL
+      RCLCPP_WARN(
+        get_logger(), "No %s to map transform, converting every gps waypoint with /fromLL",
+        get_parameter("utm_frame_id").as_string().c_str());
+      if (!fromLLToMapPoints(gps_poses, map_points)) {
+        return false;
+      }
+    }
+
+    map_poses.resize(map_points.size());
+    for (size_t i = 0; i < map_points.size(); i++) {
+      map_poses[i].header.frame_id = "map";
+      map_poses[i].pose.position.x = map_points[i].x();
+      map_poses[i].pose.position.y = map_points[i].y();
+      map_poses[i].pose.position.z = map_points[i].z();
+      map_poses[i].pose.orientation = vox_nav_utilities::getMsgQuaternionfromRPY(0, 0, 0);
+    }
+    return true;
+  }
+
   void
   NavigateThroughGPSPosesActionServer::navigate_through_gps_poses(
     const std::shared_ptr<GoalHandle> goal_handle)
@@ -100,42 +222,45 @@ namespace vox_nav_navigators
     auto result = std::make_shared<ActionServer::Result>();
     auto goal = goal_handle->get_goal();
 
-    int curr_waypont_index = 0;
-    for (auto && curr_goal : goal->gps_poses) {
+    std::vector<geometry_msgs::msg::PoseStamped> map_poses;
+    if (!gpsToMapPoses(goal->gps_poses, map_poses)) {
+      goal_handle->abort(result);
+      return;
+    }
 
-      auto request = std::make_shared<robot_localization::srv::FromLL::Request>();
-      auto response = std::make_shared<robot_localization::srv::FromLL::Response>();
-      request->ll_point.latitude = curr_goal.latitude;
-      request->ll_point.longitude = curr_goal.longitude;
-      request->ll_point.altitude = curr_goal.altitude;
-
-      while (!robot_localization_fromLL_client_->wait_for_service(std::chrono::seconds(1))) {
-        if (!rclcpp::ok()) {
-          RCLCPP_ERROR(
-            this->get_logger(),
-            "Interrupted while waiting for the /fromLL service.Exiting");
+    if (pipelined_planning_) {
+      PipelinedMissionExecutor executor(*mission_backend_, mission_params_);
+      auto should_cancel = [goal_handle]() {return goal_handle->is_canceling();};
+      auto on_leg_started = [&](size_t leg) {
+          RCLCPP_INFO(get_logger(), "Currently executing %d gps waypoint", static_cast<int>(leg));
+        };
+      switch (executor.execute(map_poses, should_cancel, on_leg_started)) {
+        case vox_nav_navigators::MissionStatus::SUCCEEDED:
+          RCLCPP_INFO(
+            get_logger(), "Finished all gps waypoints, %d of %d legs were planned ahead",
+            executor.stats().prefetched_legs, static_cast<int>(map_poses.size()));
+          goal_handle->succeed(result);
+          return;
+        case vox_nav_navigators::MissionStatus::FAILED:
+          RCLCPP_ERROR(get_logger(), "Pipelined mission failed!");
+          goal_handle->abort(result);
+          return;
+        case vox_nav_navigators::MissionStatus::CANCELED:
+          RCLCPP_INFO(get_logger(), "Pipelined mission canceled");
+          goal_handle->canceled(result);
           return;
-        }
-        RCLCPP_INFO(
-          this->get_logger(), "/fromLL service not available, waiting and trying again");
       }
+    }
 
-      auto result_future = robot_localization_fromLL_client_->async_send_request(request);
-      if (rclcpp::spin_until_future_complete(
-          this->shared_from_this(),
-          result_future) != rclcpp::FutureReturnCode::SUCCESS)
-      {
-        RCLCPP_ERROR(this->get_logger(), "/fromLL service call failed");
-      }
-      auto result_fromll = result_future.get();
-      response->map_point = result_fromll->map_point;
+    // One tree per goal, plugins and the parsed XML come from the process wide cache and
+    // the action clients created by the tree nodes are reused by all waypoints
+    BehaviorTree bt(bt_xml_);
+    auto blackboard = bt.blackboard();
 
-      geometry_msgs::msg::PoseStamped gps_pose_in_map;
-      gps_pose_in_map.pose.position = response->map_point;
-      gps_pose_in_map.pose.orientation = vox_nav_utilities::getMsgQuaternionfromRPY(0, 0, 0);
+    int curr_waypont_index = 0;
+    for (auto && gps_pose_in_map : map_poses) {
 
-      BehaviorTree bt(bt_xml_);
-      auto blackboard = bt.blackboard();
+      // Reset the values a previous waypoint may have left on the blackboard
       blackboard->set<std::chrono::seconds>("server_timeout", std::chrono::seconds(1));    // NOLINT
       blackboard->set<int>("number_recoveries", 0);                                       // NOLINT
       blackboard->set<geometry_msgs::msg::PoseStamped>("pose", gps_pose_in_map);              // NOLINT
@@ -154,11 +279,11 @@ namespace vox_nav_navigators
         case vox_nav_navigators::BtStatus::FAILED:
           RCLCPP_ERROR(get_logger(), "Behavior Tree execution failed!");
           goal_handle->abort(result);
-          break;
+          return;
         case vox_nav_navigators::BtStatus::HALTED:
           RCLCPP_INFO(get_logger(), "Behavior Tree halted");
           goal_handle->canceled(result);
-          break;
+          return;
         default:
           throw std::logic_error("Invalid status return from BT");
       }
@@ -54,6 +54,16 @@ namespace vox_nav_navigators
       std::bind(&NavigateThroughPosesActionServer::handle_cancel, this, std::placeholders::_1),
       std::bind(&NavigateThroughPosesActionServer::handle_accepted, this, std::placeholders::_1)
     );
+
+    declare_parameter("pipelined_planning.enabled", false);
+    declare_parameter("pipelined_planning.switch_distance", 1.0);
+    declare_parameter("pipelined_planning.map_topic", "octomap_pointcloud");
+    get_parameter("pipelined_planning.enabled", pipelined_planning_);
+    get_parameter("pipelined_planning.switch_distance", mission_params_.switch_distance);
+    if (pipelined_planning_) {
+      mission_backend_ = std::make_shared<RosMissionBackend>(
+        this, get_parameter("pipelined_planning.map_topic").as_string());
+    }
   }
 
   NavigateThroughPosesActionServer::~NavigateThroughPosesActionServer()
@@ -98,11 +108,39 @@ namespace vox_nav_navigators
     auto result = std::make_shared<ActionServer::Result>();
     auto goal = goal_handle->get_goal();
 
+    if (pipelined_planning_) {
+      PipelinedMissionExecutor executor(*mission_backend_, mission_params_);
+      auto should_cancel = [goal_handle]() {return goal_handle->is_canceling();};
+      auto on_leg_started = [&](size_t leg) {
+          RCLCPP_INFO(get_logger(), "Currently executing %d waypoint", static_cast<int>(leg));
+        };
+      switch (executor.execute(goal->poses, should_cancel, on_leg_started)) {
+        case vox_nav_navigators::MissionStatus::SUCCEEDED:
+          RCLCPP_INFO(
+            get_logger(), "Finished all waypoints, %d of %d legs were planned ahead",
+            executor.stats().prefetched_legs, static_cast<int>(goal->poses.size()));
+          goal_handle->succeed(result);
+          return;
+        case vox_nav_navigators::MissionStatus::FAILED:
+          RCLCPP_ERROR(get_logger(), "Pipelined mission failed!");
+          goal_handle->abort(result);
+          return;
+        case vox_nav_navigators::MissionStatus::CANCELED:
+          RCLCPP_INFO(get_logger(), "Pipelined mission canceled");
+          goal_handle->canceled(result);
+          return;
+      }
+    }
+
+    // One tree per goal, plugins and the parsed XML come from the process wide cache and
+    // the action clients created by the tree nodes are reused by all waypoints
+    BehaviorTree bt(bt_xml_);
+    auto blackboard = bt.blackboard();
+
     int curr_waypont_index = 0;
     for (auto && curr_goal : goal->poses) {
 
-      BehaviorTree bt(bt_xml_);
-      auto blackboard = bt.blackboard();
+      // Reset the values a previous waypoint may have left on the blackboard
       blackboard->set<std::chrono::seconds>("server_timeout", std::chrono::seconds(1)); // NOLINT
       blackboard->set<int>("number_recoveries", 0);                                     // NOLINT
       blackboard->set<geometry_msgs::msg::PoseStamped>("pose", curr_goal);              // NOLINT
@@ -121,11 +159,11 @@ namespace vox_nav_navigators
         case vox_nav_navigators::BtStatus::FAILED:
           RCLCPP_ERROR(get_logger(), "Behavior Tree execution failed!");
           goal_handle->abort(result);
-          break;
+          return;
         case vox_nav_navigators::BtStatus::HALTED:
           RCLCPP_INFO(get_logger(), "Behavior Tree halted");
           goal_handle->canceled(result);
-          break;
+          return;
         default:
           throw std::logic_error("Invalid status return from BT");
       }
@@ -0,0 +1,141 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_navigators/pipelined_mission_executor.hpp"
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+namespace vox_nav_navigators
+{
+
+  PipelinedMissionExecutor::PipelinedMissionExecutor(
+    MissionBackend & backend,
+    const PipelinedMissionParams & params)
+  : backend_(backend),
+    params_(params)
+  {
+  }
+
+  void PipelinedMissionExecutor::requestLeg(
+    PendingLeg & leg, size_t index, bool ahead,
+    const geometry_msgs::msg::PoseStamped & start,
+    const geometry_msgs::msg::PoseStamped & goal)
+  {
+    leg.index = index;
+    leg.requested = true;
+    leg.ahead = ahead;
+    leg.start = start;
+    if (ahead && leg.start.header.frame_id.empty()) {
+      // Waypoints are given in the map frame, an empty frame_id would mean the robot pose
+      leg.start.header.frame_id = "map";
+    }
+    // Taken before the request, a map change during planning then counts as newer than the plan
+    leg.map_version = backend_.mapVersion();
+    leg.plan = backend_.requestPlan(leg.start, goal);
+  }
+
+  MissionStatus PipelinedMissionExecutor::execute(
+    const std::vector<geometry_msgs::msg::PoseStamped> & goals,
+    std::function<bool()> should_cancel,
+    std::function<void(size_t)> on_leg_started)
+  {
+    stats_ = PipelinedMissionStats();
+    if (goals.empty()) {
+      return MissionStatus::SUCCEEDED;
+    }
+
+    // An empty frame_id asks the backend to plan from the current robot pose
+    geometry_msgs::msg::PoseStamped from_robot;
+
+    PendingLeg next;
+    requestLeg(next, 0, false, from_robot, goals[0]);
+    bool following = false;
+    size_t active = 0;
+
+    while (true) {
+      if (should_cancel()) {
+        backend_.cancel();
+        return MissionStatus::CANCELED;
+      }
+
+      FollowStatus status = following ? backend_.followStatus() : FollowStatus::IDLE;
+      if (status == FollowStatus::FAILED) {
+        return MissionStatus::FAILED;
+      }
+      bool leg_done = status == FollowStatus::SUCCEEDED;
+      if (leg_done && active + 1 == goals.size()) {
+        return MissionStatus::SUCCEEDED;
+      }
+
+      // Request the next leg, from the goal of the current leg while it is still followed
+      if (!next.requested && following && active + 1 < goals.size()) {
+        if (!leg_done && params_.pipelined) {
+          requestLeg(next, active + 1, true, goals[active], goals[active + 1]);
+        } else if (leg_done) {
+          requestLeg(next, active + 1, false, from_robot, goals[active + 1]);
+        }
+      }
+
+      if (next.requested &&
+        next.plan.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+      {
+        const nav_msgs::msg::Path & path = next.plan.get();
+        if (path.poses.empty()) {
+          return MissionStatus::FAILED;
+        }
+
+        if (next.map_version != backend_.mapVersion()) {
+          // Planned on an older map, plan the same leg again on the current one. A leg that was
+          // planned ahead from the previous goal is planned from the robot if it is already there
+          bool ahead = following && !leg_done;
+          requestLeg(next, next.index, ahead, ahead ? next.start : from_robot, goals[next.index]);
+          stats_.revalidations++;
+          continue;
+        }
+
+        bool hand_over = !following || leg_done;
+        if (!hand_over) {
+          geometry_msgs::msg::PoseStamped robot_pose;
+          if (backend_.getRobotPose(robot_pose)) {
+            double dx = robot_pose.pose.position.x - goals[active].pose.position.x;
+            double dy = robot_pose.pose.position.y - goals[active].pose.position.y;
+            double dz = robot_pose.pose.position.z - goals[active].pose.position.z;
+            hand_over = std::sqrt(dx * dx + dy * dy + dz * dz) < params_.switch_distance;
+          }
+          if (hand_over) {
+            stats_.prefetched_legs++;
+            stats_.seamless_handovers++;
+          }
+        } else if (following && next.ahead) {
+          // Planned ahead but the robot got to the previous goal before the switch distance
+          stats_.prefetched_legs++;
+        }
+
+        if (hand_over) {
+          backend_.followPath(path);
+          active = next.index;
+          following = true;
+          next = PendingLeg();
+          on_leg_started(active);
+          continue;
+        }
+      }
+
+      std::this_thread::sleep_for(params_.loop_period);
+    }
+  }
+
+}  // namespace vox_nav_navigators
@@ -0,0 +1,145 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_navigators/ros_mission_backend.hpp"
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "vox_nav_utilities/tf_helpers.hpp"
+
+namespace vox_nav_navigators
+{
+
+  RosMissionBackend::RosMissionBackend(rclcpp::Node * node, const std::string & map_topic)
+  : node_(node)
+  {
+    get_plan_client_ = node_->create_client<nav_msgs::srv::GetPlan>("vox_nav/planning/get_plan");
+    follow_path_client_ = rclcpp_action::create_client<FollowPath>(
+      node_->get_node_base_interface(),
+      node_->get_node_graph_interface(),
+      node_->get_node_logging_interface(),
+      node_->get_node_waitables_interface(),
+      "follow_path");
+    map_subscriber_ = node_->create_subscription<sensor_msgs::msg::PointCloud2>(
+      map_topic, rclcpp::SystemDefaultsQoS(),
+      std::bind(&RosMissionBackend::mapCallback, this, std::placeholders::_1));
+    tf_buffer_ = std::make_shared<tf2_ros::Buffer>(node_->get_clock());
+    tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
+  }
+
+  void RosMissionBackend::mapCallback(const sensor_msgs::msg::PointCloud2::ConstSharedPtr msg)
+  {
+    // The map server republishes the same map periodically, only a different content is a change
+    std::size_t hash = std::hash<std::string_view>{}(
+      std::string_view(reinterpret_cast<const char *>(msg->data.data()), msg->data.size()));
+    if (map_version_ == 0 || hash != map_hash_) {
+      map_hash_ = hash;
+      map_version_++;
+    }
+  }
+
+  std::shared_future<nav_msgs::msg::Path> RosMissionBackend::requestPlan(
+    const geometry_msgs::msg::PoseStamped & start,
+    const geometry_msgs::msg::PoseStamped & goal)
+  {
+    auto promise = std::make_shared<std::promise<nav_msgs::msg::Path>>();
+    std::shared_future<nav_msgs::msg::Path> future = promise->get_future().share();
+    if (!get_plan_client_->wait_for_service(std::chrono::seconds(1))) {
+      RCLCPP_ERROR(node_->get_logger(), "vox_nav/planning/get_plan service is not available");
+      promise->set_value(nav_msgs::msg::Path());
+      return future;
+    }
+    auto request = std::make_shared<nav_msgs::srv::GetPlan::Request>();
+    request->start = start;
+    request->goal = goal;
+    get_plan_client_->async_send_request(
+      request,
+      [promise](rclcpp::Client<nav_msgs::srv::GetPlan>::SharedFuture response) {
+        promise->set_value(response.get()->plan);
+      });
+    return future;
+  }
+
+  void RosMissionBackend::followPath(const nav_msgs::msg::Path & path)
+  {
+    std::uint64_t generation;
+    {
+      std::lock_guard<std::mutex> lock(follow_mutex_);
+      generation = ++follow_generation_;
+      follow_status_ = FollowStatus::RUNNING;
+      // The controller server preempts the previous leg once the new goal is accepted, so
+      // the robot does not stop in between. Its result is dropped by the generation check
+      follow_goal_handle_.reset();
+    }
+
+    if (!follow_path_client_->wait_for_action_server(std::chrono::seconds(1))) {
+      RCLCPP_ERROR(node_->get_logger(), "follow_path action server is not available");
+      std::lock_guard<std::mutex> lock(follow_mutex_);
+      follow_status_ = FollowStatus::FAILED;
+      return;
+    }
+
+    FollowPath::Goal goal;
+    goal.path = path;
+    auto send_goal_options = rclcpp_action::Client<FollowPath>::SendGoalOptions();
+    send_goal_options.goal_response_callback =
+      [this, generation](rclcpp_action::ClientGoalHandle<FollowPath>::SharedPtr goal_handle) {
+        std::lock_guard<std::mutex> lock(follow_mutex_);
+        if (generation != follow_generation_) {
+          // Preempted before it was accepted, the newer goal sent after it preempts it on the
+          // server too. Canceling it here could stop the robot while the newer leg starts
+          return;
+        }
+        follow_goal_handle_ = goal_handle;
+        if (!follow_goal_handle_) {
+          follow_status_ = FollowStatus::FAILED;
+        }
+      };
+    send_goal_options.result_callback =
+      [this, generation](const rclcpp_action::ClientGoalHandle<FollowPath>::WrappedResult & result) {
+        std::lock_guard<std::mutex> lock(follow_mutex_);
+        if (generation != follow_generation_) {
+          return;
+        }
+        follow_status_ = result.code == rclcpp_action::ResultCode::SUCCEEDED ?
+          FollowStatus::SUCCEEDED : FollowStatus::FAILED;
+        follow_goal_handle_.reset();
+      };
+    follow_path_client_->async_send_goal(goal, send_goal_options);
+  }
+
+  FollowStatus RosMissionBackend::followStatus()
+  {
+    std::lock_guard<std::mutex> lock(follow_mutex_);
+    return follow_status_;
+  }
+
+  void RosMissionBackend::cancel()
+  {
+    std::lock_guard<std::mutex> lock(follow_mutex_);
+    ++follow_generation_;
+    follow_status_ = FollowStatus::IDLE;
+    follow_goal_handle_.reset();
+    follow_path_client_->async_cancel_all_goals();
+  }
+
+  bool RosMissionBackend::getRobotPose(geometry_msgs::msg::PoseStamped & pose)
+  {
+    return vox_nav_utilities::getCurrentPose(pose, *tf_buffer_, "map", "base_link", 0.1);
+  }
+
+}  // namespace vox_nav_navigators
@@ -0,0 +1,140 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Per waypoint behavior tree setup latency over a mission of waypoints.
+"per_waypoint" is what the waypoint servers used to do: a new factory that
+registers the plugin libraries, parses the XML and instantiates the tree for
+every waypoint. "cached" registers and parses once through BehaviorTreeCache,
+instantiates once per mission and only resets the blackboard and halts the
+tree between waypoints. The tree uses a stand in action so that no action
+servers are needed; the plugin libraries are still loaded and registered.
+Usage: behavior_tree_setup_benchmark [num_waypoints]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vox_nav_navigators/behavior_tree_cache.hpp"
+
+using namespace vox_nav_navigators;
+
+namespace
+{
+  const char kMissionXml[] =
+    R"(
+  <root main_tree_to_execute="MainTree">
+    <BehaviorTree ID="MainTree">
+      <Sequence name="NavigateThroughPoses">
+        <ReachWaypoint pose="{pose}"/>
+        <ReachWaypoint pose="{pose}"/>
+      </Sequence>
+    </BehaviorTree>
+  </root>
+)";
+
+  const std::vector<std::string> kPluginLibraries = {
+    "compute_path_to_pose_action_bt_node",
+    "follow_path_action_bt_node"};
+
+  void registerStandIn(BT::BehaviorTreeFactory & factory)
+  {
+    factory.registerSimpleAction(
+      "ReachWaypoint", [](BT::TreeNode &) {return BT::NodeStatus::SUCCESS;},
+      {BT::InputPort<int>("pose")});
+  }
+
+  struct Stats
+  {
+    double mean_ms = 0.0;
+    double max_ms = 0.0;
+    double total_ms = 0.0;
+  };
+
+  void add(Stats & stats, double ms, size_t n)
+  {
+    stats.mean_ms += ms / n;
+    stats.max_ms = std::max(stats.max_ms, ms);
+    stats.total_ms += ms;
+  }
+
+  Stats perWaypoint(size_t num_waypoints)
+  {
+    Stats stats;
+    for (size_t i = 0; i < num_waypoints; ++i) {
+      auto t0 = std::chrono::steady_clock::now();
+      BT::BehaviorTreeFactory factory;
+      for (const auto & library_name : kPluginLibraries) {
+        factory.registerFromPlugin(std::string{"lib" + library_name + ".so"});
+      }
+      registerStandIn(factory);
+      BT::XMLParser parser(factory);
+      parser.loadFromText(kMissionXml);
+      auto blackboard = BT::Blackboard::create();
+      blackboard->set<int>("pose", static_cast<int>(i));
+      BT::Tree tree = parser.instantiateTree(blackboard);
+      auto t1 = std::chrono::steady_clock::now();
+      if (tree.tickRoot() != BT::NodeStatus::SUCCESS) {
+        std::cerr << "per_waypoint tree did not succeed" << std::endl;
+      }
+      add(stats, std::chrono::duration<double, std::milli>(t1 - t0).count(), num_waypoints);
+    }
+    return stats;
+  }
+
+  Stats cached(size_t num_waypoints)
+  {
+    Stats stats;
+    auto & cache = BehaviorTreeCache::instance();
+    auto blackboard = BT::Blackboard::create();
+    std::unique_ptr<BT::Tree> tree;
+    for (size_t i = 0; i < num_waypoints; ++i) {
+      auto t0 = std::chrono::steady_clock::now();
+      cache.registerPlugins(kPluginLibraries);
+      blackboard->set<int>("pose", static_cast<int>(i));
+      if (!tree) {
+        tree = std::make_unique<BT::Tree>(cache.instantiateTree(kMissionXml, blackboard));
+      } else {
+        tree->haltTree();
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      if (tree->tickRoot() != BT::NodeStatus::SUCCESS) {
+        std::cerr << "cached tree did not succeed" << std::endl;
+      }
+      add(stats, std::chrono::duration<double, std::milli>(t1 - t0).count(), num_waypoints);
+    }
+    return stats;
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t num_waypoints = argc > 1 ? std::stoul(argv[1]) : 100;
+
+  registerStandIn(BehaviorTreeCache::instance().factory());
+
+  std::cout << "mode,num_waypoints,mean_setup_ms,max_setup_ms,total_setup_ms" << std::endl;
+  for (auto mode : {"per_waypoint", "cached"}) {
+    Stats stats = std::string(mode) == "cached" ? cached(num_waypoints) : perWaypoint(num_waypoints);
+    std::cout << mode << "," << num_waypoints << "," << stats.mean_ms << "," << stats.max_ms <<
+      "," << stats.total_ms << std::endl;
+  }
+  std::cout << "# registered plugins: " << BehaviorTreeCache::instance().numRegisteredPlugins() <<
+    ", parsed trees: " << BehaviorTreeCache::instance().numParsedTrees() << std::endl;
+  return 0;
+}
@@ -0,0 +1,209 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Latency from the completion of one action to the goal of the next action
+in the navigate through poses tree (ComputePathToPose -> FollowPath).
+Stand in planner and controller servers in this process finish every goal
+after a fixed work time and record when they finished and when they
+received a goal. "fixed_rate_<ms>" ticks the tree on a fixed period like
+BehaviorTree::execute used to, "event_driven" is BehaviorTree::execute,
+which ticks when an action node signals the tree wake up condition.
+Usage: behavior_tree_wake_up_benchmark [num_waypoints] [work_ms]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "rclcpp_action/rclcpp_action.hpp"
+#include "vox_nav_msgs/action/compute_path_to_pose.hpp"
+#include "vox_nav_msgs/action/follow_path.hpp"
+#include "vox_nav_navigators/behavior_tree.hpp"
+
+using namespace vox_nav_navigators;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+  const char kMissionXml[] =
+    R"(
+  <root main_tree_to_execute="MainTree">
+    <BehaviorTree ID="MainTree">
+      <Sequence name="NavigateThroughPoses">
+        <ComputePathToPose pose="{pose}" path="{path}" planner_id="GridBased"/>
+        <FollowPath path="{path}"  controller_id="FollowPath"/>
+      </Sequence>
+    </BehaviorTree>
+  </root>
+)";
+
+  // Planner and controller stand ins that succeed every goal after work_time
+  class StandInServers : public rclcpp::Node
+  {
+  public:
+    using ComputePathToPose = vox_nav_msgs::action::ComputePathToPose;
+    using FollowPath = vox_nav_msgs::action::FollowPath;
+
+    explicit StandInServers(std::chrono::milliseconds work_time)
+    : Node("behavior_tree_wake_up_benchmark_servers"), work_time_(work_time)
+    {
+      planner_server_ = rclcpp_action::create_server<ComputePathToPose>(
+        this, "/compute_path_to_pose",
+        [](const rclcpp_action::GoalUUID &, std::shared_ptr<const ComputePathToPose::Goal>) {
+          return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+        },
+        [](const std::shared_ptr<rclcpp_action::ServerGoalHandle<ComputePathToPose>>) {
+          return rclcpp_action::CancelResponse::ACCEPT;
+        },
+        [this](const std::shared_ptr<rclcpp_action::ServerGoalHandle<ComputePathToPose>> handle) {
+          std::thread{[this, handle]() {
+              std::this_thread::sleep_for(work_time_);
+              {
+                std::lock_guard<std::mutex> lock(mutex_);
+                plan_finished_ = Clock::now();
+              }
+              handle->succeed(std::make_shared<ComputePathToPose::Result>());
+            }}.detach();
+        });
+
+      controller_server_ = rclcpp_action::create_server<FollowPath>(
+        this, "follow_path",
+        [this](const rclcpp_action::GoalUUID &, std::shared_ptr<const FollowPath::Goal>) {
+          std::lock_guard<std::mutex> lock(mutex_);
+          latencies_ms_.push_back(
+            std::chrono::duration<double, std::milli>(Clock::now() - plan_finished_).count());
+          return rclcpp_action::GoalResponse::ACCEPT_AND_EXECUTE;
+        },
+        [](const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowPath>>) {
+          return rclcpp_action::CancelResponse::ACCEPT;
+        },
+        [this](const std::shared_ptr<rclcpp_action::ServerGoalHandle<FollowPath>> handle) {
+          std::thread{[this, handle]() {
+              std::this_thread::sleep_for(work_time_);
+              handle->succeed(std::make_shared<FollowPath::Result>());
+            }}.detach();
+        });
+    }
+
+    std::vector<double> takeLatencies()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      std::vector<double> latencies;
+      latencies.swap(latencies_ms_);
+      return latencies;
+    }
+
+  private:
+    std::chrono::milliseconds work_time_;
+    rclcpp_action::Server<ComputePathToPose>::SharedPtr planner_server_;
+    rclcpp_action::Server<FollowPath>::SharedPtr controller_server_;
+    std::mutex mutex_;
+    Clock::time_point plan_finished_;
+    std::vector<double> latencies_ms_;
+  };
+
+  // The loop BehaviorTree::execute ran before it waited on the wake up condition
+  class FixedRateTree : public BehaviorTree
+  {
+  public:
+    explicit FixedRateTree(const std::string & bt_xml)
+    : BehaviorTree(bt_xml) {}
+
+    BtStatus executeFixedRate(std::chrono::milliseconds tick_period)
+    {
+      if (!tree_) {
+        tree_ = std::make_unique<BT::Tree>(
+          BehaviorTreeCache::instance().instantiateTree(bt_xml_, blackboard_));
+      } else {
+        tree_->haltTree();
+      }
+      rclcpp::WallRate loop_rate(tick_period);
+      BT::NodeStatus result = BT::NodeStatus::RUNNING;
+      while (rclcpp::ok() && result == BT::NodeStatus::RUNNING) {
+        result = tree_->rootNode()->executeTick();
+        loop_rate.sleep();
+      }
+      return (result == BT::NodeStatus::SUCCESS) ? BtStatus::SUCCEEDED : BtStatus::FAILED;
+    }
+  };
+
+  void setWaypoint(BehaviorTree & bt, size_t i)
+  {
+    geometry_msgs::msg::PoseStamped pose;
+    pose.pose.position.x = static_cast<double>(i);
+    bt.blackboard()->set<std::chrono::seconds>("server_timeout", std::chrono::seconds(1)); // NOLINT
+    bt.blackboard()->set<int>("number_recoveries", 0);                                     // NOLINT
+    bt.blackboard()->set<geometry_msgs::msg::PoseStamped>("pose", pose);                   // NOLINT
+  }
+
+  void report(const std::string & mode, std::vector<double> latencies)
+  {
+    if (latencies.empty()) {
+      std::cout << mode << ",0,,,," << std::endl;
+      return;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    double mean = 0.0;
+    for (double l : latencies) {
+      mean += l / latencies.size();
+    }
+    std::cout << mode << "," << latencies.size() << "," << mean << "," <<
+      latencies[latencies.size() / 2] << "," <<
+      latencies[std::min(latencies.size() - 1, latencies.size() * 95 / 100)] << "," <<
+      latencies.back() << std::endl;
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  rclcpp::init(argc, argv);
+  size_t num_waypoints = argc > 1 ? std::stoul(argv[1]) : 100;
+  auto work_time = std::chrono::milliseconds(argc > 2 ? std::stoi(argv[2]) : 20);
+
+  auto servers = std::make_shared<StandInServers>(work_time);
+  rclcpp::executors::MultiThreadedExecutor executor;
+  executor.add_node(servers);
+  std::thread spin_thread([&executor]() {executor.spin();});
+
+  std::cout << "mode,num_samples,mean_latency_ms,p50_latency_ms,p95_latency_ms,max_latency_ms" <<
+    std::endl;
+  for (int period_ms : {10, 50}) {
+    FixedRateTree bt(kMissionXml);
+    for (size_t i = 0; i < num_waypoints && rclcpp::ok(); ++i) {
+      setWaypoint(bt, i);
+      bt.executeFixedRate(std::chrono::milliseconds(period_ms));
+    }
+    report("fixed_rate_" + std::to_string(period_ms) + "ms", servers->takeLatencies());
+  }
+  {
+    BehaviorTree bt(kMissionXml);
+    for (size_t i = 0; i < num_waypoints && rclcpp::ok(); ++i) {
+      setWaypoint(bt, i);
+      bt.execute();
+    }
+    report("event_driven", servers->takeLatencies());
+  }
+
+  executor.cancel();
+  spin_thread.join();
+  rclcpp::shutdown();
+  return 0;
+}
@@ -0,0 +1,231 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Cost of converting gps waypoints to map poses with one /fromLL service call
+per waypoint, as the gps waypoint server does when there is no utm -> map
+transform, against converting them in process with
+vox_nav_utilities::GeodeticConverter. A stand in /fromLL server
+in this process answers with the same converter, so only the round trip is
+measured. Before timing, conversions are checked against reference
+coordinates computed with PROJ, and round trips are checked, within 1 mm.
+If any check fails the benchmark exits with 1.
+Usage: geodetic_conversion_benchmark [num_waypoints]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "robot_localization/srv/from_ll.hpp"
+#include "vox_nav_utilities/geodetic_conversions.hpp"
+
+using namespace vox_nav_utilities;
+using Clock = std::chrono::steady_clock;
+using FromLL = robot_localization::srv::FromLL;
+
+namespace
+{
+  constexpr double kToleranceMeters = 1e-3;
+  // About 1 mm on the ground
+  constexpr double kToleranceDegrees = 1e-8;
+
+  struct UTMReference
+  {
+    double latitude, longitude;
+    int zone;
+    bool north;
+    double easting, northing;
+  };
+
+  // pyproj 3.7 (PROJ), EPSG:4326 to EPSG:326xx / EPSG:327xx. To regenerate, e.g. for the first row:
+  //   Transformer.from_crs("EPSG:4326", "EPSG:32632", always_xy=True).transform(10.78, 59.66)
+  // and print easting and northing with 4 decimals. The ECEF reference below comes from
+  //   Transformer.from_crs("EPSG:4979", "EPSG:4978", always_xy=True).transform(10.78, 59.66, 100.0)
+  const UTMReference kUTMReferences[] = {
+    {59.66, 10.78, 32, true, 600293.3468, 6614891.8471},      // Norway exception
+    {40.0, -74.0, 18, true, 585360.4618, 4428236.0646},
+    {-33.8568, 151.2153, 56, false, 334900.5697, 6252288.7529},
+    {0.0, 0.0, 31, true, 166021.4431, 0.0},
+    {64.1466, -21.9426, 27, true, 454138.3765, 7113689.8690},
+    {78.2232, 15.6267, 33, true, 514278.7151, 8683355.4695},  // Svalbard exception
+  };
+
+  int checkReferences()
+  {
+    int failures = 0;
+    auto fail = [&failures](const std::string & what) {
+        std::cerr << "FAILED: " << what << std::endl;
+        failures++;
+      };
+
+    for (const auto & ref : kUTMReferences) {
+      GeoPoint geo{ref.latitude, ref.longitude, 0.0};
+      UTMPoint utm = geoToUTM(geo);
+      std::string name = std::to_string(ref.latitude) + "," + std::to_string(ref.longitude);
+      if (utm.zone != ref.zone || utm.north != ref.north) {
+        fail("utm zone of " + name);
+      }
+      if (std::abs(utm.easting - ref.easting) > kToleranceMeters ||
+        std::abs(utm.northing - ref.northing) > kToleranceMeters)
+      {
+        fail("utm coordinates of " + name);
+      }
+      GeoPoint back = utmToGeo(utm);
+      if (std::abs(back.latitude - geo.latitude) > kToleranceDegrees ||
+        std::abs(back.longitude - geo.longitude) > kToleranceDegrees)
+      {
+        fail("utm round trip of " + name);
+      }
+    }
+
+    // pyproj EPSG:4979 to EPSG:4978
+    GeoPoint geo{59.66, 10.78, 100.0};
+    Eigen::Vector3d ecef = geoToECEF(geo);
+    if ((ecef - Eigen::Vector3d(3172903.6633, 604115.9653, 5481526.6215)).norm() >
+      kToleranceMeters)
+    {
+      fail("ecef coordinates");
+    }
+    GeoPoint back = ecefToGeo(ecef);
+    if (std::abs(back.latitude - geo.latitude) > kToleranceDegrees ||
+      std::abs(back.longitude - geo.longitude) > kToleranceDegrees ||
+      std::abs(back.altitude - geo.altitude) > kToleranceMeters)
+    {
+      fail("ecef round trip");
+    }
+
+    // ENU from the pyproj ECEF coordinates of both points
+    GeodeticConverter converter;
+    converter.setDatum(geo, Eigen::Vector3d::Zero(), 0.3);
+    GeoPoint point{59.661, 10.781, 90.0};
+    Eigen::Vector3d enu = converter.geoToENU(point);
+    if ((enu - Eigen::Vector3d(56.3707, 111.4085, -10.0012)).norm() > kToleranceMeters) {
+      fail("enu coordinates");
+    }
+    back = converter.enuToGeo(enu);
+    if (std::abs(back.latitude - point.latitude) > kToleranceDegrees ||
+      std::abs(back.longitude - point.longitude) > kToleranceDegrees ||
+      std::abs(back.altitude - point.altitude) > kToleranceMeters)
+    {
+      fail("enu round trip");
+    }
+
+    // A rotated and shifted map, the datum has to land where it was anchored
+    converter.setDatum(geo, Eigen::Vector3d(10.0, 20.0, 1.0), 0.3);
+    if ((converter.geoToMap(geo) - Eigen::Vector3d(10.0, 20.0, 1.0)).norm() > kToleranceMeters) {
+      fail("datum in map");
+    }
+    back = converter.mapToGeo(converter.geoToMap(point));
+    if (std::abs(back.latitude - point.latitude) > kToleranceDegrees ||
+      std::abs(back.longitude - point.longitude) > kToleranceDegrees ||
+      std::abs(back.altitude - point.altitude) > kToleranceMeters)
+    {
+      fail("map round trip");
+    }
+    return failures;
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t num_waypoints = argc > 1 ? std::stoul(argv[1]) : 10000;
+  rclcpp::init(argc, argv);
+
+  int failures = checkReferences();
+
+  GeoPoint datum{59.66, 10.78, 100.0};
+  GeodeticConverter converter;
+  converter.setDatum(datum);
+
+  // Waypoints on a 1 km square around the datum
+  std::vector<GeoPoint> waypoints(num_waypoints);
+  for (size_t i = 0; i < num_waypoints; i++) {
+    waypoints[i].latitude = datum.latitude + 0.009 * std::sin(0.001 * i);
+    waypoints[i].longitude = datum.longitude + 0.018 * std::cos(0.0007 * i);
+    waypoints[i].altitude = datum.altitude;
+  }
+
+  // Stand in /fromLL server, spun on its own thread like navsat_transform would be
+  auto server_node = std::make_shared<rclcpp::Node>("geodetic_benchmark_fromll_server");
+  auto server = server_node->create_service<FromLL>(
+    "geodetic_benchmark/fromLL",
+    [&converter](
+      const std::shared_ptr<FromLL::Request> request,
+      std::shared_ptr<FromLL::Response> response) {
+      GeoPoint geo{request->ll_point.latitude, request->ll_point.longitude,
+        request->ll_point.altitude};
+      Eigen::Vector3d map = converter.geoToMap(geo);
+      response->map_point.x = map.x();
+      response->map_point.y = map.y();
+      response->map_point.z = map.z();
+    });
+  rclcpp::executors::SingleThreadedExecutor server_executor;
+  server_executor.add_node(server_node);
+  std::thread server_thread([&server_executor]() {server_executor.spin();});
+
+  auto client_node = std::make_shared<rclcpp::Node>("geodetic_benchmark_fromll_client");
+  auto client = client_node->create_client<FromLL>("geodetic_benchmark/fromLL");
+  client->wait_for_service(std::chrono::seconds(5));
+
+  std::vector<Eigen::Vector3d> service_points(num_waypoints);
+  auto t0 = Clock::now();
+  for (size_t i = 0; i < num_waypoints; i++) {
+    auto request = std::make_shared<FromLL::Request>();
+    request->ll_point.latitude = waypoints[i].latitude;
+    request->ll_point.longitude = waypoints[i].longitude;
+    request->ll_point.altitude = waypoints[i].altitude;
+    auto future = client->async_send_request(request);
+    if (rclcpp::spin_until_future_complete(client_node, future) !=
+      rclcpp::FutureReturnCode::SUCCESS)
+    {
+      std::cerr << "FAILED: /fromLL call " << i << std::endl;
+      failures++;
+      break;
+    }
+    auto map_point = future.get()->map_point;
+    service_points[i] = Eigen::Vector3d(map_point.x, map_point.y, map_point.z);
+  }
+  double service_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+  std::vector<Eigen::Vector3d> in_process_points;
+  t0 = Clock::now();
+  converter.geoToMap(waypoints, in_process_points);
+  double in_process_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+
+  for (size_t i = 0; i < num_waypoints; i++) {
+    if ((service_points[i] - in_process_points[i]).norm() > kToleranceMeters) {
+      std::cerr << "FAILED: waypoint " << i << " differs between service and in process" <<
+        std::endl;
+      failures++;
+      break;
+    }
+  }
+
+  std::cout << "mode,waypoints,total_s,per_waypoint_us" << std::endl;
+  std::cout << "fromll_service," << num_waypoints << "," << service_seconds << "," <<
+    service_seconds * 1e6 / num_waypoints << std::endl;
+  std::cout << "in_process," << num_waypoints << "," << in_process_seconds << "," <<
+    in_process_seconds * 1e6 / num_waypoints << std::endl;
+
+  server_executor.cancel();
+  server_thread.join();
+  rclcpp::shutdown();
+  return failures ? 1 : 0;
+}
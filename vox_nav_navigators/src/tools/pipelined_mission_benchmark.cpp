@@ -0,0 +1,267 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Time a simulated robot spends stationary between the legs of a waypoint
+mission, with and without pipelined planning of the next leg. The simulated
+planner returns a straight line after a fixed planning time, the simulated
+controller drives along the path at constant speed. In the "map_updates"
+run the map changes while legs are cached, which must trigger revalidation.
+The mission has to succeed in every run and the pipelined runs have to be
+stationary less than the sequential one, otherwise the benchmark exits with 1.
+Usage: pipelined_mission_benchmark [num_legs] [planning_ms]
+*/
+
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vox_nav_navigators/pipelined_mission_executor.hpp"
+
+using namespace vox_nav_navigators;
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+  class SimulatedBackend : public MissionBackend
+  {
+  public:
+    SimulatedBackend(double speed, std::chrono::milliseconds planning_time)
+    : speed_(speed), planning_time_(planning_time)
+    {
+      sim_thread_ = std::thread(&SimulatedBackend::simulate, this);
+    }
+
+    ~SimulatedBackend() override
+    {
+      stop_ = true;
+      sim_thread_.join();
+      for (auto & planner : planners_) {
+        planner.join();
+      }
+    }
+
+    std::shared_future<nav_msgs::msg::Path> requestPlan(
+      const geometry_msgs::msg::PoseStamped & start,
+      const geometry_msgs::msg::PoseStamped & goal) override
+    {
+      geometry_msgs::msg::PoseStamped from = start;
+      if (from.header.frame_id.empty()) {
+        getRobotPose(from);
+      }
+      auto promise = std::make_shared<std::promise<nav_msgs::msg::Path>>();
+      std::shared_future<nav_msgs::msg::Path> future = promise->get_future().share();
+      std::lock_guard<std::mutex> lock(mutex_);
+      planners_.emplace_back(
+        [this, promise, from, goal]() {
+          std::this_thread::sleep_for(planning_time_);
+          nav_msgs::msg::Path path;
+          path.header.frame_id = "map";
+          path.poses.push_back(from);
+          path.poses.push_back(goal);
+          promise->set_value(path);
+        });
+      return future;
+    }
+
+    void followPath(const nav_msgs::msg::Path & path) override
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      // Like the controller server, the path is followed from where the robot is
+      path_.assign(1, robot_);
+      path_.insert(path_.end(), path.poses.begin(), path.poses.end());
+      next_pose_ = 1;
+      status_ = FollowStatus::RUNNING;
+    }
+
+    FollowStatus followStatus() override
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return status_;
+    }
+
+    void cancel() override
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      status_ = FollowStatus::IDLE;
+    }
+
+    bool getRobotPose(geometry_msgs::msg::PoseStamped & pose) override
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      pose = robot_;
+      return true;
+    }
+
+    std::uint64_t mapVersion() override {return map_version_;}
+
+    void changeMap() {map_version_++;}
+
+    // Time since the first followPath() during which the robot did not move
+    double stationarySeconds()
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      return stationary_seconds_;
+    }
+
+  private:
+    void simulate()
+    {
+      auto last = Clock::now();
+      while (!stop_) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        auto now = Clock::now();
+        double dt = std::chrono::duration<double>(now - last).count();
+        last = now;
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (status_ != FollowStatus::RUNNING) {
+          if (started_ && status_ != FollowStatus::IDLE) {
+            stationary_seconds_ += dt;
+          }
+          continue;
+        }
+        started_ = true;
+        double step = speed_ * dt;
+        while (step > 0.0 && next_pose_ < path_.size()) {
+          auto & target = path_[next_pose_].pose.position;
+          double dx = target.x - robot_.pose.position.x;
+          double dy = target.y - robot_.pose.position.y;
+          double dist = std::hypot(dx, dy);
+          if (dist <= step) {
+            robot_.pose.position.x = target.x;
+            robot_.pose.position.y = target.y;
+            step -= dist;
+            next_pose_++;
+          } else {
+            robot_.pose.position.x += dx / dist * step;
+            robot_.pose.position.y += dy / dist * step;
+            step = 0.0;
+          }
+        }
+        if (next_pose_ >= path_.size()) {
+          status_ = FollowStatus::SUCCEEDED;
+        }
+      }
+    }
+
+    double speed_;
+    std::chrono::milliseconds planning_time_;
+    std::mutex mutex_;
+    geometry_msgs::msg::PoseStamped robot_;
+    std::vector<geometry_msgs::msg::PoseStamped> path_;
+    size_t next_pose_{0};
+    FollowStatus status_{FollowStatus::IDLE};
+    bool started_{false};
+    double stationary_seconds_{0.0};
+    std::atomic<std::uint64_t> map_version_{1};
+    std::atomic<bool> stop_{false};
+    std::vector<std::thread> planners_;
+    std::thread sim_thread_;
+  };
+
+  struct RunResult
+  {
+    MissionStatus status;
+    double mission_seconds;
+    double stationary_seconds;
+    PipelinedMissionStats stats;
+  };
+
+  RunResult run(
+    const std::vector<geometry_msgs::msg::PoseStamped> & goals, bool pipelined,
+    std::chrono::milliseconds planning_time, bool map_updates)
+  {
+    // 4 m/s over 4 m legs, one second per leg
+    SimulatedBackend backend(4.0, planning_time);
+    PipelinedMissionParams params;
+    params.pipelined = pipelined;
+    params.switch_distance = 1.0;
+    params.loop_period = std::chrono::milliseconds(5);
+    PipelinedMissionExecutor executor(backend, params);
+
+    std::atomic<bool> done{false};
+    std::thread map_updater;
+    if (map_updates) {
+      // Change the map about once per leg, so that some cached legs were planned on an older map
+      map_updater = std::thread(
+        [&]() {
+          while (!done) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1000));
+            backend.changeMap();
+          }
+        });
+    }
+
+    auto t0 = Clock::now();
+    RunResult result;
+    result.status = executor.execute(goals);
+    result.mission_seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    result.stationary_seconds = backend.stationarySeconds();
+    result.stats = executor.stats();
+    done = true;
+    if (map_updater.joinable()) {
+      map_updater.join();
+    }
+    return result;
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  size_t num_legs = argc > 1 ? std::stoul(argv[1]) : 8;
+  auto planning_time = std::chrono::milliseconds(argc > 2 ? std::stoi(argv[2]) : 300);
+
+  // Square spiral of 4 m legs
+  std::vector<geometry_msgs::msg::PoseStamped> goals(num_legs);
+  double x = 0.0, y = 0.0;
+  for (size_t i = 0; i < num_legs; i++) {
+    const double step[4][2] = {{4, 0}, {0, 4}, {-4, 0}, {0, -4}};
+    x += step[i % 4][0];
+    y += step[i % 4][1];
+    goals[i].header.frame_id = "map";
+    goals[i].pose.position.x = x;
+    goals[i].pose.position.y = y;
+  }
+
+  std::cout << "mode,legs,planning_ms,mission_s,stationary_s,prefetched_legs,seamless_handovers,"
+    "revalidations" << std::endl;
+  int failures = 0;
+  double sequential_stationary = 0.0;
+  for (auto mode : {"sequential", "pipelined", "pipelined_map_updates"}) {
+    std::string m(mode);
+    auto r = run(goals, m != "sequential", planning_time, m == "pipelined_map_updates");
+    std::cout << m << "," << num_legs << "," << planning_time.count() << "," << r.mission_seconds <<
+      "," << r.stationary_seconds << "," << r.stats.prefetched_legs << "," <<
+      r.stats.seamless_handovers << "," << r.stats.revalidations << std::endl;
+    if (r.status != MissionStatus::SUCCEEDED) {
+      std::cerr << "FAILED: " << m << " mission did not succeed" << std::endl;
+      failures++;
+    }
+    if (m == "sequential") {
+      sequential_stationary = r.stationary_seconds;
+    } else if (num_legs > 1 && r.stationary_seconds >= sequential_stationary) {
+      std::cerr << "FAILED: " << m << " was not stationary for less time than sequential" << std::endl;
+      failures++;
+    }
+    if (m == "pipelined_map_updates" && num_legs > 2 && r.stats.revalidations == 0) {
+      std::cerr << "FAILED: map updates did not revalidate any cached leg" << std::endl;
+      failures++;
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -41,6 +41,7 @@
 
 #include "rclcpp/rclcpp.hpp"
 #include "visualization_msgs/msg/marker_array.hpp"
+#include "vox_nav_planning/native_planners/PlannerVisualizationSink.hpp"
 #include "vox_nav_utilities/elevation_state_space.hpp"
 
 #include <thread>
@@ -234,36 +235,24 @@ private:
   std::vector<const ompl::base::State*> getConstStatesFromPath(const std::shared_ptr<ompl::control::PathControl>& path);
 
   // RVIZ Visualization of planner progess, this will be removed in the future
+  // The visualize methods copy what they show into a snapshot for the PlannerVisualizationSink,
+  // they return right away when the sink does not want one for the topic
 
   /** \brief static method to visulize a graph in RVIZ*/
   static void visualizeRGG(const std::shared_ptr<ompl::NearestNeighbors<VertexProperty*>>& nn_structure,
-                           const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher,
-                           const std::string& ns, const std_msgs::msg::ColorRGBA& color, const int& state_space_type);
+                           const std::string& topic, const std::string& ns, const std_msgs::msg::ColorRGBA& color,
+                           const int& state_space_type);
 
-  static void visualizePath(const std::shared_ptr<PathControl>& path,
-                            const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher,
-                            const std::string& ns, const std_msgs::msg::ColorRGBA& color, const int& state_space_type);
+  static void visualizePath(const std::shared_ptr<PathControl>& path, const std::string& topic, const std::string& ns,
+                            const std_msgs::msg::ColorRGBA& color, const int& state_space_type);
 
   /** \brief get std_msgs::msg::ColorRGBA given the color name with a std::string*/
   static std_msgs::msg::ColorRGBA getColor(std::string& color);
 
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr rgg_graph_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr geometric_path_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr first_control_graph_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr second_control_graph_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr control_path_pub_;
-
-  /** \brief The node*/
-  rclcpp::Node::SharedPtr node_;
+  /** \brief The topics for the control graph/path visulization*/
+  std::string first_control_graph_topic_{ "vox_nav/CostTrustKinoPlanner/first_control_rgg" };
+  std::string second_control_graph_topic_{ "vox_nav/CostTrustKinoPlanner/second_control_rgg" };
+  std::string control_path_topic_{ "vox_nav/CostTrustKinoPlanner/c_plan" };
 
 };  // class CostTrustKinoPlanner
 }  // namespace control
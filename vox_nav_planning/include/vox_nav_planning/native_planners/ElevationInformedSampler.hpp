@@ -0,0 +1,111 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_PLANNING__NATIVE_PLANNERS__ELEVATION_INFORMED_SAMPLER_HPP_
+#define VOX_NAV_PLANNING__NATIVE_PLANNERS__ELEVATION_INFORMED_SAMPLER_HPP_
+
+#include <Eigen/Core>
+
+#include "ompl/base/samplers/InformedStateSampler.h"
+#include "ompl/util/ProlateHyperspheroid.h"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ompl
+{
+namespace base
+{
+/**
+   @anchor ElevationInformedSampler
+   @par Short description
+   Direct informed sampler of ElevationStateSpace, OMPL's PathLengthDirectInfSampler does not know the space and
+   RejectionInfSampler wastes most of its samples once the informed set is small.
+   The cost of a path is taken to be at least its length, and the length at least the euclidean one:
+   in x, y, z for the SE2 mode of the space, in x, y for the Dubins and Reeds-Shepp modes, whose distance ignores z.
+   So x, y(, z) are sampled directly in the prolate hyperspheroid with the start and goal as foci and the cost as
+   transverse diameter, z uniformly within its bounds in the 2D case, yaw and v uniformly within their bounds.
+   With setTraversableCells() the positions are drawn from the cells (e.g. elevated surfels) inside the
+   hyperspheroid instead, the cells inside are listed once per cost and shared by all threads.
+   sampleUniform() can be called from several threads.
+   Only the first start and a GoalState goal are used.
+*/
+class ElevationInformedSampler : public InformedSampler
+{
+public:
+  /** \brief Constructor, throws if the space is not an ElevationStateSpace or there is no start or GoalState */
+  ElevationInformedSampler(const ProblemDefinitionPtr& probDefn, unsigned int maxNumberCalls);
+
+  ~ElevationInformedSampler() override = default;
+
+  /** \brief Sample only at these positions, an empty list samples the whole hyperspheroid again */
+  void setTraversableCells(const std::vector<Eigen::Vector3d>& cells);
+
+  /** \brief Number of traversable cells within the bounds and the informed set of \e maxCost */
+  std::size_t getNumCellsInInformedSet(const Cost& maxCost);
+
+  bool sampleUniform(State* statePtr, const Cost& maxCost) override;
+
+  bool sampleUniform(State* statePtr, const Cost& minCost, const Cost& maxCost) override;
+
+  bool hasInformedMeasure() const override;
+
+  /** \brief Measure of the hyperspheroid times the z (2D case), yaw and v ranges, at most the space measure */
+  double getInformedMeasure(const Cost& currentCost) const override;
+
+  /** \brief The euclidean length from the start through \e statePtr to the goal */
+  Cost heuristicSolnCost(const State* statePtr) const override;
+
+private:
+  /** \brief The hyperspheroid of one cost and the traversable cells inside it, immutable once made */
+  struct InformedSet
+  {
+    double max_cost;
+    std::shared_ptr<const ProlateHyperspheroid> phs;
+    std::vector<Eigen::Vector3d> cells;
+  };
+
+  /** \brief The informed set of \e max_cost, made when the cost changed */
+  std::shared_ptr<const InformedSet> informedSet(double max_cost);
+
+  /** \brief Position within the space bounds and the informed set, without the cells */
+  bool samplePosition(const InformedSet& set, double* xyz) const;
+
+  bool inBounds(const double* xyz) const;
+
+  void setState(State* statePtr, const double* xyz) const;
+
+  /** \brief 3 if the distance of the space includes z, 2 otherwise */
+  unsigned int phsDimension_;
+
+  double start_[3];
+  double goal_[3];
+
+  /** \brief Bounds of x, y, z, v */
+  RealVectorBounds bounds_{ 4 };
+
+  /** \brief Hyperspheroid used for measures only, its transverse diameter is never set */
+  std::shared_ptr<const ProlateHyperspheroid> measurePhs_;
+
+  /** \brief The traversable cells and the informed set made from them, changed under informedSetMutex_ */
+  std::mutex informedSetMutex_;
+  std::vector<Eigen::Vector3d> cells_;
+  std::shared_ptr<const InformedSet> informedSet_;
+};
+}  // namespace base
+}  // namespace ompl
+
+#endif  // VOX_NAV_PLANNING__NATIVE_PLANNERS__ELEVATION_INFORMED_SAMPLER_HPP_
@@ -0,0 +1,236 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_PLANNING__NATIVE_PLANNERS__GRAPH_LPASTAR_HPP_
+#define VOX_NAV_PLANNING__NATIVE_PLANNERS__GRAPH_LPASTAR_HPP_
+
+#include <boost/graph/adjacency_list.hpp>
+#include <boost/graph/graph_traits.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <list>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace ompl
+{
+namespace control
+{
+/**
+   @anchor cGraphLPAstar
+   @par Short description
+   Lifelong Planning A* (Koenig, Likhachev and Furcy, 2004) on an undirected boost graph that keeps growing.
+   The search runs from a fixed root to a fixed target and keeps its g and rhs values between calls,
+   so after the graph changed only the vertices affected by the change are expanded again.
+   The graph is not copied, vertices are read with their vertex_descriptor, which therefore has to be an index
+   (boost::vecS vertex container) and vertices must not be removed.
+   The edge weights are read from \e weightmap at the time a vertex is updated.
+*/
+template <class Graph, class WeightMap>
+class GraphLPAstar
+{
+public:
+  typedef typename boost::graph_traits<Graph>::vertex_descriptor vertex_descriptor;
+
+  /** \brief Admissible and consistent estimate of the cost from a vertex to the target */
+  typedef std::function<double(vertex_descriptor)> Heuristic;
+
+  /** \brief Constructor, the vertices and edges already in \e g are taken in at the first update() */
+  GraphLPAstar(const Graph& g, const WeightMap& weightmap, vertex_descriptor root, vertex_descriptor target,
+               const Heuristic& heuristic)
+    : g_(g), weightmap_(weightmap), root_(root), target_(target), heuristic_(heuristic)
+  {
+  }
+
+  /** \brief Take in the vertices added to the graph since the last call.
+   * Edges may only have been added next to the new vertices or to the root in the meantime,
+   * any other change has to be reported with updateEdges(). */
+  void update()
+  {
+    std::size_t num_vertices = boost::num_vertices(g_);
+    std::size_t num_known_vertices = cost_.size();
+    if (num_vertices <= num_known_vertices)
+    {
+      updateEdges(root_);
+      return;
+    }
+    cost_.resize(num_vertices, std::numeric_limits<double>::infinity());
+    rhs_.resize(num_vertices, std::numeric_limits<double>::infinity());
+    heuristic_values_.resize(num_vertices, 0.0);
+    keys_.resize(num_vertices);
+    in_queue_.resize(num_vertices, false);
+    for (std::size_t v = num_known_vertices; v < num_vertices; v++)
+    {
+      heuristic_values_[v] = heuristic_(v);
+    }
+    if (root_ >= num_known_vertices && root_ < num_vertices)
+    {
+      rhs_[root_] = 0.0;
+    }
+    for (std::size_t v = num_known_vertices; v < num_vertices; v++)
+    {
+      updateVertex(v);
+      for (auto e : boost::make_iterator_range(boost::out_edges(v, g_)))
+      {
+        vertex_descriptor u = boost::target(e, g_);
+        if (u < num_known_vertices)
+        {
+          updateVertex(u);
+        }
+      }
+    }
+    updateEdges(root_);
+  }
+
+  /** \brief Report that the weights of the edges of \e u changed, e.g. they were set to infinity */
+  void updateEdges(vertex_descriptor u)
+  {
+    updateVertex(u);
+    for (auto e : boost::make_iterator_range(boost::out_edges(u, g_)))
+    {
+      updateVertex(boost::target(e, g_));
+    }
+  }
+
+  /** \brief Repair the search until the cost of the target is known and extract the path to the root
+   * \param path is filled with the vertices from the target to the root, empty if they are not connected
+   * \return cost of the path, infinity if there is none */
+  double computeShortestPath(std::list<vertex_descriptor>& path)
+  {
+    path.clear();
+    if (target_ >= cost_.size())
+    {
+      return std::numeric_limits<double>::infinity();
+    }
+    while (!queue_.empty() && (queue_.begin()->first < calculateKey(target_) || rhs_[target_] != cost_[target_]))
+    {
+      vertex_descriptor u = queue_.begin()->second;
+      queue_.erase(queue_.begin());
+      in_queue_[u] = false;
+      num_expansions_++;
+      if (cost_[u] > rhs_[u])
+      {
+        cost_[u] = rhs_[u];
+      }
+      else
+      {
+        cost_[u] = std::numeric_limits<double>::infinity();
+        updateVertex(u);
+      }
+      for (auto e : boost::make_iterator_range(boost::out_edges(u, g_)))
+      {
+        updateVertex(boost::target(e, g_));
+      }
+    }
+
+    if (cost_[target_] == std::numeric_limits<double>::infinity())
+    {
+      return cost_[target_];
+    }
+    // Walk down the costs, every step goes to the neighbour through which the vertex got its cost
+    vertex_descriptor u = target_;
+    path.push_back(u);
+    while (u != root_)
+    {
+      double best = std::numeric_limits<double>::infinity();
+      vertex_descriptor next = u;
+      for (auto e : boost::make_iterator_range(boost::out_edges(u, g_)))
+      {
+        vertex_descriptor v = boost::target(e, g_);
+        double c = cost_[v] + weightmap_[e];
+        if (c < best)
+        {
+          best = c;
+          next = v;
+        }
+      }
+      if (next == u || path.size() > cost_.size())
+      {
+        path.clear();
+        return std::numeric_limits<double>::infinity();
+      }
+      u = next;
+      path.push_back(u);
+    }
+    return cost_[target_];
+  }
+
+  /** \brief Cost from \e u to the root as known by the search, infinity if it was not reached */
+  double getCost(vertex_descriptor u) const
+  {
+    return u < cost_.size() ? cost_[u] : std::numeric_limits<double>::infinity();
+  }
+
+  /** \brief Number of vertices expanded by all computeShortestPath() calls */
+  std::size_t getNumExpansions() const
+  {
+    return num_expansions_;
+  }
+
+private:
+  typedef std::pair<double, double> Key;
+
+  Key calculateKey(vertex_descriptor u) const
+  {
+    double k = std::min(cost_[u], rhs_[u]);
+    return Key(k + heuristic_values_[u], k);
+  }
+
+  void updateVertex(vertex_descriptor u)
+  {
+    if (u != root_)
+    {
+      rhs_[u] = std::numeric_limits<double>::infinity();
+      for (auto e : boost::make_iterator_range(boost::out_edges(u, g_)))
+      {
+        rhs_[u] = std::min(rhs_[u], cost_[boost::target(e, g_)] + weightmap_[e]);
+      }
+    }
+    if (in_queue_[u])
+    {
+      queue_.erase(std::make_pair(keys_[u], u));
+      in_queue_[u] = false;
+    }
+    if (cost_[u] != rhs_[u])
+    {
+      keys_[u] = calculateKey(u);
+      queue_.insert(std::make_pair(keys_[u], u));
+      in_queue_[u] = true;
+    }
+  }
+
+  const Graph& g_;
+  WeightMap weightmap_;
+  vertex_descriptor root_;
+  vertex_descriptor target_;
+  Heuristic heuristic_;
+
+  /** \brief g, rhs and heuristic values, the key the vertex is queued with, all indexed by vertex_descriptor */
+  std::vector<double> cost_;
+  std::vector<double> rhs_;
+  std::vector<double> heuristic_values_;
+  std::vector<Key> keys_;
+  std::vector<bool> in_queue_;
+
+  std::set<std::pair<Key, vertex_descriptor>> queue_;
+  std::size_t num_expansions_{ 0 };
+};  // GraphLPAstar
+}  // namespace control
+}  // namespace ompl
+
+#endif  // VOX_NAV_PLANNING__NATIVE_PLANNERS__GRAPH_LPASTAR_HPP_
@@ -40,9 +40,15 @@
 
 #include "rclcpp/rclcpp.hpp"
 #include "visualization_msgs/msg/marker_array.hpp"
+#include "vox_nav_planning/native_planners/PlannerVisualizationSink.hpp"
 #include "vox_nav_utilities/elevation_state_space.hpp"
+#include "vox_nav_planning/native_planners/ElevationInformedSampler.hpp"
+#include "vox_nav_planning/native_planners/GraphLPAstar.hpp"
+#include "vox_nav_planning/native_planners/NearestNeighborsKDForest.hpp"
 
+#include <algorithm>
 #include <thread>
+#include <chrono>
 #include <mutex>
 #include <atomic>
 #include <limits>
@@ -102,6 +108,22 @@ struct Parameters
 
   /** \brief whether to solve the kinodyanmic solution */
   bool solve_control_graph_{ true };
+
+  /** \brief Keep the validity of geometric vertices once it is known,
+   * so that the searches do not collision check the same vertex again */
+  bool use_validity_cache_{ true };
+
+  /** \brief Keep the geometric search of each thread alive across batches with LPA*
+   * and only repair it where the graph changed, instead of searching the whole graph again in every batch */
+  bool use_incremental_search_{ false };
+
+  /** \brief Use NearestNeighborsKDForest instead of the default nearest neighbor structure, its queries need no lock
+   * while another thread adds to it, as the control threads do when they connect to their counterpart */
+  bool use_kd_forest_{ false };
+
+  /** \brief On an ElevationStateSpace, sample the informed set with ElevationInformedSampler
+   * instead of OMPL's rejection sampling, restricted to the cells given by setInformedSamplerCells() if any */
+  bool use_direct_informed_sampler_{ false };
 };
 
 class InformedSGCP : public base::Planner
@@ -130,6 +152,14 @@ public:
   /** \brief Free the memory allocated by this planner. That is mostly in nearest neihbours. */
   void freeMemory();
 
+  /** \brief Validity of the state of a vertex, UNKNOWN until it is checked once */
+  enum class VertexValidity : std::uint8_t
+  {
+    UNKNOWN,
+    VALID,
+    INVALID
+  };
+
   /** \brief Properties of boost graph vertex, both geometriuc and control graphs share this vertex property.
    *  Some of the elements are not used in geometric graph (e.g., control, control_duration). */
   struct VertexProperty
@@ -142,6 +172,7 @@ public:
     double g{ 1.0e+3 };
     bool blacklisted{ false };
     bool is_root{ false };
+    VertexValidity validity{ VertexValidity::UNKNOWN };
   };
 
   /** \brief Compute distance between Vertexes (actually distance between contained states) */
@@ -192,6 +223,36 @@ public:
   void setSolveControlGraph(bool solve_control_graph);
   bool getSolveControlGraph() const;
 
+  void setUseValidityCache(bool use_validity_cache);
+  bool getUseValidityCache() const;
+
+  /** \brief Number of validity checks the geometric searches of the last solve() made on vertex states */
+  std::uint64_t getNumSearchValidityChecks() const;
+
+  /** \brief Number of times the geometric searches of the last solve() used a cached vertex validity */
+  std::uint64_t getNumValidityCacheHits() const;
+
+  /** \brief Number of geometric vertices of the last solve() whose validity was recorded when they were added */
+  std::uint64_t getNumPrevalidatedVertices() const;
+
+  void setUseIncrementalSearch(bool use_incremental_search);
+  bool getUseIncrementalSearch() const;
+
+  void setUseKDForest(bool use_kd_forest);
+  bool getUseKDForest() const;
+
+  void setUseDirectInformedSampler(bool use_direct_informed_sampler);
+  bool getUseDirectInformedSampler() const;
+
+  /** \brief Traversable positions (e.g. elevated surfels) the direct informed sampler draws from, empty for none */
+  void setInformedSamplerCells(const std::vector<Eigen::Vector3d>& cells);
+
+  /** \brief Number of batches the last solve() went through, can be read while solving */
+  std::size_t getNumBatches() const;
+
+  /** \brief Wall time in ms the geometric searches took in each batch of the last solve(), the slowest thread counts */
+  std::vector<double> getBatchSearchTimes() const;
+
 private:
   /** \brief All configurable parames live here. */
   Parameters params_;
@@ -209,8 +270,14 @@ private:
   /** \brief Keep status of current status*/
   int currentBestSolutionStatus_{ ompl::base::PlannerStatus::UNKNOWN };
 
-  /** \brief Informed sampling strategy */
-  std::shared_ptr<base::RejectionInfSampler> rejectionInformedSampler_{ nullptr };
+  /** \brief Informed sampling strategy, see Parameters::use_direct_informed_sampler_ */
+  base::InformedSamplerPtr informedSampler_{ nullptr };
+
+  /** \brief The cells of setInformedSamplerCells() */
+  std::vector<Eigen::Vector3d> informedSamplerCells_;
+
+  /** \brief The direct informed sampler if it is used and applies to the problem, the rejection sampler otherwise */
+  base::InformedSamplerPtr allocInformedSampler();
 
   /** \brief Valid state sampler */
   base::ValidStateSamplerPtr validStateSampler_{ nullptr };
@@ -253,6 +320,18 @@ private:
 
   std::mutex nnMutex_;
 
+  /** \brief The nearest neighbor structure of a geometric or control thread, see Parameters::use_kd_forest_ */
+  std::shared_ptr<ompl::NearestNeighbors<VertexProperty*>> allocNearestNeighbors();
+
+  /** \brief Validity bookkeeping of the last solve(), updated by all geometric threads */
+  std::atomic<std::uint64_t> numSearchValidityChecks_{ 0 };
+  std::atomic<std::uint64_t> numValidityCacheHits_{ 0 };
+  std::atomic<std::uint64_t> numPrevalidatedVertices_{ 0 };
+
+  /** \brief Search time bookkeeping of the last solve(), written by the main thread after the geometric threads joined */
+  std::atomic<std::size_t> numBatches_{ 0 };
+  std::vector<double> batchSearchTimes_;
+
   /** \brief The typedef of Edge cost as double,
    * note that ompl::base::Cost wont work as some operators are not provided (e.g. +) */
   typedef double GraphEdgeCost;
@@ -322,14 +401,15 @@ private:
     double operator()(vertex_descriptor i)
     {
       double cost{ std::numeric_limits<double>::infinity() };
+      auto* vertex = alg_->getVertexMutable(i, threadId_);
       // verify that the state is valid
-      if (alg_->si_->isValid(alg_->getVertex(i, threadId_)->state))
+      if (alg_->isVertexValid(vertex))
       {
-        cost = alg_->getVertex(i, threadId_)->g;
+        cost = vertex->g;
       }
       else
       {
-        alg_->getVertexMutable(i, threadId_)->blacklisted = true;
+        vertex->blacklisted = true;
       }
       return cost;
     }
@@ -383,6 +463,9 @@ private:
   /** \brief The control graphs, the numbers of graphs equals to number of threads */
   std::vector<GraphT> graphControlThreads_;
 
+  /** \brief The incremental geometric searches from goal to start, one for each geometric graph */
+  std::vector<std::shared_ptr<GraphLPAstar<GraphT, WeightMap>>> incrementalSearchThreads_;
+
   /** \brief A templetaed function to run shortest path algorithms such as A* or Dijkstra on boost graphs
    * \param[in] g The boost graph
    * \param[in] weightmap The weightmap of the boost graph indicating edge weights
@@ -478,6 +561,28 @@ private:
     }
   }
 
+  /** \brief Validity of the state of a geometric vertex,
+   * checked once and then read from the vertex if use_validity_cache_ is set.
+   * Each geometric graph is only touched by its own thread, so the vertex needs no locking.
+   * \param vertex the vertex to check, its validity is updated
+   */
+  bool isVertexValid(VertexProperty* vertex);
+
+  /** \brief Incremental counterpart of the two computeShortestPath() calls of a batch.
+   * Brings the new vertices and edges into \e search, repairs it and checks the vertices of the resulting path,
+   * invalid vertices are blacklisted, their edges get infinite cost and the search is repaired again
+   * until a valid path is found, there is none or \e ptc is met. Once the vertices are valid the motions
+   * between them are checked the same way, an edge in collision gets infinite cost.
+   * \param g The boost graph
+   * \param weightmap The weightmap of the boost graph indicating edge weights
+   * \param search The LPA* search of this graph
+   * \param ptc termination condition
+   * \return The shortest valid path from start to goal as a list of vertex_descriptors
+   */
+  std::list<vertex_descriptor> computeIncrementalShortestPath(GraphT& g, WeightMap& weightmap,
+                                                              GraphLPAstar<GraphT, WeightMap>& search,
+                                                              const base::PlannerTerminationCondition& ptc);
+
   /** \brief generate a requested amound of states with preffered state sampler
    * \param batch_size number of states to generate
    * \param use_valid_sampler if true, use valid state sampler, otherwise use uniform sampler
@@ -596,43 +701,30 @@ private:
                           std::vector<std::pair<vertex_descriptor, vertex_descriptor>>& control_start_goal_descriptors);
 
   // RVIZ Visualization of planner progess, this will be removed in the future
+  // The visualize methods copy what they show into a snapshot for the PlannerVisualizationSink,
+  // they return right away when the sink does not want one for the topic
 
   /** \brief static method to visulize a graph in RVIZ*/
-  static void visualizeRGG(const GraphT& g,
-                           const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher,
-                           const std::string& ns, const std_msgs::msg::ColorRGBA& color,
-                           const vertex_descriptor& start_vertex, const vertex_descriptor& goal_vertex,
-                           const int& state_space_type);
+  static void visualizeRGG(const GraphT& g, const std::string& topic, const std::string& ns,
+                           const std_msgs::msg::ColorRGBA& color, const vertex_descriptor& start_vertex,
+                           const vertex_descriptor& goal_vertex, const int& state_space_type);
 
   /** \brief static method to visulize a path in RVIZ*/
-  static void visualizePath(const GraphT& g, const std::list<vertex_descriptor>& path,
-                            const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher,
+  static void visualizePath(const GraphT& g, const std::list<vertex_descriptor>& path, const std::string& topic,
                             const std::string& ns, const std_msgs::msg::ColorRGBA& color, const int& state_space_type);
 
-  static void visualizePath(const std::shared_ptr<PathControl>& path,
-                            const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher,
-                            const std::string& ns, const std_msgs::msg::ColorRGBA& color, const int& state_space_type);
+  static void visualizePath(const std::shared_ptr<PathControl>& path, const std::string& topic, const std::string& ns,
+                            const std_msgs::msg::ColorRGBA& color, const int& state_space_type);
 
   /** \brief get std_msgs::msg::ColorRGBA given the color name with a std::string*/
   static std_msgs::msg::ColorRGBA getColor(std::string& color);
 
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr rgg_graph_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr geometric_path_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr first_control_graph_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr second_control_graph_pub_;
-
-  /** \brief The publishers for the geometric and control graph/path visulization*/
-  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr control_path_pub_;
-
-  /** \brief The node*/
-  rclcpp::Node::SharedPtr node_;
+  /** \brief The topics for the geometric and control graph/path visulization*/
+  std::string rgg_graph_topic_{ "vox_nav/InformedSGCP/rgg" };
+  std::string geometric_path_topic_{ "vox_nav/InformedSGCP/g_plan" };
+  std::string first_control_graph_topic_{ "vox_nav/InformedSGCP/first_control_rgg" };
+  std::string second_control_graph_topic_{ "vox_nav/InformedSGCP/second_control_rgg" };
+  std::string control_path_topic_{ "vox_nav/InformedSGCP/c_plan" };
 
 };  // class InformedSGCP
 }  // namespace control
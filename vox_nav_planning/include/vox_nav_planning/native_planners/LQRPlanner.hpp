@@ -55,10 +55,6 @@ namespace ompl
       /** \brief Free the memory allocated by this planner */
       void freeMemory();
 
-      rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr rrt_nodes_pub_;
-
-      rclcpp::Node::SharedPtr node_;
-
       double dt_{0.25};
       double max_time_{2.0};
       double q1_{1};
@@ -0,0 +1,435 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_PLANNING__NATIVE_PLANNERS__NEAREST_NEIGHBORS_KD_FOREST_HPP_
+#define VOX_NAV_PLANNING__NATIVE_PLANNERS__NEAREST_NEIGHBORS_KD_FOREST_HPP_
+
+#include "ompl/datastructures/NearestNeighbors.h"
+#include "ompl/util/Exception.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace ompl
+{
+/**
+   @anchor NearestNeighborsKDForest
+   @par Short description
+   Nearest neighbor structure for planners whose threads query a structure while another thread adds to it.
+   The elements live in a forest of static, balanced KD-trees and a small append-only buffer.
+   A full buffer, or a batch given to add(std::vector), becomes a new tree, and trees of similar size are merged
+   into one (logarithmic method), so there are O(log n) trees and every element is rebuilt O(log n) times.
+   The trees and the buffer are published as an immutable snapshot, queries take no lock and see either the
+   snapshot before or after a concurrent add(). Writers are serialized by a mutex.
+   The KD-trees split on a projection of the elements, which has to be a lower bound of the distance:
+   distFun_(a, b) >= |projection(a) - projection(b)|, e.g. the x, y position of Dubins, Reeds-Shepp and
+   ElevationStateSpace states or any subset of RealVectorStateSpace coordinates.
+*/
+template <typename _T>
+class NearestNeighborsKDForest : public NearestNeighbors<_T>
+{
+public:
+  /** \brief Writes the \e dimension projected coordinates of an element */
+  typedef std::function<void(const _T&, double*)> Projection;
+
+  /** \brief Constructor
+   * \param dimension of the projection
+   * \param projection lower bound of the distance, see the class description
+   * \param buffer_capacity elements added one by one are collected in a buffer of this size before they become a tree
+   */
+  NearestNeighborsKDForest(unsigned int dimension, const Projection& projection, std::size_t buffer_capacity = 256)
+    : dimension_(dimension), projection_(projection), bufferCapacity_(std::max<std::size_t>(buffer_capacity, 1))
+  {
+    std::atomic_store(&snapshot_, std::make_shared<const Snapshot>(Snapshot{ {}, newBuffer() }));
+  }
+
+  ~NearestNeighborsKDForest() override = default;
+
+  bool reportsSortedResults() const override
+  {
+    return true;
+  }
+
+  void clear() override
+  {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    std::atomic_store(&snapshot_, std::make_shared<const Snapshot>(Snapshot{ {}, newBuffer() }));
+  }
+
+  void add(const _T& data) override
+  {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    auto snapshot = std::atomic_load(&snapshot_);
+    Buffer& buffer = *snapshot->buffer;
+    std::size_t n = buffer.size.load(std::memory_order_relaxed);
+    if (n < bufferCapacity_)
+    {
+      // Readers only look at the first size elements, so the slot can be written before size is published
+      buffer.data[n] = data;
+      projection_(data, &buffer.coords[n * dimension_]);
+      buffer.size.store(n + 1, std::memory_order_release);
+      return;
+    }
+    std::vector<_T> elements(buffer.data.get(), buffer.data.get() + n);
+    elements.push_back(data);
+    insertTree(*snapshot, std::move(elements));
+  }
+
+  /** \brief Bulk insertion, the batch becomes a tree of its own right away */
+  void add(const std::vector<_T>& data) override
+  {
+    if (data.empty())
+    {
+      return;
+    }
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    auto snapshot = std::atomic_load(&snapshot_);
+    const Buffer& buffer = *snapshot->buffer;
+    std::vector<_T> elements(data);
+    elements.insert(elements.end(), buffer.data.get(),
+                    buffer.data.get() + buffer.size.load(std::memory_order_relaxed));
+    insertTree(*snapshot, std::move(elements));
+  }
+
+  /** \brief Removal rebuilds the forest into one tree, it is meant to be rare */
+  bool remove(const _T& data) override
+  {
+    std::lock_guard<std::mutex> lock(writeMutex_);
+    std::vector<_T> elements;
+    listSnapshot(*std::atomic_load(&snapshot_), elements);
+    auto it = std::find(elements.begin(), elements.end(), data);
+    if (it == elements.end())
+    {
+      return false;
+    }
+    elements.erase(it);
+    Snapshot rebuilt{ {}, newBuffer() };
+    if (!elements.empty())
+    {
+      rebuilt.trees.push_back(buildTree(std::move(elements)));
+    }
+    std::atomic_store(&snapshot_, std::make_shared<const Snapshot>(std::move(rebuilt)));
+    return true;
+  }
+
+  _T nearest(const _T& data) const override
+  {
+    std::vector<_T> nbh;
+    nearestK(data, 1, nbh);
+    if (nbh.empty())
+    {
+      throw Exception("No elements found in nearest neighbors data structure");
+    }
+    return nbh.front();
+  }
+
+  void nearestK(const _T& data, std::size_t k, std::vector<_T>& nbh) const override
+  {
+    nbh.clear();
+    if (k == 0)
+    {
+      return;
+    }
+    auto snapshot = std::atomic_load(&snapshot_);
+    std::vector<double> query(dimension_);
+    projection_(data, query.data());
+
+    KHeap heap;
+    for (const auto& tree : snapshot->trees)
+    {
+      searchK(*tree, 0, tree->data.size(), query.data(), data, k, heap);
+    }
+    const Buffer& buffer = *snapshot->buffer;
+    std::size_t n = buffer.size.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      pushK(heap, k, this->distFun_(data, buffer.data[i]), buffer.data[i]);
+    }
+
+    nbh.resize(heap.size());
+    for (std::size_t i = heap.size(); i > 0; i--)
+    {
+      nbh[i - 1] = heap.top().second;
+      heap.pop();
+    }
+  }
+
+  void nearestR(const _T& data, double radius, std::vector<_T>& nbh) const override
+  {
+    nbh.clear();
+    auto snapshot = std::atomic_load(&snapshot_);
+    std::vector<double> query(dimension_);
+    projection_(data, query.data());
+
+    std::vector<std::pair<double, _T>> found;
+    for (const auto& tree : snapshot->trees)
+    {
+      searchR(*tree, 0, tree->data.size(), query.data(), data, radius, found);
+    }
+    const Buffer& buffer = *snapshot->buffer;
+    std::size_t n = buffer.size.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      double d = this->distFun_(data, buffer.data[i]);
+      if (d <= radius)
+      {
+        found.emplace_back(d, buffer.data[i]);
+      }
+    }
+
+    std::stable_sort(found.begin(), found.end(),
+                     [](const std::pair<double, _T>& a, const std::pair<double, _T>& b) { return a.first < b.first; });
+    nbh.reserve(found.size());
+    for (const auto& f : found)
+    {
+      nbh.push_back(f.second);
+    }
+  }
+
+  std::size_t size() const override
+  {
+    auto snapshot = std::atomic_load(&snapshot_);
+    std::size_t n = snapshot->buffer->size.load(std::memory_order_acquire);
+    for (const auto& tree : snapshot->trees)
+    {
+      n += tree->data.size();
+    }
+    return n;
+  }
+
+  void list(std::vector<_T>& data) const override
+  {
+    data.clear();
+    listSnapshot(*std::atomic_load(&snapshot_), data);
+  }
+
+  /** \brief Number of KD-trees, O(log n) */
+  std::size_t getNumTrees() const
+  {
+    return std::atomic_load(&snapshot_)->trees.size();
+  }
+
+private:
+  /** \brief Balanced KD-tree stored in place: the root of the range [lo, hi) is at (lo + hi) / 2 */
+  struct Tree
+  {
+    std::vector<_T> data;
+    std::vector<double> coords;
+    std::vector<std::uint8_t> split;
+  };
+
+  /** \brief Append-only buffer, only the first size elements are valid */
+  struct Buffer
+  {
+    std::unique_ptr<_T[]> data;
+    std::unique_ptr<double[]> coords;
+    std::atomic<std::size_t> size{ 0 };
+  };
+
+  /** \brief What a query sees, the trees are sorted by decreasing size */
+  struct Snapshot
+  {
+    std::vector<std::shared_ptr<const Tree>> trees;
+    std::shared_ptr<Buffer> buffer;
+  };
+
+  struct FartherFirst
+  {
+    bool operator()(const std::pair<double, _T>& a, const std::pair<double, _T>& b) const
+    {
+      return a.first < b.first;
+    }
+  };
+  typedef std::priority_queue<std::pair<double, _T>, std::vector<std::pair<double, _T>>, FartherFirst> KHeap;
+
+  std::shared_ptr<Buffer> newBuffer() const
+  {
+    auto buffer = std::make_shared<Buffer>();
+    buffer->data.reset(new _T[bufferCapacity_]);
+    buffer->coords.reset(new double[bufferCapacity_ * dimension_]);
+    return buffer;
+  }
+
+  /** \brief Publish a snapshot with \e elements as a new tree, an empty buffer, and trees of similar size merged */
+  void insertTree(const Snapshot& snapshot, std::vector<_T> elements)
+  {
+    Snapshot updated{ snapshot.trees, newBuffer() };
+    std::vector<_T> carry(std::move(elements));
+    while (!updated.trees.empty() && updated.trees.back()->data.size() <= 2 * carry.size())
+    {
+      const auto& smallest = updated.trees.back()->data;
+      carry.insert(carry.end(), smallest.begin(), smallest.end());
+      updated.trees.pop_back();
+    }
+    updated.trees.push_back(buildTree(std::move(carry)));
+    std::atomic_store(&snapshot_, std::make_shared<const Snapshot>(std::move(updated)));
+  }
+
+  std::shared_ptr<const Tree> buildTree(std::vector<_T> elements) const
+  {
+    std::size_t n = elements.size();
+    std::vector<double> coords(n * dimension_);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      projection_(elements[i], &coords[i * dimension_]);
+    }
+    std::vector<std::size_t> order(n);
+    std::iota(order.begin(), order.end(), 0);
+    std::vector<std::uint8_t> split(n, 0);
+    buildRange(order, coords, split, 0, n);
+
+    auto tree = std::make_shared<Tree>();
+    tree->data.reserve(n);
+    tree->coords.resize(n * dimension_);
+    tree->split = std::move(split);
+    for (std::size_t i = 0; i < n; i++)
+    {
+      tree->data.push_back(elements[order[i]]);
+      std::copy_n(&coords[order[i] * dimension_], dimension_, &tree->coords[i * dimension_]);
+    }
+    return tree;
+  }
+
+  /** \brief Put the median along the dimension of largest spread at the middle of [lo, hi) and recurse */
+  void buildRange(std::vector<std::size_t>& order, const std::vector<double>& coords, std::vector<std::uint8_t>& split,
+                  std::size_t lo, std::size_t hi) const
+  {
+    if (hi - lo <= 1)
+    {
+      return;
+    }
+    std::uint8_t best_dim = 0;
+    double best_spread = -1.0;
+    for (unsigned int d = 0; d < dimension_; d++)
+    {
+      double low = std::numeric_limits<double>::infinity(), high = -low;
+      for (std::size_t i = lo; i < hi; i++)
+      {
+        double c = coords[order[i] * dimension_ + d];
+        low = std::min(low, c);
+        high = std::max(high, c);
+      }
+      if (high - low > best_spread)
+      {
+        best_spread = high - low;
+        best_dim = d;
+      }
+    }
+    std::size_t mid = lo + (hi - lo) / 2;
+    std::nth_element(order.begin() + lo, order.begin() + mid, order.begin() + hi,
+                     [&](std::size_t a, std::size_t b) {
+                       return coords[a * dimension_ + best_dim] < coords[b * dimension_ + best_dim];
+                     });
+    split[mid] = best_dim;
+    buildRange(order, coords, split, lo, mid);
+    buildRange(order, coords, split, mid + 1, hi);
+  }
+
+  void pushK(KHeap& heap, std::size_t k, double d, const _T& element) const
+  {
+    if (heap.size() < k)
+    {
+      heap.emplace(d, element);
+    }
+    else if (d < heap.top().first)
+    {
+      heap.pop();
+      heap.emplace(d, element);
+    }
+  }
+
+  void searchK(const Tree& tree, std::size_t lo, std::size_t hi, const double* query, const _T& data, std::size_t k,
+               KHeap& heap) const
+  {
+    if (lo >= hi)
+    {
+      return;
+    }
+    std::size_t mid = lo + (hi - lo) / 2;
+    pushK(heap, k, this->distFun_(data, tree.data[mid]), tree.data[mid]);
+    double diff = query[tree.split[mid]] - tree.coords[mid * dimension_ + tree.split[mid]];
+    if (diff < 0)
+    {
+      searchK(tree, lo, mid, query, data, k, heap);
+      if (heap.size() < k || -diff < heap.top().first)
+      {
+        searchK(tree, mid + 1, hi, query, data, k, heap);
+      }
+    }
+    else
+    {
+      searchK(tree, mid + 1, hi, query, data, k, heap);
+      if (heap.size() < k || diff < heap.top().first)
+      {
+        searchK(tree, lo, mid, query, data, k, heap);
+      }
+    }
+  }
+
+  void searchR(const Tree& tree, std::size_t lo, std::size_t hi, const double* query, const _T& data, double radius,
+               std::vector<std::pair<double, _T>>& found) const
+  {
+    if (lo >= hi)
+    {
+      return;
+    }
+    std::size_t mid = lo + (hi - lo) / 2;
+    double d = this->distFun_(data, tree.data[mid]);
+    if (d <= radius)
+    {
+      found.emplace_back(d, tree.data[mid]);
+    }
+    double diff = query[tree.split[mid]] - tree.coords[mid * dimension_ + tree.split[mid]];
+    // The lower side is at least diff away from the query, the upper side at least -diff
+    if (diff <= radius)
+    {
+      searchR(tree, lo, mid, query, data, radius, found);
+    }
+    if (-diff <= radius)
+    {
+      searchR(tree, mid + 1, hi, query, data, radius, found);
+    }
+  }
+
+  static void listSnapshot(const Snapshot& snapshot, std::vector<_T>& data)
+  {
+    for (const auto& tree : snapshot.trees)
+    {
+      data.insert(data.end(), tree->data.begin(), tree->data.end());
+    }
+    const Buffer& buffer = *snapshot.buffer;
+    data.insert(data.end(), buffer.data.get(), buffer.data.get() + buffer.size.load(std::memory_order_acquire));
+  }
+
+  unsigned int dimension_;
+  Projection projection_;
+  std::size_t bufferCapacity_;
+
+  /** \brief Replaced as a whole by the writers, read with std::atomic_load by the queries */
+  std::shared_ptr<const Snapshot> snapshot_;
+  std::mutex writeMutex_;
+};  // NearestNeighborsKDForest
+}  // namespace ompl
+
+#endif  // VOX_NAV_PLANNING__NATIVE_PLANNERS__NEAREST_NEIGHBORS_KD_FOREST_HPP_
@@ -0,0 +1,159 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_PLANNING__NATIVE_PLANNERS__PLANNER_VISUALIZATION_SINK_HPP_
+#define VOX_NAV_PLANNING__NATIVE_PLANNERS__PLANNER_VISUALIZATION_SINK_HPP_
+
+#include <boost/lockfree/queue.hpp>
+
+#include "geometry_msgs/msg/point.hpp"
+#include "ompl/base/State.h"
+#include "rclcpp/rclcpp.hpp"
+#include "std_msgs/msg/color_rgba.hpp"
+#include "visualization_msgs/msg/marker_array.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * RVIZ visualization of the native planners goes through one PlannerVisualizationSink per process.
+ * A planner asks wants() before it copies anything out of its graph, and push()es the copy.
+ * In ASYNCHRONOUS mode (the default) the copies go through a lock-free queue to a low priority thread,
+ * which builds the MarkerArrays and publishes them at most max_rate times a second per topic,
+ * so the solve loop only pays for the copy, and only that often. So that RVIZ ends up showing the returned path,
+ * a planner offers its path once more when solve() returns if the last one was turned down, see acceptFinal().
+ * SYNCHRONOUS builds and publishes in the calling thread on every call, as the planners used to, OFF drops everything.
+ * The mode is read from the VOX_NAV_PLANNER_VISUALIZATION environment variable (off, sync, async)
+ * when the sink is first used, and can be changed with setMode().
+ * Building with -DVOX_NAV_PLANNER_VISUALIZATION_ENABLED=0 compiles the visualization out, wants() is then always false.
+ */
+#ifndef VOX_NAV_PLANNER_VISUALIZATION_ENABLED
+#define VOX_NAV_PLANNER_VISUALIZATION_ENABLED 1
+#endif
+
+namespace vox_nav_planning
+{
+/** \brief A snapshot of what a planner shows, it does not refer to the planner's graph anymore */
+struct PlannerVisualization
+{
+  enum class Type
+  {
+    GRAPH,
+    PATH
+  };
+  Type type{ Type::GRAPH };
+
+  /** \brief The topic of the MarkerArray and the prefix of its marker namespaces */
+  std::string topic;
+  std::string ns;
+  std_msgs::msg::ColorRGBA color;
+
+  /** \brief GRAPH: the vertices, PATH: the waypoints in order */
+  std::vector<geometry_msgs::msg::Point> points;
+
+  /** \brief GRAPH only, two points per edge */
+  std::vector<geometry_msgs::msg::Point> edges;
+
+  /** \brief PATH only, the text and marker id shown over every waypoint but the last */
+  std::vector<std::string> labels;
+  std::vector<int> label_ids;
+  double label_lifetime{ 0.0 };
+};
+
+/** \brief Position of a RealVectorStateSpace or ElevationStateSpace state, the state spaces the native planners use */
+geometry_msgs::msg::Point stateToPoint(const ompl::base::State* state, int state_space_type);
+
+class PlannerVisualizationSink
+{
+public:
+  enum class Mode
+  {
+    OFF,
+    SYNCHRONOUS,
+    ASYNCHRONOUS
+  };
+
+  /** \brief The sink of this process */
+  static PlannerVisualizationSink& instance();
+
+  ~PlannerVisualizationSink();
+
+  void setMode(Mode mode);
+  Mode getMode() const;
+
+  /** \brief Publishes per topic a second in ASYNCHRONOUS mode */
+  void setMaxRate(double max_rate);
+  double getMaxRate() const;
+
+  /** \brief Whether a snapshot for \e topic would be published now. If not, the planner should not make one */
+  bool wants(const std::string& topic);
+
+  /** \brief Call when solve() returns. If the last snapshot for \e topic was turned down by the rate limit, RVIZ
+   * would keep showing an older one, so the next wants() for it is true regardless of the rate and this returns true */
+  bool acceptFinal(const std::string& topic);
+
+  /** \brief Hand over a snapshot, it is published in this thread in SYNCHRONOUS mode and queued in ASYNCHRONOUS */
+  void push(std::unique_ptr<PlannerVisualization> visualization);
+
+  /** \brief Snapshots published, and the ones dropped because a newer one for the same topic came or the queue was
+   * full */
+  std::size_t getNumPublished() const;
+  std::size_t getNumDropped() const;
+
+  /** \brief Build the MarkerArray of a snapshot, clearing the previous markers of its namespaces first */
+  static visualization_msgs::msg::MarkerArray toMarkerArray(const PlannerVisualization& visualization);
+
+private:
+  PlannerVisualizationSink();
+
+  void run();
+
+  void publish(const PlannerVisualization& visualization);
+
+  std::atomic<Mode> mode_{ Mode::ASYNCHRONOUS };
+  std::atomic<double> max_rate_{ 2.0 };
+
+  /** \brief When each topic accepts its next snapshot, and the topics whose last snapshot was turned down */
+  std::mutex rate_mutex_;
+  std::map<std::string, std::chrono::steady_clock::time_point> next_accept_;
+  std::set<std::string> rate_limited_;
+
+  /** \brief Owning pointers, from push() to the visualization thread */
+  boost::lockfree::queue<PlannerVisualization*> queue_{ 64 };
+
+  std::once_flag thread_once_;
+  std::thread thread_;
+  std::atomic<bool> running_{ true };
+  std::mutex wake_mutex_;
+  std::condition_variable wake_;
+
+  /** \brief The node and publishers are created on first publish, when rclcpp is initialized */
+  std::mutex publishers_mutex_;
+  rclcpp::Node::SharedPtr node_;
+  std::map<std::string, rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr> publishers_;
+
+  std::atomic<std::size_t> num_published_{ 0 };
+  std::atomic<std::size_t> num_dropped_{ 0 };
+};
+}  // namespace vox_nav_planning
+
+#endif  // VOX_NAV_PLANNING__NATIVE_PLANNERS__PLANNER_VISUALIZATION_SINK_HPP_
@@ -20,6 +20,7 @@
 #include <rclcpp_action/rclcpp_action.hpp>
 #include <geometry_msgs/msg/point.hpp>
 #include <geometry_msgs/msg/pose_stamped.hpp>
+#include <nav_msgs/srv/get_plan.hpp>
 #include <visualization_msgs/msg/marker.hpp>
 #include <visualization_msgs/msg/marker_array.hpp>
 #include <pluginlib/class_loader.hpp>
@@ -55,7 +56,7 @@ namespace vox_nav_planning
      * @brief Construct a new Planner Server object
      *
      */
-    PlannerServer();
+    explicit PlannerServer(const rclcpp::NodeOptions & options = rclcpp::NodeOptions());
 
     /**
      * @brief Destroy the Planner Server object
@@ -103,10 +104,27 @@ namespace vox_nav_planning
      */
     void handle_accepted(const std::shared_ptr<GoalHandleComputePathToPose> goal_handle);
 
+    /**
+     * @brief Plan between the requested start and goal, unlike the action
+     * the start does not have to be the current robot pose, which lets a
+     * navigator plan the next leg of a mission while the current one is followed.
+     * A start with an empty frame_id means the current robot pose.
+     *
+     * @param request
+     * @param response
+     */
+    void getPlanCallback(
+      const std::shared_ptr<nav_msgs::srv::GetPlan::Request> request,
+      std::shared_ptr<nav_msgs::srv::GetPlan::Response> response);
+
   protected:
     // Our action server implements the ComputePathToPose action
     rclcpp_action::Server<ComputePathToPose>::SharedPtr action_server_;
 
+    // Planning between arbitrary poses, served in its own callback group as it blocks while planning
+    rclcpp::Service<nav_msgs::srv::GetPlan>::SharedPtr get_plan_service_;
+    rclcpp::CallbackGroup::SharedPtr get_plan_callback_group_;
+
     /**
      * @brief The action server callback which calls planner to get the path
      */
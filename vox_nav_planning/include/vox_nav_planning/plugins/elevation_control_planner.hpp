@@ -24,6 +24,7 @@
 #include "vox_nav_planning/planner_core.hpp"
 #include "geometry_msgs/msg/pose_array.hpp"
 #include "vox_nav_utilities/elevation_state_space.hpp"
+#include "vox_nav_utilities/map_snapshot.hpp"
 
 #include "ompl/control/SimpleDirectedControlSampler.h"
 #include "ompl/control/spaces/RealVectorControlSpace.h"
@@ -168,6 +169,7 @@ namespace vox_nav_planning
         planner->as<ompl::control::InformedSGCP>()->setUseKNearest(true);
         planner->as<ompl::control::InformedSGCP>()->setSolveControlGraph(false);
         planner->as<ompl::control::InformedSGCP>()->setBatchSize(1000);
+        planner->as<ompl::control::InformedSGCP>()->setUseDirectInformedSampler(true);
       } else {
         RCLCPP_WARN(
           logger,
@@ -179,6 +181,8 @@ namespace vox_nav_planning
   protected:
     rclcpp::Logger logger_{rclcpp::get_logger("elevation_control_planner")};
     rclcpp::Client<vox_nav_msgs::srv::GetTraversabilityMap>::SharedPtr get_traversability_map_client_;
+    // Maps below are borrowed from this snapshot, shared with the other plugins, read only
+    std::shared_ptr<const vox_nav_utilities::MapSnapshot> map_snapshot_;
 
     // Surfels centers are elevated by node_elevation_distance_, and are stored in this
     // octomap, this maps is used by planner to sample states that are
@@ -204,6 +208,8 @@ namespace vox_nav_planning
     ompl::base::ElevationStateSpace::SE2StateType se2_space_type_;
     // curve radius for reeds and dubins only
     double rho_;
+    // InformedSGCP only, sample its informed set directly on the elevated surfels
+    bool use_direct_informed_sampler_;
 
     // octomap acquired from original PCD map
     std::shared_ptr<octomap::OcTree> original_octomap_octree_;
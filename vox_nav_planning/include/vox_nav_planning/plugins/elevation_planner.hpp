@@ -22,6 +22,7 @@
 #include "vox_nav_planning/planner_core.hpp"
 #include "geometry_msgs/msg/pose_array.hpp"
 #include "vox_nav_utilities/elevation_state_space.hpp"
+#include "vox_nav_utilities/map_snapshot.hpp"
 
 
 namespace vox_nav_planning
@@ -111,6 +112,8 @@ namespace vox_nav_planning
   protected:
     rclcpp::Logger logger_{rclcpp::get_logger("elevation_planner")};
     rclcpp::Client<vox_nav_msgs::srv::GetTraversabilityMap>::SharedPtr get_traversability_map_client_;
+    // Maps below are borrowed from this snapshot, shared with the other plugins, read only
+    std::shared_ptr<const vox_nav_utilities::MapSnapshot> map_snapshot_;
 
     // Surfels centers are elevated by node_elevation_distance_, and are stored in this
     // octomap, this maps is used by planner to sample states that are
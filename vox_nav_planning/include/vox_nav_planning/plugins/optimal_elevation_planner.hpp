@@ -24,6 +24,7 @@
 #include "visualization_msgs/msg/marker_array.hpp"
 #include "vox_nav_utilities/elevation_state_space.hpp"
 #include "vox_nav_utilities/boost_graph_utils.hpp"
+#include "vox_nav_utilities/map_snapshot.hpp"
 
 namespace vox_nav_planning
 {
@@ -127,6 +128,8 @@ namespace vox_nav_planning
     // Get the traversability map from vox_nav_map_server
     rclcpp::Client<vox_nav_msgs::srv::GetTraversabilityMap>::SharedPtr
       get_traversability_map_client_;
+    // Maps below are borrowed from this snapshot, shared with the other plugins, read only
+    std::shared_ptr<const vox_nav_utilities::MapSnapshot> map_snapshot_;
 
     // Surfels centers are elevated by node_elevation_distance_, and are stored in this
     // octomap, this maps is used by planner to sample states that are
@@ -25,6 +25,7 @@
 #include "geometry_msgs/msg/pose_array.hpp"
 #include "vox_nav_utilities/elevation_state_space.hpp"
 #include "vox_nav_utilities/pcl_helpers.hpp"
+#include "vox_nav_utilities/road_graph.hpp"
 #include "vox_nav_msgs/srv/get_osm_road_topology_map.hpp"
 
 #include "ompl/control/SimpleDirectedControlSampler.h"
@@ -121,6 +122,36 @@ namespace vox_nav_planning
     */
     std::vector<geometry_msgs::msg::PoseStamped> getOverlayedStartandGoal();
 
+    /**
+     * @brief Plan with A* over the road graph built from the OSM road topology
+     *
+     * @param start
+     * @param goal
+     * @return std::vector<geometry_msgs::msg::PoseStamped> empty if start or goal are off the roads
+     * or not connected
+     */
+    std::vector<geometry_msgs::msg::PoseStamped> createRoadGraphPlan(
+      const geometry_msgs::msg::PoseStamped & start,
+      const geometry_msgs::msg::PoseStamped & goal);
+
+    /**
+     * @brief Turn road points into poses the robot can follow, connecting waypoints
+     * taken every road_path_smoothing_spacing_ meters with curves of the selected
+     * SE2 space (Dubins or Reeds-Shepp with radius rho). With SE2 or smoothing
+     * disabled the road points are returned with their heading along the path.
+     * Either way the plan starts at start and ends at goal with their yaw, joined
+     * to the nearest road points with curves of the same space.
+     *
+     * @param road_points
+     * @param start
+     * @param goal
+     * @return std::vector<geometry_msgs::msg::PoseStamped>
+     */
+    std::vector<geometry_msgs::msg::PoseStamped> roadPointsToPlan(
+      const std::vector<Eigen::Vector3d> & road_points,
+      const geometry_msgs::msg::PoseStamped & start,
+      const geometry_msgs::msg::PoseStamped & goal);
+
     void propagate(
       const ompl::control::SpaceInformation * si,
       const ompl::base::State * start,
@@ -217,6 +248,15 @@ namespace vox_nav_planning
     geometry_msgs::msg::PoseStamped goal_pose_;
     geometry_msgs::msg::PoseArray::SharedPtr valid_poses_;
 
+    // Road network of osm_road_topology_pcd_, when enabled plans are searched on it
+    // and the sampling based planner is only used if that fails
+    std::shared_ptr<vox_nav_utilities::RoadGraph> road_graph_;
+    vox_nav_utilities::RoadGraphParams road_graph_params_;
+    bool use_road_graph_;
+    bool smooth_road_path_;
+    double road_path_smoothing_spacing_;
+    // Dubins, Reeds-Shepp or SE2 space with rho_, used to smooth road graph plans
+    ompl::base::StateSpacePtr road_path_se2_space_;
 
   };
 }  // namespace vox_nav_planning
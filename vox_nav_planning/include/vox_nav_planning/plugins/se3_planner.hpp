@@ -20,6 +20,8 @@
 #include <memory>
 
 #include "vox_nav_planning/planner_core.hpp"
+#include "vox_nav_utilities/map_snapshot.hpp"
+#include "vox_nav_utilities/projected_map.hpp"
 /**
  * @brief
  *
@@ -87,6 +89,8 @@ public:
 
 protected:
   rclcpp::Client<vox_nav_msgs::srv::GetTraversabilityMap>::SharedPtr get_traversability_map_client_;
+  // Maps below are borrowed from this snapshot, shared with the other plugins, read only
+  std::shared_ptr<const vox_nav_utilities::MapSnapshot> map_snapshot_;
 
   rclcpp::Logger logger_{ rclcpp::get_logger("se3_planner") };
 
@@ -99,6 +103,15 @@ protected:
   std::shared_ptr<octomap::OcTree> original_octomap_octree_;
   std::shared_ptr<fcl::CollisionObjectf> original_octomap_collision_object_;
   std::shared_ptr<fcl::CollisionObjectf> robot_collision_object_;
+  double robot_body_height_;
+  // 2.5D projection of the original octomap, states are checked against it instead of FCL if set.
+  // Off by default, the body has to be above the highest voxel under its footprint, so states
+  // under overhangs the robot fits under, e.g. bridges and tree canopies, are rejected
+  bool use_projected_map_;
+  vox_nav_utilities::ProjectedMapParams projected_map_params_;
+  std::shared_ptr<const vox_nav_utilities::ProjectedMap> projected_map_;
+  // Weight of the projected map cost against the path length, 0 plans the shortest path
+  double projected_map_cost_weight_;
   // Better t keep this parameter consistent with map_server, 0.2 is a OK default fo this
   double octomap_voxel_size_;
   // global mutex to guard octomap
@@ -122,19 +122,6 @@ void ompl::control::CostTrustKinoPlanner::setup()
 
   // initialize the best control cost
   bestControlCost_ = opt_->infiniteCost();
-
-  // RVIZ VISUALIZATIONS, this is likely to be removed in the future, but for now it is useful
-  node_ = std::make_shared<rclcpp::Node>("CP_rclcpp_node");
-
-  // reliable QOS settings for rviz visualization
-  auto reliable_qos = rclcpp::QoS(rclcpp::KeepLast(1)).reliable();
-
-  first_control_graph_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>(
-      "vox_nav/CostTrustKinoPlanner/first_control_rgg", reliable_qos);
-  second_control_graph_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>(
-      "vox_nav/CostTrustKinoPlanner/second_control_rgg", reliable_qos);
-  control_path_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>(
-      "vox_nav/CostTrustKinoPlanner/c_plan", reliable_qos);
 }
 
 void ompl::control::CostTrustKinoPlanner::clear()
@@ -556,12 +543,12 @@ ompl::base::PlannerStatus ompl::control::CostTrustKinoPlanner::solve(const base:
 
     // best control path
 
-    visualizePath(bestControlPath_, control_path_pub_, "c", getColor(blue), si_->getStateSpace()->getType());
+    visualizePath(bestControlPath_, control_path_topic_, "c", getColor(blue), si_->getStateSpace()->getType());
 
-    visualizeRGG(best_control_nn_structure, first_control_graph_pub_, "c", getColor(red),
+    visualizeRGG(best_control_nn_structure, first_control_graph_topic_, "c", getColor(red),
                  si_->getStateSpace()->getType());
 
-    visualizeRGG(best_control_nn_structure_counterpart, second_control_graph_pub_, "c", getColor(green),
+    visualizeRGG(best_control_nn_structure_counterpart, second_control_graph_topic_, "c", getColor(green),
                  si_->getStateSpace()->getType());
 
     if (static_cast<bool>(Planner::pdef_->getIntermediateSolutionCallback()))
@@ -570,6 +557,13 @@ ompl::base::PlannerStatus ompl::control::CostTrustKinoPlanner::solve(const base:
     }
   }
 
+  // The path of the last iterations may have been turned down by the rate limit, RVIZ has to show the returned one
+  std::string blue("blue");
+  if (vox_nav_planning::PlannerVisualizationSink::instance().acceptFinal(control_path_topic_))
+  {
+    visualizePath(bestControlPath_, control_path_topic_, "c", getColor(blue), si_->getStateSpace()->getType());
+  }
+
   // Add the best path to the solution path
   OMPL_INFORM("%s: Best Control path has %d vertices and ", getName().c_str(), bestControlPath_->getStateCount());
   pdef_->addSolutionPath(bestControlPath_, approximate_solution, 0.0, getName());
@@ -859,221 +853,64 @@ ompl::control::CostTrustKinoPlanner::getConstStatesFromPath(const std::shared_pt
 }
 
 void ompl::control::CostTrustKinoPlanner::visualizeRGG(
-    const std::shared_ptr<ompl::NearestNeighbors<VertexProperty*>>& nn_structure,
-    const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher, const std::string& ns,
-    const std_msgs::msg::ColorRGBA& color, const int& state_space_type)
+    const std::shared_ptr<ompl::NearestNeighbors<VertexProperty*>>& nn_structure, const std::string& topic,
+    const std::string& ns, const std_msgs::msg::ColorRGBA& color, const int& state_space_type)
 {
-  // Clear All previous markers
-  visualization_msgs::msg::MarkerArray clear_markers;
-  visualization_msgs::msg::Marker rgg_vertex, rgg_edges;
-  rgg_vertex.id = 0;
-  rgg_edges.id = 0;
-  rgg_vertex.ns = ns + "rgg_vertex";
-  rgg_edges.ns = ns + "rgg_edges";
-  rgg_vertex.action = visualization_msgs::msg::Marker::DELETEALL;
-  rgg_edges.action = visualization_msgs::msg::Marker::DELETEALL;
-  clear_markers.markers.push_back(rgg_vertex);
-  clear_markers.markers.push_back(rgg_edges);
-  publisher->publish(clear_markers);
-
-  visualization_msgs::msg::Marker spheres;
-  spheres.header.frame_id = "map";
-  spheres.header.stamp = rclcpp::Clock().now();
-  spheres.ns = ns + "rgg_vertex";
-  spheres.id = 0;
-  spheres.type = visualization_msgs::msg::Marker::SPHERE_LIST;
-  spheres.action = visualization_msgs::msg::Marker::ADD;
-  spheres.scale.x = 0.15;
-  spheres.scale.y = 0.15;
-  spheres.scale.z = 0.15;
-
-  int edge_index = 0;
-  visualization_msgs::msg::Marker line_stripes;
-  line_stripes.header.frame_id = "map";
-  line_stripes.ns = ns + "rgg_edges";
-  line_stripes.id = edge_index;
-  line_stripes.type = visualization_msgs::msg::Marker::LINE_LIST;
-  line_stripes.action = visualization_msgs::msg::Marker::ADD;
-  line_stripes.lifetime = rclcpp::Duration::from_seconds(0);
-  line_stripes.header.stamp = rclcpp::Clock().now();
-  line_stripes.scale.x = 0.01;
-  line_stripes.scale.y = 0.01;
-  line_stripes.scale.z = 0.01;
-  line_stripes.color = color;
-
-  visualization_msgs::msg::MarkerArray marker_array;
+  auto& sink = vox_nav_planning::PlannerVisualizationSink::instance();
+  if (!sink.wants(topic))
+  {
+    return;
+  }
+
+  auto visualization = std::make_unique<vox_nav_planning::PlannerVisualization>();
+  visualization->type = vox_nav_planning::PlannerVisualization::Type::GRAPH;
+  visualization->topic = topic;
+  visualization->ns = ns;
+  visualization->color = color;
 
   // iterate through all the vertices in the graph
   std::vector<VertexProperty*> vertices;
   nn_structure->list(vertices);
-
+  visualization->points.reserve(vertices.size());
   for (auto vd : vertices)
   {
-    // Paint the start and goal vertices differently.
-    std_msgs::msg::ColorRGBA color_vd = color;
-    double is_goal_or_start{ 0.0 };
-
-    geometry_msgs::msg::Point point;
-    if (state_space_type == base::STATE_SPACE_REAL_VECTOR)
-    {
-      const auto* target_cstate = vd->state->as<ompl::base::RealVectorStateSpace::StateType>();
-      point.x = target_cstate->values[0];
-      point.y = target_cstate->values[1];
-      point.z = target_cstate->values[2];
-    }
-    else
-    {
-      const auto* target_cstate = vd->state->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* target_so2 = target_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* target_xyzv = target_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      point.x = target_xyzv->values[0];
-      point.y = target_xyzv->values[1];
-      point.z = target_xyzv->values[2];
-    }
-
-    spheres.points.push_back(point);
-    spheres.colors.push_back(color);
+    auto point = vox_nav_planning::stateToPoint(vd->state, state_space_type);
+    visualization->points.push_back(point);
 
     // draw lines from current vd to all its branches
     for (auto b : vd->branches)
     {
-      geometry_msgs::msg::Point source_point, target_point;
-      if (state_space_type == base::STATE_SPACE_REAL_VECTOR)
-      {
-        const auto* source_cstate = vd->state->as<ompl::base::RealVectorStateSpace::StateType>();
-        source_point.x = source_cstate->values[0];
-        source_point.y = source_cstate->values[1];
-        source_point.z = source_cstate->values[2];
-
-        const auto* target_cstate = b->state->as<ompl::base::RealVectorStateSpace::StateType>();
-        target_point.x = target_cstate->values[0];
-        target_point.y = target_cstate->values[1];
-        target_point.z = target_cstate->values[2];
-      }
-      else
-      {
-        const auto* source_cstate = vd->state->as<ompl::base::ElevationStateSpace::StateType>();
-        const auto* source_so2 = source_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-        const auto* source_xyzv = source_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-        source_point.x = source_xyzv->values[0];
-        source_point.y = source_xyzv->values[1];
-        source_point.z = source_xyzv->values[2];
-
-        const auto* target_cstate = b->state->as<ompl::base::ElevationStateSpace::StateType>();
-        const auto* target_so2 = target_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-        const auto* target_xyzv = target_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-        target_point.x = target_xyzv->values[0];
-        target_point.y = target_xyzv->values[1];
-        target_point.z = target_xyzv->values[2];
-      }
-
-      line_stripes.points.push_back(source_point);
-      line_stripes.colors.push_back(color);
-      line_stripes.points.push_back(target_point);
-      line_stripes.colors.push_back(color);
+      visualization->edges.push_back(point);
+      visualization->edges.push_back(vox_nav_planning::stateToPoint(b->state, state_space_type));
     }
   }
-
-  marker_array.markers.push_back(spheres);
-  marker_array.markers.push_back(line_stripes);
-
-  publisher->publish(marker_array);
+  sink.push(std::move(visualization));
 }
 
-void ompl::control::CostTrustKinoPlanner::visualizePath(
-    const std::shared_ptr<PathControl>& path,
-    const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher, const std::string& ns,
-    const std_msgs::msg::ColorRGBA& color, const int& state_space_type)
+void ompl::control::CostTrustKinoPlanner::visualizePath(const std::shared_ptr<PathControl>& path,
+                                                        const std::string& topic, const std::string& ns,
+                                                        const std_msgs::msg::ColorRGBA& color,
+                                                        const int& state_space_type)
 {
-  // Clear All previous markers
-  visualization_msgs::msg::MarkerArray clear_markers;
-  visualization_msgs::msg::Marker path_marker, cost_marker;
-  path_marker.id = 0;
-  cost_marker.id = 0;
-  path_marker.ns = ns + "path";
-  cost_marker.ns = ns + "costs";
-  path_marker.action = visualization_msgs::msg::Marker::DELETEALL;
-  cost_marker.action = visualization_msgs::msg::Marker::DELETEALL;
-  clear_markers.markers.push_back(path_marker);
-  clear_markers.markers.push_back(cost_marker);
-  publisher->publish(clear_markers);
-
-  visualization_msgs::msg::MarkerArray marker_array;
-  visualization_msgs::msg::Marker line_strip;
-  line_strip.header.frame_id = "map";
-  line_strip.ns = ns + "path";
-  line_strip.id = 0;
-  line_strip.type = visualization_msgs::msg::Marker::LINE_LIST;
-  line_strip.action = visualization_msgs::msg::Marker::ADD;
-  line_strip.lifetime = rclcpp::Duration::from_seconds(0);
-  line_strip.header.stamp = rclcpp::Clock().now();
-  line_strip.scale.x = 0.1;
-  line_strip.scale.y = 0.1;
-  line_strip.scale.z = 0.1;
-  line_strip.color = color;
-
-  for (size_t i = 1; i < path->getStateCount(); i++)
+  auto& sink = vox_nav_planning::PlannerVisualizationSink::instance();
+  if (!sink.wants(topic))
   {
-    auto u = path->getState(i - 1);
-    auto v = path->getState(i);
-
-    geometry_msgs::msg::Point source_point, target_point;
-
-    if (state_space_type == ompl::base::STATE_SPACE_REAL_VECTOR)
-    {
-      const auto* source_cstate = u->as<ompl::base::RealVectorStateSpace::StateType>();
-      source_point.x = source_cstate->values[0];
-      source_point.y = source_cstate->values[1];
-      source_point.z = source_cstate->values[2];
-
-      const auto* target_cstate = v->as<ompl::base::RealVectorStateSpace::StateType>();
-      target_point.x = target_cstate->values[0];
-      target_point.y = target_cstate->values[1];
-      target_point.z = target_cstate->values[2];
-    }
-    else
-    {
-      const auto* source_cstate = u->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* source_so2 = source_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* source_xyzv = source_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      source_point.x = source_xyzv->values[0];
-      source_point.y = source_xyzv->values[1];
-      source_point.z = source_xyzv->values[2];
-
-      const auto* target_cstate = v->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* target_so2 = target_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* target_xyzv = target_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      target_point.x = target_xyzv->values[0];
-      target_point.y = target_xyzv->values[1];
-      target_point.z = target_xyzv->values[2];
-    }
-
-    line_strip.points.push_back(source_point);
-    line_strip.colors.push_back(color);
-    line_strip.points.push_back(target_point);
-    line_strip.colors.push_back(color);
-
-    visualization_msgs::msg::Marker text;
-    text.header.frame_id = "map";
-    text.header.stamp = rclcpp::Clock().now();
-    text.ns = ns + "costs";
-    text.id = i - 1;  // g[u].id;
-    text.type = visualization_msgs::msg::Marker::TEXT_VIEW_FACING;
-    text.action = visualization_msgs::msg::Marker::ADD;
-    text.lifetime = rclcpp::Duration::from_seconds(1);
-    text.text = std::to_string(i - 1);
-    text.pose.position = source_point;
-    text.pose.position.z += 0.5;
-    text.scale.x = 0.3;
-    text.scale.y = 0.3;
-    text.scale.z = 0.3;
-    text.color.a = 1.0;
-    text.color.r = 1.0;
-    marker_array.markers.push_back(text);
+    return;
   }
-  marker_array.markers.push_back(line_strip);
 
-  publisher->publish(marker_array);
+  auto visualization = std::make_unique<vox_nav_planning::PlannerVisualization>();
+  visualization->type = vox_nav_planning::PlannerVisualization::Type::PATH;
+  visualization->topic = topic;
+  visualization->ns = ns;
+  visualization->color = color;
+  visualization->label_lifetime = 1.0;
+  for (std::size_t i = 0; i < path->getStateCount(); i++)
+  {
+    visualization->points.push_back(vox_nav_planning::stateToPoint(path->getState(i), state_space_type));
+    visualization->labels.push_back(std::to_string(i));
+    visualization->label_ids.push_back(i);
+  }
+  sink.push(std::move(visualization));
 }
 
 std_msgs::msg::ColorRGBA ompl::control::CostTrustKinoPlanner::getColor(std::string& color)
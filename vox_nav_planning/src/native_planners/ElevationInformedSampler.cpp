@@ -0,0 +1,240 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_planning/native_planners/ElevationInformedSampler.hpp"
+
+#include "ompl/base/goals/GoalState.h"
+#include "ompl/util/Exception.h"
+#include "ompl/util/RandomNumbers.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// ompl::RNG is not thread-safe, the planner threads sample concurrently
+ompl::RNG& threadRNG()
+{
+  static thread_local ompl::RNG rng;
+  return rng;
+}
+
+const double* xyzv(const ompl::base::State* state)
+{
+  return state->as<ompl::base::ElevationStateSpace::StateType>()
+      ->as<ompl::base::RealVectorStateSpace::StateType>(1)
+      ->values;
+}
+
+double euclidean(const double* a, const double* b, unsigned int dimension)
+{
+  double sum = 0.0;
+  for (unsigned int i = 0; i < dimension; i++)
+  {
+    sum += (a[i] - b[i]) * (a[i] - b[i]);
+  }
+  return std::sqrt(sum);
+}
+}  // namespace
+
+ompl::base::ElevationInformedSampler::ElevationInformedSampler(const ProblemDefinitionPtr& probDefn,
+                                                               unsigned int maxNumberCalls)
+  : InformedSampler(probDefn, maxNumberCalls)
+{
+  const auto* space = dynamic_cast<const ElevationStateSpace*>(space_->getStateSpace().get());
+  if (space == nullptr)
+  {
+    throw Exception("ElevationInformedSampler: the state space is not an ElevationStateSpace");
+  }
+  if (probDefn_->getStartStateCount() == 0u)
+  {
+    throw Exception("ElevationInformedSampler: the problem has no start state");
+  }
+  if (!probDefn_->getGoal() || !probDefn_->getGoal()->hasType(GOAL_STATE))
+  {
+    throw Exception("ElevationInformedSampler: the goal is not a GoalState");
+  }
+
+  phsDimension_ = space->getSE2StateType() == ElevationStateSpace::SE2StateType::SE2 ? 3u : 2u;
+  std::copy_n(xyzv(probDefn_->getStartState(0u)), 3, start_);
+  std::copy_n(xyzv(probDefn_->getGoal()->as<GoalState>()->getState()), 3, goal_);
+  bounds_ = space->as<RealVectorStateSpace>(1)->getBounds();
+  measurePhs_ = std::make_shared<const ProlateHyperspheroid>(phsDimension_, start_, goal_);
+}
+
+void ompl::base::ElevationInformedSampler::setTraversableCells(const std::vector<Eigen::Vector3d>& cells)
+{
+  std::lock_guard<std::mutex> lock(informedSetMutex_);
+  cells_ = cells;
+  std::atomic_store(&informedSet_, std::shared_ptr<const InformedSet>());
+}
+
+std::size_t ompl::base::ElevationInformedSampler::getNumCellsInInformedSet(const Cost& maxCost)
+{
+  return informedSet(maxCost.value())->cells.size();
+}
+
+std::shared_ptr<const ompl::base::ElevationInformedSampler::InformedSet>
+ompl::base::ElevationInformedSampler::informedSet(double max_cost)
+{
+  auto set = std::atomic_load(&informedSet_);
+  if (set && set->max_cost == max_cost)
+  {
+    return set;
+  }
+
+  // The cost changes once per solution, the first thread to see the new cost makes the set for all of them
+  std::lock_guard<std::mutex> lock(informedSetMutex_);
+  set = std::atomic_load(&informedSet_);
+  if (set && set->max_cost == max_cost)
+  {
+    return set;
+  }
+
+  auto new_set = std::make_shared<InformedSet>();
+  new_set->max_cost = max_cost;
+  if (std::isfinite(max_cost) && max_cost > measurePhs_->getMinTransverseDiameter())
+  {
+    auto phs = std::make_shared<ProlateHyperspheroid>(phsDimension_, start_, goal_);
+    phs->setTransverseDiameter(max_cost);
+    new_set->phs = phs;
+  }
+  for (const auto& cell : cells_)
+  {
+    if (inBounds(cell.data()) && (!new_set->phs || new_set->phs->isInPhs(cell.data())))
+    {
+      new_set->cells.push_back(cell);
+    }
+  }
+  std::atomic_store(&informedSet_, std::shared_ptr<const InformedSet>(new_set));
+  return new_set;
+}
+
+bool ompl::base::ElevationInformedSampler::sampleUniform(State* statePtr, const Cost& maxCost)
+{
+  // No informed set without a cost better than the straight line
+  if (std::isfinite(maxCost.value()) && maxCost.value() <= measurePhs_->getMinTransverseDiameter())
+  {
+    return false;
+  }
+
+  auto set = informedSet(maxCost.value());
+  double xyz[3];
+  if (!set->cells.empty())
+  {
+    const auto& cell = set->cells[threadRNG().uniformInt(0, static_cast<int>(set->cells.size()) - 1)];
+    std::copy_n(cell.data(), 3, xyz);
+  }
+  else if (!samplePosition(*set, xyz))
+  {
+    return false;
+  }
+  setState(statePtr, xyz);
+  return true;
+}
+
+bool ompl::base::ElevationInformedSampler::sampleUniform(State* statePtr, const Cost& minCost, const Cost& maxCost)
+{
+  // Reject the samples of the inner hyperspheroid
+  for (unsigned int i = 0; i < numIters_; i++)
+  {
+    if (!sampleUniform(statePtr, maxCost))
+    {
+      return false;
+    }
+    if (!opt_->isCostBetterThan(heuristicSolnCost(statePtr), minCost))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ompl::base::ElevationInformedSampler::hasInformedMeasure() const
+{
+  return true;
+}
+
+double ompl::base::ElevationInformedSampler::getInformedMeasure(const Cost& currentCost) const
+{
+  double space_measure = space_->getSpaceMeasure();
+  if (!std::isfinite(currentCost.value()))
+  {
+    return space_measure;
+  }
+  if (currentCost.value() <= measurePhs_->getMinTransverseDiameter())
+  {
+    return 0.0;
+  }
+
+  double measure = measurePhs_->getPhsMeasure(currentCost.value()) * 2.0 * M_PI * (bounds_.high[3] - bounds_.low[3]);
+  if (phsDimension_ == 2u)
+  {
+    measure *= bounds_.high[2] - bounds_.low[2];
+  }
+  return std::min(measure, space_measure);
+}
+
+ompl::base::Cost ompl::base::ElevationInformedSampler::heuristicSolnCost(const State* statePtr) const
+{
+  const double* xyz = xyzv(statePtr);
+  return Cost(euclidean(start_, xyz, phsDimension_) + euclidean(xyz, goal_, phsDimension_));
+}
+
+bool ompl::base::ElevationInformedSampler::samplePosition(const InformedSet& set, double* xyz) const
+{
+  auto& rng = threadRNG();
+  for (unsigned int i = 0; i < numIters_; i++)
+  {
+    if (set.phs)
+    {
+      rng.uniformProlateHyperspheroid(set.phs, xyz);
+    }
+    else
+    {
+      xyz[0] = rng.uniformReal(bounds_.low[0], bounds_.high[0]);
+      xyz[1] = rng.uniformReal(bounds_.low[1], bounds_.high[1]);
+    }
+    if (!set.phs || phsDimension_ == 2u)
+    {
+      xyz[2] = rng.uniformReal(bounds_.low[2], bounds_.high[2]);
+    }
+    if (inBounds(xyz))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ompl::base::ElevationInformedSampler::inBounds(const double* xyz) const
+{
+  for (unsigned int i = 0; i < 3; i++)
+  {
+    if (xyz[i] < bounds_.low[i] || xyz[i] > bounds_.high[i])
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void ompl::base::ElevationInformedSampler::setState(State* statePtr, const double* xyz) const
+{
+  auto& rng = threadRNG();
+  auto* cstate = statePtr->as<ElevationStateSpace::StateType>();
+  cstate->setXYZV(xyz[0], xyz[1], xyz[2], rng.uniformReal(bounds_.low[3], bounds_.high[3]));
+  cstate->setSO2(rng.uniformReal(-M_PI, M_PI));
+}
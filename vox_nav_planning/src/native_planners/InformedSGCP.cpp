@@ -55,11 +55,32 @@ ompl::control::InformedSGCP::InformedSGCP(const SpaceInformationPtr& si) : base:
   // If the user sets this param to true, use k nearest neighbors to connect to the graph
   declareParam<bool>("use_k_nearest", this, &InformedSGCP::setUseKNearest, &InformedSGCP::getUseKNearest, "0,1");
 
+  // If the user sets this param to true, the validity of a geometric vertex is checked only once
+  declareParam<bool>("use_validity_cache", this, &InformedSGCP::setUseValidityCache,
+                     &InformedSGCP::getUseValidityCache, "0,1");
+
+  // If the user sets this param to true, the geometric searches are repaired across batches rather than recomputed
+  declareParam<bool>("use_incremental_search", this, &InformedSGCP::setUseIncrementalSearch,
+                     &InformedSGCP::getUseIncrementalSearch, "0,1");
+
+  // If the user sets this param to true, the nearest neighbor structures are KD-forests that allow lock-free queries
+  declareParam<bool>("use_kd_forest", this, &InformedSGCP::setUseKDForest, &InformedSGCP::getUseKDForest, "0,1");
+
+  // If the user sets this param to true, the informed set of an ElevationStateSpace is sampled directly
+  declareParam<bool>("use_direct_informed_sampler", this, &InformedSGCP::setUseDirectInformedSampler,
+                     &InformedSGCP::getUseDirectInformedSampler, "0,1");
+
   // as planner progresses, the cost of the best geometric solution is updated
   addPlannerProgressProperty("geometric_cost DOUBLE", [this]() { return std::to_string(bestGeometricCost_.value()); });
 
   // as planner progresses, the cost of the best control solution is updated
   addPlannerProgressProperty("control_cost DOUBLE", [this]() { return std::to_string(bestControlCost_.value()); });
+
+  // validity checks the geometric searches made so far, and the ones the cache saved
+  addPlannerProgressProperty("search_validity_checks INTEGER",
+                             [this]() { return std::to_string(numSearchValidityChecks_.load()); });
+  addPlannerProgressProperty("validity_cache_hits INTEGER",
+                             [this]() { return std::to_string(numValidityCacheHits_.load()); });
 }
 
 ompl::control::InformedSGCP::~InformedSGCP()
@@ -97,15 +118,13 @@ void ompl::control::InformedSGCP::setup()
   nnGeometricThreads_.clear();
   for (int i = 0; i < params_.num_threads_; i++)
   {
-    std::shared_ptr<ompl::NearestNeighbors<VertexProperty*>> this_nn;
-    this_nn.reset(tools::SelfConfig::getDefaultNearestNeighbors<VertexProperty*>(this));
+    auto this_nn = allocNearestNeighbors();
     nnGeometricThreads_.push_back(this_nn);
   }
   nnControlsThreads_.clear();
   for (int i = 0; i < params_.num_threads_; i++)
   {
-    std::shared_ptr<ompl::NearestNeighbors<VertexProperty*>> this_nn;
-    this_nn.reset(tools::SelfConfig::getDefaultNearestNeighbors<VertexProperty*>(this));
+    auto this_nn = allocNearestNeighbors();
     nnControlsThreads_.push_back(this_nn);
   }
 
@@ -141,10 +160,9 @@ void ompl::control::InformedSGCP::setup()
   {
     validStateSampler_ = si_->allocValidStateSampler();
   }
-  if (!rejectionInformedSampler_)
+  if (!informedSampler_)
   {
-    rejectionInformedSampler_ =
-        std::make_shared<base::RejectionInfSampler>(pdef_, std::numeric_limits<double>::infinity());
+    informedSampler_ = allocInformedSampler();
   }
   if (!directedControlSampler_)
   {
@@ -156,26 +174,13 @@ void ompl::control::InformedSGCP::setup()
   // initialize the best geometric and control paths
   bestControlPath_ = std::make_shared<PathControl>(si_);
   bestGeometricPath_ = std::make_shared<PathControl>(si_);
-
-  // RVIZ VISUALIZATIONS, this is likely to be removed in the future, but for now it is useful
-  node_ = std::make_shared<rclcpp::Node>("InformedSGCP_rclcpp_node");
-  rgg_graph_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>("vox_nav/InformedSGCP/rgg",
-                                                                                 rclcpp::SystemDefaultsQoS());
-  geometric_path_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>("vox_nav/InformedSGCP/g_plan",
-                                                                                      rclcpp::SystemDefaultsQoS());
-  first_control_graph_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>(
-      "vox_nav/InformedSGCP/first_control_rgg", rclcpp::SystemDefaultsQoS());
-  second_control_graph_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>(
-      "vox_nav/InformedSGCP/second_control_rgg", rclcpp::SystemDefaultsQoS());
-  control_path_pub_ = node_->create_publisher<visualization_msgs::msg::MarkerArray>("vox_nav/InformedSGCP/c_plan",
-                                                                                    rclcpp::SystemDefaultsQoS());
 }
 
 void ompl::control::InformedSGCP::clear()
 {
   Planner::clear();
   validStateSampler_.reset();
-  rejectionInformedSampler_.reset();
+  informedSampler_.reset();
   radius_ = std::numeric_limits<double>::infinity();
   numNeighbors_ = std::numeric_limits<std::size_t>::max();
   bestControlCost_ = opt_->infiniteCost();
@@ -195,6 +200,9 @@ void ompl::control::InformedSGCP::clear()
     nn->clear();
   }
 
+  // the incremental searches refer to the geometric graphs
+  incrementalSearchThreads_.clear();
+
   // clear all graphs in geometric threads
   for (auto& graph : graphGeometricThreads_)
   {
@@ -214,6 +222,63 @@ void ompl::control::InformedSGCP::freeMemory()
 {
 }
 
+std::shared_ptr<ompl::NearestNeighbors<ompl::control::InformedSGCP::VertexProperty*>>
+ompl::control::InformedSGCP::allocNearestNeighbors()
+{
+  std::shared_ptr<ompl::NearestNeighbors<VertexProperty*>> nn;
+  if (!params_.use_kd_forest_)
+  {
+    nn.reset(tools::SelfConfig::getDefaultNearestNeighbors<VertexProperty*>(this));
+    return nn;
+  }
+
+  // The KD-trees split on coordinates whose euclidean distance never exceeds the state distance:
+  // all coordinates of a RealVectorStateSpace, x and y of an ElevationStateSpace, as its SE2, Dubins and
+  // Reeds-Shepp distances are at least as long as the straight line
+  if (si_->getStateSpace()->getType() == base::STATE_SPACE_REAL_VECTOR)
+  {
+    unsigned int dimension = si_->getStateDimension();
+    nn = std::make_shared<ompl::NearestNeighborsKDForest<VertexProperty*>>(
+        dimension, [dimension](VertexProperty* const& v, double* coords) {
+          const auto* cstate = v->state->as<ompl::base::RealVectorStateSpace::StateType>();
+          std::copy_n(cstate->values, dimension, coords);
+        });
+  }
+  else
+  {
+    nn = std::make_shared<ompl::NearestNeighborsKDForest<VertexProperty*>>(
+        2, [](VertexProperty* const& v, double* coords) {
+          const auto* xyzv = v->state->as<ompl::base::ElevationStateSpace::StateType>()
+                                 ->as<ompl::base::RealVectorStateSpace::StateType>(1);
+          coords[0] = xyzv->values[0];
+          coords[1] = xyzv->values[1];
+        });
+  }
+  return nn;
+}
+
+ompl::base::InformedSamplerPtr ompl::control::InformedSGCP::allocInformedSampler()
+{
+  // Only the ElevationStateSpace is known to the direct sampler, with a single start and goal state
+  bool direct = params_.use_direct_informed_sampler_ &&
+                dynamic_cast<const base::ElevationStateSpace*>(si_->getStateSpace().get()) != nullptr &&
+                pdef_->getStartStateCount() > 0 && pdef_->getGoal() && pdef_->getGoal()->hasType(base::GOAL_STATE);
+  if (params_.use_direct_informed_sampler_ && !direct)
+  {
+    OMPL_WARN("%s: The direct informed sampler needs an ElevationStateSpace, a start and a goal state. "
+              "Using rejection sampling",
+              getName().c_str());
+  }
+  if (!direct)
+  {
+    return std::make_shared<base::RejectionInfSampler>(pdef_, std::numeric_limits<unsigned int>::max());
+  }
+
+  auto sampler = std::make_shared<base::ElevationInformedSampler>(pdef_, std::numeric_limits<unsigned int>::max());
+  sampler->setTraversableCells(informedSamplerCells_);
+  return sampler;
+}
+
 double ompl::control::InformedSGCP::distanceFunction(const VertexProperty* a, const VertexProperty* b) const
 {
   return si_->distance(a->state, b->state);
@@ -341,11 +406,105 @@ bool ompl::control::InformedSGCP::getSolveControlGraph() const
   return params_.solve_control_graph_;
 }
 
+void ompl::control::InformedSGCP::setUseValidityCache(bool use_validity_cache)
+{
+  params_.use_validity_cache_ = use_validity_cache;
+}
+
+bool ompl::control::InformedSGCP::getUseValidityCache() const
+{
+  return params_.use_validity_cache_;
+}
+
+std::uint64_t ompl::control::InformedSGCP::getNumSearchValidityChecks() const
+{
+  return numSearchValidityChecks_.load();
+}
+
+std::uint64_t ompl::control::InformedSGCP::getNumValidityCacheHits() const
+{
+  return numValidityCacheHits_.load();
+}
+
+std::uint64_t ompl::control::InformedSGCP::getNumPrevalidatedVertices() const
+{
+  return numPrevalidatedVertices_.load();
+}
+
+void ompl::control::InformedSGCP::setUseIncrementalSearch(bool use_incremental_search)
+{
+  params_.use_incremental_search_ = use_incremental_search;
+}
+
+bool ompl::control::InformedSGCP::getUseIncrementalSearch() const
+{
+  return params_.use_incremental_search_;
+}
+
+void ompl::control::InformedSGCP::setUseKDForest(bool use_kd_forest)
+{
+  params_.use_kd_forest_ = use_kd_forest;
+}
+
+bool ompl::control::InformedSGCP::getUseKDForest() const
+{
+  return params_.use_kd_forest_;
+}
+
+void ompl::control::InformedSGCP::setUseDirectInformedSampler(bool use_direct_informed_sampler)
+{
+  params_.use_direct_informed_sampler_ = use_direct_informed_sampler;
+}
+
+bool ompl::control::InformedSGCP::getUseDirectInformedSampler() const
+{
+  return params_.use_direct_informed_sampler_;
+}
+
+void ompl::control::InformedSGCP::setInformedSamplerCells(const std::vector<Eigen::Vector3d>& cells)
+{
+  informedSamplerCells_ = cells;
+  if (auto sampler = std::dynamic_pointer_cast<base::ElevationInformedSampler>(informedSampler_))
+  {
+    sampler->setTraversableCells(informedSamplerCells_);
+  }
+}
+
+std::size_t ompl::control::InformedSGCP::getNumBatches() const
+{
+  return numBatches_.load();
+}
+
+std::vector<double> ompl::control::InformedSGCP::getBatchSearchTimes() const
+{
+  return batchSearchTimes_;
+}
+
+bool ompl::control::InformedSGCP::isVertexValid(VertexProperty* vertex)
+{
+  if (params_.use_validity_cache_ && vertex->validity != VertexValidity::UNKNOWN)
+  {
+    numValidityCacheHits_++;
+    return vertex->validity == VertexValidity::VALID;
+  }
+  numSearchValidityChecks_++;
+  bool valid = si_->isValid(vertex->state);
+  vertex->validity = valid ? VertexValidity::VALID : VertexValidity::INVALID;
+  return valid;
+}
+
 ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::PlannerTerminationCondition& ptc)
 {
   // check if the problem is setup properly
   checkValidity();
 
+  // validity bookkeeping is reported per solve
+  numSearchValidityChecks_ = 0;
+  numValidityCacheHits_ = 0;
+  numPrevalidatedVertices_ = 0;
+  numBatches_ = 0;
+  batchSearchTimes_.clear();
+
   // get the goal node and state
   auto* goal_state = si_->allocState();
   auto* start_state = si_->allocState();
@@ -377,6 +536,9 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
   // NOTE: In gemetric problem setting the we are always solving from start to goal
   startVertexGeometric_->state = start_state;
   goalVertexGeometric_->state = goal_state;
+  // both were checked above
+  startVertexGeometric_->validity = VertexValidity::VALID;
+  goalVertexGeometric_->validity = VertexValidity::VALID;
   for (auto& nn : nnGeometricThreads_)
   {
     nn->add(goalVertexGeometric_);
@@ -478,6 +640,21 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
     control_weightmaps.push_back(get(boost::edge_weight, graph));
   }
 
+  // In incremental mode each geometric graph keeps one LPA* search from goal to start for the whole solve
+  incrementalSearchThreads_.clear();
+  if (params_.use_incremental_search_)
+  {
+    for (int i = 0; i < params_.num_threads_; i++)
+    {
+      auto& graph = graphGeometricThreads_[i];
+      incrementalSearchThreads_.push_back(std::make_shared<GraphLPAstar<GraphT, WeightMap>>(
+          graph, geometric_weightmaps[i], geometric_start_goal_descriptors[i].second,
+          geometric_start_goal_descriptors[i].first, [this, &graph](vertex_descriptor v) {
+            return opt_->motionCost(graph[v].state, startVertexGeometric_->state).value();
+          }));
+    }
+  }
+
   // The thread ids needs to be immutable for the lambda function
   std::vector<int> thread_ids;
   for (int t = 0; t < params_.num_threads_; t++)
@@ -500,6 +677,9 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
     numNeighbors_ = computeNumberOfNeighbors(numSamplesInInformedSet /*- 2 goal and start */);
     radius_ = computeConnectionRadius(numSamplesInInformedSet /*- 2 goal and start*/);
 
+    // Time the searches of each geometric thread takes in this batch
+    std::vector<double> geometric_search_times(params_.num_threads_, 0.0);
+
     // launch geometric planning threads
     std::vector<std::thread*> geometric_threads(params_.num_threads_);
     for (int t = 0; t < params_.num_threads_; t++)
@@ -512,10 +692,11 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
       auto& geometric_weightmap = geometric_weightmaps.at(thread_id);
       auto& geometric_shortest_path = geometric_shortest_paths.at(thread_id);
       auto& start_goal_descriptor_pair = geometric_start_goal_descriptors.at(thread_id);
+      auto& search_time = geometric_search_times.at(thread_id);
 
       geometric_threads[thread_id] = new std::thread([this, &geometric_graph, &geometric_nn, &geometric_weightmap,
                                                       &geometric_shortest_path, &start_goal_descriptor_pair, &thread_id,
-                                                      &ptc] {
+                                                      &search_time, &ptc] {
         // Generate a batch of samples
         std::vector<ompl::base::State*> samples;
         generateBatchofSamples(params_.batch_size_, params_.use_valid_sampler_, samples);
@@ -527,24 +708,37 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
         ensureGeometricGoalVertexConnectivity(&geometric_graph[start_goal_descriptor_pair.second], geometric_graph,
                                               geometric_nn, geometric_weightmap);
 
-        // First lets compute an heuristic working backward from goal -> start (Adaptive Heuristic)
-        // This is done by running A*/Dijkstra backwards from goal to start with no collision checking
-        auto heuristic = GenericDistanceHeuristic<GraphT, VertexProperty, GraphEdgeCost>(
-            this, &geometric_graph[start_goal_descriptor_pair.first], false, thread_id);
-        geometric_shortest_path = computeShortestPath<GenericDistanceHeuristic<GraphT, VertexProperty, GraphEdgeCost>>(
-            geometric_graph, geometric_weightmap, heuristic, start_goal_descriptor_pair.second,
-            start_goal_descriptor_pair.first, true, false);
-
-        // Now an actual heuristic is computed by running A*/Dijkstra from start -> goal without collision checking
-        if (geometric_shortest_path.size() > 0)
+        auto search_start = std::chrono::steady_clock::now();
+        if (params_.use_incremental_search_)
+        {
+          // Repair the search of this graph where the batch changed it
+          geometric_shortest_path = computeIncrementalShortestPath(geometric_graph, geometric_weightmap,
+                                                                   *incrementalSearchThreads_.at(thread_id), ptc);
+        }
+        else
         {
-          // precomputed heuristic is available,
-          // lets use it for actual path search with collision checking
-          auto precomputed_heuristic = PrecomputedCostHeuristic<GraphT, GraphEdgeCost>(this, thread_id);
-          geometric_shortest_path = computeShortestPath<PrecomputedCostHeuristic<GraphT, GraphEdgeCost>>(
-              geometric_graph, geometric_weightmap, precomputed_heuristic, start_goal_descriptor_pair.first,
-              start_goal_descriptor_pair.second, false, true);
+          // First lets compute an heuristic working backward from goal -> start (Adaptive Heuristic)
+          // This is done by running A*/Dijkstra backwards from goal to start with no collision checking
+          auto heuristic = GenericDistanceHeuristic<GraphT, VertexProperty, GraphEdgeCost>(
+              this, &geometric_graph[start_goal_descriptor_pair.first], false, thread_id);
+          geometric_shortest_path =
+              computeShortestPath<GenericDistanceHeuristic<GraphT, VertexProperty, GraphEdgeCost>>(
+                  geometric_graph, geometric_weightmap, heuristic, start_goal_descriptor_pair.second,
+                  start_goal_descriptor_pair.first, true, false);
+
+          // Now an actual heuristic is computed by running A*/Dijkstra from start -> goal without collision checking
+          if (geometric_shortest_path.size() > 0)
+          {
+            // precomputed heuristic is available,
+            // lets use it for actual path search with collision checking
+            auto precomputed_heuristic = PrecomputedCostHeuristic<GraphT, GraphEdgeCost>(this, thread_id);
+            geometric_shortest_path = computeShortestPath<PrecomputedCostHeuristic<GraphT, GraphEdgeCost>>(
+                geometric_graph, geometric_weightmap, precomputed_heuristic, start_goal_descriptor_pair.first,
+                start_goal_descriptor_pair.second, false, true);
+          }
         }
+        search_time =
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - search_start).count();
       });
     }
 
@@ -646,6 +840,8 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
       thread->join();
       delete thread;
     }
+    batchSearchTimes_.push_back(*std::max_element(geometric_search_times.begin(), geometric_search_times.end()));
+    numBatches_++;
 
     // Populate the OMPL geometric paths from vertexes found by A* in the geometric threads
     for (size_t i = 0; i < geometric_shortest_paths.size(); i++)
@@ -698,10 +894,9 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
       control_counter++;
     }
 
-    // only for visualization, keep a copy of the best geometric and control graphs
-    // Keep a copy before we change graphGeometricThreads_ and graphControlThreads_
-    auto best_geometric_graph = graphGeometricThreads_[bestGeometricPathIndex_];
-    auto best_control_graph = graphControlThreads_[bestControlPathIndex_];
+    // only for visualization, the graphs are not changed until they are visualized below, so no copies are needed
+    const auto& best_geometric_graph = graphGeometricThreads_[bestGeometricPathIndex_];
+    const auto& best_control_graph = graphControlThreads_[bestControlPathIndex_];
 
     int best_control_graph_counterpart_index{ 0 };
     if (bestControlPathIndex_ % 2 == 0)
@@ -712,7 +907,7 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
     {
       best_control_graph_counterpart_index = bestControlPathIndex_ - 1;
     }
-    auto best_control_graph_counterpart = graphControlThreads_[best_control_graph_counterpart_index];
+    const auto& best_control_graph_counterpart = graphControlThreads_[best_control_graph_counterpart_index];
 
     // If the cost is less than L2 norm of start and goal, this is likely an useless one.
     // make sure the current cost is not less than L2 norm of start and goal
@@ -825,25 +1020,38 @@ ompl::base::PlannerStatus ompl::control::InformedSGCP::solve(const base::Planner
     std::string blue("blue");
 
     // geometric path
-    visualizePath(best_geometric_graph, geometric_shortest_paths[bestGeometricPathIndex_], geometric_path_pub_, "g",
+    visualizePath(best_geometric_graph, geometric_shortest_paths[bestGeometricPathIndex_], geometric_path_topic_, "g",
                   getColor(blue), si_->getStateSpace()->getType());
 
     // best control path
-    visualizePath(bestControlPath_, control_path_pub_, "c", getColor(red), si_->getStateSpace()->getType());
+    visualizePath(bestControlPath_, control_path_topic_, "c", getColor(red), si_->getStateSpace()->getType());
 
-    visualizeRGG(best_geometric_graph, rgg_graph_pub_, "g", getColor(green),
+    visualizeRGG(best_geometric_graph, rgg_graph_topic_, "g", getColor(green),
                  geometric_start_goal_descriptors[bestGeometricPathIndex_].first,
                  geometric_start_goal_descriptors[bestGeometricPathIndex_].second, si_->getStateSpace()->getType());
 
-    visualizeRGG(best_control_graph, first_control_graph_pub_, "c", getColor(red),
+    visualizeRGG(best_control_graph, first_control_graph_topic_, "c", getColor(red),
                  control_start_goal_descriptors[bestControlPathIndex_].first,
                  control_start_goal_descriptors[bestControlPathIndex_].second, si_->getStateSpace()->getType());
 
-    visualizeRGG(best_control_graph_counterpart, second_control_graph_pub_, "c", getColor(green),
+    visualizeRGG(best_control_graph_counterpart, second_control_graph_topic_, "c", getColor(green),
                  control_start_goal_descriptors[bestControlPathIndex_].first,
                  control_start_goal_descriptors[bestControlPathIndex_].second, si_->getStateSpace()->getType());
   }
 
+  // The paths of the last batches may have been turned down by the rate limit, RVIZ has to show the returned ones
+  auto& sink = vox_nav_planning::PlannerVisualizationSink::instance();
+  std::string red("red");
+  std::string blue("blue");
+  if (sink.acceptFinal(geometric_path_topic_))
+  {
+    visualizePath(bestGeometricPath_, geometric_path_topic_, "g", getColor(blue), si_->getStateSpace()->getType());
+  }
+  if (sink.acceptFinal(control_path_topic_))
+  {
+    visualizePath(bestControlPath_, control_path_topic_, "c", getColor(red), si_->getStateSpace()->getType());
+  }
+
   // Add the best path to the solution path
   if (params_.solve_control_graph_)
   {
@@ -868,6 +1076,67 @@ void ompl::control::InformedSGCP::getPlannerData(base::PlannerData& data) const
   Planner::getPlannerData(data);
 }
 
+std::list<ompl::control::InformedSGCP::vertex_descriptor> ompl::control::InformedSGCP::computeIncrementalShortestPath(
+    GraphT& g, WeightMap& weightmap, GraphLPAstar<GraphT, WeightMap>& search,
+    const base::PlannerTerminationCondition& ptc)
+{
+  // Take in the vertices of this batch and the edges next to them and to the goal
+  search.update();
+
+  std::list<vertex_descriptor> shortest_path;
+  while (ptc == false)
+  {
+    // The search runs from goal to start, so the path comes out from start to goal
+    search.computeShortestPath(shortest_path);
+    if (shortest_path.empty())
+    {
+      return shortest_path;
+    }
+
+    bool is_valid_path = true;
+    for (auto v : shortest_path)
+    {
+      if (!g[v].blacklisted && isVertexValid(&g[v]))
+      {
+        continue;
+      }
+      is_valid_path = false;
+      // Found an invalid vertex, mark its edges as invalid and let the search route around it
+      g[v].blacklisted = true;
+      for (auto ed : boost::make_iterator_range(boost::out_edges(v, g)))
+      {
+        weightmap[ed] = opt_->infiniteCost().value();
+      }
+      search.updateEdges(v);
+    }
+
+    // Valid vertices can still be joined by an edge in collision, the search only learns about it through
+    // updateEdges(), otherwise it would return the same path again in the next batch
+    if (is_valid_path)
+    {
+      for (auto it = std::next(shortest_path.begin()); it != shortest_path.end(); ++it)
+      {
+        auto u = *std::prev(it);
+        auto v = *it;
+        if (si_->checkMotion(g[u].state, g[v].state))
+        {
+          continue;
+        }
+        is_valid_path = false;
+        weightmap[boost::edge(u, v, g).first] = opt_->infiniteCost().value();
+        search.updateEdges(u);
+        search.updateEdges(v);
+      }
+    }
+
+    if (is_valid_path)
+    {
+      return shortest_path;
+    }
+  }
+  return std::list<vertex_descriptor>({});
+}
+
 void ompl::control::InformedSGCP::generateBatchofSamples(int batch_size, bool use_valid_sampler,
                                                          std::vector<ompl::base::State*>& samples)
 {
@@ -897,7 +1166,7 @@ void ompl::control::InformedSGCP::generateBatchofSamples(int batch_size, bool us
             min_cost = bestControlCost_;
           }
         }
-        rejectionInformedSampler_->sampleUniform(samples.back(), min_cost);
+        informedSampler_->sampleUniform(samples.back(), min_cost);
       } while (!si_->getStateValidityChecker()->isValid(samples.back()));
     }
   } while (samples.size() < batch_size);  // Keep sampling until batch_size is reached
@@ -928,6 +1197,8 @@ void ompl::control::InformedSGCP::expandGeometricGraph(
     // We will potentially add a new vertex to the graph and nn structure, so allocate a vertex property
     VertexProperty* vertex_property_to_be_added = new VertexProperty();
     vertex_property_to_be_added->state = (i);
+    // The sample was just checked in this thread, keep the result so the searches below do not check it again
+    vertex_property_to_be_added->validity = VertexValidity::VALID;
 
     // Get the neighbors of the new vertex with radius_ or k-nearest
     std::vector<ompl::control::InformedSGCP::VertexProperty*> nbh;
@@ -966,6 +1237,7 @@ void ompl::control::InformedSGCP::expandGeometricGraph(
       vertex_property_to_be_added->id = vertex_descriptor_to_be_added;
       geometric_graph[vertex_descriptor_to_be_added] = *vertex_property_to_be_added;
       geometric_nn->add(vertex_property_to_be_added);
+      numPrevalidatedVertices_++;
       for (auto&& nb : nbh)
       {
         if (!si_->checkMotion(vertex_property_to_be_added->state, nb->state))
@@ -1402,7 +1674,7 @@ double ompl::control::InformedSGCP::computeConnectionRadius(std::size_t numSampl
   // Compute the RRT* factor. Taken from AITStar::computeConnectionRadius.
   return params_.rewire_factor_ *
          std::pow(2.0 * (1.0 + 1.0 / dimension) *
-                      (rejectionInformedSampler_->getInformedMeasure(bestControlCost_) /
+                      (informedSampler_->getInformedMeasure(bestControlCost_) /
                        unitNBallMeasure(si_->getStateDimension())) *
                       (std::log(static_cast<double>(numSamples)) / static_cast<double>(numSamples)),
                   1.0 / dimension);
@@ -1531,322 +1803,82 @@ void ompl::control::InformedSGCP::clearControlGraphs(
   }
 }
 
-void ompl::control::InformedSGCP::visualizeRGG(
-    const GraphT& g, const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher,
-    const std::string& ns, const std_msgs::msg::ColorRGBA& color, const vertex_descriptor& start_vertex,
-    const vertex_descriptor& goal_vertex, const int& state_space_type)
-{
-  // Clear All previous markers
-  visualization_msgs::msg::MarkerArray clear_markers;
-  visualization_msgs::msg::Marker rgg_vertex, rgg_edges;
-  rgg_vertex.id = 0;
-  rgg_edges.id = 0;
-  rgg_vertex.ns = ns + "rgg_vertex";
-  rgg_edges.ns = ns + "rgg_edges";
-  rgg_vertex.action = visualization_msgs::msg::Marker::DELETEALL;
-  rgg_edges.action = visualization_msgs::msg::Marker::DELETEALL;
-  clear_markers.markers.push_back(rgg_vertex);
-  clear_markers.markers.push_back(rgg_edges);
-  publisher->publish(clear_markers);
-
-  visualization_msgs::msg::Marker sphere;
-  sphere.header.frame_id = "map";
-  sphere.header.stamp = rclcpp::Clock().now();
-  sphere.ns = ns + "rgg_vertex";
-  sphere.id = 0;
-  sphere.type = visualization_msgs::msg::Marker::SPHERE_LIST;
-  sphere.action = visualization_msgs::msg::Marker::ADD;
-  sphere.scale.x = 0.15;
-  sphere.scale.y = 0.15;
-  sphere.scale.z = 0.15;
-
-  visualization_msgs::msg::MarkerArray marker_array;
-  // To make a graph of the supervoxel adjacency,
-  // we need to iterate through the supervoxel adjacency multimap
-  for (auto vd : boost::make_iterator_range(vertices(g)))
+void ompl::control::InformedSGCP::visualizeRGG(const GraphT& g, const std::string& topic, const std::string& ns,
+                                               const std_msgs::msg::ColorRGBA& color,
+                                               const vertex_descriptor& start_vertex,
+                                               const vertex_descriptor& goal_vertex, const int& state_space_type)
+{
+  auto& sink = vox_nav_planning::PlannerVisualizationSink::instance();
+  if (!sink.wants(topic))
   {
-    // Paint the start and goal vertices differently.
-    std_msgs::msg::ColorRGBA color_vd = color;
-    double is_goal_or_start{ 0.0 };
-    if (g[vd].id == start_vertex || g[vd].id == goal_vertex)
-    {
-      color_vd.b *= 0.5;
-    }
-
-    geometry_msgs::msg::Point point;
-    if (state_space_type == base::STATE_SPACE_REAL_VECTOR)
-    {
-      const auto* target_cstate = g[vd].state->as<ompl::base::RealVectorStateSpace::StateType>();
-      point.x = target_cstate->values[0];
-      point.y = target_cstate->values[1];
-      point.z = target_cstate->values[2];
-    }
-    else
-    {
-      const auto* target_cstate = g[vd].state->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* target_so2 = target_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* target_xyzv = target_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      point.x = target_xyzv->values[0];
-      point.y = target_xyzv->values[1];
-      point.z = target_xyzv->values[2];
-    }
-
-    sphere.points.push_back(point);
-    sphere.colors.push_back(color);
+    return;
   }
-  marker_array.markers.push_back(sphere);
 
-  auto es = boost::edges(g);
-  vertex_descriptor u, v;
-  int edge_index = 0;
-  visualization_msgs::msg::Marker line_strip;
-  line_strip.header.frame_id = "map";
-  line_strip.ns = ns + "rgg_edges";
-  line_strip.id = edge_index;
-  line_strip.type = visualization_msgs::msg::Marker::LINE_LIST;
-  line_strip.action = visualization_msgs::msg::Marker::ADD;
-  line_strip.lifetime = rclcpp::Duration::from_seconds(0);
-  line_strip.header.stamp = rclcpp::Clock().now();
-  line_strip.scale.x = 0.01;
-  line_strip.scale.y = 0.01;
-  line_strip.scale.z = 0.01;
-  line_strip.color = color;
-
-  for (auto eit = es.first; eit != es.second; ++eit)
+  auto visualization = std::make_unique<vox_nav_planning::PlannerVisualization>();
+  visualization->type = vox_nav_planning::PlannerVisualization::Type::GRAPH;
+  visualization->topic = topic;
+  visualization->ns = ns;
+  visualization->color = color;
+  visualization->points.reserve(boost::num_vertices(g));
+  for (auto vd : boost::make_iterator_range(vertices(g)))
   {
-    u = boost::source(*eit, g);
-    v = boost::target(*eit, g);
-
-    geometry_msgs::msg::Point source_point, target_point;
+    visualization->points.push_back(vox_nav_planning::stateToPoint(g[vd].state, state_space_type));
+  }
+  visualization->edges.reserve(2 * boost::num_edges(g));
+  for (auto e : boost::make_iterator_range(boost::edges(g)))
+  {
+    visualization->edges.push_back(visualization->points[boost::source(e, g)]);
+    visualization->edges.push_back(visualization->points[boost::target(e, g)]);
+  }
+  sink.push(std::move(visualization));
+}
 
-    if (state_space_type == base::STATE_SPACE_REAL_VECTOR)
-    {
-      const auto* source_cstate = g[u].state->as<ompl::base::RealVectorStateSpace::StateType>();
-      source_point.x = source_cstate->values[0];
-      source_point.y = source_cstate->values[1];
-      source_point.z = source_cstate->values[2];
-
-      const auto* target_cstate = g[v].state->as<ompl::base::RealVectorStateSpace::StateType>();
-      target_point.x = target_cstate->values[0];
-      target_point.y = target_cstate->values[1];
-      target_point.z = target_cstate->values[2];
-    }
-    else
-    {
-      const auto* source_cstate = g[u].state->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* source_so2 = source_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* source_xyzv = source_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      source_point.x = source_xyzv->values[0];
-      source_point.y = source_xyzv->values[1];
-      source_point.z = source_xyzv->values[2];
-
-      const auto* target_cstate = g[v].state->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* target_so2 = target_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* target_xyzv = target_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      target_point.x = target_xyzv->values[0];
-      target_point.y = target_xyzv->values[1];
-      target_point.z = target_xyzv->values[2];
-    }
+void ompl::control::InformedSGCP::visualizePath(const GraphT& g, const std::list<vertex_descriptor>& path,
+                                                const std::string& topic, const std::string& ns,
+                                                const std_msgs::msg::ColorRGBA& color, const int& state_space_type)
+{
+  auto& sink = vox_nav_planning::PlannerVisualizationSink::instance();
+  if (!sink.wants(topic))
+  {
+    return;
+  }
 
-    line_strip.points.push_back(source_point);
-    line_strip.colors.push_back(color);
-    line_strip.points.push_back(target_point);
-    line_strip.colors.push_back(color);
-  }
-  marker_array.markers.push_back(line_strip);
-
-  publisher->publish(marker_array);
-}
-
-void ompl::control::InformedSGCP::visualizePath(
-    const GraphT& g, const std::list<vertex_descriptor>& path,
-    const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher, const std::string& ns,
-    const std_msgs::msg::ColorRGBA& color, const int& state_space_type)
-{
-  // Clear All previous markers
-  visualization_msgs::msg::MarkerArray clear_markers;
-  visualization_msgs::msg::Marker path_marker, cost_marker;
-  path_marker.id = 0;
-  cost_marker.id = 0;
-  path_marker.ns = ns + "path";
-  cost_marker.ns = ns + "costs";
-  path_marker.action = visualization_msgs::msg::Marker::DELETEALL;
-  cost_marker.action = visualization_msgs::msg::Marker::DELETEALL;
-  clear_markers.markers.push_back(path_marker);
-  clear_markers.markers.push_back(cost_marker);
-  publisher->publish(clear_markers);
-
-  visualization_msgs::msg::MarkerArray marker_array;
-  visualization_msgs::msg::Marker line_strip;
-  line_strip.header.frame_id = "map";
-  line_strip.ns = ns + "path";
-  line_strip.id = 0;
-  line_strip.type = visualization_msgs::msg::Marker::LINE_LIST;
-  line_strip.action = visualization_msgs::msg::Marker::ADD;
-  line_strip.lifetime = rclcpp::Duration::from_seconds(0);
-  line_strip.header.stamp = rclcpp::Clock().now();
-  line_strip.scale.x = 0.1;
-  line_strip.scale.y = 0.1;
-  line_strip.scale.z = 0.1;
-  line_strip.color = color;
-
-  for (size_t i = 1; i < path.size(); i++)
-  {
-    auto u = *std::next(path.begin(), i - 1);
-    auto v = *std::next(path.begin(), i);
-    geometry_msgs::msg::Point source_point, target_point;
-
-    if (state_space_type == base::STATE_SPACE_REAL_VECTOR)
-    {
-      const auto* source_cstate = g[u].state->as<ompl::base::RealVectorStateSpace::StateType>();
-      source_point.x = source_cstate->values[0];
-      source_point.y = source_cstate->values[1];
-      source_point.z = source_cstate->values[2];
-
-      const auto* target_cstate = g[v].state->as<ompl::base::RealVectorStateSpace::StateType>();
-      target_point.x = target_cstate->values[0];
-      target_point.y = target_cstate->values[1];
-      target_point.z = target_cstate->values[2];
-    }
-    else
-    {
-      const auto* source_cstate = g[u].state->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* source_so2 = source_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* source_xyzv = source_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      source_point.x = source_xyzv->values[0];
-      source_point.y = source_xyzv->values[1];
-      source_point.z = source_xyzv->values[2];
-
-      const auto* target_cstate = g[v].state->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* target_so2 = target_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* target_xyzv = target_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      target_point.x = target_xyzv->values[0];
-      target_point.y = target_xyzv->values[1];
-      target_point.z = target_xyzv->values[2];
-    }
+  auto visualization = std::make_unique<vox_nav_planning::PlannerVisualization>();
+  visualization->type = vox_nav_planning::PlannerVisualization::Type::PATH;
+  visualization->topic = topic;
+  visualization->ns = ns;
+  visualization->color = color;
+  for (auto u : path)
+  {
+    visualization->points.push_back(vox_nav_planning::stateToPoint(g[u].state, state_space_type));
+    visualization->labels.push_back(std::to_string(g[u].g));
+    visualization->label_ids.push_back(g[u].id);
+  }
+  sink.push(std::move(visualization));
+}
 
-    line_strip.points.push_back(source_point);
-    line_strip.colors.push_back(color);
-    line_strip.points.push_back(target_point);
-    line_strip.colors.push_back(color);
-
-    visualization_msgs::msg::Marker text;
-    text.header.frame_id = "map";
-    text.header.stamp = rclcpp::Clock().now();
-    text.ns = ns + "costs";
-    text.id = g[u].id;
-    text.type = visualization_msgs::msg::Marker::TEXT_VIEW_FACING;
-    text.action = visualization_msgs::msg::Marker::ADD;
-    text.lifetime = rclcpp::Duration::from_seconds(0);
-    text.text = std::to_string(g[u].g);
-    text.pose.position = source_point;
-    text.pose.position.z += 0.5;
-    text.scale.x = 0.3;
-    text.scale.y = 0.3;
-    text.scale.z = 0.3;
-    text.color.a = 1.0;
-    text.color.r = 1.0;
-    marker_array.markers.push_back(text);
-  }
-  marker_array.markers.push_back(line_strip);
-
-  publisher->publish(marker_array);
-}
-
-void ompl::control::InformedSGCP::visualizePath(
-    const std::shared_ptr<PathControl>& path,
-    const rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr& publisher, const std::string& ns,
-    const std_msgs::msg::ColorRGBA& color, const int& state_space_type)
-{
-  // Clear All previous markers
-  visualization_msgs::msg::MarkerArray clear_markers;
-  visualization_msgs::msg::Marker path_marker, cost_marker;
-  path_marker.id = 0;
-  cost_marker.id = 0;
-  path_marker.ns = ns + "path";
-  cost_marker.ns = ns + "costs";
-  path_marker.action = visualization_msgs::msg::Marker::DELETEALL;
-  cost_marker.action = visualization_msgs::msg::Marker::DELETEALL;
-  clear_markers.markers.push_back(path_marker);
-  clear_markers.markers.push_back(cost_marker);
-  publisher->publish(clear_markers);
-
-  visualization_msgs::msg::MarkerArray marker_array;
-  visualization_msgs::msg::Marker line_strip;
-  line_strip.header.frame_id = "map";
-  line_strip.ns = ns + "path";
-  line_strip.id = 0;
-  line_strip.type = visualization_msgs::msg::Marker::LINE_LIST;
-  line_strip.action = visualization_msgs::msg::Marker::ADD;
-  line_strip.lifetime = rclcpp::Duration::from_seconds(0);
-  line_strip.header.stamp = rclcpp::Clock().now();
-  line_strip.scale.x = 0.1;
-  line_strip.scale.y = 0.1;
-  line_strip.scale.z = 0.1;
-  line_strip.color = color;
-
-  for (size_t i = 1; i < path->getStateCount(); i++)
-  {
-    auto u = path->getState(i - 1);
-    auto v = path->getState(i);
-
-    geometry_msgs::msg::Point source_point, target_point;
-
-    if (state_space_type == ompl::base::STATE_SPACE_REAL_VECTOR)
-    {
-      const auto* source_cstate = u->as<ompl::base::RealVectorStateSpace::StateType>();
-      source_point.x = source_cstate->values[0];
-      source_point.y = source_cstate->values[1];
-      source_point.z = source_cstate->values[2];
-
-      const auto* target_cstate = v->as<ompl::base::RealVectorStateSpace::StateType>();
-      target_point.x = target_cstate->values[0];
-      target_point.y = target_cstate->values[1];
-      target_point.z = target_cstate->values[2];
-    }
-    else
-    {
-      const auto* source_cstate = u->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* source_so2 = source_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* source_xyzv = source_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      source_point.x = source_xyzv->values[0];
-      source_point.y = source_xyzv->values[1];
-      source_point.z = source_xyzv->values[2];
-
-      const auto* target_cstate = v->as<ompl::base::ElevationStateSpace::StateType>();
-      const auto* target_so2 = target_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-      const auto* target_xyzv = target_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-      target_point.x = target_xyzv->values[0];
-      target_point.y = target_xyzv->values[1];
-      target_point.z = target_xyzv->values[2];
-    }
+void ompl::control::InformedSGCP::visualizePath(const std::shared_ptr<PathControl>& path, const std::string& topic,
+                                                const std::string& ns, const std_msgs::msg::ColorRGBA& color,
+                                                const int& state_space_type)
+{
+  auto& sink = vox_nav_planning::PlannerVisualizationSink::instance();
+  if (!sink.wants(topic))
+  {
+    return;
+  }
 
-    line_strip.points.push_back(source_point);
-    line_strip.colors.push_back(color);
-    line_strip.points.push_back(target_point);
-    line_strip.colors.push_back(color);
-
-    visualization_msgs::msg::Marker text;
-    text.header.frame_id = "map";
-    text.header.stamp = rclcpp::Clock().now();
-    text.ns = ns + "costs";
-    text.id = i - 1;  // g[u].id;
-    text.type = visualization_msgs::msg::Marker::TEXT_VIEW_FACING;
-    text.action = visualization_msgs::msg::Marker::ADD;
-    text.lifetime = rclcpp::Duration::from_seconds(0);
-    text.text = std::to_string(i - 1);
-    text.pose.position = source_point;
-    text.pose.position.z += 0.5;
-    text.scale.x = 0.3;
-    text.scale.y = 0.3;
-    text.scale.z = 0.3;
-    text.color.a = 1.0;
-    text.color.r = 1.0;
-    marker_array.markers.push_back(text);
-  }
-  marker_array.markers.push_back(line_strip);
-
-  publisher->publish(marker_array);
+  auto visualization = std::make_unique<vox_nav_planning::PlannerVisualization>();
+  visualization->type = vox_nav_planning::PlannerVisualization::Type::PATH;
+  visualization->topic = topic;
+  visualization->ns = ns;
+  visualization->color = color;
+  for (std::size_t i = 0; i < path->getStateCount(); i++)
+  {
+    visualization->points.push_back(vox_nav_planning::stateToPoint(path->getState(i), state_space_type));
+    visualization->labels.push_back(std::to_string(i));
+    visualization->label_ids.push_back(i);
+  }
+  sink.push(std::move(visualization));
 }
 
 std_msgs::msg::ColorRGBA ompl::control::InformedSGCP::getColor(std::string& color)
@@ -28,13 +28,6 @@ ompl::control::LQRPlanner::~LQRPlanner()
 void ompl::control::LQRPlanner::setup()
 {
   base::Planner::setup();
-
-  // ros2 node to publish rrt nodes
-  node_ = std::make_shared<rclcpp::Node>("LQRPlanner_rclcpp_node");
-
-  rrt_nodes_pub_ =
-    node_->create_publisher<visualization_msgs::msg::MarkerArray>(
-    "vox_nav/rrtstar/nodes", rclcpp::SystemDefaultsQoS());
 }
 
 void ompl::control::LQRPlanner::clear()
@@ -0,0 +1,353 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_planning/native_planners/PlannerVisualizationSink.hpp"
+
+#include "ompl/base/spaces/RealVectorStateSpace.h"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace vox_nav_planning
+{
+geometry_msgs::msg::Point stateToPoint(const ompl::base::State* state, int state_space_type)
+{
+  geometry_msgs::msg::Point point;
+  if (state_space_type == ompl::base::STATE_SPACE_REAL_VECTOR)
+  {
+    const auto* cstate = state->as<ompl::base::RealVectorStateSpace::StateType>();
+    point.x = cstate->values[0];
+    point.y = cstate->values[1];
+    point.z = cstate->values[2];
+  }
+  else
+  {
+    const auto* cstate = state->as<ompl::base::ElevationStateSpace::StateType>();
+    const auto* xyzv = cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
+    point.x = xyzv->values[0];
+    point.y = xyzv->values[1];
+    point.z = xyzv->values[2];
+  }
+  return point;
+}
+
+PlannerVisualizationSink& PlannerVisualizationSink::instance()
+{
+  static PlannerVisualizationSink sink;
+  return sink;
+}
+
+PlannerVisualizationSink::PlannerVisualizationSink()
+{
+  if (const char* mode = std::getenv("VOX_NAV_PLANNER_VISUALIZATION"))
+  {
+    if (std::strcmp(mode, "off") == 0 || std::strcmp(mode, "0") == 0)
+    {
+      mode_ = Mode::OFF;
+    }
+    else if (std::strcmp(mode, "sync") == 0)
+    {
+      mode_ = Mode::SYNCHRONOUS;
+    }
+  }
+}
+
+PlannerVisualizationSink::~PlannerVisualizationSink()
+{
+  {
+    std::lock_guard<std::mutex> lock(wake_mutex_);
+    running_ = false;
+  }
+  wake_.notify_all();
+  if (thread_.joinable())
+  {
+    thread_.join();
+  }
+  queue_.consume_all([](PlannerVisualization* visualization) { delete visualization; });
+}
+
+void PlannerVisualizationSink::setMode(Mode mode)
+{
+  mode_ = mode;
+}
+
+PlannerVisualizationSink::Mode PlannerVisualizationSink::getMode() const
+{
+  return mode_;
+}
+
+void PlannerVisualizationSink::setMaxRate(double max_rate)
+{
+  max_rate_ = std::max(max_rate, 1e-3);
+  wake_.notify_all();
+}
+
+double PlannerVisualizationSink::getMaxRate() const
+{
+  return max_rate_;
+}
+
+bool PlannerVisualizationSink::wants(const std::string& topic)
+{
+#if VOX_NAV_PLANNER_VISUALIZATION_ENABLED
+  Mode mode = mode_;
+  if (mode == Mode::OFF)
+  {
+    return false;
+  }
+  if (mode == Mode::SYNCHRONOUS)
+  {
+    return true;
+  }
+  auto now = std::chrono::steady_clock::now();
+  std::lock_guard<std::mutex> lock(rate_mutex_);
+  auto& next_accept = next_accept_[topic];
+  if (now < next_accept)
+  {
+    rate_limited_.insert(topic);
+    return false;
+  }
+  rate_limited_.erase(topic);
+  next_accept = now + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                          std::chrono::duration<double>(1.0 / max_rate_));
+  return true;
+#else
+  (void)topic;
+  return false;
+#endif
+}
+
+bool PlannerVisualizationSink::acceptFinal(const std::string& topic)
+{
+#if VOX_NAV_PLANNER_VISUALIZATION_ENABLED
+  // Only the asynchronous mode turns snapshots down
+  if (mode_ != Mode::ASYNCHRONOUS)
+  {
+    return false;
+  }
+  std::lock_guard<std::mutex> lock(rate_mutex_);
+  if (rate_limited_.erase(topic) == 0)
+  {
+    return false;
+  }
+  next_accept_[topic] = std::chrono::steady_clock::time_point();
+  return true;
+#else
+  (void)topic;
+  return false;
+#endif
+}
+
+void PlannerVisualizationSink::push(std::unique_ptr<PlannerVisualization> visualization)
+{
+#if VOX_NAV_PLANNER_VISUALIZATION_ENABLED
+  Mode mode = mode_;
+  if (mode == Mode::SYNCHRONOUS)
+  {
+    publish(*visualization);
+    return;
+  }
+  if (mode == Mode::ASYNCHRONOUS)
+  {
+    std::call_once(thread_once_, [this]() { thread_ = std::thread(&PlannerVisualizationSink::run, this); });
+    if (queue_.push(visualization.get()))
+    {
+      visualization.release();
+      return;
+    }
+  }
+#endif
+  num_dropped_++;
+}
+
+std::size_t PlannerVisualizationSink::getNumPublished() const
+{
+  return num_published_;
+}
+
+std::size_t PlannerVisualizationSink::getNumDropped() const
+{
+  return num_dropped_;
+}
+
+void PlannerVisualizationSink::run()
+{
+#ifdef __linux__
+  // Only run when the planner threads leave a core idle
+  sched_param param{};
+  param.sched_priority = 0;
+  pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+
+  while (running_)
+  {
+    {
+      std::unique_lock<std::mutex> lock(wake_mutex_);
+      wake_.wait_for(lock, std::chrono::duration<double>(1.0 / max_rate_), [this]() { return !running_; });
+    }
+
+    // Only the latest snapshot of each topic is worth publishing
+    std::map<std::string, std::unique_ptr<PlannerVisualization>> latest;
+    queue_.consume_all([this, &latest](PlannerVisualization* visualization) {
+      auto& slot = latest[visualization->topic];
+      if (slot)
+      {
+        num_dropped_++;
+      }
+      slot.reset(visualization);
+    });
+
+    for (const auto& [topic, visualization] : latest)
+    {
+      if (running_)
+      {
+        publish(*visualization);
+      }
+    }
+  }
+}
+
+void PlannerVisualizationSink::publish(const PlannerVisualization& visualization)
+{
+  if (!rclcpp::ok())
+  {
+    num_dropped_++;
+    return;
+  }
+
+  rclcpp::Publisher<visualization_msgs::msg::MarkerArray>::SharedPtr publisher;
+  {
+    std::lock_guard<std::mutex> lock(publishers_mutex_);
+    if (!node_)
+    {
+      node_ = std::make_shared<rclcpp::Node>("planner_visualization_rclcpp_node");
+    }
+    auto& topic_publisher = publishers_[visualization.topic];
+    if (!topic_publisher)
+    {
+      topic_publisher = node_->create_publisher<visualization_msgs::msg::MarkerArray>(visualization.topic,
+                                                                                       rclcpp::SystemDefaultsQoS());
+    }
+    publisher = topic_publisher;
+  }
+
+  publisher->publish(toMarkerArray(visualization));
+  num_published_++;
+}
+
+visualization_msgs::msg::MarkerArray PlannerVisualizationSink::toMarkerArray(const PlannerVisualization& visualization)
+{
+  bool is_graph = visualization.type == PlannerVisualization::Type::GRAPH;
+  std::string points_ns = visualization.ns + (is_graph ? "rgg_vertex" : "path");
+  std::string second_ns = visualization.ns + (is_graph ? "rgg_edges" : "costs");
+  auto stamp = rclcpp::Clock().now();
+
+  // Clear All previous markers, in the same message so that RVIZ never shows the old and new ones together
+  visualization_msgs::msg::MarkerArray marker_array;
+  visualization_msgs::msg::Marker clear_points, clear_second;
+  clear_points.id = 0;
+  clear_second.id = 0;
+  clear_points.ns = points_ns;
+  clear_second.ns = second_ns;
+  clear_points.action = visualization_msgs::msg::Marker::DELETEALL;
+  clear_second.action = visualization_msgs::msg::Marker::DELETEALL;
+  marker_array.markers.push_back(clear_points);
+  marker_array.markers.push_back(clear_second);
+
+  if (is_graph)
+  {
+    visualization_msgs::msg::Marker sphere;
+    sphere.header.frame_id = "map";
+    sphere.header.stamp = stamp;
+    sphere.ns = points_ns;
+    sphere.id = 0;
+    sphere.type = visualization_msgs::msg::Marker::SPHERE_LIST;
+    sphere.action = visualization_msgs::msg::Marker::ADD;
+    sphere.scale.x = 0.15;
+    sphere.scale.y = 0.15;
+    sphere.scale.z = 0.15;
+    sphere.points = visualization.points;
+    sphere.colors.assign(sphere.points.size(), visualization.color);
+    marker_array.markers.push_back(sphere);
+
+    visualization_msgs::msg::Marker line_strip;
+    line_strip.header.frame_id = "map";
+    line_strip.header.stamp = stamp;
+    line_strip.ns = second_ns;
+    line_strip.id = 0;
+    line_strip.type = visualization_msgs::msg::Marker::LINE_LIST;
+    line_strip.action = visualization_msgs::msg::Marker::ADD;
+    line_strip.lifetime = rclcpp::Duration::from_seconds(0);
+    line_strip.scale.x = 0.01;
+    line_strip.scale.y = 0.01;
+    line_strip.scale.z = 0.01;
+    line_strip.color = visualization.color;
+    line_strip.points = visualization.edges;
+    line_strip.colors.assign(line_strip.points.size(), visualization.color);
+    marker_array.markers.push_back(line_strip);
+    return marker_array;
+  }
+
+  visualization_msgs::msg::Marker line_strip;
+  line_strip.header.frame_id = "map";
+  line_strip.header.stamp = stamp;
+  line_strip.ns = points_ns;
+  line_strip.id = 0;
+  line_strip.type = visualization_msgs::msg::Marker::LINE_LIST;
+  line_strip.action = visualization_msgs::msg::Marker::ADD;
+  line_strip.lifetime = rclcpp::Duration::from_seconds(0);
+  line_strip.scale.x = 0.1;
+  line_strip.scale.y = 0.1;
+  line_strip.scale.z = 0.1;
+  line_strip.color = visualization.color;
+
+  for (std::size_t i = 1; i < visualization.points.size(); i++)
+  {
+    line_strip.points.push_back(visualization.points[i - 1]);
+    line_strip.colors.push_back(visualization.color);
+    line_strip.points.push_back(visualization.points[i]);
+    line_strip.colors.push_back(visualization.color);
+
+    if (i - 1 < visualization.labels.size())
+    {
+      visualization_msgs::msg::Marker text;
+      text.header.frame_id = "map";
+      text.header.stamp = stamp;
+      text.ns = second_ns;
+      text.id = visualization.label_ids[i - 1];
+      text.type = visualization_msgs::msg::Marker::TEXT_VIEW_FACING;
+      text.action = visualization_msgs::msg::Marker::ADD;
+      text.lifetime = rclcpp::Duration::from_seconds(visualization.label_lifetime);
+      text.text = visualization.labels[i - 1];
+      text.pose.position = visualization.points[i - 1];
+      text.pose.position.z += 0.5;
+      text.scale.x = 0.3;
+      text.scale.y = 0.3;
+      text.scale.z = 0.3;
+      text.color.a = 1.0;
+      text.color.r = 1.0;
+      marker_array.markers.push_back(text);
+    }
+  }
+  marker_array.markers.push_back(line_strip);
+  return marker_array;
+}
+}  // namespace vox_nav_planning
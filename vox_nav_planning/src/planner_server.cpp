@@ -15,13 +15,14 @@
 // limitations under the License.
 
 #include "vox_nav_planning/planner_server.hpp"
+#include "vox_nav_utilities/tracing.hpp"
 
 using namespace std::chrono_literals;
 
 namespace vox_nav_planning
 {
-  PlannerServer::PlannerServer()
-  : Node("vox_nav_planning_server_rclcpp_node"),
+  PlannerServer::PlannerServer(const rclcpp::NodeOptions & options)
+  : Node("vox_nav_planning_server_rclcpp_node", options),
     pc_loader_("vox_nav_planning", "vox_nav_planning::PlannerCore"),
     planner_id_("SE2Planner"),
     planner_type_("vox_nav_planning::SE2Planner")
@@ -96,6 +97,15 @@ namespace vox_nav_planning
       std::bind(&PlannerServer::handle_cancel, this, std::placeholders::_1),
       std::bind(&PlannerServer::handle_accepted, this, std::placeholders::_1));
 
+    get_plan_callback_group_ = this->create_callback_group(
+      rclcpp::CallbackGroupType::MutuallyExclusive);
+    get_plan_service_ = this->create_service<nav_msgs::srv::GetPlan>(
+      "vox_nav/planning/get_plan",
+      std::bind(
+        &PlannerServer::getPlanCallback, this, std::placeholders::_1,
+        std::placeholders::_2),
+      rmw_qos_profile_services_default, get_plan_callback_group_);
+
     tf_buffer_ = std::make_unique<tf2_ros::Buffer>(this->get_clock());
     tf_listener_ = std::make_shared<tf2_ros::TransformListener>(*tf_buffer_);
   }
@@ -215,6 +225,31 @@ namespace vox_nav_planning
     loop_rate.sleep();
   }
 
+  void PlannerServer::getPlanCallback(
+    const std::shared_ptr<nav_msgs::srv::GetPlan::Request> request,
+    std::shared_ptr<nav_msgs::srv::GetPlan::Response> response)
+  {
+    geometry_msgs::msg::PoseStamped start_pose = request->start;
+    if (start_pose.header.frame_id.empty()) {
+      vox_nav_utilities::getCurrentPose(start_pose, *tf_buffer_, "map", "base_link", 0.1);
+    }
+
+    RCLCPP_INFO(
+      this->get_logger(), "Received a planning request from (%.3f, %.3f) to (%.3f, %.3f)",
+      start_pose.pose.position.x, start_pose.pose.position.y,
+      request->goal.pose.position.x, request->goal.pose.position.y);
+
+    response->plan.poses = getPlan(start_pose, request->goal, planner_id_);
+    response->plan.header.frame_id = "map";
+    response->plan.header.stamp = now();
+
+    if (response->plan.poses.empty()) {
+      RCLCPP_WARN(
+        get_logger(), "Planning algorithm %s failed to generate a valid path",
+        planner_id_.c_str());
+    }
+  }
+
   std::vector<geometry_msgs::msg::PoseStamped>
   PlannerServer::getPlan(
     const geometry_msgs::msg::PoseStamped & start,
@@ -222,6 +257,7 @@ namespace vox_nav_planning
     const std::string & planner_id)
   {
     if (planners_.find(planner_id) != planners_.end()) {
+      VOX_NAV_TRACE_SCOPE("createPlan", "planning");
       std::vector<geometry_msgs::msg::PoseStamped> plan =
         planners_[planner_id]->createPlan(start, goal);
       return plan;
@@ -238,11 +274,5 @@ namespace vox_nav_planning
 
 }  // namespace vox_nav_planning
 
-int main(int argc, char ** argv)
-{
-  rclcpp::init(argc, argv);
-  auto node = std::make_shared<vox_nav_planning::PlannerServer>();
-  rclcpp::spin(node->get_node_base_interface());
-  rclcpp::shutdown();
-  return 0;
-}
+#include "rclcpp_components/register_node_macro.hpp"
+RCLCPP_COMPONENTS_REGISTER_NODE(vox_nav_planning::PlannerServer)
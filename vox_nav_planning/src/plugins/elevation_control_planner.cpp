@@ -14,6 +14,7 @@
 
 #include "vox_nav_planning/plugins/elevation_control_planner.hpp"
 #include <pluginlib/class_list_macros.hpp>
+#include "vox_nav_utilities/tracing.hpp"
 
 #include <string>
 #include <memory>
@@ -48,6 +49,7 @@ namespace vox_nav_planning
     // common parameters are declared in server
     parent->declare_parameter(plugin_name + ".se2_space", "REEDS");
     parent->declare_parameter(plugin_name + ".rho", 1.5);
+    parent->declare_parameter(plugin_name + ".use_direct_informed_sampler", false);
     parent->declare_parameter(plugin_name + ".state_space_boundries.minx", -10.0);
     parent->declare_parameter(plugin_name + ".state_space_boundries.maxx", 10.0);
     parent->declare_parameter(plugin_name + ".state_space_boundries.miny", -10.0);
@@ -67,6 +69,8 @@ namespace vox_nav_planning
     parent->get_parameter("octomap_voxel_size", octomap_voxel_size_);
     parent->get_parameter(plugin_name + ".se2_space", selected_se2_space_name_);
     parent->get_parameter(plugin_name + ".rho", rho_);
+    parent->get_parameter(
+      plugin_name + ".use_direct_informed_sampler", use_direct_informed_sampler_);
 
     se2_bounds_->setLow(
       0, parent->get_parameter(plugin_name + ".state_space_boundries.minx").as_double());
@@ -215,7 +219,7 @@ namespace vox_nav_planning
       nearest_elevated_surfel_to_goal_,
       start,
       goal,
-      elevated_surfel_cloud_);
+      *map_snapshot_->elevatedSurfelKdTree());
 
     nearest_elevated_surfel_to_start_.pose.orientation = start.pose.orientation;
     nearest_elevated_surfel_to_goal_.pose.orientation = goal.pose.orientation;
@@ -253,6 +257,21 @@ namespace vox_nav_planning
       si,
       logger_);
 
+    // With the direct informed sampler, InformedSGCP samples its informed set on the elevated
+    // surfels only
+    auto informed_sgcp = std::dynamic_pointer_cast<ompl::control::InformedSGCP>(planner);
+    if (informed_sgcp) {
+      informed_sgcp->setUseDirectInformedSampler(use_direct_informed_sampler_);
+    }
+    if (informed_sgcp && use_direct_informed_sampler_) {
+      std::vector<Eigen::Vector3d> surfel_cells;
+      surfel_cells.reserve(elevated_surfel_poses_msg_->poses.size());
+      for (const auto & pose : elevated_surfel_poses_msg_->poses) {
+        surfel_cells.emplace_back(pose.position.x, pose.position.y, pose.position.z);
+      }
+      informed_sgcp->setInformedSamplerCells(surfel_cells);
+    }
+
     si->setValidStateSamplerAllocator(
       std::bind(
         &ElevationControlPlanner::
@@ -326,6 +345,7 @@ namespace vox_nav_planning
 
   bool ElevationControlPlanner::isStateValid(const ompl::base::State * state)
   {
+    VOX_NAV_TRACE_FUNCTION("planning");
     const auto * cstate = state->as<ompl::base::ElevationStateSpace::StateType>();
     // cast the abstract state type to the type we expect
     const auto * so2 = cstate->as<ompl::base::SO2StateSpace::StateType>(0);
@@ -390,58 +410,15 @@ namespace vox_nav_planning
         continue;
       }
 
-      auto original_octomap_octree =
-        dynamic_cast<octomap::OcTree *>(octomap_msgs::fullMsgToMap(response->collision_octomap));
-      original_octomap_octree_ = std::make_shared<octomap::OcTree>(*original_octomap_octree);
-
-      auto elevated_surfel_octomap_octree =
-        dynamic_cast<octomap::OcTree *>(octomap_msgs::fullMsgToMap(
-          response->elevated_surfel_octomap));
-      elevated_surfel_octomap_octree_ = std::make_shared<octomap::OcTree>(
-        *elevated_surfel_octomap_octree);
-
-      delete original_octomap_octree;
-      delete elevated_surfel_octomap_octree;
-
-      auto elevated_surfels_fcl_octree =
-        std::make_shared<fcl::OcTreef>(elevated_surfel_octomap_octree_);
-      elevated_surfels_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
-        std::shared_ptr<fcl::CollisionGeometryf>(elevated_surfels_fcl_octree));
-
-      auto original_octomap_fcl_octree = std::make_shared<fcl::OcTreef>(original_octomap_octree_);
-      original_octomap_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
-        std::shared_ptr<fcl::CollisionGeometryf>(original_octomap_fcl_octree));
-
-
-      elevated_surfel_poses_msg_ = std::make_shared<geometry_msgs::msg::PoseArray>(
-        response->elevated_surfel_poses);
-
-      /*for (sensor_msgs::PointCloud2ConstIterator<float> it(response->traversable_cloud, "x");
-        it != it.end(); ++it)
-      {
-        geometry_msgs::msg::Pose pose;
-        pose.position.x = it[0];
-        pose.position.y = it[1];
-        pose.position.z = it[2];
-        pose.orientation = vox_nav_utilities::getMsgQuaternionfromRPY(
-          0,
-          0,
-          0);
-        elevated_surfel_poses_msg_->poses.push_back(pose);
-      }*/
-
-      for (auto && i : response->elevated_surfel_poses.poses) {
-        pcl::PointSurfel surfel;
-        surfel.x = i.position.x;
-        surfel.y = i.position.y;
-        surfel.z = i.position.z;
-        double r, p, y;
-        vox_nav_utilities::getRPYfromMsgQuaternion(i.orientation, r, p, y);
-        surfel.normal_x = r;
-        surfel.normal_y = p;
-        surfel.normal_z = y;
-        elevated_surfel_cloud_->points.push_back(surfel);
-      }
+      // Decoded once per map version and shared with the other plugins. This planner
+      // checks collisions against the collision octomap rather than the original one
+      map_snapshot_ = vox_nav_utilities::MapSnapshotRegistry::instance().acquire(response);
+      original_octomap_octree_ = map_snapshot_->collisionOctree();
+      original_octomap_collision_object_ = map_snapshot_->collisionCollisionObject();
+      elevated_surfel_octomap_octree_ = map_snapshot_->elevatedSurfelOctree();
+      elevated_surfels_collision_object_ = map_snapshot_->elevatedSurfelCollisionObject();
+      elevated_surfel_poses_msg_ = map_snapshot_->elevatedSurfelPoses();
+      elevated_surfel_cloud_ = map_snapshot_->elevatedSurfelCloud();
 
       RCLCPP_INFO(
         logger_,
@@ -461,11 +438,14 @@ namespace vox_nav_planning
   ompl::base::ValidStateSamplerPtr ElevationControlPlanner::allocValidStateSampler(
     const ompl::base::SpaceInformation * si)
   {
-    auto valid_sampler = std::make_shared<ompl::base::OctoCellValidStateSampler>(
-      control_simple_setup_->getSpaceInformation(),
+    // The surfels and their KD-tree are the ones of the map snapshot, shared and not copied
+    auto valid_sampler = std::make_shared<ompl::base::SurfelValidStateSampler>(
+      control_simple_setup_->getSpaceInformation().get(),
+      map_snapshot_->elevatedSurfelCloud(),
+      map_snapshot_->elevatedSurfelKdTree());
+    valid_sampler->updateSearchArea(
       nearest_elevated_surfel_to_start_,
-      nearest_elevated_surfel_to_goal_,
-      elevated_surfel_poses_msg_);
+      nearest_elevated_surfel_to_goal_);
     return valid_sampler;
   }
 
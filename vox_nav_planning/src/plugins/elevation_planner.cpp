@@ -14,6 +14,7 @@
 
 #include "vox_nav_planning/plugins/elevation_planner.hpp"
 #include <pluginlib/class_list_macros.hpp>
+#include "vox_nav_utilities/tracing.hpp"
 
 #include <memory>
 #include <random>
@@ -165,7 +166,7 @@ namespace vox_nav_planning
 
     vox_nav_utilities::determineValidNearestGoalStart(
       nearest_elevated_surfel_to_start_, nearest_elevated_surfel_to_goal_,
-      start, goal, elevated_surfel_cloud_);
+      start, goal, *map_snapshot_->elevatedSurfelKdTree());
 
     nearest_elevated_surfel_to_start_.pose.orientation = start.pose.orientation;
     nearest_elevated_surfel_to_goal_.pose.orientation = goal.pose.orientation;
@@ -262,6 +263,7 @@ namespace vox_nav_planning
 
   bool ElevationPlanner::isStateValid(const ompl::base::State * state)
   {
+    VOX_NAV_TRACE_FUNCTION("planning");
     const auto * cstate = state->as<ompl::base::ElevationStateSpace::StateType>();
     // cast the abstract state type to the type we expect
     const auto * so2 = cstate->as<ompl::base::SO2StateSpace::StateType>(0);
@@ -332,44 +334,14 @@ namespace vox_nav_planning
         continue;
       }
 
-      auto original_octomap_octree = dynamic_cast<octomap::OcTree *>(
-        octomap_msgs::fullMsgToMap(response->original_octomap));
-      original_octomap_octree_ =
-        std::make_shared<octomap::OcTree>(*original_octomap_octree);
-
-      auto elevated_surfel_octomap_octree = dynamic_cast<octomap::OcTree *>(
-        octomap_msgs::fullMsgToMap(response->elevated_surfel_octomap));
-      elevated_surfel_octomap_octree_ =
-        std::make_shared<octomap::OcTree>(*elevated_surfel_octomap_octree);
-
-      delete original_octomap_octree;
-      delete elevated_surfel_octomap_octree;
-
-      auto elevated_surfels_fcl_octree =
-        std::make_shared<fcl::OcTreef>(elevated_surfel_octomap_octree_);
-      elevated_surfels_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
-        std::shared_ptr<fcl::CollisionGeometryf>(elevated_surfels_fcl_octree));
-
-      auto original_octomap_fcl_octree =
-        std::make_shared<fcl::OcTreef>(original_octomap_octree_);
-      original_octomap_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
-        std::shared_ptr<fcl::CollisionGeometryf>(original_octomap_fcl_octree));
-
-      elevated_surfel_poses_msg_ =
-        std::make_shared<geometry_msgs::msg::PoseArray>(
-        response->elevated_surfel_poses);
-      for (auto && i : elevated_surfel_poses_msg_->poses) {
-        pcl::PointSurfel surfel;
-        surfel.x = i.position.x;
-        surfel.y = i.position.y;
-        surfel.z = i.position.z;
-        double r, p, y;
-        vox_nav_utilities::getRPYfromMsgQuaternion(i.orientation, r, p, y);
-        surfel.normal_x = r;
-        surfel.normal_y = p;
-        surfel.normal_z = y;
-        elevated_surfel_cloud_->points.push_back(surfel);
-      }
+      // Decoded once per map version and shared with the other plugins
+      map_snapshot_ = vox_nav_utilities::MapSnapshotRegistry::instance().acquire(response);
+      original_octomap_octree_ = map_snapshot_->originalOctree();
+      original_octomap_collision_object_ = map_snapshot_->originalCollisionObject();
+      elevated_surfel_octomap_octree_ = map_snapshot_->elevatedSurfelOctree();
+      elevated_surfels_collision_object_ = map_snapshot_->elevatedSurfelCollisionObject();
+      elevated_surfel_poses_msg_ = map_snapshot_->elevatedSurfelPoses();
+      elevated_surfel_cloud_ = map_snapshot_->elevatedSurfelCloud();
 
       RCLCPP_INFO(
         logger_,
@@ -412,9 +384,14 @@ namespace vox_nav_planning
   ompl::base::ValidStateSamplerPtr ElevationPlanner::allocValidStateSampler(
     const ompl::base::SpaceInformation * si)
   {
-    auto valid_sampler = std::make_shared<ompl::base::OctoCellValidStateSampler>(
-      simple_setup_->getSpaceInformation(), nearest_elevated_surfel_to_start_,
-      nearest_elevated_surfel_to_goal_, elevated_surfel_poses_msg_);
+    // The surfels and their KD-tree are the ones of the map snapshot, shared and not copied
+    auto valid_sampler = std::make_shared<ompl::base::SurfelValidStateSampler>(
+      simple_setup_->getSpaceInformation().get(),
+      map_snapshot_->elevatedSurfelCloud(),
+      map_snapshot_->elevatedSurfelKdTree());
+    valid_sampler->updateSearchArea(
+      nearest_elevated_surfel_to_start_,
+      nearest_elevated_surfel_to_goal_);
     return valid_sampler;
   }
 
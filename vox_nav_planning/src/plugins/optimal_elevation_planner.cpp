@@ -14,6 +14,7 @@
 
 #include "vox_nav_planning/plugins/optimal_elevation_planner.hpp"
 #include <pluginlib/class_list_macros.hpp>
+#include "vox_nav_utilities/tracing.hpp"
 #include <string>
 #include <memory>
 #include <vector>
@@ -575,6 +576,7 @@ namespace vox_nav_planning
 
   bool OptimalElevationPlanner::isStateValid(const ompl::base::State * state)
   {
+    VOX_NAV_TRACE_FUNCTION("planning");
     const auto * cstate = state->as<ompl::base::ElevationStateSpace::StateType>();
     // cast the abstract state type to the type we expect
     const auto * so2 = cstate->as<ompl::base::SO2StateSpace::StateType>(0);
@@ -675,44 +677,15 @@ namespace vox_nav_planning
         continue;
       }
 
-      auto original_octomap_octree =
-        dynamic_cast<octomap::OcTree *>(octomap_msgs::fullMsgToMap(response->original_octomap));
-      original_octomap_octree_ = std::make_shared<octomap::OcTree>(*original_octomap_octree);
-
-      auto elevated_surfel_octomap_octree =
-        dynamic_cast<octomap::OcTree *>(octomap_msgs::fullMsgToMap(
-          response->elevated_surfel_octomap));
-      elevated_surfel_octomap_octree_ = std::make_shared<octomap::OcTree>(
-        *elevated_surfel_octomap_octree);
-
-      delete original_octomap_octree;
-      delete elevated_surfel_octomap_octree;
-
-      auto elevated_surfels_fcl_octree =
-        std::make_shared<fcl::OcTreef>(elevated_surfel_octomap_octree_);
-      elevated_surfels_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
-        std::shared_ptr<fcl::CollisionGeometryf>(elevated_surfels_fcl_octree));
-
-      auto original_octomap_fcl_octree = std::make_shared<fcl::OcTreef>(original_octomap_octree_);
-      original_octomap_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
-        std::shared_ptr<fcl::CollisionGeometryf>(original_octomap_fcl_octree));
-
-      elevated_surfel_poses_msg_ = std::make_shared<geometry_msgs::msg::PoseArray>(
-        response->elevated_surfel_poses);
-      for (auto && i : elevated_surfel_poses_msg_->poses) {
-        pcl::PointSurfel surfel;
-        surfel.x = i.position.x;
-        surfel.y = i.position.y;
-        surfel.z = i.position.z;
-        double r, p, y;
-        vox_nav_utilities::getRPYfromMsgQuaternion(i.orientation, r, p, y);
-        surfel.normal_x = r;
-        surfel.normal_y = p;
-        surfel.normal_z = y;
-        elevated_surfel_cloud_->points.push_back(surfel);
-      }
-
-      pcl::fromROSMsg(response->traversable_elevated_cloud, *elevated_traversable_cloud_);
+      // Decoded once per map version and shared with the other plugins
+      map_snapshot_ = vox_nav_utilities::MapSnapshotRegistry::instance().acquire(response);
+      original_octomap_octree_ = map_snapshot_->originalOctree();
+      original_octomap_collision_object_ = map_snapshot_->originalCollisionObject();
+      elevated_surfel_octomap_octree_ = map_snapshot_->elevatedSurfelOctree();
+      elevated_surfels_collision_object_ = map_snapshot_->elevatedSurfelCollisionObject();
+      elevated_surfel_poses_msg_ = map_snapshot_->elevatedSurfelPoses();
+      elevated_surfel_cloud_ = map_snapshot_->elevatedSurfelCloud();
+      elevated_traversable_cloud_ = map_snapshot_->traversableElevatedCloud();
 
       RCLCPP_INFO(
         logger_,
@@ -15,6 +15,7 @@
 #include "vox_nav_planning/plugins/osm_elevation_planner.hpp"
 #include <pluginlib/class_list_macros.hpp>
 
+#include <chrono>
 #include <memory>
 #include <random>
 #include <string>
@@ -55,6 +56,14 @@ namespace vox_nav_planning
     parent->declare_parameter(plugin_name + ".control_boundries.maxv", 0.5);
     parent->declare_parameter(plugin_name + ".control_boundries.minw", -0.5);
     parent->declare_parameter(plugin_name + ".control_boundries.maxw", 0.5);
+    parent->declare_parameter(plugin_name + ".use_road_graph", true);
+    parent->declare_parameter(plugin_name + ".road_graph.connection_radius", 1.5);
+    parent->declare_parameter(plugin_name + ".road_graph.max_neighbors", 8);
+    parent->declare_parameter(plugin_name + ".road_graph.way_link_max_distance", 5.0);
+    parent->declare_parameter(plugin_name + ".road_graph.climb_weight", 0.0);
+    parent->declare_parameter(plugin_name + ".road_graph.snap_max_distance", 10.0);
+    parent->declare_parameter(plugin_name + ".road_graph.smooth_path", true);
+    parent->declare_parameter(plugin_name + ".road_graph.smoothing_spacing", 4.0);
 
     parent->get_parameter("planner_name", planner_name_);
     parent->get_parameter("planner_timeout", planner_timeout_);
@@ -62,6 +71,17 @@ namespace vox_nav_planning
     parent->get_parameter(plugin_name + ".se2_space", selected_se2_space_name_);
     parent->get_parameter(plugin_name + ".rho", rho_);
     parent->get_parameter(plugin_name + ".goal_tolerance", goal_tolerance_);
+    parent->get_parameter(plugin_name + ".use_road_graph", use_road_graph_);
+    parent->get_parameter(
+      plugin_name + ".road_graph.connection_radius", road_graph_params_.connection_radius);
+    parent->get_parameter(plugin_name + ".road_graph.max_neighbors", road_graph_params_.max_neighbors);
+    parent->get_parameter(
+      plugin_name + ".road_graph.way_link_max_distance", road_graph_params_.way_link_max_distance);
+    parent->get_parameter(plugin_name + ".road_graph.climb_weight", road_graph_params_.climb_weight);
+    parent->get_parameter(
+      plugin_name + ".road_graph.snap_max_distance", road_graph_params_.snap_max_distance);
+    parent->get_parameter(plugin_name + ".road_graph.smooth_path", smooth_road_path_);
+    parent->get_parameter(plugin_name + ".road_graph.smoothing_spacing", road_path_smoothing_spacing_);
 
     se2_bounds_->setLow(
       0, parent->get_parameter(plugin_name + ".state_space_boundries.minx")
@@ -94,10 +114,13 @@ namespace vox_nav_planning
 
     if (selected_se2_space_name_ == "SE2") {
       se2_space_type_ = ompl::base::ElevationStateSpace::SE2StateType::SE2;
+      road_path_se2_space_ = std::make_shared<ompl::base::SE2StateSpace>();
     } else if (selected_se2_space_name_ == "DUBINS") {
       se2_space_type_ = ompl::base::ElevationStateSpace::SE2StateType::DUBINS;
+      road_path_se2_space_ = std::make_shared<ompl::base::DubinsStateSpace>(rho_);
     } else {
       se2_space_type_ = ompl::base::ElevationStateSpace::SE2StateType::REDDSSHEEP;
+      road_path_se2_space_ = std::make_shared<ompl::base::ReedsSheppStateSpace>(rho_);
     }
 
     typedef std::shared_ptr<fcl::CollisionGeometryf> CollisionGeometryPtr_t;
@@ -155,6 +178,16 @@ namespace vox_nav_planning
     }
     start_pose_ = start;
     goal_pose_ = goal;
+
+    if (use_road_graph_) {
+      auto road_plan = createRoadGraphPlan(start, goal);
+      if (!road_plan.empty()) {
+        return road_plan;
+      }
+      RCLCPP_WARN(
+        logger_, "No path over the road graph, falling back to %s", planner_name_.c_str());
+    }
+
     // set the start and goal states
     double start_yaw, goal_yaw, nan;
     vox_nav_utilities::getRPYfromMsgQuaternion(
@@ -279,6 +312,138 @@ namespace vox_nav_planning
     return true;
   }
 
+  std::vector<geometry_msgs::msg::PoseStamped> OSMElevationPlanner::createRoadGraphPlan(
+    const geometry_msgs::msg::PoseStamped & start,
+    const geometry_msgs::msg::PoseStamped & goal)
+  {
+    if (!road_graph_) {
+      return std::vector<geometry_msgs::msg::PoseStamped>();
+    }
+    vox_nav_utilities::RoadPathResult result;
+    auto t0 = std::chrono::steady_clock::now();
+    bool found = road_graph_->plan(
+      Eigen::Vector3d(start.pose.position.x, start.pose.position.y, start.pose.position.z),
+      Eigen::Vector3d(goal.pose.position.x, goal.pose.position.y, goal.pose.position.z),
+      result);
+    double elapsed_ms = std::chrono::duration<double, std::milli>(
+      std::chrono::steady_clock::now() - t0).count();
+    if (!found) {
+      return std::vector<geometry_msgs::msg::PoseStamped>();
+    }
+
+    auto plan_poses = roadPointsToPlan(result.points, start, goal);
+    RCLCPP_INFO(
+      logger_, "Found a road graph plan with %d poses, cost %.2f, %d vertices expanded in %.2f ms",
+      static_cast<int>(plan_poses.size()), result.cost, result.expanded_vertices, elapsed_ms);
+    return plan_poses;
+  }
+
+  std::vector<geometry_msgs::msg::PoseStamped> OSMElevationPlanner::roadPointsToPlan(
+    const std::vector<Eigen::Vector3d> & road_points,
+    const geometry_msgs::msg::PoseStamped & start,
+    const geometry_msgs::msg::PoseStamped & goal)
+  {
+    auto to_pose = [&start](double x, double y, double z, double yaw) {
+        tf2::Quaternion quat;
+        quat.setRPY(0, 0, yaw);
+        geometry_msgs::msg::PoseStamped pose;
+        pose.header.frame_id = start.header.frame_id;
+        pose.header.stamp = rclcpp::Clock().now();
+        pose.pose.position.x = x;
+        pose.pose.position.y = y;
+        pose.pose.position.z = z;
+        pose.pose.orientation = tf2::toMsg(quat);
+        return pose;
+      };
+    double start_yaw, goal_yaw, nan;
+    vox_nav_utilities::getRPYfromMsgQuaternion(start.pose.orientation, nan, nan, start_yaw);
+    vox_nav_utilities::getRPYfromMsgQuaternion(goal.pose.orientation, nan, nan, goal_yaw);
+
+    // The road points run between the vertices nearest to start and goal, which can be up to
+    // snap_max_distance away from them, so the plan starts and ends at the requested poses
+    constexpr double kSamePoint = 1e-3;
+    const Eigen::Vector3d start_point(start.pose.position.x, start.pose.position.y, start.pose.position.z);
+    const Eigen::Vector3d goal_point(goal.pose.position.x, goal.pose.position.y, goal.pose.position.z);
+    std::vector<Eigen::Vector3d> points{start_point};
+    points.reserve(road_points.size() + 2);
+    for (const auto & point : road_points) {
+      if ((point - points.back()).norm() > kSamePoint) {
+        points.push_back(point);
+      }
+    }
+    if (points.size() > 1 && (goal_point - points.back()).norm() <= kSamePoint) {
+      points.back() = goal_point;
+    } else {
+      points.push_back(goal_point);
+    }
+
+    // Heading of each point along the path, the first and last take the requested ones
+    std::vector<double> yaws(points.size(), start_yaw);
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+      Eigen::Vector3d d = points[i + 1] - points[i];
+      yaws[i] = std::atan2(d.y(), d.x());
+    }
+    yaws.front() = start_yaw;
+    yaws.back() = goal_yaw;
+
+    // Spacing of the poses on the smoothed curves, close to the one of the road points
+    constexpr double kRoadPathResolution = 0.25;
+    std::vector<geometry_msgs::msg::PoseStamped> plan_poses;
+    ompl::base::ScopedState<ompl::base::SE2StateSpace> from(road_path_se2_space_), to(road_path_se2_space_),
+    interpolated(road_path_se2_space_);
+    // Poses from point i up to, not including, point j on a curve of the selected SE2 space
+    auto append_segment = [&](size_t i, size_t j) {
+        const auto & a = points[i];
+        const auto & b = points[j];
+        from->setXY(a.x(), a.y());
+        from->setYaw(yaws[i]);
+        to->setXY(b.x(), b.y());
+        to->setYaw(yaws[j]);
+        double length = road_path_se2_space_->distance(from.get(), to.get());
+        int steps = std::max(1, static_cast<int>(std::ceil(length / kRoadPathResolution)));
+        for (int k = 0; k < steps; k++) {
+          double t = static_cast<double>(k) / steps;
+          road_path_se2_space_->interpolate(from.get(), to.get(), t, interpolated.get());
+          plan_poses.push_back(
+            to_pose(
+              interpolated->getX(), interpolated->getY(), a.z() + t * (b.z() - a.z()),
+              interpolated->getYaw()));
+        }
+      };
+
+    bool kinematic = se2_space_type_ != ompl::base::ElevationStateSpace::SE2StateType::SE2;
+    if (!smooth_road_path_ || !kinematic) {
+      // Road points as they are, only the legs joining them to start and goal are curves
+      const size_t last = points.size() - 1;
+      append_segment(0, 1);
+      for (size_t i = 1; i + 1 < last; i++) {
+        plan_poses.push_back(to_pose(points[i].x(), points[i].y(), points[i].z(), yaws[i]));
+      }
+      if (last > 1) {
+        append_segment(last - 1, last);
+      }
+      plan_poses.push_back(to_pose(goal_point.x(), goal_point.y(), goal_point.z(), goal_yaw));
+      return plan_poses;
+    }
+
+    // Waypoints every road_path_smoothing_spacing_ meters along the road, plus both ends
+    std::vector<size_t> waypoints{0};
+    double travelled = 0.0;
+    for (size_t i = 1; i + 1 < points.size(); i++) {
+      travelled += (points[i] - points[i - 1]).norm();
+      if (travelled >= road_path_smoothing_spacing_) {
+        waypoints.push_back(i);
+        travelled = 0.0;
+      }
+    }
+    waypoints.push_back(points.size() - 1);
+    for (size_t w = 0; w + 1 < waypoints.size(); w++) {
+      append_segment(waypoints[w], waypoints[w + 1]);
+    }
+    plan_poses.push_back(to_pose(goal_point.x(), goal_point.y(), goal_point.z(), goal_yaw));
+    return plan_poses;
+  }
+
   void OSMElevationPlanner::setupMap()
   {
     const std::lock_guard<std::mutex> lock(map_mutex_);
@@ -328,6 +493,14 @@ namespace vox_nav_planning
           logger_, "Received a valid map with %i points",
           osm_road_topology_pcd_->points.size());
 
+        if (use_road_graph_) {
+          road_graph_ = std::make_shared<vox_nav_utilities::RoadGraph>(
+            osm_road_topology_pcd_, road_graph_params_);
+          RCLCPP_INFO(
+            logger_, "Built a road graph with %d vertices and %d edges",
+            static_cast<int>(road_graph_->numVertices()), static_cast<int>(road_graph_->numEdges()));
+        }
+
       } else {
         std::this_thread::sleep_for(std::chrono::seconds(1));
         RCLCPP_INFO(
@@ -14,6 +14,7 @@
 
 #include "vox_nav_planning/plugins/se2_planner.hpp"
 #include <pluginlib/class_list_macros.hpp>
+#include "vox_nav_utilities/tracing.hpp"
 
 #include <string>
 #include <memory>
@@ -48,6 +49,10 @@ namespace vox_nav_planning
     parent->declare_parameter(plugin_name + ".state_space_boundries.maxy", 10.0);
     parent->declare_parameter(plugin_name + ".state_space_boundries.minyaw", -3.14);
     parent->declare_parameter(plugin_name + ".state_space_boundries.maxyaw", 3.14);
+    parent->declare_parameter(plugin_name + ".use_projected_map", false);
+    parent->declare_parameter(plugin_name + ".projected_map.max_step_height", 0.2);
+    parent->declare_parameter(plugin_name + ".projected_map.cost_decay_distance", 1.0);
+    parent->declare_parameter(plugin_name + ".projected_map.cost_weight", 0.0);
 
     parent->get_parameter("planner_name", planner_name_);
     parent->get_parameter("planner_timeout", planner_timeout_);
@@ -56,6 +61,13 @@ namespace vox_nav_planning
     parent->get_parameter(plugin_name + ".se2_space", selected_se2_space_name_);
     parent->get_parameter(plugin_name + ".rho", rho_);
     parent->get_parameter(plugin_name + ".z_elevation", z_elevation_);
+    parent->get_parameter(plugin_name + ".use_projected_map", use_projected_map_);
+    parent->get_parameter(
+      plugin_name + ".projected_map.max_step_height", projected_map_params_.max_step_height);
+    parent->get_parameter(
+      plugin_name + ".projected_map.cost_decay_distance",
+      projected_map_params_.cost_decay_distance);
+    parent->get_parameter(plugin_name + ".projected_map.cost_weight", projected_map_cost_weight_);
 
     se2_bounds_->setLow(
       0, parent->get_parameter(plugin_name + ".state_space_boundries.minx").as_double());
@@ -87,6 +99,14 @@ namespace vox_nav_planning
         parent->get_parameter("robot_body_dimens.y").as_double(),
         parent->get_parameter("robot_body_dimens.z").as_double()));
 
+    // The projected map checks the footprint of the same box, what is above it passes over it
+    projected_map_params_.footprint_length =
+      parent->get_parameter("robot_body_dimens.x").as_double();
+    projected_map_params_.footprint_width =
+      parent->get_parameter("robot_body_dimens.y").as_double();
+    projected_map_params_.clearance_height =
+      parent->get_parameter("robot_body_dimens.z").as_double();
+
     fcl::CollisionObjectf robot_body_box_object(robot_body_box, fcl::Transform3f());
     robot_collision_object_ = std::make_shared<fcl::CollisionObjectf>(robot_body_box_object);
     original_octomap_octree_ = std::make_shared<octomap::OcTree>(octomap_voxel_size_);
@@ -137,9 +157,15 @@ namespace vox_nav_planning
 
     simple_setup_->setStartAndGoalStates(se2_start, se2_goal);
 
-    // objective is to minimize the planned path
-    ompl::base::OptimizationObjectivePtr objective(
-      new ompl::base::PathLengthOptimizationObjective(simple_setup_->getSpaceInformation()));
+    // objective is to minimize the planned path, weighted by the terrain cost of the projected map
+    ompl::base::OptimizationObjectivePtr objective;
+    if (projected_map_ && projected_map_cost_weight_ > 0.0) {
+      objective = std::make_shared<vox_nav_utilities::ProjectedMapCostObjective>(
+        simple_setup_->getSpaceInformation(), projected_map_, projected_map_cost_weight_);
+    } else {
+      objective = std::make_shared<ompl::base::PathLengthOptimizationObjective>(
+        simple_setup_->getSpaceInformation());
+    }
 
     simple_setup_->setOptimizationObjective(objective);
 
@@ -201,9 +227,14 @@ namespace vox_nav_planning
 
   bool SE2Planner::isStateValid(const ompl::base::State * state)
   {
+    VOX_NAV_TRACE_FUNCTION("planning");
     // cast the abstract state type to the type we expect
     const ompl::base::SE2StateSpace::StateType * se2_state =
       state->as<ompl::base::SE2StateSpace::StateType>();
+    if (projected_map_) {
+      return projected_map_->isFootprintFree(
+        se2_state->getX(), se2_state->getY(), se2_state->getYaw());
+    }
     // check validity of state Fdefined by pos & rot
     fcl::Vector3f translation(se2_state->getX(), se2_state->getY(), z_elevation_);
     tf2::Quaternion myQuaternion;
@@ -258,21 +289,27 @@ namespace vox_nav_planning
         continue;
       }
 
-      auto original_octomap_octree =
-        dynamic_cast<octomap::OcTree *>(octomap_msgs::fullMsgToMap(response->original_octomap));
-      original_octomap_octree_ = std::make_shared<octomap::OcTree>(*original_octomap_octree);
-
-      delete original_octomap_octree;
-
-      auto original_octomap_fcl_octree = std::make_shared<fcl::OcTreef>(original_octomap_octree_);
-      original_octomap_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
-        std::shared_ptr<fcl::CollisionGeometryf>(original_octomap_fcl_octree));
+      // Decoded once per map version and shared with the other plugins
+      map_snapshot_ = vox_nav_utilities::MapSnapshotRegistry::instance().acquire(response);
+      original_octomap_octree_ = map_snapshot_->originalOctree();
+      original_octomap_collision_object_ = map_snapshot_->originalCollisionObject();
 
       RCLCPP_INFO(
         logger_,
         "Recieved a valid Octomap with %d nodes, A FCL collision tree will be created from this "
         "octomap for state validity (aka collision check)", original_octomap_octree_->size());
 
+      if (use_projected_map_) {
+        // Built once per map, the planner threads only read it
+        projected_map_ = std::make_shared<const vox_nav_utilities::ProjectedMap>(
+          *original_octomap_octree_, projected_map_params_);
+        RCLCPP_INFO(
+          logger_,
+          "Projected the Octomap to a %dx%d grid with %zu lethal cells, it replaces the FCL tree "
+          "for state validity", projected_map_->width(), projected_map_->height(),
+          projected_map_->numLethalCells());
+      }
+
       simple_setup_->setStateValidityChecker(
         std::bind(&SE2Planner::isStateValid, this, std::placeholders::_1));
     }
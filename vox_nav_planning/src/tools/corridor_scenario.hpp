@@ -0,0 +1,154 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_PLANNING__TOOLS__CORRIDOR_SCENARIO_HPP_
+#define VOX_NAV_PLANNING__TOOLS__CORRIDOR_SCENARIO_HPP_
+
+#include <octomap/octomap.h>
+#include <fcl/config.h>
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+
+#include "fcl/geometry/octree/octree.h"
+#include "fcl/narrowphase/collision.h"
+#include "fcl/narrowphase/collision_object.h"
+#include "ompl/base/objectives/PathLengthOptimizationObjective.h"
+#include "ompl/control/SimpleSetup.h"
+#include "ompl/control/spaces/RealVectorControlSpace.h"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+/**
+ * The car scenario the InformedSGCP benchmarks share: a 100 m x 20 m corridor with pillars, an FCL box for the
+ * robot and a Reeds-Shepp ElevationStateSpace with speed, driven from one end of the corridor to the other.
+ */
+namespace vox_nav_planning
+{
+namespace corridor_scenario
+{
+/** \brief Pillars every 10 m, alternating sides of the corridor, so the robot has to weave through them */
+inline std::shared_ptr<fcl::CollisionObjectf> makeCorridor(double resolution)
+{
+  auto octree = std::make_shared<octomap::OcTree>(resolution);
+  for (double x = -40.0; x <= 40.0; x += 10.0)
+  {
+    double side = std::fmod(std::abs(x), 20.0) < 1e-3 ? 1.0 : -1.0;
+    for (double y = side > 0 ? -4.0 : -10.0; y <= (side > 0 ? 10.0 : 4.0); y += resolution)
+    {
+      for (double dx = -1.0; dx <= 1.0; dx += resolution)
+      {
+        for (double z = 0.0; z <= 2.0; z += resolution)
+        {
+          octree->updateNode(x + dx, y, z, true);
+        }
+      }
+    }
+  }
+  octree->updateInnerOccupancy();
+  return std::make_shared<fcl::CollisionObjectf>(
+      std::shared_ptr<fcl::CollisionGeometryf>(std::make_shared<fcl::OcTreef>(octree)));
+}
+
+/** \brief The car model of car_control_planners_benchmark, controls are acceleration and yaw rate */
+inline void propagate(const ompl::control::SpaceInformation* si, const ompl::base::State* start,
+                      const ompl::control::Control* control, const double duration, ompl::base::State* result)
+{
+  const auto* ee_start = start->as<ompl::base::ElevationStateSpace::StateType>();
+  const auto* ee_start_so2 = ee_start->as<ompl::base::SO2StateSpace::StateType>(0);
+  const auto* ee_start_xyzv = ee_start->as<ompl::base::RealVectorStateSpace::StateType>(1);
+  const double* ctrl = control->as<ompl::control::RealVectorControlSpace::ControlType>()->values;
+  double v = ee_start_xyzv->values[3];
+  double yaw = ee_start_so2->value;
+  result->as<ompl::base::ElevationStateSpace::StateType>()->setXYZV(
+      ee_start_xyzv->values[0] + duration * v * std::cos(yaw), ee_start_xyzv->values[1] + duration * v * std::sin(yaw),
+      ee_start_xyzv->values[2], v + duration * ctrl[0]);
+  result->as<ompl::base::ElevationStateSpace::StateType>()->setSO2(yaw + duration * ctrl[1]);
+  si->enforceBounds(result);
+}
+
+/** \brief Collision check of a 1.5 m x 1.5 m x 0.4 m robot box against \e obstacles, counting its calls in
+ * \e calls if given. The robot collision object is made per call, as the planner threads check states
+ * concurrently */
+inline ompl::base::StateValidityCheckerFn makeValidityChecker(const std::shared_ptr<fcl::CollisionObjectf>& obstacles,
+                                                              std::atomic<std::uint64_t>* calls = nullptr)
+{
+  auto robot_box = std::make_shared<fcl::Box<float>>(1.5, 1.5, 0.4);
+  return [obstacles, robot_box, calls](const ompl::base::State* state) {
+    if (calls)
+    {
+      (*calls)++;
+    }
+    const auto* cstate = state->as<ompl::base::ElevationStateSpace::StateType>();
+    const auto* so2 = cstate->as<ompl::base::SO2StateSpace::StateType>(0);
+    const auto* xyzv = cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
+    fcl::Transform3f transform = fcl::Transform3f::Identity();
+    transform.translation() = fcl::Vector3f(xyzv->values[0], xyzv->values[1], xyzv->values[2]);
+    transform.linear() = Eigen::AngleAxisf(so2->value, Eigen::Vector3f::UnitZ()).toRotationMatrix();
+    fcl::CollisionObjectf robot(robot_box, transform);
+    fcl::CollisionRequestf request(1, false, 1, false);
+    fcl::CollisionResultf result;
+    fcl::collide<float>(&robot, obstacles.get(), request, result);
+    return !result.isCollision();
+  };
+}
+
+/** \brief The problem from x = -45 m to x = 45 m with path length as objective, ready for a planner */
+inline std::shared_ptr<ompl::control::SimpleSetup> makeSetup(const std::shared_ptr<fcl::CollisionObjectf>& obstacles,
+                                                             std::atomic<std::uint64_t>* checker_calls = nullptr)
+{
+  ompl::base::RealVectorBounds se2_bounds(2), z_bounds(1), v_bounds(1), control_bounds(2);
+  se2_bounds.setLow(0, -50.0);
+  se2_bounds.setHigh(0, 50.0);
+  se2_bounds.setLow(1, -10.0);
+  se2_bounds.setHigh(1, 10.0);
+  z_bounds.setLow(0.3);
+  z_bounds.setHigh(0.5);
+  v_bounds.setLow(-1.5);
+  v_bounds.setHigh(1.5);
+  control_bounds.setLow(-0.5);
+  control_bounds.setHigh(0.5);
+
+  auto state_space = std::make_shared<ompl::base::ElevationStateSpace>(
+      ompl::base::ElevationStateSpace::SE2StateType::REDDSSHEEP, 2.5, false);
+  state_space->setBounds(se2_bounds, z_bounds, v_bounds);
+  state_space->setLongestValidSegmentFraction(0.001);
+  auto control_space = std::make_shared<ompl::control::RealVectorControlSpace>(state_space, 2);
+  control_space->setBounds(control_bounds);
+  auto setup = std::make_shared<ompl::control::SimpleSetup>(control_space);
+  setup->setStateValidityChecker(makeValidityChecker(obstacles, checker_calls));
+
+  auto si = setup->getSpaceInformation();
+  si->setMinMaxControlDuration(5, 30);
+  si->setPropagationStepSize(0.1);
+  setup->setStatePropagator([si_ptr = si.get()](const ompl::base::State* state,
+                                                 const ompl::control::Control* control, const double duration,
+                                                 ompl::base::State* result) {
+    propagate(si_ptr, state, control, duration, result);
+  });
+  setup->setOptimizationObjective(std::make_shared<ompl::base::PathLengthOptimizationObjective>(si));
+
+  ompl::base::ScopedState<ompl::base::ElevationStateSpace> start(state_space), goal(state_space);
+  start->setXYZV(-45.0, 0.0, 0.4, 0);
+  start->setSO2(0);
+  goal->setXYZV(45.0, 0.0, 0.4, 0);
+  goal->setSO2(0);
+  setup->setStartAndGoalStates(start, goal, 0.5);
+  return setup;
+}
+}  // namespace corridor_scenario
+}  // namespace vox_nav_planning
+
+#endif  // VOX_NAV_PLANNING__TOOLS__CORRIDOR_SCENARIO_HPP_
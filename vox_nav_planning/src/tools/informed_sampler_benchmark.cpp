@@ -0,0 +1,200 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Valid informed samples per second of OMPL's RejectionInfSampler, ElevationInformedSampler ("direct") and
+ElevationInformedSampler restricted to the traversable cells ("direct_surfel"), as the cost bound shrinks from
+infinity to 1.01 times the cost of the straight start-goal motion. The terrain is a 100 m x 100 m wave,
+h(x, y) = sin(x / 8) cos(y / 8), with pillars of 2 m radius every 10 m; a state is valid within 0.15 m of the
+terrain and off the pillars, the cells are the terrain points of a 0.25 m grid off the pillars.
+Both the SE2 (x, y, z hyperspheroid) and the Reeds-Shepp (x, y ellipse) modes of ElevationStateSpace are run.
+Every direct sample has to lie within the bounds and the informed set, every direct_surfel sample on a cell,
+and the informed measure must not grow as the bound shrinks, otherwise the benchmark exits with 1.
+Usage: informed_sampler_benchmark [seconds_per_bound] [max_calls]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ompl/base/ProblemDefinition.h"
+#include "ompl/base/SpaceInformation.h"
+#include "ompl/base/objectives/PathLengthOptimizationObjective.h"
+#include "ompl/base/samplers/informed/RejectionInfSampler.h"
+#include "vox_nav_planning/native_planners/ElevationInformedSampler.hpp"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+using ElevationState = ompl::base::ElevationStateSpace::StateType;
+
+namespace
+{
+const double kCellSize = 0.25;
+
+double terrainHeight(double x, double y)
+{
+  return std::sin(x / 8.0) * std::cos(y / 8.0);
+}
+
+bool onPillar(double x, double y)
+{
+  double dx = std::remainder(x - 5.0, 10.0);
+  double dy = std::remainder(y - 5.0, 10.0);
+  return dx * dx + dy * dy < 4.0;
+}
+
+const double* xyzv(const ompl::base::State* state)
+{
+  return state->as<ElevationState>()->as<ompl::base::RealVectorStateSpace::StateType>(1)->values;
+}
+
+struct RunResult
+{
+  std::size_t calls = 0;
+  std::size_t samples = 0;
+  std::size_t valid = 0;
+  double seconds = 0.0;
+  int failures = 0;
+};
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  double seconds_per_bound = argc > 1 ? std::stod(argv[1]) : 1.0;
+  unsigned int max_calls = argc > 2 ? std::stoul(argv[2]) : 10000u;
+
+  std::vector<Eigen::Vector3d> cells;
+  for (double x = -50.0; x <= 50.0; x += kCellSize)
+  {
+    for (double y = -50.0; y <= 50.0; y += kCellSize)
+    {
+      if (!onPillar(x, y))
+      {
+        cells.emplace_back(x, y, terrainHeight(x, y));
+      }
+    }
+  }
+
+  int failures = 0;
+  std::cout << "mode,sampler,cost_ratio,calls,samples,valid,valid_per_s,informed_measure,cells_in_set" << std::endl;
+
+  using SE2StateType = ompl::base::ElevationStateSpace::SE2StateType;
+  for (const auto& [mode_name, mode] : { std::make_pair(std::string("se2"), SE2StateType::SE2),
+                                         std::make_pair(std::string("reeds_shepp"), SE2StateType::REDDSSHEEP) })
+  {
+    ompl::base::RealVectorBounds se2_bounds(2), z_bounds(1), v_bounds(1);
+    se2_bounds.setLow(-50.0);
+    se2_bounds.setHigh(50.0);
+    z_bounds.setLow(-1.5);
+    z_bounds.setHigh(1.5);
+    v_bounds.setLow(-1.5);
+    v_bounds.setHigh(1.5);
+    auto space = std::make_shared<ompl::base::ElevationStateSpace>(mode, 2.5, false);
+    space->setBounds(se2_bounds, z_bounds, v_bounds);
+
+    auto si = std::make_shared<ompl::base::SpaceInformation>(space);
+    si->setStateValidityChecker([](const ompl::base::State* state) {
+      const double* p = xyzv(state);
+      return std::abs(p[2] - terrainHeight(p[0], p[1])) <= 0.15 && !onPillar(p[0], p[1]);
+    });
+    si->setup();
+
+    ompl::base::ScopedState<ompl::base::ElevationStateSpace> start(space), goal(space);
+    start->setXYZV(-40.0, -5.0, terrainHeight(-40.0, -5.0), 0.0);
+    start->setSO2(0.0);
+    goal->setXYZV(40.0, 5.0, terrainHeight(40.0, 5.0), 0.0);
+    goal->setSO2(0.0);
+    auto pdef = std::make_shared<ompl::base::ProblemDefinition>(si);
+    pdef->setStartAndGoalStates(start, goal);
+    pdef->setOptimizationObjective(std::make_shared<ompl::base::PathLengthOptimizationObjective>(si));
+    double min_cost = si->distance(start.get(), goal.get());
+
+    auto rejection = std::make_shared<ompl::base::RejectionInfSampler>(pdef, max_calls);
+    auto direct = std::make_shared<ompl::base::ElevationInformedSampler>(pdef, max_calls);
+    auto direct_surfel = std::make_shared<ompl::base::ElevationInformedSampler>(pdef, max_calls);
+    direct_surfel->setTraversableCells(cells);
+
+    double last_measure = std::numeric_limits<double>::infinity();
+    for (double ratio : { std::numeric_limits<double>::infinity(), 3.0, 2.0, 1.5, 1.2, 1.1, 1.05, 1.01 })
+    {
+      ompl::base::Cost max_cost(min_cost * ratio);
+      for (const auto& [sampler_name, sampler] :
+           { std::make_pair(std::string("rejection"), std::static_pointer_cast<ompl::base::InformedSampler>(rejection)),
+             std::make_pair(std::string("direct"), std::static_pointer_cast<ompl::base::InformedSampler>(direct)),
+             std::make_pair(std::string("direct_surfel"),
+                            std::static_pointer_cast<ompl::base::InformedSampler>(direct_surfel)) })
+      {
+        bool is_direct = sampler_name != "rejection";
+        bool is_surfel = sampler_name == "direct_surfel";
+        auto* state = si->allocState();
+        RunResult r;
+        auto t0 = std::chrono::steady_clock::now();
+        while (r.seconds < seconds_per_bound)
+        {
+          r.calls++;
+          if (sampler->sampleUniform(state, max_cost))
+          {
+            r.samples++;
+            r.valid += si->isValid(state);
+
+            const double* p = xyzv(state);
+            if (is_direct && (!si->satisfiesBounds(state) ||
+                              (std::isfinite(ratio) &&
+                               direct->heuristicSolnCost(state).value() > max_cost.value() * (1.0 + 1e-9))))
+            {
+              r.failures++;
+            }
+            if (is_surfel && (std::abs(p[2] - terrainHeight(p[0], p[1])) > 1e-9 || onPillar(p[0], p[1])))
+            {
+              r.failures++;
+            }
+          }
+          // Reading the clock every call would be a noticeable part of a direct sample
+          if (r.calls % 64 == 0)
+          {
+            r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+          }
+        }
+        si->freeState(state);
+
+        std::size_t cells_in_set = is_surfel ? direct_surfel->getNumCellsInInformedSet(max_cost) : 0;
+        double measure = sampler->getInformedMeasure(max_cost);
+        std::cout << mode_name << "," << sampler_name << "," << ratio << "," << r.calls << "," << r.samples << ","
+                  << r.valid << "," << r.valid / r.seconds << "," << measure << "," << cells_in_set << std::endl;
+
+        if (r.failures > 0)
+        {
+          std::cerr << "FAILED: " << r.failures << " " << sampler_name << " samples of cost ratio " << ratio
+                    << " in the " << mode_name << " mode are outside the bounds, the informed set or the cells"
+                    << std::endl;
+          failures++;
+        }
+        if (sampler_name == "direct")
+        {
+          if (measure > last_measure * (1.0 + 1e-9))
+          {
+            std::cerr << "FAILED: the informed measure of cost ratio " << ratio << " in the " << mode_name
+                      << " mode grew to " << measure << " from " << last_measure << std::endl;
+            failures++;
+          }
+          last_measure = measure;
+        }
+      }
+    }
+  }
+  return failures ? 1 : 0;
+}
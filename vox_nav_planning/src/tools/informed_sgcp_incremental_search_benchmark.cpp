@@ -0,0 +1,186 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Per batch geometric search time of InformedSGCP, "full" reruns the backward
+and forward searches over the whole graph in every batch, "incremental"
+repairs one LPA* search per graph. Both run num_batches batches on the car
+scenario of corridor_scenario.hpp (100 m x 20 m corridor with pillars, FCL
+robot box, Reeds-Shepp ElevationStateSpace), geometric graph only. The
+time of a batch is the slowest thread's search. Prints one row per batch
+and a summary per mode. Both modes have to run all batches, and
+the incremental mode has to find a path if the full one does. Then both run
+again with a one voxel thin wall across the corridor, where edges between
+valid vertices on either side cross the wall, and the incremental path has to
+be free of collisions. Otherwise the benchmark exits with 1.
+Usage: informed_sgcp_incremental_search_benchmark [num_batches] [batch_size] [num_threads] [max_time_s]
+*/
+
+#include "corridor_scenario.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "vox_nav_planning/native_planners/InformedSGCP.hpp"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+namespace
+{
+// One voxel thick wall across the corridor at x = 0 with a gap at its upper end. No vertex fits into it, so only
+// the motion checks of the edges crossing it keep the paths out of it
+std::shared_ptr<fcl::CollisionObjectf> makeThinWall(double resolution)
+{
+  auto octree = std::make_shared<octomap::OcTree>(resolution);
+  for (double y = -10.0; y <= 6.0; y += resolution)
+  {
+    for (double z = 0.0; z <= 2.0; z += resolution)
+    {
+      octree->updateNode(0.0, y, z, true);
+    }
+  }
+  octree->updateInnerOccupancy();
+  return std::make_shared<fcl::CollisionObjectf>(
+      std::shared_ptr<fcl::CollisionGeometryf>(std::make_shared<fcl::OcTreef>(octree)));
+}
+
+struct RunResult
+{
+  std::vector<double> batch_search_ms;
+  bool solved = false;
+  double length = 0.0;
+  bool collision_free = true;
+};
+
+RunResult run(const std::shared_ptr<fcl::CollisionObjectf>& corridor, bool use_incremental_search, int num_batches,
+              int batch_size, int num_threads, double max_time)
+{
+  auto setup = vox_nav_planning::corridor_scenario::makeSetup(corridor);
+  auto si = setup->getSpaceInformation();
+  // Only the geometric graph is searched, the control graph and its propagation are not used
+  setup->setStatePropagator([si_ptr = si.get()](const ompl::base::State* state, const ompl::control::Control*,
+                                                 const double, ompl::base::State* result) {
+    si_ptr->copyState(result, state);
+  });
+
+  auto planner = std::make_shared<ompl::control::InformedSGCP>(si);
+  planner->setMinDistBetweenVertices(0.05);
+  planner->setSolveControlGraph(false);
+  planner->setNumThreads(num_threads);
+  planner->setBatchSize(batch_size);
+  planner->setUseIncrementalSearch(use_incremental_search);
+  setup->setPlanner(planner);
+  setup->setup();
+
+  // Stop after num_batches batches, max_time only guards against a stuck run
+  auto ptc = ompl::base::plannerOrTerminationCondition(
+      ompl::base::PlannerTerminationCondition(
+          [&planner, num_batches]() { return planner->getNumBatches() >= static_cast<std::size_t>(num_batches); }),
+      ompl::base::timedPlannerTerminationCondition(max_time));
+  auto status = setup->solve(ptc);
+
+  RunResult result;
+  result.batch_search_ms = planner->getBatchSearchTimes();
+  result.solved = status == ompl::base::PlannerStatus::EXACT_SOLUTION;
+  if (status)
+  {
+    const auto& path = setup->getSolutionPath().asGeometric();
+    result.length = path.length();
+    for (std::size_t i = 1; i < path.getStateCount(); i++)
+    {
+      result.collision_free = result.collision_free && si->checkMotion(path.getState(i - 1), path.getState(i));
+    }
+  }
+  return result;
+}
+
+double meanOf(const std::vector<double>& values, std::size_t begin, std::size_t end)
+{
+  double sum = 0.0;
+  end = std::min(end, values.size());
+  for (std::size_t i = begin; i < end; i++)
+  {
+    sum += values[i];
+  }
+  return end > begin ? sum / (end - begin) : 0.0;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  int num_batches = argc > 1 ? std::stoi(argv[1]) : 100;
+  int batch_size = argc > 2 ? std::stoi(argv[2]) : 100;
+  int num_threads = argc > 3 ? std::stoi(argv[3]) : 2;
+  double max_time = argc > 4 ? std::stod(argv[4]) : 600.0;
+
+  // InformedSGCP still hands its paths to the visualization sink, which needs rclcpp
+  rclcpp::init(argc, argv);
+  auto corridor = vox_nav_planning::corridor_scenario::makeCorridor(0.2);
+
+  auto full = run(corridor, false, num_batches, batch_size, num_threads, max_time);
+  auto incremental = run(corridor, true, num_batches, batch_size, num_threads, max_time);
+
+  std::cout << "batch,full_search_ms,incremental_search_ms" << std::endl;
+  for (std::size_t i = 0; i < static_cast<std::size_t>(num_batches); i++)
+  {
+    std::cout << i << "," << (i < full.batch_search_ms.size() ? full.batch_search_ms[i] : NAN) << ","
+              << (i < incremental.batch_search_ms.size() ? incremental.batch_search_ms[i] : NAN) << std::endl;
+  }
+
+  int failures = 0;
+  std::cout << "mode,batches,first_10_mean_ms,last_10_mean_ms,total_ms,solved,path_length_m" << std::endl;
+  for (const auto& [mode, r] : { std::make_pair(std::string("full"), full),
+                                 std::make_pair(std::string("incremental"), incremental) })
+  {
+    std::size_t n = r.batch_search_ms.size();
+    std::cout << mode << "," << n << "," << meanOf(r.batch_search_ms, 0, 10) << ","
+              << meanOf(r.batch_search_ms, n > 10 ? n - 10 : 0, n) << "," << meanOf(r.batch_search_ms, 0, n) * n << ","
+              << r.solved << "," << r.length << std::endl;
+    if (n < static_cast<std::size_t>(num_batches))
+    {
+      std::cerr << "FAILED: " << mode << " ran " << n << " of " << num_batches << " batches" << std::endl;
+      failures++;
+    }
+  }
+  if (full.solved && !incremental.solved)
+  {
+    std::cerr << "FAILED: the incremental search found no path where the full one did" << std::endl;
+    failures++;
+  }
+
+  auto wall = makeThinWall(0.2);
+  auto full_wall = run(wall, false, num_batches, batch_size, num_threads, max_time);
+  auto incremental_wall = run(wall, true, num_batches, batch_size, num_threads, max_time);
+  std::cout << "mode,solved,path_length_m,collision_free" << std::endl;
+  std::cout << "full_thin_wall," << full_wall.solved << "," << full_wall.length << "," << full_wall.collision_free
+            << std::endl;
+  std::cout << "incremental_thin_wall," << incremental_wall.solved << "," << incremental_wall.length << ","
+            << incremental_wall.collision_free << std::endl;
+  if (!incremental_wall.collision_free)
+  {
+    std::cerr << "FAILED: the incremental path crosses the thin wall" << std::endl;
+    failures++;
+  }
+  if (full_wall.solved && !incremental_wall.solved)
+  {
+    std::cerr << "FAILED: the incremental search found no path past the thin wall where the full one did" << std::endl;
+    failures++;
+  }
+  rclcpp::shutdown();
+  return failures ? 1 : 0;
+}
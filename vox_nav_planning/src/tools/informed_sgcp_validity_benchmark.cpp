@@ -0,0 +1,136 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Validity checks of InformedSGCP with and without its vertex validity cache,
+for several thread counts, on the car scenario of
+car_control_planners_benchmark: a 100 m x 20 m corridor (the default state
+space bounds of that benchmark) with pillars in an octomap, a 1.5 x 1.5 x 0.4
+robot box checked with FCL, Reeds-Shepp ElevationStateSpace with turning
+radius 2.5 and the same unicycle propagation. Every run gets the same
+planner_timeout. checker_calls counts every call of the state validity
+checker, search_validity_checks only the ones the A* searches made on graph
+vertices, validity_cache_hits the ones the cache answered instead. With the
+cache on, all vertices are validated when they are added, so the searches
+must not check any vertex again; without it the cache must never be used.
+Otherwise the benchmark exits with 1.
+Usage: informed_sgcp_validity_benchmark [planner_timeout_s] [solve_control_graph] [threads,...]
+*/
+
+#include "corridor_scenario.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "vox_nav_planning/native_planners/InformedSGCP.hpp"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+struct RunResult
+{
+  bool solved = false;
+  double ms = 0.0;
+  double length = 0.0;
+  std::uint64_t checker_calls = 0;
+  std::uint64_t search_validity_checks = 0;
+  std::uint64_t validity_cache_hits = 0;
+  std::uint64_t prevalidated_vertices = 0;
+};
+
+RunResult run(const std::shared_ptr<fcl::CollisionObjectf>& corridor, int num_threads, bool use_validity_cache,
+              bool solve_control_graph, double timeout)
+{
+  std::atomic<std::uint64_t> checker_calls{ 0 };
+  auto setup = vox_nav_planning::corridor_scenario::makeSetup(corridor, &checker_calls);
+  auto si = setup->getSpaceInformation();
+
+  auto planner = std::make_shared<ompl::control::InformedSGCP>(si);
+  planner->setMinDistBetweenVertices(0.05);
+  planner->setGoalBias(0.25);
+  planner->setSolveControlGraph(solve_control_graph);
+  planner->setNumThreads(num_threads);
+  planner->setUseValidityCache(use_validity_cache);
+  setup->setPlanner(planner);
+  setup->setup();
+
+  RunResult result;
+  auto t0 = Clock::now();
+  auto status = setup->solve(timeout);
+  result.ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  result.solved = status == ompl::base::PlannerStatus::EXACT_SOLUTION;
+  if (status)
+  {
+    result.length = setup->getSolutionPath().asGeometric().length();
+  }
+  result.checker_calls = checker_calls.load();
+  result.search_validity_checks = planner->getNumSearchValidityChecks();
+  result.validity_cache_hits = planner->getNumValidityCacheHits();
+  result.prevalidated_vertices = planner->getNumPrevalidatedVertices();
+  return result;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  double timeout = argc > 1 ? std::stod(argv[1]) : 10.0;
+  bool solve_control_graph = argc > 2 ? std::stoi(argv[2]) != 0 : true;
+  std::vector<int> thread_counts;
+  std::stringstream threads_arg(argc > 3 ? argv[3] : "2,4,8,12");
+  for (std::string t; std::getline(threads_arg, t, ',');)
+  {
+    thread_counts.push_back(std::stoi(t));
+  }
+
+  // The planner visualizations are published only while rclcpp is initialized
+  rclcpp::init(argc, argv);
+  auto corridor = vox_nav_planning::corridor_scenario::makeCorridor(0.2);
+
+  int failures = 0;
+  std::cout << "threads,validity_cache,solved,solve_ms,path_length_m,checker_calls,search_validity_checks,"
+               "validity_cache_hits,prevalidated_vertices"
+            << std::endl;
+  for (int threads : thread_counts)
+  {
+    for (bool use_validity_cache : { false, true })
+    {
+      auto r = run(corridor, threads, use_validity_cache, solve_control_graph, timeout);
+      std::cout << threads << "," << use_validity_cache << "," << r.solved << "," << r.ms << "," << r.length << ","
+                << r.checker_calls << "," << r.search_validity_checks << "," << r.validity_cache_hits << ","
+                << r.prevalidated_vertices << std::endl;
+      if (use_validity_cache && r.search_validity_checks != 0)
+      {
+        std::cerr << "FAILED: with the cache on, the searches checked " << r.search_validity_checks
+                  << " vertices again" << std::endl;
+        failures++;
+      }
+      if (!use_validity_cache && r.validity_cache_hits != 0)
+      {
+        std::cerr << "FAILED: with the cache off, " << r.validity_cache_hits << " checks were read from the cache"
+                  << std::endl;
+        failures++;
+      }
+    }
+  }
+  rclcpp::shutdown();
+  return failures ? 1 : 0;
+}
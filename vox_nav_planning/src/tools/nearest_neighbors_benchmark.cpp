@@ -0,0 +1,363 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+NearestNeighborsKDForest against OMPL's GNAT on ElevationStateSpace states
+spread over a 100 m x 100 m x 2 m box. Inserts: one by one and, for the
+forest, as one batch. Queries: kNN and radius queries from 1 to 16 threads,
+once on the full structure ("read") and once while another thread keeps
+adding states ("mixed"). GNAT is not safe to read while it is written, so as
+in the planners it is used behind a mutex; the forest takes no lock.
+Every case runs with the SE2 mode distance of ElevationStateSpace (x, y, z
+euclidean) and with its DUBINS mode distance, both through
+ElevationStateSpace::distance, which the query threads call concurrently.
+The kNN and radius results of both structures have to have the distances of
+a linear scan, GNAT is only checked in SE2 mode as the Dubins distance is not
+a metric. The concurrent kNN queries of the read phase have to find the
+distances of the same queries run on one thread. Otherwise the benchmark
+exits with 1.
+Usage: nearest_neighbors_benchmark [num_states] [num_queries] [k] [radius] [threads,...]
+*/
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ompl/datastructures/NearestNeighborsGNAT.h"
+#include "ompl/datastructures/NearestNeighborsLinear.h"
+#include "ompl/util/RandomNumbers.h"
+#include "vox_nav_planning/native_planners/NearestNeighborsKDForest.hpp"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+using Clock = std::chrono::steady_clock;
+using ElevationState = ompl::base::ElevationStateSpace::StateType;
+
+namespace
+{
+const double* xyzv(const ompl::base::State* state)
+{
+  return state->as<ElevationState>()->as<ompl::base::RealVectorStateSpace::StateType>(1)->values;
+}
+
+using DistanceFn = ompl::NearestNeighbors<const ompl::base::State*>::DistanceFunction;
+
+std::shared_ptr<ompl::NearestNeighbors<const ompl::base::State*>> makeStructure(bool kd_forest,
+                                                                                const DistanceFn& distance)
+{
+  std::shared_ptr<ompl::NearestNeighbors<const ompl::base::State*>> nn;
+  if (kd_forest)
+  {
+    // x and y are a lower bound of both the SE2 mode and the Dubins distance
+    nn = std::make_shared<ompl::NearestNeighborsKDForest<const ompl::base::State*>>(
+        2, [](const ompl::base::State* const& state, double* coords) {
+          coords[0] = xyzv(state)[0];
+          coords[1] = xyzv(state)[1];
+        });
+  }
+  else
+  {
+    nn = std::make_shared<ompl::NearestNeighborsGNAT<const ompl::base::State*>>();
+  }
+  nn->setDistanceFunction(distance);
+  return nn;
+}
+
+double secondsSince(const Clock::time_point& t0)
+{
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// Whether the neighbors of query are at the given distances, in order
+bool sameDistances(const ompl::NearestNeighbors<const ompl::base::State*>& nn, const ompl::base::State* query,
+                   const std::vector<const ompl::base::State*>& nbh, const std::vector<double>& distances)
+{
+  if (nbh.size() != distances.size())
+  {
+    return false;
+  }
+  for (std::size_t j = 0; j < nbh.size(); j++)
+  {
+    if (std::abs(nn.getDistanceFunction()(query, nbh[j]) - distances[j]) > 1e-9)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct QueryResult
+{
+  double knn_per_s = 0.0;
+  double radius_per_s = 0.0;
+  double inserts_per_s = 0.0;
+  // kNN queries whose neighbor distances differ from knn_distances
+  std::size_t wrong_knn = 0;
+};
+
+// num_threads threads run the queries, if writes is not empty another thread adds them meanwhile.
+// If knn_distances is not empty, the kNN neighbors of query i have to be at knn_distances[i]
+QueryResult runQueries(ompl::NearestNeighbors<const ompl::base::State*>& nn, bool lock,
+                       const std::vector<const ompl::base::State*>& queries, int num_threads, std::size_t k,
+                       double radius, const std::vector<const ompl::base::State*>& writes,
+                       const std::vector<std::vector<double>>& knn_distances = {})
+{
+  std::mutex nn_mutex;
+  QueryResult result;
+  std::atomic<std::size_t> wrong_knn{ 0 };
+
+  std::thread writer;
+  auto t_write = Clock::now();
+  if (!writes.empty())
+  {
+    writer = std::thread([&]() {
+      for (const auto* state : writes)
+      {
+        std::unique_lock<std::mutex> guard(nn_mutex, std::defer_lock);
+        if (lock)
+        {
+          guard.lock();
+        }
+        nn.add(state);
+      }
+      result.inserts_per_s = writes.size() / secondsSince(t_write);
+    });
+  }
+
+  auto query = [&](bool knn) {
+    std::vector<std::thread> threads;
+    auto t0 = Clock::now();
+    for (int t = 0; t < num_threads; t++)
+    {
+      threads.emplace_back([&, t]() {
+        std::vector<const ompl::base::State*> nbh;
+        for (std::size_t i = t; i < queries.size(); i += num_threads)
+        {
+          std::unique_lock<std::mutex> guard(nn_mutex, std::defer_lock);
+          if (lock)
+          {
+            guard.lock();
+          }
+          if (knn)
+          {
+            nn.nearestK(queries[i], k, nbh);
+          }
+          else
+          {
+            nn.nearestR(queries[i], radius, nbh);
+          }
+          if (knn && !knn_distances.empty() && !sameDistances(nn, queries[i], nbh, knn_distances[i]))
+          {
+            wrong_knn++;
+          }
+        }
+      });
+    }
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+    return queries.size() / secondsSince(t0);
+  };
+  result.knn_per_s = query(true);
+  result.radius_per_s = query(false);
+  result.wrong_knn = wrong_knn;
+
+  if (writer.joinable())
+  {
+    writer.join();
+  }
+  return result;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  std::size_t num_states = argc > 1 ? std::stoul(argv[1]) : 100000;
+  std::size_t num_queries = argc > 2 ? std::stoul(argv[2]) : 20000;
+  std::size_t k = argc > 3 ? std::stoul(argv[3]) : 10;
+  double radius = argc > 4 ? std::stod(argv[4]) : 2.0;
+  std::vector<int> thread_counts;
+  std::stringstream threads_arg(argc > 5 ? argv[5] : "1,2,4,8,16");
+  for (std::string t; std::getline(threads_arg, t, ',');)
+  {
+    thread_counts.push_back(std::stoi(t));
+  }
+
+  int failures = 0;
+  std::cout << "space,structure,threads,phase,knn_per_s,radius_per_s,inserts_per_s" << std::endl;
+
+  for (auto se2_type : { ompl::base::ElevationStateSpace::SE2StateType::SE2,
+                         ompl::base::ElevationStateSpace::SE2StateType::DUBINS })
+  {
+    bool dubins = se2_type == ompl::base::ElevationStateSpace::SE2StateType::DUBINS;
+    std::string space_name = dubins ? "dubins" : "se2";
+    auto space = std::make_shared<ompl::base::ElevationStateSpace>(se2_type, 2.5, false);
+    DistanceFn distance = [space](const ompl::base::State* const& a, const ompl::base::State* const& b) {
+      return space->distance(a, b);
+    };
+    // Same states in both spaces
+    ompl::RNG rng(42);
+    auto sample = [&](std::size_t n) {
+      std::vector<const ompl::base::State*> states;
+      for (std::size_t i = 0; i < n; i++)
+      {
+        auto* state = space->allocState()->as<ElevationState>();
+        state->setXYZV(rng.uniformReal(-50.0, 50.0), rng.uniformReal(-50.0, 50.0), rng.uniformReal(0.0, 2.0),
+                       0.0);
+        state->setSO2(rng.uniformReal(-M_PI, M_PI));
+        states.push_back(state);
+      }
+      return states;
+    };
+    auto states = sample(num_states);
+    auto queries = sample(num_queries);
+    auto writes = sample(num_states / 10);
+
+    // Insert throughput, the structures built here are the ones queried below
+    auto gnat = makeStructure(false, distance);
+    auto t0 = Clock::now();
+    for (const auto* state : states)
+    {
+      gnat->add(state);
+    }
+    std::cout << space_name << ",gnat,1,insert,0,0," << num_states / secondsSince(t0) << std::endl;
+
+    auto forest = makeStructure(true, distance);
+    t0 = Clock::now();
+    for (const auto* state : states)
+    {
+      forest->add(state);
+    }
+    std::cout << space_name << ",kd_forest,1,insert,0,0," << num_states / secondsSince(t0) << std::endl;
+
+    auto forest_batch = makeStructure(true, distance);
+    t0 = Clock::now();
+    forest_batch->add(states);
+    std::cout << space_name << ",kd_forest,1,batch_insert,0,0," << num_states / secondsSince(t0) << std::endl;
+
+    // The structures have to find neighbors at the distances of a linear scan
+    ompl::NearestNeighborsLinear<const ompl::base::State*> linear;
+    linear.setDistanceFunction(distance);
+    linear.add(states);
+    std::vector<const ompl::base::State*> linear_nbh, nbh;
+    std::vector<double> linear_distances;
+    for (std::size_t i = 0; i < std::min<std::size_t>(num_queries, 200); i++)
+    {
+      for (bool knn : { true, false })
+      {
+        if (knn)
+        {
+          linear.nearestK(queries[i], k, linear_nbh);
+        }
+        else
+        {
+          linear.nearestR(queries[i], radius, linear_nbh);
+        }
+        linear_distances.clear();
+        for (const auto* neighbor : linear_nbh)
+        {
+          linear_distances.push_back(distance(queries[i], neighbor));
+        }
+        for (bool kd_forest : { false, true })
+        {
+          if (dubins && !kd_forest)
+          {
+            continue;
+          }
+          auto& nn = kd_forest ? *forest : *gnat;
+          if (knn)
+          {
+            nn.nearestK(queries[i], k, nbh);
+          }
+          else
+          {
+            nn.nearestR(queries[i], radius, nbh);
+          }
+          if (!sameDistances(nn, queries[i], nbh, linear_distances))
+          {
+            std::cerr << "FAILED: the " << space_name << " " << (knn ? "kNN" : "radius") << " neighbors of query "
+                      << i << " differ between " << (kd_forest ? "the KD-forest" : "GNAT") << " and a linear scan"
+                      << std::endl;
+            failures++;
+          }
+        }
+      }
+    }
+
+    // What the concurrent queries have to find, from the same structure on one thread
+    std::vector<std::vector<double>> knn_distances[2];
+    for (bool kd_forest : { false, true })
+    {
+      auto& nn = kd_forest ? *forest : *gnat;
+      knn_distances[kd_forest].resize(queries.size());
+      for (std::size_t i = 0; i < queries.size(); i++)
+      {
+        nn.nearestK(queries[i], k, nbh);
+        for (const auto* neighbor : nbh)
+        {
+          knn_distances[kd_forest][i].push_back(distance(queries[i], neighbor));
+        }
+      }
+    }
+
+    for (int threads : thread_counts)
+    {
+      for (bool kd_forest : { false, true })
+      {
+        auto& nn = kd_forest ? *forest : *gnat;
+        std::string name = kd_forest ? "kd_forest" : "gnat";
+        auto r = runQueries(nn, !kd_forest, queries, threads, k, radius, {}, knn_distances[kd_forest]);
+        std::cout << space_name << "," << name << "," << threads << ",read," << r.knn_per_s << "," << r.radius_per_s
+                  << ",0" << std::endl;
+        if (r.wrong_knn > 0)
+        {
+          std::cerr << "FAILED: " << r.wrong_knn << " " << space_name << " kNN queries of " << name << " on "
+                    << threads << " threads found other neighbors than on one thread" << std::endl;
+          failures++;
+        }
+      }
+    }
+
+    // The mixed phase grows the structures, each thread count gets fresh copies of the same states
+    for (int threads : thread_counts)
+    {
+      for (bool kd_forest : { false, true })
+      {
+        auto nn = makeStructure(kd_forest, distance);
+        nn->add(states);
+        std::string name = kd_forest ? "kd_forest" : "gnat";
+        auto r = runQueries(*nn, !kd_forest, queries, threads, k, radius, writes);
+        std::cout << space_name << "," << name << "," << threads << ",mixed," << r.knn_per_s << ","
+                  << r.radius_per_s << "," << r.inserts_per_s << std::endl;
+      }
+    }
+
+    for (auto* state_set : { &states, &queries, &writes })
+    {
+      for (const auto* state : *state_set)
+      {
+        space->freeState(const_cast<ompl::base::State*>(state));
+      }
+    }
+  }
+  return failures ? 1 : 0;
+}
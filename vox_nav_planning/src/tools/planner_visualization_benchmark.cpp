@@ -0,0 +1,125 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Solve loop iterations (batches) per second of InformedSGCP with its RVIZ
+visualization off, built and published in the solve loop (sync) and handed
+to the PlannerVisualizationSink thread (async), on the car scenario of
+corridor_scenario.hpp (100 m x 20 m corridor with pillars, FCL robot box,
+Reeds-Shepp ElevationStateSpace). Every mode runs for the same
+time. Off must not publish anything and async must not publish more than
+max_rate_hz per topic and second, plus the paths offered again when solve()
+returns, otherwise the benchmark exits with 1.
+Usage: planner_visualization_benchmark [run_time_s] [max_rate_hz] [num_threads] [solve_control_graph]
+*/
+
+#include "corridor_scenario.hpp"
+
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rclcpp/rclcpp.hpp"
+#include "vox_nav_planning/native_planners/InformedSGCP.hpp"
+#include "vox_nav_planning/native_planners/PlannerVisualizationSink.hpp"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+
+namespace
+{
+struct RunResult
+{
+  std::size_t batches = 0;
+  double seconds = 0.0;
+  std::size_t published = 0;
+  std::size_t dropped = 0;
+};
+
+RunResult run(const std::shared_ptr<fcl::CollisionObjectf>& corridor,
+              vox_nav_planning::PlannerVisualizationSink::Mode mode, double run_time, int num_threads,
+              bool solve_control_graph)
+{
+  auto setup = vox_nav_planning::corridor_scenario::makeSetup(corridor);
+  auto si = setup->getSpaceInformation();
+
+  auto planner = std::make_shared<ompl::control::InformedSGCP>(si);
+  planner->setMinDistBetweenVertices(0.05);
+  planner->setGoalBias(0.25);
+  planner->setSolveControlGraph(solve_control_graph);
+  planner->setNumThreads(num_threads);
+  setup->setPlanner(planner);
+  setup->setup();
+
+  auto& sink = vox_nav_planning::PlannerVisualizationSink::instance();
+  sink.setMode(mode);
+  std::size_t published = sink.getNumPublished();
+  std::size_t dropped = sink.getNumDropped();
+
+  RunResult result;
+  auto t0 = std::chrono::steady_clock::now();
+  setup->solve(run_time);
+  result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  result.batches = planner->getNumBatches();
+
+  // Let the sink thread finish what is queued, the final paths included, so it is not counted for the next mode
+  std::this_thread::sleep_for(std::chrono::duration<double>(2.0 / sink.getMaxRate()));
+  result.published = sink.getNumPublished() - published;
+  result.dropped = sink.getNumDropped() - dropped;
+  return result;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  double run_time = argc > 1 ? std::stod(argv[1]) : 20.0;
+  double max_rate = argc > 2 ? std::stod(argv[2]) : 2.0;
+  int num_threads = argc > 3 ? std::stoi(argv[3]) : 4;
+  bool solve_control_graph = argc > 4 ? std::stoi(argv[4]) != 0 : true;
+
+  // The sink publishes only while rclcpp is initialized
+  rclcpp::init(argc, argv);
+  auto corridor = vox_nav_planning::corridor_scenario::makeCorridor(0.2);
+  vox_nav_planning::PlannerVisualizationSink::instance().setMaxRate(max_rate);
+
+  // InformedSGCP publishes the geometric and control graphs and paths, five topics
+  const double num_topics = 5.0;
+
+  int failures = 0;
+  std::cout << "mode,batches,seconds,batches_per_s,published,dropped" << std::endl;
+  using Mode = vox_nav_planning::PlannerVisualizationSink::Mode;
+  for (const auto& [name, mode] : { std::make_pair(std::string("off"), Mode::OFF),
+                                    std::make_pair(std::string("sync"), Mode::SYNCHRONOUS),
+                                    std::make_pair(std::string("async"), Mode::ASYNCHRONOUS) })
+  {
+    auto r = run(corridor, mode, run_time, num_threads, solve_control_graph);
+    std::cout << name << "," << r.batches << "," << r.seconds << "," << r.batches / r.seconds << "," << r.published
+              << "," << r.dropped << std::endl;
+    if (mode == Mode::OFF && r.published != 0)
+    {
+      std::cerr << "FAILED: " << r.published << " visualizations were published while it was off" << std::endl;
+      failures++;
+    }
+    // One more per topic for the paths offered again when solve() returns
+    if (mode == Mode::ASYNCHRONOUS && r.published > num_topics * (max_rate * r.seconds + 2.0))
+    {
+      std::cerr << "FAILED: " << r.published << " visualizations were published in " << r.seconds
+                << " s, more than " << max_rate << " per topic and second" << std::endl;
+      failures++;
+    }
+  }
+  rclcpp::shutdown();
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,213 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+State validity checks per second of the SE2Planner and SE3Planner plugins, through FCL against the
+octomap ("fcl", what the plugins did before) and through the 2.5D ProjectedMap ("projected"), on the same
+random queries. The octomap is a flat ground of one voxel with pillars and walls 1 m high and bumps of one
+voxel, low enough to be driven over. The SE2 robot box floats just above the bumps, as z_elevation would
+put it, so both checks should see the pillars and walls only; the SE3 box is placed at random heights.
+The build of the FCL tree and of the projected map are timed too.
+The projected map may call a state in collision that FCL calls free (it is conservative near cell
+borders and under the body in SE3), but at most max_unsafe_percent of the states it calls free may be in
+collision for FCL, otherwise the benchmark exits with 1.
+Usage: projected_map_benchmark [map_size_m] [resolution] [num_queries] [max_unsafe_percent]
+*/
+
+#include <fcl/config.h>
+#include <fcl/geometry/octree/octree.h>
+#include <fcl/geometry/shape/box.h>
+#include <fcl/narrowphase/collision.h>
+#include <fcl/narrowphase/collision_object.h>
+#include <octomap/octomap.h>
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vox_nav_utilities/projected_map.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+const double kRobotLength = 1.0;
+const double kRobotWidth = 0.6;
+const double kRobotHeight = 0.5;
+
+double secondsSince(const Clock::time_point& t0)
+{
+  return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+struct Query
+{
+  double x, y, z, yaw;
+};
+
+struct CheckResult
+{
+  std::vector<char> valid;
+  double per_s = 0.0;
+};
+
+// The collision check of SE2Planner and SE3Planner
+bool fclValid(fcl::CollisionObjectf& robot, const fcl::CollisionObjectf& map, const Query& q)
+{
+  fcl::Quaternionf rotation(Eigen::AngleAxisf(static_cast<float>(q.yaw), Eigen::Vector3f::UnitZ()));
+  robot.setTransform(rotation, fcl::Vector3f(q.x, q.y, q.z));
+  fcl::CollisionRequestf request(1, false, 1, false);
+  fcl::CollisionResultf result;
+  fcl::collide<float>(&robot, &map, request, result);
+  return !result.isCollision();
+}
+
+template <typename F>
+CheckResult runChecks(const std::vector<Query>& queries, F valid)
+{
+  CheckResult r;
+  r.valid.reserve(queries.size());
+  auto t0 = Clock::now();
+  for (const auto& q : queries)
+  {
+    r.valid.push_back(valid(q));
+  }
+  r.per_s = queries.size() / secondsSince(t0);
+  return r;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  double map_size = argc > 1 ? std::stod(argv[1]) : 60.0;
+  double resolution = argc > 2 ? std::stod(argv[2]) : 0.2;
+  std::size_t num_queries = argc > 3 ? std::stoul(argv[3]) : 100000;
+  double max_unsafe_percent = argc > 4 ? std::stod(argv[4]) : 2.0;
+
+  // Ground voxels are centered half a voxel above 0
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  octomap::OcTree octree(resolution);
+  const double ground_z = resolution / 2.0;
+  const int n = static_cast<int>(map_size / resolution);
+  for (int i = 0; i < n; i++)
+  {
+    for (int j = 0; j < n; j++)
+    {
+      double x = -map_size / 2.0 + (i + 0.5) * resolution;
+      double y = -map_size / 2.0 + (j + 0.5) * resolution;
+      octree.updateNode(x, y, ground_z, true);
+
+      double px = std::remainder(x, 6.0);
+      double py = std::remainder(y, 6.0);
+      bool pillar = px * px + py * py < 0.36;
+      bool wall = std::abs(std::remainder(x + 3.0, 15.0)) < 0.3 && std::abs(y) > 4.0;
+      if (pillar || wall)
+      {
+        for (double z = ground_z + resolution; z < 1.0; z += resolution)
+        {
+          octree.updateNode(x, y, z, true);
+        }
+      }
+      else if (unit(rng) < 0.02)
+      {
+        octree.updateNode(x, y, ground_z + resolution, true);
+      }
+    }
+  }
+
+  std::cout << "check,operation,calls,per_s,valid_percent,agreement_percent,unsafe_percent" << std::endl;
+
+  auto t0 = Clock::now();
+  auto fcl_octree = std::make_shared<fcl::OcTreef>(std::make_shared<octomap::OcTree>(octree));
+  fcl::CollisionObjectf map_object(std::shared_ptr<fcl::CollisionGeometryf>(fcl_octree));
+  std::cout << "fcl,build,1," << 1.0 / secondsSince(t0) << ",0,0,0" << std::endl;
+
+  vox_nav_utilities::ProjectedMapParams params;
+  params.footprint_length = kRobotLength;
+  params.footprint_width = kRobotWidth;
+  params.clearance_height = kRobotHeight;
+  params.max_step_height = resolution;
+  t0 = Clock::now();
+  vox_nav_utilities::ProjectedMap projected_map(octree, params);
+  std::cout << "projected,build,1," << 1.0 / secondsSince(t0) << ",0,0,0" << std::endl;
+
+  fcl::CollisionObjectf robot(std::make_shared<fcl::Boxf>(kRobotLength, kRobotWidth, kRobotHeight));
+
+  // The SE2 box clears the bumps, whose tops are two voxels above 0
+  const double z_elevation = 2.0 * resolution + kRobotHeight / 2.0 + 0.01;
+  std::vector<Query> se2_queries, se3_queries;
+  std::uniform_real_distribution<double> xy(-map_size / 2.0, map_size / 2.0);
+  std::uniform_real_distribution<double> yaw(-M_PI, M_PI);
+  std::uniform_real_distribution<double> z(0.0, 2.0);
+  for (std::size_t i = 0; i < num_queries; i++)
+  {
+    se2_queries.push_back({ xy(rng), xy(rng), z_elevation, yaw(rng) });
+    se3_queries.push_back({ xy(rng), xy(rng), z(rng), 0.0 });
+  }
+
+  int failures = 0;
+  for (bool se3 : { false, true })
+  {
+    const auto& queries = se3 ? se3_queries : se2_queries;
+    std::string name = se3 ? "se3" : "se2";
+    auto fcl_result = runChecks(queries, [&](const Query& q) { return fclValid(robot, map_object, q); });
+    auto projected_result = runChecks(queries, [&](const Query& q) {
+      return se3 ? projected_map.isBodyAboveTerrain(q.x, q.y, q.z - kRobotHeight / 2.0) :
+                   projected_map.isFootprintFree(q.x, q.y, q.yaw);
+    });
+
+    std::size_t fcl_valid = 0, projected_valid = 0, agree = 0, unsafe = 0;
+    for (std::size_t i = 0; i < queries.size(); i++)
+    {
+      fcl_valid += fcl_result.valid[i];
+      projected_valid += projected_result.valid[i];
+      agree += fcl_result.valid[i] == projected_result.valid[i];
+      unsafe += projected_result.valid[i] && !fcl_result.valid[i];
+    }
+    double unsafe_percent = projected_valid ? 100.0 * unsafe / projected_valid : 0.0;
+    std::cout << "fcl," << name << "_validity," << queries.size() << "," << fcl_result.per_s << ","
+              << 100.0 * fcl_valid / queries.size() << ",100,0" << std::endl;
+    std::cout << "projected," << name << "_validity," << queries.size() << "," << projected_result.per_s << ","
+              << 100.0 * projected_valid / queries.size() << "," << 100.0 * agree / queries.size() << ","
+              << unsafe_percent << std::endl;
+
+    if (unsafe_percent > max_unsafe_percent)
+    {
+      std::cerr << "FAILED: " << unsafe_percent << "% of the " << name
+                << " states free on the projected map are in collision for FCL" << std::endl;
+      failures++;
+    }
+    if (projected_valid == 0)
+    {
+      std::cerr << "FAILED: no " << name << " state is free on the projected map" << std::endl;
+      failures++;
+    }
+  }
+
+  // The cost lookup the objective makes for every state
+  t0 = Clock::now();
+  std::size_t below_lethal_cost = 0;
+  for (const auto& q : se2_queries)
+  {
+    below_lethal_cost += projected_map.cost(q.x, q.y) < 1.0f;
+  }
+  std::cout << "projected,cost," << se2_queries.size() << "," << se2_queries.size() / secondsSince(t0) << ","
+            << 100.0 * below_lethal_cost / se2_queries.size() << ",0,0" << std::endl;
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,321 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Query time of OSMElevationPlanner on a synthetic grid city: road points every
+meter along the streets of blocks x blocks city blocks, each street a
+separate OSM way, over rolling terrain. "road_graph" plans with A* on the
+RoadGraph of the road points, "ompl" with the control planner setup the
+plugin falls back to (ElevationStateSpace, Reeds-Shepp, states sampled on
+road points, every state valid), given planner_timeout per query. Both run
+the same random road point to road point queries. off_road_m is the mean
+distance of the path states to the nearest road point. Every road graph
+query has to succeed, with a path whose cost is at least the straight line
+distance, otherwise the benchmark exits with 1.
+Usage: road_graph_benchmark [blocks] [block_size_m] [num_queries] [planner_timeout_s] [ompl_planner]
+*/
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "ompl/control/SimpleSetup.h"
+#include "ompl/control/planners/rrt/RRT.h"
+#include "ompl/control/planners/sst/SST.h"
+#include "ompl/control/spaces/RealVectorControlSpace.h"
+#include "rclcpp/rclcpp.hpp"
+#include "vox_nav_planning/native_planners/InformedSGCP.hpp"
+#include "vox_nav_planning/native_planners/RRTStarF.hpp"
+#include "vox_nav_utilities/elevation_state_space.hpp"
+#include "vox_nav_utilities/road_graph.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+double terrainHeight(double x, double y)
+{
+  return 2.0 * std::sin(x / 60.0) * std::cos(y / 80.0);
+}
+
+pcl::PointCloud<pcl::PointXYZRGB>::Ptr makeGridCity(int blocks, double block_size)
+{
+  auto city = std::make_shared<pcl::PointCloud<pcl::PointXYZRGB>>();
+  double extent = blocks * block_size;
+  int way = 0;
+  for (int line = 0; line <= blocks; line++)
+  {
+    for (bool along_x : { true, false })
+    {
+      way++;
+      for (double s = 0.0; s <= extent; s += 1.0)
+      {
+        pcl::PointXYZRGB p;
+        p.x = along_x ? s : line * block_size;
+        p.y = along_x ? line * block_size : s;
+        p.z = terrainHeight(p.x, p.y);
+        // Ways are told apart by color, as in the map server
+        p.r = way % 256;
+        p.g = (way / 256) % 256;
+        p.b = 128;
+        city->points.push_back(p);
+      }
+    }
+  }
+  city->width = city->points.size();
+  city->height = 1;
+  return city;
+}
+
+// The propagation of OSMElevationPlanner, a unicycle with acceleration and turn rate controls
+void propagate(const ompl::control::SpaceInformation* si, const ompl::base::State* start,
+               const ompl::control::Control* control, const double duration, ompl::base::State* result)
+{
+  const auto* ee_start = start->as<ompl::base::ElevationStateSpace::StateType>();
+  const auto* ee_start_so2 = ee_start->as<ompl::base::SO2StateSpace::StateType>(0);
+  const auto* ee_start_xyzv = ee_start->as<ompl::base::RealVectorStateSpace::StateType>(1);
+  const double* ctrl = control->as<ompl::control::RealVectorControlSpace::ControlType>()->values;
+  double v = ee_start_xyzv->values[3];
+  double yaw = ee_start_so2->value;
+  result->as<ompl::base::ElevationStateSpace::StateType>()->setXYZV(
+      ee_start_xyzv->values[0] + duration * v * std::cos(yaw), ee_start_xyzv->values[1] + duration * v * std::sin(yaw),
+      ee_start_xyzv->values[2], v + duration * ctrl[0]);
+  result->as<ompl::base::ElevationStateSpace::StateType>()->setSO2(yaw + duration * ctrl[1]);
+  si->enforceBounds(result);
+}
+
+struct QueryResult
+{
+  bool solved = false;
+  double ms = 0.0;
+  double length = 0.0;
+  double off_road_m = 0.0;
+};
+
+double offRoad(const vox_nav_utilities::RoadGraph& graph, const Eigen::Vector3d& p)
+{
+  int nearest = graph.snap(p);
+  if (nearest < 0)
+  {
+    return graph.params().snap_max_distance;
+  }
+  return (graph.points().points[nearest].getVector3fMap().cast<double>() - p).norm();
+}
+
+QueryResult planOMPL(const pcl::PointCloud<pcl::PointXYZRGB>& city, const vox_nav_utilities::RoadGraph& graph,
+                     const Eigen::Vector3d& start, const Eigen::Vector3d& goal, double timeout,
+                     const std::string& planner_name)
+{
+  ompl::base::RealVectorBounds se2_bounds(2), z_bounds(1), v_bounds(1), control_bounds(2);
+  double extent = 0.0;
+  for (const auto& p : city.points)
+  {
+    extent = std::max<double>(extent, std::max(p.x, p.y));
+  }
+  se2_bounds.setLow(-1.0);
+  se2_bounds.setHigh(extent + 1.0);
+  z_bounds.setLow(-5.0);
+  z_bounds.setHigh(5.0);
+  v_bounds.setLow(-0.5);
+  v_bounds.setHigh(0.5);
+  control_bounds.setLow(-0.5);
+  control_bounds.setHigh(0.5);
+
+  auto state_space = std::make_shared<ompl::base::ElevationStateSpace>(
+      ompl::base::ElevationStateSpace::SE2StateType::REDDSSHEEP, 1.5, false);
+  state_space->setBounds(se2_bounds, z_bounds, v_bounds);
+  state_space->setLongestValidSegmentFraction(0.1);
+  auto control_space = std::make_shared<ompl::control::RealVectorControlSpace>(state_space, 2);
+  control_space->setBounds(control_bounds);
+  ompl::control::SimpleSetup setup(control_space);
+  setup.setStateValidityChecker([](const ompl::base::State*) { return true; });
+
+  auto si = setup.getSpaceInformation();
+  si->setMinMaxControlDuration(20, 30);
+  si->setPropagationStepSize(0.025);
+  setup.setStatePropagator([si_ptr = si.get()](const ompl::base::State* state, const ompl::control::Control* control,
+                                                const double duration, ompl::base::State* result) {
+    propagate(si_ptr, state, control, duration, result);
+  });
+
+  auto poses = std::make_shared<geometry_msgs::msg::PoseArray>();
+  for (const auto& p : city.points)
+  {
+    geometry_msgs::msg::Pose pose;
+    pose.position.x = p.x;
+    pose.position.y = p.y;
+    pose.position.z = p.z;
+    poses->poses.push_back(pose);
+  }
+  geometry_msgs::msg::PoseStamped start_pose, goal_pose;
+  start_pose.pose.position.x = start.x();
+  start_pose.pose.position.y = start.y();
+  start_pose.pose.position.z = start.z();
+  goal_pose.pose.position.x = goal.x();
+  goal_pose.pose.position.y = goal.y();
+  goal_pose.pose.position.z = goal.z();
+  si->setValidStateSamplerAllocator([&](const ompl::base::SpaceInformation*) {
+    return std::make_shared<ompl::base::OctoCellValidStateSampler>(si, start_pose, goal_pose, poses);
+  });
+
+  ompl::base::ScopedState<ompl::base::ElevationStateSpace> se3_start(state_space), se3_goal(state_space);
+  se3_start->setXYZV(start.x(), start.y(), start.z(), 0);
+  se3_start->setSO2(0);
+  se3_goal->setXYZV(goal.x(), goal.y(), start.z(), 0);
+  se3_goal->setSO2(0);
+  setup.setStartAndGoalStates(se3_start, se3_goal, 2.0);
+
+  ompl::base::PlannerPtr planner;
+  if (planner_name == "RRT")
+  {
+    planner = std::make_shared<ompl::control::RRT>(si);
+  }
+  else if (planner_name == "SST")
+  {
+    planner = std::make_shared<ompl::control::SST>(si);
+  }
+  else if (planner_name == "InformedSGCP")
+  {
+    planner = std::make_shared<ompl::control::InformedSGCP>(si);
+    planner->as<ompl::control::InformedSGCP>()->setUseValidSampler(true);
+    planner->as<ompl::control::InformedSGCP>()->setMaxDistBetweenVertices(5.0);
+    planner->as<ompl::control::InformedSGCP>()->setUseKNearest(true);
+    planner->as<ompl::control::InformedSGCP>()->setSolveControlGraph(false);
+    planner->as<ompl::control::InformedSGCP>()->setBatchSize(1000);
+  }
+  else
+  {
+    planner = std::make_shared<ompl::control::RRTStarF>(si);
+  }
+  setup.setPlanner(planner);
+  setup.setup();
+
+  QueryResult result;
+  auto t0 = Clock::now();
+  auto status = setup.solve(timeout);
+  result.ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+  result.solved = status == ompl::base::PlannerStatus::EXACT_SOLUTION;
+  if (status)
+  {
+    auto path = setup.getSolutionPath().asGeometric();
+    result.length = path.length();
+    for (size_t i = 0; i < path.getStateCount(); i++)
+    {
+      const auto* xyzv = path.getState(i)
+                             ->as<ompl::base::ElevationStateSpace::StateType>()
+                             ->as<ompl::base::RealVectorStateSpace::StateType>(1);
+      result.off_road_m +=
+          offRoad(graph, Eigen::Vector3d(xyzv->values[0], xyzv->values[1], xyzv->values[2])) / path.getStateCount();
+    }
+  }
+  return result;
+}
+
+void printSummary(const std::string& mode, const std::vector<QueryResult>& results, double build_ms)
+{
+  std::vector<double> times;
+  double length = 0.0, off_road = 0.0;
+  size_t solved = 0;
+  for (const auto& r : results)
+  {
+    times.push_back(r.ms);
+    if (r.solved)
+    {
+      solved++;
+      length += r.length;
+      off_road += r.off_road_m;
+    }
+  }
+  std::sort(times.begin(), times.end());
+  double mean = 0.0;
+  for (double t : times)
+  {
+    mean += t / times.size();
+  }
+  std::cout << mode << "," << results.size() << "," << solved << "," << build_ms << "," << mean << ","
+            << times[times.size() / 2] << "," << times.back() << "," << (solved ? length / solved : 0.0) << ","
+            << (solved ? off_road / solved : 0.0) << std::endl;
+}
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  int blocks = argc > 1 ? std::stoi(argv[1]) : 8;
+  double block_size = argc > 2 ? std::stod(argv[2]) : 50.0;
+  int num_queries = argc > 3 ? std::stoi(argv[3]) : 20;
+  double timeout = argc > 4 ? std::stod(argv[4]) : 5.0;
+  std::string ompl_planner = argc > 5 ? argv[5] : "RRTStarF";
+  // The planner visualizations are published only while rclcpp is initialized
+  rclcpp::init(argc, argv);
+
+  auto city = makeGridCity(blocks, block_size);
+
+  auto t0 = Clock::now();
+  vox_nav_utilities::RoadGraph graph(city);
+  double build_ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<size_t> pick(0, city->points.size() - 1);
+  std::vector<std::pair<Eigen::Vector3d, Eigen::Vector3d>> queries;
+  for (int i = 0; i < num_queries; i++)
+  {
+    queries.emplace_back(city->points[pick(rng)].getVector3fMap().cast<double>(),
+                         city->points[pick(rng)].getVector3fMap().cast<double>());
+  }
+
+  int failures = 0;
+  std::vector<QueryResult> graph_results;
+  for (const auto& query : queries)
+  {
+    vox_nav_utilities::RoadPathResult path;
+    QueryResult result;
+    auto q0 = Clock::now();
+    result.solved = graph.plan(query.first, query.second, path);
+    result.ms = std::chrono::duration<double, std::milli>(Clock::now() - q0).count();
+    result.length = path.cost;
+    for (const auto& p : path.points)
+    {
+      result.off_road_m += offRoad(graph, p) / path.points.size();
+    }
+    if (!result.solved || path.cost + 1e-3 < (query.second - query.first).norm())
+    {
+      std::cerr << "FAILED: road graph query from " << query.first.transpose() << " to "
+                << query.second.transpose() << std::endl;
+      failures++;
+    }
+    graph_results.push_back(result);
+  }
+
+  std::vector<QueryResult> ompl_results;
+  for (const auto& query : queries)
+  {
+    ompl_results.push_back(planOMPL(*city, graph, query.first, query.second, timeout, ompl_planner));
+  }
+
+  std::cout << "road_points,vertices,directed_edges" << std::endl;
+  std::cout << city->points.size() << "," << graph.numVertices() << "," << graph.numEdges() << std::endl;
+  std::cout << "mode,queries,solved,build_ms,mean_ms,p50_ms,max_ms,mean_length_m,off_road_m" << std::endl;
+  printSummary("road_graph", graph_results, build_ms);
+  printSummary("ompl_" + ompl_planner, ompl_results, 0.0);
+  rclcpp::shutdown();
+  return failures ? 1 : 0;
+}
@@ -36,6 +36,7 @@
 #include <pcl/point_types.h>
 #include <pcl_conversions/pcl_conversions.h>
 #include <pcl/octree/octree_search.h>
+#include <pcl/kdtree/kdtree_flann.h>
 #include <pcl/filters/random_sample.h>
 // OMPL GEOMETRIC
 #include <ompl/geometric/planners/fmt/BFMT.h>
@@ -70,6 +71,7 @@
 #include <ompl/base/spaces/SE3StateSpace.h>
 #include <ompl/tools/benchmark/Benchmark.h>
 #include <ompl/base/StateSampler.h>
+#include <ompl/util/RandomNumbers.h>
 // OCTOMAP
 #include <octomap_msgs/msg/octomap.hpp>
 #include <octomap_msgs/conversions.h>
@@ -171,6 +173,11 @@ namespace ompl
 
       const RealVectorBounds getBounds() const;
 
+      SE2StateType getSE2StateType() const
+      {
+        return se2_state_type_;
+      }
+
       State * allocState() const override;
 
       void freeState(State * state) const override;
@@ -197,47 +204,105 @@ namespace ompl
       std::shared_ptr<RealVectorStateSpace> real_vector_;
       std::shared_ptr<SO2StateSpace> so2_;
 
-      ompl::base::State * state1_se2_;
-      ompl::base::State * state2_se2_;
-
-      ompl::base::State * interpolation_state1_se2_;
-      ompl::base::State * interpolation_state2_se2_;
-      ompl::base::State * interpolated_state_se2_;
-
       double rho_;
       bool isSymmetric_;
     };
 
-    class OctoCellValidStateSampler : public ValidStateSampler
+    /**
+     * @brief Walker's alias table, draws index i with probability weights[i] / sum(weights) in O(1).
+     * All weights zero (or none positive) draw uniformly.
+     */
+    class AliasTable
     {
     public:
-      OctoCellValidStateSampler(
-        const ompl::base::SpaceInformationPtr & si,
-        const geometry_msgs::msg::PoseStamped start,
-        const geometry_msgs::msg::PoseStamped goal,
-        const geometry_msgs::msg::PoseArray::SharedPtr & elevated_surfels_poses);
+      AliasTable() = default;
+
+      explicit AliasTable(const std::vector<double> & weights);
+
+      std::size_t sample(RNG & rng) const;
+
+      std::size_t size() const
+      {
+        return prob_.size();
+      }
+
+    protected:
+      std::vector<double> prob_;
+      std::vector<std::size_t> alias_;
+    };
+
+    /**
+     * @brief Valid states on the surfels of a map. The surfels and their KD-tree are shared, e.g. with the
+     * MapSnapshot of the map, and not copied. Within the search area (all surfels until updateSearchArea())
+     * sample() draws a surfel in O(1) from an alias table, uniformly or by the tilt cost of the surfels;
+     * sampleNear() is one radius query of the KD-tree. Every sampler has its own RNG, seeded by OMPL
+     * or setSeed(), so a sampler must not be shared between threads, as OMPL allocates one per planner thread.
+     */
+    class SurfelValidStateSampler : public ValidStateSampler
+    {
+    public:
+      enum class Weighting
+      {
+        UNIFORM,
+        // 1 / (1 + tilt in degrees), the tilt being the larger of the roll and pitch of the surfel
+        TILT_COST
+      };
+
+      /**
+       * @param surfels with roll, pitch, yaw in the normal, as fillSurfelsfromMsgPoses makes them
+       * @param kdtree over surfels, built here if null
+       */
+      SurfelValidStateSampler(
+        const SpaceInformation * si,
+        const pcl::PointCloud<pcl::PointSurfel>::ConstPtr & surfels,
+        const std::shared_ptr<const pcl::KdTreeFLANN<pcl::PointSurfel>> & kdtree = nullptr,
+        Weighting weighting = Weighting::UNIFORM);
 
-      bool sample(ompl::base::State * state) override;
+      bool sample(State * state) override;
 
-      bool sampleNear(
-        ompl::base::State * state,
-        const ompl::base::State * near,
-        const double distance) override;
+      bool sampleNear(State * state, const State * near, const double distance) override;
 
+      // Restrict sample() to the surfels within the ball having the start and goal on its diameter
       void updateSearchArea(
         const geometry_msgs::msg::PoseStamped start,
         const geometry_msgs::msg::PoseStamped goal);
 
+      void setSeed(std::uint_fast32_t seed);
+
+      // Indices of the surfels sample() draws from
+      const std::vector<int> & getSearchArea() const
+      {
+        return search_area_;
+      }
+
+      // Unnormalized probability of a surfel to be drawn by sample()
+      double getSurfelWeight(const pcl::PointSurfel & surfel) const;
+
     protected:
-      rclcpp::Logger logger_{rclcpp::get_logger("octo_cell_valid_state_sampler")};
-      geometry_msgs::msg::PoseArray elevated_surfels_poses_;
-      pcl::PointCloud<pcl::PointSurfel>::Ptr workspace_surfels_;
-      pcl::PointCloud<pcl::PointSurfel>::Ptr search_area_surfels_;
-      std::discrete_distribution<> distrubutions_;
-      std::random_device rd_;
-      std::mt19937 rng_;
-
-      std::shared_ptr<std::uniform_int_distribution<>> int_distr_;
+      void setSearchArea(std::vector<int> && search_area);
+
+      rclcpp::Logger logger_{rclcpp::get_logger("surfel_valid_state_sampler")};
+      pcl::PointCloud<pcl::PointSurfel>::ConstPtr surfels_;
+      std::shared_ptr<const pcl::KdTreeFLANN<pcl::PointSurfel>> kdtree_;
+      Weighting weighting_;
+      std::vector<int> search_area_;
+      AliasTable alias_table_;
+      RNG rng_;
+
+      // Radius query results, kept to not allocate on every sampleNear()
+      std::vector<int> near_indices_;
+      std::vector<float> near_squared_distances_;
+    };
+
+    // SurfelValidStateSampler on its own copy of surfels given as poses
+    class OctoCellValidStateSampler : public SurfelValidStateSampler
+    {
+    public:
+      OctoCellValidStateSampler(
+        const ompl::base::SpaceInformationPtr & si,
+        const geometry_msgs::msg::PoseStamped start,
+        const geometry_msgs::msg::PoseStamped goal,
+        const geometry_msgs::msg::PoseArray::SharedPtr & elevated_surfels_poses);
     };
 
     class ElevationStateSpaceProjection : public base::ProjectionEvaluator
@@ -0,0 +1,149 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_UTILITIES__GEODETIC_CONVERSIONS_HPP_
+#define VOX_NAV_UTILITIES__GEODETIC_CONVERSIONS_HPP_
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+#include <vector>
+
+namespace vox_nav_utilities
+{
+
+/**
+ * @brief WGS84 coordinate in degrees and meters above the ellipsoid
+ *
+ */
+  struct GeoPoint
+  {
+    double latitude{0.0};
+    double longitude{0.0};
+    double altitude{0.0};
+  };
+
+  struct UTMPoint
+  {
+    double easting{0.0};
+    double northing{0.0};
+    double altitude{0.0};
+    int zone{0};
+    bool north{true};
+  };
+
+/**
+ * @brief Standard UTM zone of a coordinate, including the Norway and Svalbard exceptions
+ *
+ * @param latitude
+ * @param longitude
+ * @return int
+ */
+  int utmZone(double latitude, double longitude);
+
+/**
+ * @brief WGS84 to UTM with the 6th order Krueger series, accurate to well below a millimeter
+ * within a zone
+ *
+ * @param geo
+ * @param force_zone project into this zone instead of the standard one when > 0
+ * @return UTMPoint
+ */
+  UTMPoint geoToUTM(const GeoPoint & geo, int force_zone = 0);
+
+/**
+ * @brief Inverse of geoToUTM
+ *
+ * @param utm
+ * @return GeoPoint
+ */
+  GeoPoint utmToGeo(const UTMPoint & utm);
+
+  Eigen::Vector3d geoToECEF(const GeoPoint & geo);
+
+  GeoPoint ecefToGeo(const Eigen::Vector3d & ecef);
+
+/**
+ * @brief Converts between WGS84 and a robot's map frame, the same way
+ * robot_localization's navsat_transform does for /fromLL: a coordinate is
+ * projected into a fixed UTM zone and moved into the map with the utm -> map
+ * transform. Also converts to the local ENU tangent plane at the map origin.
+ * The transform is set once, either from the utm -> map TF or from a single
+ * /fromLL lookup, after which every conversion is done in process.
+ *
+ */
+  class GeodeticConverter
+  {
+  public:
+    GeodeticConverter() = default;
+
+    /**
+     * @brief Anchor the converter with one known correspondence
+     *
+     * @param datum geodetic coordinate of the anchor
+     * @param datum_in_map where the anchor is in the map frame, e.g. the map_point of /fromLL
+     * @param map_yaw rotation about z from the UTM grid axes to the map axes, 0 if they are aligned
+     */
+    void setDatum(
+      const GeoPoint & datum,
+      const Eigen::Vector3d & datum_in_map = Eigen::Vector3d::Zero(),
+      double map_yaw = 0.0);
+
+    /**
+     * @brief Anchor the converter with the utm -> map transform, as published by navsat_transform
+     *
+     * @param zone UTM zone of the utm frame, every coordinate is projected into it
+     * @param north hemisphere of the utm frame
+     * @param map_from_utm pose of the utm frame in the map frame
+     */
+    void setUTMToMap(int zone, bool north, const Eigen::Isometry3d & map_from_utm);
+
+    bool hasDatum() const {return has_datum_;}
+
+    // Geodetic coordinate of the map origin, also the origin of the ENU plane
+    const GeoPoint & datum() const {return datum_;}
+
+    Eigen::Vector3d geoToMap(const GeoPoint & geo) const;
+
+    GeoPoint mapToGeo(const Eigen::Vector3d & map) const;
+
+    // East, north, up in the tangent plane at the map origin
+    Eigen::Vector3d geoToENU(const GeoPoint & geo) const;
+
+    GeoPoint enuToGeo(const Eigen::Vector3d & enu) const;
+
+    // Batch versions, output is resized to the size of the input
+    void geoToMap(const std::vector<GeoPoint> & geo, std::vector<Eigen::Vector3d> & map) const;
+
+    void mapToGeo(const std::vector<Eigen::Vector3d> & map, std::vector<GeoPoint> & geo) const;
+
+    void geoToENU(const std::vector<GeoPoint> & geo, std::vector<Eigen::Vector3d> & enu) const;
+
+    void enuToGeo(const std::vector<Eigen::Vector3d> & enu, std::vector<GeoPoint> & geo) const;
+
+  private:
+    bool has_datum_{false};
+    int zone_{0};
+    bool north_{true};
+    Eigen::Isometry3d map_from_utm_{Eigen::Isometry3d::Identity()};
+    Eigen::Isometry3d utm_from_map_{Eigen::Isometry3d::Identity()};
+    GeoPoint datum_;
+    Eigen::Vector3d datum_ecef_{Eigen::Vector3d::Zero()};
+    // Rows are the east, north and up axes in ECEF
+    Eigen::Matrix3d ecef_to_enu_{Eigen::Matrix3d::Identity()};
+  };
+
+}  // namespace vox_nav_utilities
+
+#endif  // VOX_NAV_UTILITIES__GEODETIC_CONVERSIONS_HPP_
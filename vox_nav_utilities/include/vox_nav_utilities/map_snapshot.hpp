@@ -0,0 +1,131 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_UTILITIES__MAP_SNAPSHOT_HPP_
+#define VOX_NAV_UTILITIES__MAP_SNAPSHOT_HPP_
+
+#include <fcl/config.h>
+#include <fcl/geometry/octree/octree.h>
+#include <fcl/narrowphase/collision_object.h>
+#include <octomap/octomap.h>
+#include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <geometry_msgs/msg/pose_array.hpp>
+#include <vox_nav_msgs/srv/get_traversability_map.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace vox_nav_utilities
+{
+
+/**
+ * @brief One version of the maps served by get_traversability_map, decoded
+ * once and shared by every planner plugin of the process. Each part is
+ * decoded the first time it is asked for, so a plugin that only needs the
+ * original octomap does not pay for the surfel structures.
+ * Everything returned is shared between the plugins and must be treated as
+ * read only; in particular the map collision objects must never be moved with
+ * setTransform, collide the robot object against them instead.
+ *
+ */
+  class MapSnapshot
+  {
+  public:
+    using Response = vox_nav_msgs::srv::GetTraversabilityMap::Response;
+
+    MapSnapshot(Response::ConstSharedPtr response, uint64_t version);
+
+    // Hash of the map contents, equal snapshots have equal versions
+    uint64_t version() const {return version_;}
+
+    const Response & response() const {return *response_;}
+
+    std::shared_ptr<octomap::OcTree> originalOctree() const;
+    std::shared_ptr<fcl::CollisionObjectf> originalCollisionObject() const;
+
+    std::shared_ptr<octomap::OcTree> collisionOctree() const;
+    std::shared_ptr<fcl::CollisionObjectf> collisionCollisionObject() const;
+
+    std::shared_ptr<octomap::OcTree> elevatedSurfelOctree() const;
+    std::shared_ptr<fcl::CollisionObjectf> elevatedSurfelCollisionObject() const;
+
+    geometry_msgs::msg::PoseArray::SharedPtr elevatedSurfelPoses() const;
+
+    // Surfels at the elevated poses, roll pitch yaw stored in the normal
+    pcl::PointCloud<pcl::PointSurfel>::Ptr elevatedSurfelCloud() const;
+
+    std::shared_ptr<const pcl::KdTreeFLANN<pcl::PointSurfel>> elevatedSurfelKdTree() const;
+
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr traversableElevatedCloud() const;
+
+  private:
+    struct OctreePart
+    {
+      std::once_flag once;
+      std::shared_ptr<octomap::OcTree> octree;
+      std::shared_ptr<fcl::CollisionObjectf> collision_object;
+    };
+
+    void decode(OctreePart & part, const octomap_msgs::msg::Octomap & msg) const;
+    void decodeSurfels() const;
+
+    Response::ConstSharedPtr response_;
+    uint64_t version_;
+
+    mutable OctreePart original_;
+    mutable OctreePart collision_;
+    mutable OctreePart elevated_surfel_;
+
+    mutable std::once_flag surfels_once_;
+    mutable geometry_msgs::msg::PoseArray::SharedPtr elevated_surfel_poses_;
+    mutable pcl::PointCloud<pcl::PointSurfel>::Ptr elevated_surfel_cloud_;
+    mutable std::shared_ptr<pcl::KdTreeFLANN<pcl::PointSurfel>> elevated_surfel_kdtree_;
+
+    mutable std::once_flag traversable_once_;
+    mutable pcl::PointCloud<pcl::PointXYZRGB>::Ptr traversable_elevated_cloud_;
+  };
+
+/**
+ * @brief Process wide registry of map snapshots. Plugins hand it the
+ * response they got from get_traversability_map and borrow the snapshot of
+ * that map version; the first plugin asking for a version creates it, the
+ * others share it. A snapshot lives as long as one plugin still holds it.
+ *
+ */
+  class MapSnapshotRegistry
+  {
+  public:
+    static MapSnapshotRegistry & instance();
+
+    std::shared_ptr<const MapSnapshot> acquire(MapSnapshot::Response::ConstSharedPtr response);
+
+    // Number of snapshots created so far, i.e. map versions decoded
+    size_t created() const;
+
+  private:
+    MapSnapshotRegistry() = default;
+
+    mutable std::mutex mutex_;
+    std::unordered_multimap<uint64_t, std::weak_ptr<const MapSnapshot>> snapshots_;
+    size_t created_{0};
+  };
+
+}  // namespace vox_nav_utilities
+
+#endif  // VOX_NAV_UTILITIES__MAP_SNAPSHOT_HPP_
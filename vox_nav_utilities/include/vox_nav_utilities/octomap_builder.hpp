@@ -0,0 +1,148 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_UTILITIES__OCTOMAP_BUILDER_HPP_
+#define VOX_NAV_UTILITIES__OCTOMAP_BUILDER_HPP_
+
+#include <octomap/octomap.h>
+#include <octomap/ColorOcTree.h>
+
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+
+  struct OctomapBuilderParams
+  {
+    double resolution{0.2};
+    // Cast a ray from sensor_origin to every point and mark the voxels it passes as free, as
+    // ColorOcTree::insertPointCloud does. The planners only look at occupied voxels, and the
+    // rays of a whole map are by far the slowest part, so it is off by default
+    bool clear_free_space{false};
+    double sensor_origin_x{0.0};
+    double sensor_origin_y{0.0};
+    double sensor_origin_z{0.0};
+    // Split the map into x, y tiles of this size, one tree per tile, 0 for a single tree
+    double tile_size{0.0};
+    // Worker threads, 0 for one per hardware thread
+    unsigned int num_threads{0};
+  };
+
+  // Voxel of the finest resolution, keys interleaved into a Morton code, which sorts the voxels
+  // in the depth first order of the octree
+  struct OctomapVoxel
+  {
+    uint64_t morton;
+    float log_odds;
+    uint8_t r, g, b;
+  };
+
+  struct OctomapTile
+  {
+    int x;
+    int y;
+    std::shared_ptr<octomap::ColorOcTree> tree;
+  };
+
+/**
+ * @brief Converts colored point clouds of the map server layout into
+ * ColorOcTrees without inserting them point by point. The keys of all points
+ * are computed and sorted in parallel, the points of a voxel are aggregated
+ * into one occupied voxel (highest cost, average color), and the leaves are
+ * created directly in depth first order, descending only from the deepest
+ * node shared with the previous leaf. Inner nodes are updated once at the
+ * end. Yellow points (elevated node centers) are left out and the cost of
+ * a point is its blue channel, 1 for red obstacle points, as in
+ * PCL2OctomapConverter.
+ *
+ */
+  class OctomapBuilder
+  {
+  public:
+    explicit OctomapBuilder(const OctomapBuilderParams & params = OctomapBuilderParams());
+
+    const OctomapBuilderParams & params() const {return params_;}
+
+    /**
+     * @brief Sort and aggregate the voxels of a cloud, replacing those of a previous one
+     *
+     * @param cloud
+     */
+    void build(const pcl::PointCloud<pcl::PointXYZRGB> & cloud);
+
+    const std::vector<OctomapVoxel> & occupiedVoxels() const {return occupied_;}
+
+    const std::vector<OctomapVoxel> & freeVoxels() const {return free_;}
+
+    // The whole map as one tree, also when tile_size is set
+    std::shared_ptr<octomap::ColorOcTree> tree() const;
+
+    // The map split into tiles of tile_size, built in parallel
+    std::vector<OctomapTile> tiles() const;
+
+    /**
+     * @brief Write the tree, or each tile to filename with _<x>_<y> before its extension
+     *
+     * @param filename
+     * @return std::vector<std::string> the files written
+     */
+    std::vector<std::string> write(const std::string & filename) const;
+
+    /**
+     * @brief Write tiles made by tiles() to filename with _<x>_<y> before its extension
+     *
+     * @param filename
+     * @param tiles
+     * @return std::vector<std::string> the files written
+     */
+    static std::vector<std::string> writeTiles(
+      const std::string & filename,
+      const std::vector<OctomapTile> & tiles);
+
+    static uint64_t keyToMorton(const octomap::OcTreeKey & key);
+
+    static octomap::OcTreeKey mortonToKey(uint64_t morton);
+
+  private:
+    std::shared_ptr<octomap::ColorOcTree> makeTree(
+      const std::vector<const std::vector<OctomapVoxel> *> & voxel_lists) const;
+
+    unsigned int numThreads() const;
+
+    OctomapBuilderParams params_;
+    std::vector<OctomapVoxel> occupied_;
+    std::vector<OctomapVoxel> free_;
+  };
+
+  /**
+   * @brief The conversion PCL2OctomapConverter has always done: ray cast the
+   * cloud into the tree from the origin, then set the value and color of the
+   * voxel of every point, the last point of a voxel wins
+   *
+   * @param cloud
+   * @param tree
+   */
+  void insertCloudByRayCasting(
+    const pcl::PointCloud<pcl::PointXYZRGB> & cloud,
+    octomap::ColorOcTree & tree);
+
+}  // namespace vox_nav_utilities
+
+#endif  // VOX_NAV_UTILITIES__OCTOMAP_BUILDER_HPP_
@@ -36,6 +36,7 @@
 #include "rclcpp/rclcpp.hpp"
 #include "visualization_msgs/msg/marker_array.hpp"
 #include "vox_nav_utilities/pcl_helpers.hpp"
+#include "vox_nav_utilities/octomap_builder.hpp"
 #include <tf2_eigen/tf2_eigen.h>
 
 
@@ -57,6 +58,14 @@ namespace vox_nav_utilities
     double remove_outlier_stddev_threshold_;
     double remove_outlier_radius_search_;
     int remove_outlier_min_neighbors_in_radius_;
+    // Build the voxels directly with OctomapBuilder instead of ray casting the cloud into the tree
+    bool use_direct_build_;
+    // Mark the voxels between the origin and the points as free, what ray casting always did
+    bool clear_free_space_;
+    // Write tiles of this size instead of a single tree, 0 to disable, direct build only. The
+    // whole map is then never built as one tree, markers and statistics are made per tile
+    double output_tile_size_;
+    int num_threads_;
     pcl::PointCloud<pcl::PointXYZRGB>::Ptr pointcloud_;
     // Used to creted a periodic callback function IOT publish transfrom/octomap/cloud etc.
     rclcpp::TimerBase::SharedPtr timer_;
@@ -84,7 +93,7 @@ namespace vox_nav_utilities
      * @param num_other
      */
     void calcThresholdedNodes(
-      const octomap::ColorOcTree tree,
+      const octomap::ColorOcTree & tree,
       unsigned int & num_thresholded,
       unsigned int & num_other);
 
@@ -93,7 +102,14 @@ namespace vox_nav_utilities
      *
      * @param tree
      */
-    void outputStatistics(const octomap::ColorOcTree tree);
+    void outputStatistics(const octomap::ColorOcTree & tree);
+
+    /**
+     * @brief Add the occupied leaves of a tree to octomap_markers_
+     *
+     * @param tree
+     */
+    void addToMarkers(const octomap::ColorOcTree & tree);
 
     /**
      * @brief
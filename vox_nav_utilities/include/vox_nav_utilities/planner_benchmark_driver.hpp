@@ -0,0 +1,173 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_UTILITIES__PLANNER_BENCHMARK_DRIVER_HPP_
+#define VOX_NAV_UTILITIES__PLANNER_BENCHMARK_DRIVER_HPP_
+
+#include <ompl/geometric/SimpleSetup.h>
+#include <ompl/tools/benchmark/Benchmark.h>
+
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+
+  struct PlannerBenchmarkDriverParams
+  {
+    // Append only log of the finished runs, read back to resume an interrupted benchmark
+    std::string results_log;
+    // Worker processes, 0 for one per hardware thread. Workers share the CPUs, so the
+    // timings are only comparable between benchmarks run with the same number of workers
+    unsigned int num_workers{1};
+    // Passes over the runs left when workers crashed, a pass that finishes none ends them
+    int max_attempts{3};
+  };
+
+  // One run of a planner on the problem of an epoch
+  struct PlannerBenchmarkTask
+  {
+    int epoch;
+    std::string planner;
+    int run;
+  };
+
+  struct PlannerBenchmarkRecord
+  {
+    PlannerBenchmarkTask task;
+    // As OMPL records them, names carry their type, e.g. "time REAL"
+    ompl::tools::Benchmark::RunProperties properties;
+  };
+
+/**
+ * @brief Runs (epoch, planner, run) tasks in forked worker processes and
+ * checkpoints every finished run to an append only results log. Every worker
+ * calls a setup function first, so it can build its own collision objects,
+ * then runs its share of the tasks. Tasks found in the log are not run again,
+ * so a benchmark that was killed or crashed resumes where it stopped; the
+ * runs lost with a crashed worker are retried. OMPL's seed generator is
+ * reseeded from (epoch, planner, run) before every task, so the runs of a
+ * planner are independent of each other and of the worker that runs them.
+ * Values a benchmark needs to repeat itself, e.g. the randomly drawn problem
+ * of an epoch, are kept in the same log.
+ *
+ */
+  class PlannerBenchmarkDriver
+  {
+  public:
+    using WorkerSetup = std::function<void()>;
+    using RunFunction =
+      std::function<ompl::tools::Benchmark::RunProperties(const PlannerBenchmarkTask &)>;
+
+    explicit PlannerBenchmarkDriver(const PlannerBenchmarkDriverParams & params);
+
+    const PlannerBenchmarkDriverParams & params() const {return params_;}
+
+    // Finished runs in the order they were logged, the first one of a task if it was logged twice
+    const std::vector<PlannerBenchmarkRecord> & runs() const {return runs_;}
+
+    bool isFinished(const PlannerBenchmarkTask & task) const;
+
+    /**
+     * @brief Value recorded with key by this or an earlier benchmark on the same log
+     *
+     * @param key
+     * @param value
+     * @return true if there is one
+     */
+    bool recorded(const std::string & key, std::string & value) const;
+
+    void record(const std::string & key, const std::string & value);
+
+    /**
+     * @brief Run the tasks that are not finished yet, each once, sharded across the workers
+     *
+     * @param tasks
+     * @param setup called once in every worker before its first task
+     * @param run called in the workers, must not use state shared with other processes
+     * @return size_t number of tasks still not finished
+     */
+    size_t run(
+      const std::vector<PlannerBenchmarkTask> & tasks,
+      const WorkerSetup & setup,
+      const RunFunction & run);
+
+  private:
+    // Reads the log from where it was last read
+    void load();
+
+    void append(const std::string & line) const;
+
+    PlannerBenchmarkDriverParams params_;
+    std::vector<PlannerBenchmarkRecord> runs_;
+    std::set<std::tuple<int, std::string, int>> finished_;
+    std::map<std::string, std::string> values_;
+    size_t log_offset_{0};
+  };
+
+  /**
+   * @brief One run of a planner with ompl::tools::Benchmark, so the run
+   * records the same properties as in a benchmark of all runs at once.
+   * Progress properties are not recorded.
+   *
+   * @param ss
+   * @param planner
+   * @param request maxTime, maxMem and the other options, runCount is ignored
+   * @return ompl::tools::Benchmark::RunProperties
+   */
+  ompl::tools::Benchmark::RunProperties runPlannerOnce(
+    ompl::geometric::SimpleSetup & ss,
+    const ompl::base::PlannerPtr & planner,
+    const ompl::tools::Benchmark::Request & request);
+
+  /**
+   * @brief Write runs of one problem in the log format of
+   * ompl::tools::Benchmark::saveResultsToFile, for ompl_benchmark_statistics.py
+   * and Planner Arena. Planners are written in the given order, their runs in
+   * the order of their run index.
+   *
+   * @param ss the problem the runs solved
+   * @param planners name of the tasks and a planner of that kind, for its parameters
+   * @param runs
+   * @param request
+   * @param experiment_name
+   * @param filename
+   * @return true if the file was written
+   */
+  bool saveMergedResults(
+    ompl::geometric::SimpleSetup & ss,
+    const std::vector<std::pair<std::string, ompl::base::PlannerPtr>> & planners,
+    const std::vector<PlannerBenchmarkRecord> & runs,
+    const ompl::tools::Benchmark::Request & request,
+    const std::string & experiment_name,
+    const std::string & filename);
+
+  /**
+   * @brief Mean of every numeric property per epoch and planner, and over all
+   * epochs per planner (epoch "all"), as CSV
+   *
+   * @param runs
+   * @param filename
+   * @return true if the file was written
+   */
+  bool saveCsvSummary(const std::vector<PlannerBenchmarkRecord> & runs, const std::string & filename);
+
+}  // namespace vox_nav_utilities
+
+#endif  // VOX_NAV_UTILITIES__PLANNER_BENCHMARK_DRIVER_HPP_
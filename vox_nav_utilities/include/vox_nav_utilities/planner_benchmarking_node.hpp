@@ -26,6 +26,7 @@
 #include <tf2_geometry_msgs/tf2_geometry_msgs.h>
 #include <visualization_msgs/msg/marker_array.hpp>
 #include <vox_nav_utilities/elevation_state_space.hpp>
+#include <vox_nav_utilities/planner_benchmark_driver.hpp>
 #include <vox_nav_utilities/pcl_helpers.hpp>
 #include <vox_nav_utilities/tf_helpers.hpp>
 // PCL
@@ -58,6 +59,7 @@
 #include <ompl/geometric/planners/sst/SST.h>
 // OMPL BASE
 #include <ompl/base/OptimizationObjective.h>
+#include <ompl/base/goals/GoalState.h>
 #include <ompl/base/objectives/MaximizeMinClearanceObjective.h>
 #include <ompl/base/objectives/PathLengthOptimizationObjective.h>
 #include <ompl/base/objectives/StateCostIntegralObjective.h>
@@ -80,11 +82,15 @@
 #include "fcl/narrowphase/collision.h"
 #include "fcl/narrowphase/collision_object.h"
 // STL
+#include <algorithm>
+#include <iomanip>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <random>
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace vox_nav_utilities
@@ -138,6 +144,10 @@ namespace vox_nav_utilities
     int batch_size_;
     int epochs_;
     int max_memory_;
+    // Worker processes the (planner, run) pairs are sharded across
+    int num_workers_;
+    // Finished runs are checkpointed here, an interrupted benchmark resumes from it
+    std::string results_log_;
     bool publish_a_sample_bencmark_;
     std::string sample_bencmark_plans_topic_;
 
@@ -181,6 +191,32 @@ namespace vox_nav_utilities
      */
     std::map<int, ompl::geometric::PathGeometric> doBenchMarking();
 
+    /**
+     * @brief Draw a random start and goal pair that is valid, far enough apart
+     * and solvable
+     *
+     * @param ss
+     * @param start
+     * @param goal
+     */
+    void sampleProblem(
+      ompl::geometric::SimpleSetup & ss,
+      GroundRobotPose & start,
+      GroundRobotPose & goal);
+
+    /**
+     * @brief Set start, goal, state validity checker and optimization objective
+     * of a benchmark problem
+     *
+     * @param ss
+     * @param start
+     * @param goal
+     */
+    void setupProblem(
+      ompl::geometric::SimpleSetup & ss,
+      const GroundRobotPose & start,
+      const GroundRobotPose & goal);
+
     /**
      * @brief Callback to subscribe ang get octomap
      *
@@ -134,6 +134,24 @@ namespace vox_nav_utilities
     const pcl::PointCloud<pcl::PointSurfel>::Ptr & elevated_surfel_cloud
   );
 
+/**
+ * @brief Same as above with a KD-tree that is already built over the
+ * elevated surfels, e.g. the one of a MapSnapshot
+ *
+ * @param nearest_valid_start
+ * @param nearest_valid_goal
+ * @param actual_start
+ * @param actual_goal
+ * @param elevated_surfel_kdtree
+ */
+  void determineValidNearestGoalStart(
+    geometry_msgs::msg::PoseStamped & nearest_valid_start,
+    geometry_msgs::msg::PoseStamped & nearest_valid_goal,
+    const geometry_msgs::msg::PoseStamped & actual_start,
+    const geometry_msgs::msg::PoseStamped & actual_goal,
+    const pcl::KdTreeFLANN<pcl::PointSurfel> & elevated_surfel_kdtree
+  );
+
   /**
    * @brief
    *
@@ -0,0 +1,173 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_UTILITIES__PROJECTED_MAP_HPP_
+#define VOX_NAV_UTILITIES__PROJECTED_MAP_HPP_
+
+#include <octomap/octomap.h>
+
+#include <ompl/base/objectives/StateCostIntegralObjective.h>
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+
+  struct ProjectedMapParams
+  {
+    // Footprint of the robot body, length along its heading
+    double footprint_length{1.0};
+    double footprint_width{0.6};
+    // Voxels higher than this above the ground of their column pass over the robot, e.g. branches
+    double clearance_height{0.5};
+    // Cells with obstacles higher than this above their ground are lethal, lower ones are driven over
+    double max_step_height{0.2};
+    // Length over which the proximity cost decays away from the inscribed radius of the footprint
+    double cost_decay_distance{1.0};
+  };
+
+/**
+ * @brief 2.5D projection of an octomap for robots that drive on the ground.
+ * Every x, y column of the octomap becomes a cell keeping the height of the
+ * lowest voxel (the ground), of the highest one and of the highest one within
+ * clearance_height of the ground (the obstacle). Cells whose obstacle is more
+ * than max_step_height above the ground are lethal; a distance transform of
+ * the lethal cells gives every cell its distance to the nearest one, from
+ * which the footprint checks and the cost are looked up in constant time.
+ * The grid is built once and padded by the footprint around the octomap,
+ * positions off the grid are free with zero cost as nothing is mapped there.
+ * Queries do not modify the map and can run concurrently.
+ *
+ */
+  class ProjectedMap
+  {
+  public:
+    ProjectedMap(const octomap::OcTree & octree, const ProjectedMapParams & params = ProjectedMapParams());
+
+    const ProjectedMapParams & params() const {return params_;}
+
+    double resolution() const {return resolution_;}
+
+    int width() const {return width_;}
+
+    int height() const {return height_;}
+
+    size_t numLethalCells() const {return num_lethal_cells_;}
+
+    // Index of the cell containing x, y, -1 off the grid
+    int cellIndex(double x, double y) const;
+
+    // Lowest occupied voxel of the column, NaN where nothing is mapped
+    float groundHeight(double x, double y) const;
+
+    // Highest occupied voxel of the column, NaN where nothing is mapped
+    float topHeight(double x, double y) const;
+
+    // Highest occupied voxel within clearance_height of the ground, relative to the ground
+    float obstacleHeight(double x, double y) const;
+
+    // Distance to the nearest lethal cell, infinity if there is none
+    float obstacleDistance(double x, double y) const;
+
+    /**
+     * @brief Traversal cost in [0, 1], the larger of the step height relative
+     * to max_step_height and the proximity to lethal cells. 1 on lethal cells
+     * and within the inscribed radius of the footprint.
+     *
+     */
+    float cost(double x, double y) const;
+
+    /**
+     * @brief Whether the footprint at x, y, yaw is off the lethal cells. Far
+     * from and close to them the distance transform decides, only in between
+     * the cells under the footprint are looked at, a number independent of
+     * the map size.
+     *
+     */
+    bool isFootprintFree(double x, double y, double yaw) const;
+
+    /**
+     * @brief Whether an axis aligned robot body with its bottom at bottom_z
+     * is above every voxel under its footprint at x, y, for planners that
+     * move the body in 3D without rotating it.
+     *
+     */
+    bool isBodyAboveTerrain(double x, double y, double bottom_z) const;
+
+  private:
+    void buildColumns(const octomap::OcTree & octree);
+    void buildDistances();
+    void buildCosts();
+    void buildFootprint();
+
+    bool isLethal(double x, double y) const;
+
+    ProjectedMapParams params_;
+    double resolution_;
+    // Center of cell 0, cells are row major along x
+    double origin_x_;
+    double origin_y_;
+    int width_;
+    int height_;
+    size_t num_lethal_cells_{0};
+
+    std::vector<float> ground_;
+    std::vector<float> top_;
+    std::vector<float> obstacle_;
+    std::vector<uint8_t> lethal_;
+    std::vector<float> distance_;
+    std::vector<float> cost_;
+    // Highest voxel under the axis aligned footprint centered on the cell
+    std::vector<float> footprint_top_;
+
+    double inscribed_radius_;
+    double circumscribed_radius_;
+    // Points covering the footprint at half the resolution, in the body frame
+    std::vector<std::pair<double, double>> footprint_points_;
+  };
+
+/**
+ * @brief Integral of 1 + cost_weight * ProjectedMap::cost along the path, so
+ * a path costs its length with every meter made more expensive by the
+ * terrain it crosses. Works with the SE2 (also Dubins, Reeds-Shepp) and SE3
+ * state spaces, only x and y are looked at.
+ *
+ */
+  class ProjectedMapCostObjective : public ompl::base::StateCostIntegralObjective
+  {
+  public:
+    ProjectedMapCostObjective(
+      const ompl::base::SpaceInformationPtr & si,
+      const std::shared_ptr<const ProjectedMap> & projected_map,
+      double cost_weight);
+
+    ompl::base::Cost stateCost(const ompl::base::State * s) const override;
+
+    // Every meter costs at least 1, so the distance never overestimates
+    ompl::base::Cost motionCostHeuristic(
+      const ompl::base::State * s1,
+      const ompl::base::State * s2) const override;
+
+  private:
+    std::shared_ptr<const ProjectedMap> projected_map_;
+    double cost_weight_;
+    bool is_se3_;
+  };
+
+}  // namespace vox_nav_utilities
+
+#endif  // VOX_NAV_UTILITIES__PROJECTED_MAP_HPP_
@@ -0,0 +1,118 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_UTILITIES__ROAD_GRAPH_HPP_
+#define VOX_NAV_UTILITIES__ROAD_GRAPH_HPP_
+
+#include <boost/graph/compressed_sparse_row_graph.hpp>
+
+#include <pcl/kdtree/kdtree_flann.h>
+#include <pcl/point_cloud.h>
+#include <pcl/point_types.h>
+
+#include <Eigen/Core>
+
+#include <memory>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+
+  struct RoadGraphParams
+  {
+    // Road points closer than this are connected, a bit more than the point spacing of the roads
+    double connection_radius{1.5};
+    // At most this many neighbours within connection_radius are connected to a point
+    int max_neighbors{8};
+    // Consecutive points of the cloud with the same color belong to the same OSM way and are
+    // connected up to this distance, so sparse ways stay connected
+    double way_link_max_distance{5.0};
+    // Extra cost per meter climbed or descended on top of the 3D length of an edge
+    double climb_weight{0.0};
+    // Start and goal further than this from any road point are not snapped onto the graph
+    double snap_max_distance{10.0};
+  };
+
+  struct RoadEdge
+  {
+    float cost;
+  };
+
+  struct RoadPathResult
+  {
+    std::vector<Eigen::Vector3d> points;
+    std::vector<int> vertices;
+    double cost{0.0};
+    int expanded_vertices{0};
+  };
+
+/**
+ * @brief Graph of a road network given as a point cloud, e.g. the road
+ * topology of the OSM map server. Points are the vertices, edges connect
+ * points within a spacing tolerance and consecutive points of an OSM way.
+ * The graph is kept in compressed sparse row form, start and goal are
+ * snapped onto it with a KD-tree and paths are found with A*.
+ * Queries do not modify the graph and can run concurrently.
+ *
+ */
+  class RoadGraph
+  {
+  public:
+    typedef boost::compressed_sparse_row_graph<boost::directedS, boost::no_property, RoadEdge> CSRGraph;
+    typedef boost::graph_traits<CSRGraph>::vertex_descriptor Vertex;
+
+    RoadGraph(
+      const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr & road_points,
+      const RoadGraphParams & params = RoadGraphParams());
+
+    size_t numVertices() const {return boost::num_vertices(graph_);}
+
+    // Directed edges, every road connection is stored in both directions
+    size_t numEdges() const {return boost::num_edges(graph_);}
+
+    const RoadGraphParams & params() const {return params_;}
+
+    const pcl::PointCloud<pcl::PointXYZRGB> & points() const {return *road_points_;}
+
+    /**
+     * @brief Nearest road point to a position
+     *
+     * @param position
+     * @return int vertex index, -1 if there is none within snap_max_distance
+     */
+    int snap(const Eigen::Vector3d & position) const;
+
+    /**
+     * @brief Cheapest path over the roads from the road point nearest to start
+     * to the one nearest to goal
+     *
+     * @param start
+     * @param goal
+     * @param result road points of the path with its cost
+     * @return true if both ends could be snapped and are connected
+     */
+    bool plan(const Eigen::Vector3d & start, const Eigen::Vector3d & goal, RoadPathResult & result) const;
+
+  private:
+    float edgeCost(int a, int b) const;
+
+    RoadGraphParams params_;
+    pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr road_points_;
+    pcl::KdTreeFLANN<pcl::PointXYZRGB> kdtree_;
+    CSRGraph graph_;
+  };
+
+}  // namespace vox_nav_utilities
+
+#endif  // VOX_NAV_UTILITIES__ROAD_GRAPH_HPP_
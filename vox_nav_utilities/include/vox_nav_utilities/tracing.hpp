@@ -0,0 +1,189 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef VOX_NAV_UTILITIES__TRACING_HPP_
+#define VOX_NAV_UTILITIES__TRACING_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Scoped spans that end up in a Chrome trace event file (chrome://tracing, Perfetto).
+ *
+ *   void MapManager::regressCosts()
+ *   {
+ *     VOX_NAV_TRACE_FUNCTION("map_server");
+ *     ...
+ *     {
+ *       VOX_NAV_TRACE_SCOPE("downsample", "map_server");
+ *       ...
+ *     }
+ *   }
+ *
+ * Tracing is off at runtime until tracing::start() is called, or the
+ * VOX_NAV_TRACE_FILE environment variable is set when the process starts, in
+ * which case every process writes to <VOX_NAV_TRACE_FILE>.<pid>.json. While
+ * off, a span costs one relaxed atomic load. Building with
+ * -DVOX_NAV_TRACING_ENABLED=0 compiles the spans out entirely.
+ * Names and categories must outlive the trace, use string literals.
+ */
+#ifndef VOX_NAV_TRACING_ENABLED
+#define VOX_NAV_TRACING_ENABLED 1
+#endif
+
+namespace vox_nav_utilities
+{
+  namespace tracing
+  {
+    struct TraceEvent
+    {
+      const char * name;
+      const char * category;
+      std::int64_t start_ns;
+      std::int64_t duration_ns;
+    };
+
+    /**
+     * @brief Single producer single consumer ring of finished spans. The owning thread
+     * pushes without locking, the flusher thread drains. Spans that do not fit are dropped.
+     *
+     */
+    class ThreadTraceBuffer
+    {
+    public:
+      ThreadTraceBuffer(std::uint32_t tid, std::size_t capacity);
+
+      bool push(const TraceEvent & event) noexcept
+      {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) > mask_) {
+          dropped_.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        events_[head & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+      }
+
+      // Appends all pushed events to out, returns how many
+      std::size_t drain(std::vector<TraceEvent> & out);
+
+      std::uint32_t tid() const {return tid_;}
+
+      bool empty() const
+      {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+      }
+
+      std::uint64_t dropped() const {return dropped_.load(std::memory_order_relaxed);}
+
+      // Set by the owning thread when it exits, nothing is pushed afterwards
+      void markExited() noexcept {exited_.store(true, std::memory_order_release);}
+
+      bool exited() const noexcept {return exited_.load(std::memory_order_acquire);}
+
+    private:
+      std::uint32_t tid_;
+      std::size_t mask_;
+      std::vector<TraceEvent> events_;
+      alignas(64) std::atomic<std::size_t> head_{0};
+      alignas(64) std::atomic<std::size_t> tail_{0};
+      std::atomic<std::uint64_t> dropped_{0};
+      std::atomic<bool> exited_{false};
+    };
+
+    extern std::atomic<bool> g_enabled;
+
+    inline bool enabled()
+    {
+      return g_enabled.load(std::memory_order_relaxed);
+    }
+
+    inline std::int64_t nowNs()
+    {
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief Start writing spans of all threads to file_path, a previous trace is stopped first
+     *
+     * @param file_path
+     * @param flush_period how often the background thread drains the thread buffers
+     * @return true if the file could be opened
+     */
+    bool start(
+      const std::string & file_path,
+      std::chrono::milliseconds flush_period = std::chrono::milliseconds(100));
+
+    /**
+     * @brief Stop tracing, write what is left in the thread buffers and close the file
+     *
+     */
+    void stop();
+
+    // Spans dropped because a thread buffer was full, since the last start()
+    std::uint64_t droppedEvents();
+
+    // Thread buffers held by the tracer, the buffer of an exited thread is released once drained
+    std::size_t threadBuffers();
+
+    // Records a finished span of the calling thread, ignored while tracing is off
+    void record(const char * name, const char * category, std::int64_t start_ns,
+      std::int64_t end_ns);
+
+    class ScopedSpan
+    {
+    public:
+      ScopedSpan(const char * name, const char * category)
+      : name_(name), category_(category), start_ns_(enabled() ? nowNs() : -1)
+      {
+      }
+
+      ~ScopedSpan()
+      {
+        if (start_ns_ >= 0) {
+          record(name_, category_, start_ns_, nowNs());
+        }
+      }
+
+      ScopedSpan(const ScopedSpan &) = delete;
+      ScopedSpan & operator=(const ScopedSpan &) = delete;
+
+    private:
+      const char * name_;
+      const char * category_;
+      std::int64_t start_ns_;
+    };
+
+  }  // namespace tracing
+}  // namespace vox_nav_utilities
+
+#define VOX_NAV_TRACE_CONCAT_INNER(a, b) a ## b
+#define VOX_NAV_TRACE_CONCAT(a, b) VOX_NAV_TRACE_CONCAT_INNER(a, b)
+
+#if VOX_NAV_TRACING_ENABLED
+#define VOX_NAV_TRACE_SCOPE(name, category) \
+  ::vox_nav_utilities::tracing::ScopedSpan VOX_NAV_TRACE_CONCAT(vox_nav_trace_span_, __LINE__)( \
+    name, category)
+#else
+#define VOX_NAV_TRACE_SCOPE(name, category) do {} while (0)
+#endif
+
+#define VOX_NAV_TRACE_FUNCTION(category) VOX_NAV_TRACE_SCOPE(__func__, category)
+
+#endif  // VOX_NAV_UTILITIES__TRACING_HPP_
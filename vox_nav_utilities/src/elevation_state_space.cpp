@@ -15,8 +15,43 @@
 
 #include "vox_nav_utilities/elevation_state_space.hpp"
 #include "ompl/tools/config/MagicConstants.h"
+
+#include <algorithm>
+#include <numeric>
+
 using namespace ompl::base;
 
+namespace
+{
+// SE2 states distance() and interpolate() work on. They are per thread, as the planners call both from
+// several threads at once, e.g. in lock free nearest neighbor queries and parallel motion checks
+struct SE2ScratchStates
+{
+  SE2ScratchStates()
+  {
+    for (auto & state : states) {
+      state = space.allocState();
+    }
+  }
+
+  ~SE2ScratchStates()
+  {
+    for (auto & state : states) {
+      space.freeState(state);
+    }
+  }
+
+  SE2StateSpace space;
+  State * states[3];
+};
+
+SE2ScratchStates & se2ScratchStates()
+{
+  thread_local SE2ScratchStates scratch;
+  return scratch;
+}
+}  // namespace
+
 OctoCostOptimizationObjective::OctoCostOptimizationObjective(
   const ompl::base::SpaceInformationPtr & si,
   const std::shared_ptr<octomap::OcTree> & elevated_surfels_octree)
@@ -85,13 +120,6 @@ ElevationStateSpace::ElevationStateSpace(
   dubins_ = std::make_shared<ompl::base::DubinsStateSpace>(rho_, isSymmetric_);
   reeds_sheep_ = std::make_shared<ompl::base::ReedsSheppStateSpace>(rho_);
   so2_ = std::make_shared<ompl::base::SO2StateSpace>();
-
-  state1_se2_ = se2_->allocState();
-  state2_se2_ = se2_->allocState();
-  interpolation_state1_se2_ = se2_->allocState();
-  interpolation_state2_se2_ = se2_->allocState();
-  interpolated_state_se2_ = se2_->allocState();
-
 }
 
 void ElevationStateSpace::setBounds(
@@ -103,8 +131,8 @@ void ElevationStateSpace::setBounds(
   auto xyzv_bounds = std::make_shared<ompl::base::RealVectorBounds>(4);
   xyzv_bounds->setLow(0, se2_bounds.low[0]);    // x-
   xyzv_bounds->setHigh(0, se2_bounds.high[0]);  // x+
-  xyzv_bounds->setLow(1, se2_bounds.low[0]);    // y-
-  xyzv_bounds->setHigh(1, se2_bounds.high[0]);  // y+
+  xyzv_bounds->setLow(1, se2_bounds.low[1]);    // y-
+  xyzv_bounds->setHigh(1, se2_bounds.high[1]);  // y+
   xyzv_bounds->setLow(2, z_bounds.low[0]);      // z-
   xyzv_bounds->setHigh(2, z_bounds.high[0]);    // z+
   xyzv_bounds->setLow(3, v_bounds.low[0]);      // v-
@@ -163,33 +191,35 @@ double ompl::base::ElevationStateSpace::distance(const State * state1, const Sta
   const auto * state2_so2 = state2->as<StateType>()->as<SO2StateSpace::StateType>(0);
   const auto * state2_xyzv = state2->as<StateType>()->as<RealVectorStateSpace::StateType>(1);
 
-  state1_se2_->as<SE2StateSpace::StateType>()->setXY(
-    state1_xyzv->values[0],
-    state1_xyzv->values[1]);
-  state1_se2_->as<SE2StateSpace::StateType>()->setYaw(state1_so2->value);
-
-  state2_se2_->as<SE2StateSpace::StateType>()->setXY(
-    state2_xyzv->values[0],
-    state2_xyzv->values[1]);
-  state2_se2_->as<SE2StateSpace::StateType>()->setYaw(state2_so2->value);
-
   if (se2_state_type_ == SE2StateType::SE2) {
     return std::sqrt(
       std::pow(state1_xyzv->values[0] - state2_xyzv->values[0], 2) +
       std::pow(state1_xyzv->values[1] - state2_xyzv->values[1], 2) +
       std::pow(state1_xyzv->values[2] - state2_xyzv->values[2], 2));
+  }
 
-  } else if (se2_state_type_ == SE2StateType::DUBINS) {
+  auto & scratch = se2ScratchStates();
+  State * state1_se2 = scratch.states[0];
+  State * state2_se2 = scratch.states[1];
+  state1_se2->as<SE2StateSpace::StateType>()->setXY(
+    state1_xyzv->values[0],
+    state1_xyzv->values[1]);
+  state1_se2->as<SE2StateSpace::StateType>()->setYaw(state1_so2->value);
+
+  state2_se2->as<SE2StateSpace::StateType>()->setXY(
+    state2_xyzv->values[0],
+    state2_xyzv->values[1]);
+  state2_se2->as<SE2StateSpace::StateType>()->setYaw(state2_so2->value);
+
+  if (se2_state_type_ == SE2StateType::DUBINS) {
     if (isSymmetric_) {
       return rho_ * std::min(
-        dubins_->dubins(state1_se2_, state2_se2_).length(),
-        dubins_->dubins(state2_se2_, state1_se2_).length());
+        dubins_->dubins(state1_se2, state2_se2).length(),
+        dubins_->dubins(state2_se2, state1_se2).length());
     }
-    return rho_ * dubins_->dubins(state1_se2_, state2_se2_).length();
-  } else {
-    return rho_ * reeds_sheep_->reedsShepp(state1_se2_, state2_se2_).length();
+    return rho_ * dubins_->dubins(state1_se2, state2_se2).length();
   }
-  return 0;
+  return rho_ * reeds_sheep_->reedsShepp(state1_se2, state2_se2).length();
 }
 
 void ompl::base::ElevationStateSpace::interpolate(
@@ -205,33 +235,38 @@ void ompl::base::ElevationStateSpace::interpolate(
   auto * interpolated_so2 = state->as<StateType>()->as<SO2StateSpace::StateType>(0);
   auto * interpolated_xyzv = state->as<StateType>()->as<RealVectorStateSpace::StateType>(1);
 
-  interpolation_state1_se2_->as<SE2StateSpace::StateType>()->setXY(
+  auto & scratch = se2ScratchStates();
+  State * interpolation_state1_se2 = scratch.states[0];
+  State * interpolation_state2_se2 = scratch.states[1];
+  State * interpolated_state_se2 = scratch.states[2];
+
+  interpolation_state1_se2->as<SE2StateSpace::StateType>()->setXY(
     from_xyzv->values[0],
     from_xyzv->values[1]);
-  interpolation_state1_se2_->as<SE2StateSpace::StateType>()->setYaw(from_so2->value);
+  interpolation_state1_se2->as<SE2StateSpace::StateType>()->setYaw(from_so2->value);
 
-  interpolation_state2_se2_->as<SE2StateSpace::StateType>()->setXY(
+  interpolation_state2_se2->as<SE2StateSpace::StateType>()->setXY(
     to_xyzv->values[0],
     to_xyzv->values[1]);
-  interpolation_state2_se2_->as<SE2StateSpace::StateType>()->setYaw(to_so2->value);
+  interpolation_state2_se2->as<SE2StateSpace::StateType>()->setYaw(to_so2->value);
 
   if (se2_state_type_ == SE2StateType::SE2) {
     se2_->interpolate(
-      interpolation_state1_se2_, interpolation_state2_se2_, t,
-      interpolated_state_se2_);
+      interpolation_state1_se2, interpolation_state2_se2, t,
+      interpolated_state_se2);
   } else if (se2_state_type_ == SE2StateType::DUBINS) {
     dubins_->interpolate(
-      interpolation_state1_se2_, interpolation_state2_se2_, t,
-      interpolated_state_se2_);
+      interpolation_state1_se2, interpolation_state2_se2, t,
+      interpolated_state_se2);
   } else {
     reeds_sheep_->interpolate(
-      interpolation_state1_se2_, interpolation_state2_se2_, t,
-      interpolated_state_se2_);
+      interpolation_state1_se2, interpolation_state2_se2, t,
+      interpolated_state_se2);
   }
 
-  interpolated_so2->value = interpolated_state_se2_->as<SE2StateSpace::StateType>()->getYaw();     // so2
-  interpolated_xyzv->values[0] = interpolated_state_se2_->as<SE2StateSpace::StateType>()->getX();  // x
-  interpolated_xyzv->values[1] = interpolated_state_se2_->as<SE2StateSpace::StateType>()->getY();  // y
+  interpolated_so2->value = interpolated_state_se2->as<SE2StateSpace::StateType>()->getYaw();     // so2
+  interpolated_xyzv->values[0] = interpolated_state_se2->as<SE2StateSpace::StateType>()->getX();  // x
+  interpolated_xyzv->values[1] = interpolated_state_se2->as<SE2StateSpace::StateType>()->getY();  // y
   interpolated_xyzv->values[2] = (from_xyzv->values[2] + to_xyzv->values[2]) / 2.0;         // z
   interpolated_xyzv->values[3] = (from_xyzv->values[3] + to_xyzv->values[3]) / 2.0;         // v
 
@@ -259,99 +294,178 @@ void ompl::base::ElevationStateSpace::printState(const State * state, std::ostre
 }
 
 
-OctoCellValidStateSampler::OctoCellValidStateSampler(
-  const ompl::base::SpaceInformationPtr & si,
-  const geometry_msgs::msg::PoseStamped start,
-  const geometry_msgs::msg::PoseStamped goal,
-  const geometry_msgs::msg::PoseArray::SharedPtr & elevated_surfels_poses)
-: ValidStateSampler(si.get()),
-  elevated_surfels_poses_(*elevated_surfels_poses),
-  rng_(rd_())
+AliasTable::AliasTable(const std::vector<double> & weights)
+: prob_(weights.size(), 1.0),
+  alias_(weights.size())
 {
-  workspace_surfels_ = pcl::PointCloud<pcl::PointSurfel>::Ptr(
-    new pcl::PointCloud<pcl::PointSurfel>);
+  double sum = 0.0;
+  for (auto && w : weights) {
+    sum += std::max(w, 0.0);
+  }
+
+  // Vose's method, scale the weights to a mean of 1 and pair every small one with a large one
+  std::vector<double> scaled(weights.size(), 1.0);
+  std::vector<std::size_t> small, large;
+  for (std::size_t i = 0; i < weights.size(); i++) {
+    alias_[i] = i;
+    if (sum > 0.0) {
+      scaled[i] = std::max(weights[i], 0.0) * weights.size() / sum;
+    }
+    (scaled[i] < 1.0 ? small : large).push_back(i);
+  }
+  while (!small.empty() && !large.empty()) {
+    std::size_t s = small.back();
+    std::size_t l = large.back();
+    small.pop_back();
+    large.pop_back();
+    prob_[s] = scaled[s];
+    alias_[s] = l;
+    scaled[l] = (scaled[l] + scaled[s]) - 1.0;
+    (scaled[l] < 1.0 ? small : large).push_back(l);
+  }
+  // What is left is 1 up to rounding errors
+  for (auto && i : small) {
+    prob_[i] = 1.0;
+  }
+  for (auto && i : large) {
+    prob_[i] = 1.0;
+  }
+}
 
-  vox_nav_utilities::fillSurfelsfromMsgPoses(elevated_surfels_poses_, workspace_surfels_);
+std::size_t AliasTable::sample(RNG & rng) const
+{
+  std::size_t i = rng.uniformInt(0, static_cast<int>(prob_.size()) - 1);
+  return rng.uniform01() < prob_[i] ? i : alias_[i];
+}
 
-  name_ = "OctoCellValidStateSampler";
-  RCLCPP_INFO(
-    logger_, "OctoCellValidStateSampler bases on an Octomap with %d surfels",
-    workspace_surfels_->points.size());
+SurfelValidStateSampler::SurfelValidStateSampler(
+  const SpaceInformation * si,
+  const pcl::PointCloud<pcl::PointSurfel>::ConstPtr & surfels,
+  const std::shared_ptr<const pcl::KdTreeFLANN<pcl::PointSurfel>> & kdtree,
+  Weighting weighting)
+: ValidStateSampler(si),
+  surfels_(surfels),
+  kdtree_(kdtree),
+  weighting_(weighting)
+{
+  name_ = "SurfelValidStateSampler";
+  if (!kdtree_) {
+    auto own_kdtree = std::make_shared<pcl::KdTreeFLANN<pcl::PointSurfel>>();
+    if (!surfels_->points.empty()) {
+      own_kdtree->setInputCloud(surfels_);
+    }
+    kdtree_ = own_kdtree;
+  }
 
-  updateSearchArea(start, goal);
+  std::vector<int> search_area(surfels_->points.size());
+  std::iota(search_area.begin(), search_area.end(), 0);
+  setSearchArea(std::move(search_area));
 }
 
-bool OctoCellValidStateSampler::sample(ompl::base::State * state)
+bool SurfelValidStateSampler::sample(State * state)
 {
-  auto * cstate = state->as<ompl::base::ElevationStateSpace::StateType>();
-  auto val = (*int_distr_)(rng_);
-  auto out_sample = search_area_surfels_->points.at(val);
-  cstate->setXYZV(out_sample.x, out_sample.y, out_sample.z, 0);
+  if (search_area_.empty()) {
+    return false;
+  }
+  const auto & surfel = surfels_->points[search_area_[alias_table_.sample(rng_)]];
+  auto * cstate = state->as<ElevationStateSpace::StateType>();
+  cstate->setXYZV(surfel.x, surfel.y, surfel.z, 0);
   cstate->setSO2(0);
   return true;
 }
 
-bool OctoCellValidStateSampler::sampleNear(
-  ompl::base::State * state, const ompl::base::State * near,
+bool SurfelValidStateSampler::sampleNear(
+  State * state, const State * near,
   const double distance)
 {
-  auto * cstate = state->as<ompl::base::ElevationStateSpace::StateType>();
-  auto * near_cstate = near->as<ompl::base::ElevationStateSpace::StateType>();
-  const auto * so2 = near_cstate->as<ompl::base::SO2StateSpace::StateType>(0);
-  const auto * xyzv = near_cstate->as<ompl::base::RealVectorStateSpace::StateType>(1);
-
-  pcl::PointSurfel surfel;
-  surfel.x = xyzv->values[0];
-  surfel.y = xyzv->values[1];
-  surfel.z = xyzv->values[2];
-
-  auto out_sample = vox_nav_utilities::getNearstRPoints<
-    pcl::PointSurfel,
-    pcl::PointCloud<pcl::PointSurfel>::Ptr>(
-    distance,
-    surfel,
-    search_area_surfels_);
+  if (surfels_->points.empty()) {
+    return false;
+  }
+  const auto * xyzv =
+    near->as<ElevationStateSpace::StateType>()->as<RealVectorStateSpace::StateType>(1);
+
+  pcl::PointSurfel near_surfel;
+  near_surfel.x = xyzv->values[0];
+  near_surfel.y = xyzv->values[1];
+  near_surfel.z = xyzv->values[2];
+  if (kdtree_->radiusSearch(near_surfel, distance, near_indices_, near_squared_distances_) <= 0) {
+    return false;
+  }
 
-  cstate->setXYZV(out_sample.x, out_sample.y, out_sample.z, 0);
+  const auto & surfel =
+    surfels_->points[near_indices_[rng_.uniformInt(0, static_cast<int>(near_indices_.size()) - 1)]];
+  auto * cstate = state->as<ElevationStateSpace::StateType>();
+  cstate->setXYZV(surfel.x, surfel.y, surfel.z, 0);
   cstate->setSO2(0);
-
   return true;
 }
 
-void OctoCellValidStateSampler::updateSearchArea(
+void SurfelValidStateSampler::updateSearchArea(
   const geometry_msgs::msg::PoseStamped start,
   const geometry_msgs::msg::PoseStamped goal)
 {
-  RCLCPP_INFO(logger_, "Updating search area");
-
   double radius = vox_nav_utilities::getEuclidianDistBetweenPoses(goal, start) / 1.0;
   auto search_point_pose = vox_nav_utilities::getLinearInterpolatedPose(goal, start);
   auto search_point_surfel = vox_nav_utilities::poseMsg2PCLSurfel(search_point_pose);
 
-  search_area_surfels_ =
-    vox_nav_utilities::getSubCloudWithinRadius<pcl::PointSurfel>(
-    workspace_surfels_, search_point_surfel,
-    radius);
+  std::vector<int> search_area;
+  std::vector<float> squared_distances;
+  if (!surfels_->points.empty()) {
+    kdtree_->radiusSearch(search_point_surfel, radius, search_area, squared_distances);
+  }
+  setSearchArea(std::move(search_area));
+
+  RCLCPP_INFO(logger_, "Updated search area surfels, %zu", search_area_.size());
+}
 
-  RCLCPP_INFO(logger_, "Updated search area surfels, %d", search_area_surfels_->points.size());
+void SurfelValidStateSampler::setSeed(std::uint_fast32_t seed)
+{
+  rng_.setLocalSeed(seed);
+}
 
-  /*search_area_surfels_ = vox_nav_utilities::uniformlySampleCloud<pcl::PointSurfel>(
-    search_area_surfels_, 1.2);*/
+double SurfelValidStateSampler::getSurfelWeight(const pcl::PointSurfel & surfel) const
+{
+  if (weighting_ == Weighting::UNIFORM) {
+    return 1.0;
+  }
+  // Roll and pitch are kept in the normal of the surfels
+  double tilt = std::max(std::abs(surfel.normal_x), std::abs(surfel.normal_y)) * 180.0 / M_PI;
+  return 1.0 / (1.0 + tilt);
+}
 
-  RCLCPP_INFO(
-    logger_, "Uniformly sampled %d search area surfels,", search_area_surfels_->points.size());
+void SurfelValidStateSampler::setSearchArea(std::vector<int> && search_area)
+{
+  search_area_ = std::move(search_area);
+  std::vector<double> weights;
+  weights.reserve(search_area_.size());
+  for (auto && i : search_area_) {
+    weights.push_back(getSurfelWeight(surfels_->points[i]));
+  }
+  alias_table_ = AliasTable(weights);
+}
 
-  std::vector<int> weights;
-  for (auto && i : search_area_surfels_->points) {
-    //auto tilt_angle = std::max(std::abs(i.normal_x), std::abs(i.normal_y)) * 180.0 / M_PI;
-    //weights.push_back(200 / tilt_angle);
-    weights.push_back(1);
+namespace
+{
+  pcl::PointCloud<pcl::PointSurfel>::Ptr surfelsFromPoses(const geometry_msgs::msg::PoseArray & poses)
+  {
+    pcl::PointCloud<pcl::PointSurfel>::Ptr surfels(new pcl::PointCloud<pcl::PointSurfel>);
+    surfels->points.reserve(poses.poses.size());
+    vox_nav_utilities::fillSurfelsfromMsgPoses(poses, surfels);
+    return surfels;
   }
-  std::discrete_distribution<> distrubutions(weights.begin(), weights.end());
-  distrubutions_ = distrubutions;
+}  // namespace
 
-  int_distr_ = std::make_shared<std::uniform_int_distribution<int>>(
-    0,
-    search_area_surfels_->points.size() - 1);
+OctoCellValidStateSampler::OctoCellValidStateSampler(
+  const ompl::base::SpaceInformationPtr & si,
+  const geometry_msgs::msg::PoseStamped start,
+  const geometry_msgs::msg::PoseStamped goal,
+  const geometry_msgs::msg::PoseArray::SharedPtr & elevated_surfels_poses)
+: SurfelValidStateSampler(si.get(), surfelsFromPoses(*elevated_surfels_poses))
+{
+  name_ = "OctoCellValidStateSampler";
+  RCLCPP_INFO(
+    logger_, "OctoCellValidStateSampler bases on an Octomap with %zu surfels",
+    surfels_->points.size());
 
+  updateSearchArea(start, goal);
 }
@@ -0,0 +1,351 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_utilities/geodetic_conversions.hpp"
+
+#include <Eigen/Geometry>
+
+#include <cmath>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+  namespace
+  {
+    // WGS84 ellipsoid
+    constexpr double kA = 6378137.0;
+    constexpr double kF = 1.0 / 298.257223563;
+    constexpr double kE2 = kF * (2.0 - kF);
+    constexpr double kB = kA * (1.0 - kF);
+
+    constexpr double kK0 = 0.9996;
+    constexpr double kFalseEasting = 500000.0;
+    constexpr double kFalseNorthingSouth = 10000000.0;
+    constexpr double kDegToRad = M_PI / 180.0;
+    constexpr double kRadToDeg = 180.0 / M_PI;
+
+    // Coefficients of the Krueger series to 6th order in the third flattening n
+    struct KruegerSeries
+    {
+      double A;          // rectifying radius
+      double alpha[7];   // forward, index 1..6
+      double beta[7];    // inverse, index 1..6
+      double e;
+
+      KruegerSeries()
+      {
+        const double n = kF / (2.0 - kF);
+        const double n2 = n * n, n3 = n2 * n, n4 = n3 * n, n5 = n4 * n, n6 = n5 * n;
+        A = kA / (1.0 + n) * (1.0 + n2 / 4.0 + n4 / 64.0 + n6 / 256.0);
+        e = std::sqrt(kE2);
+
+        alpha[0] = 0.0;
+        alpha[1] = n / 2.0 - 2.0 * n2 / 3.0 + 5.0 * n3 / 16.0 + 41.0 * n4 / 180.0 -
+          127.0 * n5 / 288.0 + 7891.0 * n6 / 37800.0;
+        alpha[2] = 13.0 * n2 / 48.0 - 3.0 * n3 / 5.0 + 557.0 * n4 / 1440.0 +
+          281.0 * n5 / 630.0 - 1983433.0 * n6 / 1935360.0;
+        alpha[3] = 61.0 * n3 / 240.0 - 103.0 * n4 / 140.0 + 15061.0 * n5 / 26880.0 +
+          167603.0 * n6 / 181440.0;
+        alpha[4] = 49561.0 * n4 / 161280.0 - 179.0 * n5 / 168.0 + 6601661.0 * n6 / 7257600.0;
+        alpha[5] = 34729.0 * n5 / 80640.0 - 3418889.0 * n6 / 1995840.0;
+        alpha[6] = 212378941.0 * n6 / 319334400.0;
+
+        beta[0] = 0.0;
+        beta[1] = n / 2.0 - 2.0 * n2 / 3.0 + 37.0 * n3 / 96.0 - n4 / 360.0 -
+          81.0 * n5 / 512.0 + 96199.0 * n6 / 604800.0;
+        beta[2] = n2 / 48.0 + n3 / 15.0 - 437.0 * n4 / 1440.0 + 46.0 * n5 / 105.0 -
+          1118711.0 * n6 / 3870720.0;
+        beta[3] = 17.0 * n3 / 480.0 - 37.0 * n4 / 840.0 - 209.0 * n5 / 4480.0 +
+          5569.0 * n6 / 90720.0;
+        beta[4] = 4397.0 * n4 / 161280.0 - 11.0 * n5 / 504.0 - 830251.0 * n6 / 7257600.0;
+        beta[5] = 4583.0 * n5 / 161280.0 - 108847.0 * n6 / 3991680.0;
+        beta[6] = 20648693.0 * n6 / 638668800.0;
+      }
+    };
+
+    const KruegerSeries & series()
+    {
+      static const KruegerSeries s;
+      return s;
+    }
+
+    double centralMeridian(int zone)
+    {
+      return (zone * 6.0 - 183.0) * kDegToRad;
+    }
+
+    // Conformal latitude tau' = tan(chi) from tau = tan(phi)
+    double conformalTau(double tau, double e)
+    {
+      double tau1 = std::hypot(1.0, tau);
+      double sig = std::sinh(e * std::atanh(e * tau / tau1));
+      return tau * std::hypot(1.0, sig) - sig * tau1;
+    }
+  }  // namespace
+
+  int utmZone(double latitude, double longitude)
+  {
+    // Normalize to [-180, 180)
+    double lon = std::fmod(longitude + 180.0, 360.0);
+    if (lon < 0.0) {
+      lon += 360.0;
+    }
+    lon -= 180.0;
+    int zone = static_cast<int>(std::floor((lon + 180.0) / 6.0)) + 1;
+    if (zone > 60) {
+      zone = 60;
+    }
+    // South west Norway
+    if (latitude >= 56.0 && latitude < 64.0 && lon >= 3.0 && lon < 12.0) {
+      zone = 32;
+    }
+    // Svalbard
+    if (latitude >= 72.0 && latitude <= 84.0 && lon >= 0.0 && lon < 42.0) {
+      if (lon < 9.0) {
+        zone = 31;
+      } else if (lon < 21.0) {
+        zone = 33;
+      } else if (lon < 33.0) {
+        zone = 35;
+      } else {
+        zone = 37;
+      }
+    }
+    return zone;
+  }
+
+  UTMPoint geoToUTM(const GeoPoint & geo, int force_zone)
+  {
+    const KruegerSeries & s = series();
+    UTMPoint utm;
+    utm.zone = force_zone > 0 ? force_zone : utmZone(geo.latitude, geo.longitude);
+    utm.north = geo.latitude >= 0.0;
+    utm.altitude = geo.altitude;
+
+    double lambda = geo.longitude * kDegToRad - centralMeridian(utm.zone);
+    lambda = std::remainder(lambda, 2.0 * M_PI);
+    double phi = geo.latitude * kDegToRad;
+
+    double tau_p = conformalTau(std::tan(phi), s.e);
+    double xi_p = std::atan2(tau_p, std::cos(lambda));
+    double eta_p = std::asinh(std::sin(lambda) / std::hypot(tau_p, std::cos(lambda)));
+
+    double xi = xi_p;
+    double eta = eta_p;
+    for (int j = 1; j <= 6; j++) {
+      xi += s.alpha[j] * std::sin(2.0 * j * xi_p) * std::cosh(2.0 * j * eta_p);
+      eta += s.alpha[j] * std::cos(2.0 * j * xi_p) * std::sinh(2.0 * j * eta_p);
+    }
+
+    utm.easting = kFalseEasting + kK0 * s.A * eta;
+    utm.northing = kK0 * s.A * xi + (utm.north ? 0.0 : kFalseNorthingSouth);
+    return utm;
+  }
+
+  GeoPoint utmToGeo(const UTMPoint & utm)
+  {
+    const KruegerSeries & s = series();
+    double xi = (utm.northing - (utm.north ? 0.0 : kFalseNorthingSouth)) / (kK0 * s.A);
+    double eta = (utm.easting - kFalseEasting) / (kK0 * s.A);
+
+    double xi_p = xi;
+    double eta_p = eta;
+    for (int j = 1; j <= 6; j++) {
+      xi_p -= s.beta[j] * std::sin(2.0 * j * xi) * std::cosh(2.0 * j * eta);
+      eta_p -= s.beta[j] * std::cos(2.0 * j * xi) * std::sinh(2.0 * j * eta);
+    }
+
+    double tau_p = std::sin(xi_p) / std::hypot(std::sinh(eta_p), std::cos(xi_p));
+    double lambda = std::atan2(std::sinh(eta_p), std::cos(xi_p));
+
+    // Newton iterations for tau = tan(phi), converges in 2 to 3 steps
+    double tau = tau_p;
+    for (int i = 0; i < 10; i++) {
+      double tau_i_p = conformalTau(tau, s.e);
+      double dtau = (tau_p - tau_i_p) / std::hypot(1.0, tau_i_p) *
+        (1.0 + (1.0 - kE2) * tau * tau) / ((1.0 - kE2) * std::hypot(1.0, tau));
+      tau += dtau;
+      if (std::abs(dtau) < 1e-14) {
+        break;
+      }
+    }
+
+    GeoPoint geo;
+    geo.latitude = std::atan(tau) * kRadToDeg;
+    geo.longitude = std::remainder(
+      (lambda + centralMeridian(utm.zone)) * kRadToDeg, 360.0);
+    geo.altitude = utm.altitude;
+    return geo;
+  }
+
+  Eigen::Vector3d geoToECEF(const GeoPoint & geo)
+  {
+    double phi = geo.latitude * kDegToRad;
+    double lambda = geo.longitude * kDegToRad;
+    double sin_phi = std::sin(phi);
+    double N = kA / std::sqrt(1.0 - kE2 * sin_phi * sin_phi);
+    return Eigen::Vector3d(
+      (N + geo.altitude) * std::cos(phi) * std::cos(lambda),
+      (N + geo.altitude) * std::cos(phi) * std::sin(lambda),
+      (N * (1.0 - kE2) + geo.altitude) * sin_phi);
+  }
+
+  GeoPoint ecefToGeo(const Eigen::Vector3d & ecef)
+  {
+    // Heikkinen's closed form solution
+    const double a2 = kA * kA;
+    const double b2 = kB * kB;
+    const double ep2 = (a2 - b2) / b2;
+    double x = ecef.x(), y = ecef.y(), z = ecef.z();
+    double p = std::hypot(x, y);
+    double F = 54.0 * b2 * z * z;
+    double G = p * p + (1.0 - kE2) * z * z - kE2 * (a2 - b2);
+    double c = kE2 * kE2 * F * p * p / (G * G * G);
+    double s = std::cbrt(1.0 + c + std::sqrt(c * c + 2.0 * c));
+    double k = s + 1.0 + 1.0 / s;
+    double P = F / (3.0 * k * k * G * G);
+    double Q = std::sqrt(1.0 + 2.0 * kE2 * kE2 * P);
+    double r0 = -P * kE2 * p / (1.0 + Q) +
+      std::sqrt(
+      std::max(
+        0.0, a2 / 2.0 * (1.0 + 1.0 / Q) - P * (1.0 - kE2) * z * z / (Q * (1.0 + Q)) -
+        P * p * p / 2.0));
+    double U = std::hypot(p - kE2 * r0, z);
+    double V = std::sqrt((p - kE2 * r0) * (p - kE2 * r0) + (1.0 - kE2) * z * z);
+    double z0 = b2 * z / (kA * V);
+
+    GeoPoint geo;
+    geo.latitude = std::atan2(z + ep2 * z0, p) * kRadToDeg;
+    geo.longitude = std::atan2(y, x) * kRadToDeg;
+    geo.altitude = U * (1.0 - b2 / (kA * V));
+    return geo;
+  }
+
+  void GeodeticConverter::setDatum(
+    const GeoPoint & datum,
+    const Eigen::Vector3d & datum_in_map,
+    double map_yaw)
+  {
+    UTMPoint datum_utm = geoToUTM(datum);
+    // map = datum_in_map + Rz(map_yaw) * (utm - datum_utm)
+    Eigen::Isometry3d map_from_utm = Eigen::Isometry3d::Identity();
+    map_from_utm.translate(datum_in_map);
+    map_from_utm.rotate(Eigen::AngleAxisd(map_yaw, Eigen::Vector3d::UnitZ()));
+    map_from_utm.translate(
+      -Eigen::Vector3d(datum_utm.easting, datum_utm.northing, datum_utm.altitude));
+    setUTMToMap(datum_utm.zone, datum_utm.north, map_from_utm);
+  }
+
+  void GeodeticConverter::setUTMToMap(
+    int zone, bool north,
+    const Eigen::Isometry3d & map_from_utm)
+  {
+    zone_ = zone;
+    north_ = north;
+    map_from_utm_ = map_from_utm;
+    utm_from_map_ = map_from_utm.inverse();
+
+    // The tangent plane is anchored at the geodetic coordinate of the map origin
+    UTMPoint origin;
+    origin.zone = zone_;
+    origin.north = north_;
+    Eigen::Vector3d origin_utm = utm_from_map_ * Eigen::Vector3d::Zero();
+    origin.easting = origin_utm.x();
+    origin.northing = origin_utm.y();
+    origin.altitude = origin_utm.z();
+    datum_ = utmToGeo(origin);
+
+    double phi = datum_.latitude * kDegToRad;
+    double lambda = datum_.longitude * kDegToRad;
+    datum_ecef_ = geoToECEF(datum_);
+    ecef_to_enu_ <<
+      -std::sin(lambda), std::cos(lambda), 0.0,
+      -std::sin(phi) * std::cos(lambda), -std::sin(phi) * std::sin(lambda), std::cos(phi),
+      std::cos(phi) * std::cos(lambda), std::cos(phi) * std::sin(lambda), std::sin(phi);
+    has_datum_ = true;
+  }
+
+  Eigen::Vector3d GeodeticConverter::geoToMap(const GeoPoint & geo) const
+  {
+    UTMPoint utm = geoToUTM(geo, zone_);
+    if (utm.north != north_) {
+      // Keep the northing continuous across the equator
+      utm.northing += north_ ? -kFalseNorthingSouth : kFalseNorthingSouth;
+    }
+    return map_from_utm_ * Eigen::Vector3d(utm.easting, utm.northing, utm.altitude);
+  }
+
+  GeoPoint GeodeticConverter::mapToGeo(const Eigen::Vector3d & map) const
+  {
+    Eigen::Vector3d p = utm_from_map_ * map;
+    UTMPoint utm;
+    utm.zone = zone_;
+    utm.north = north_;
+    utm.easting = p.x();
+    utm.northing = p.y();
+    utm.altitude = p.z();
+    return utmToGeo(utm);
+  }
+
+  Eigen::Vector3d GeodeticConverter::geoToENU(const GeoPoint & geo) const
+  {
+    return ecef_to_enu_ * (geoToECEF(geo) - datum_ecef_);
+  }
+
+  GeoPoint GeodeticConverter::enuToGeo(const Eigen::Vector3d & enu) const
+  {
+    return ecefToGeo(datum_ecef_ + ecef_to_enu_.transpose() * enu);
+  }
+
+  void GeodeticConverter::geoToMap(
+    const std::vector<GeoPoint> & geo,
+    std::vector<Eigen::Vector3d> & map) const
+  {
+    map.resize(geo.size());
+    for (size_t i = 0; i < geo.size(); i++) {
+      map[i] = geoToMap(geo[i]);
+    }
+  }
+
+  void GeodeticConverter::mapToGeo(
+    const std::vector<Eigen::Vector3d> & map,
+    std::vector<GeoPoint> & geo) const
+  {
+    geo.resize(map.size());
+    for (size_t i = 0; i < map.size(); i++) {
+      geo[i] = mapToGeo(map[i]);
+    }
+  }
+
+  void GeodeticConverter::geoToENU(
+    const std::vector<GeoPoint> & geo,
+    std::vector<Eigen::Vector3d> & enu) const
+  {
+    enu.resize(geo.size());
+    for (size_t i = 0; i < geo.size(); i++) {
+      enu[i] = geoToENU(geo[i]);
+    }
+  }
+
+  void GeodeticConverter::enuToGeo(
+    const std::vector<Eigen::Vector3d> & enu,
+    std::vector<GeoPoint> & geo) const
+  {
+    geo.resize(enu.size());
+    for (size_t i = 0; i < enu.size(); i++) {
+      geo[i] = enuToGeo(enu[i]);
+    }
+  }
+
+}  // namespace vox_nav_utilities
@@ -0,0 +1,196 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_utilities/map_snapshot.hpp"
+
+#include <octomap_msgs/conversions.h>
+#include <pcl_conversions/pcl_conversions.h>
+
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include "vox_nav_utilities/planner_helpers.hpp"
+
+namespace vox_nav_utilities
+{
+  namespace
+  {
+    template<typename T>
+    uint64_t hashBytes(const std::vector<T> & data, uint64_t seed)
+    {
+      uint64_t h = std::hash<std::string_view>()(
+        std::string_view(reinterpret_cast<const char *>(data.data()), data.size() * sizeof(T)));
+      return seed ^ (h + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2));
+    }
+
+    uint64_t mapVersion(const MapSnapshot::Response & response)
+    {
+      uint64_t version = 0;
+      version = hashBytes(response.original_octomap.data, version);
+      version = hashBytes(response.collision_octomap.data, version);
+      version = hashBytes(response.elevated_surfel_octomap.data, version);
+      version = hashBytes(response.elevated_surfel_poses.poses, version);
+      version = hashBytes(response.traversable_elevated_cloud.data, version);
+      version = hashBytes(response.traversable_cloud.data, version);
+      return version;
+    }
+  }  // namespace
+
+  MapSnapshot::MapSnapshot(Response::ConstSharedPtr response, uint64_t version)
+  : response_(std::move(response)),
+    version_(version)
+  {
+  }
+
+  void MapSnapshot::decode(OctreePart & part, const octomap_msgs::msg::Octomap & msg) const
+  {
+    std::call_once(
+      part.once, [&part, &msg]() {
+        // fullMsgToMap allocates the tree, own it directly rather than copying it
+        std::unique_ptr<octomap::AbstractOcTree> tree(octomap_msgs::fullMsgToMap(msg));
+        if (dynamic_cast<octomap::OcTree *>(tree.get())) {
+          part.octree.reset(static_cast<octomap::OcTree *>(tree.release()));
+        } else {
+          // Not a full OcTree message, keep an empty map of the same resolution
+          part.octree = std::make_shared<octomap::OcTree>(msg.resolution > 0.0 ? msg.resolution : 0.1);
+        }
+        auto fcl_octree = std::make_shared<fcl::OcTreef>(part.octree);
+        part.collision_object = std::make_shared<fcl::CollisionObjectf>(
+          std::shared_ptr<fcl::CollisionGeometryf>(fcl_octree));
+      });
+  }
+
+  std::shared_ptr<octomap::OcTree> MapSnapshot::originalOctree() const
+  {
+    decode(original_, response_->original_octomap);
+    return original_.octree;
+  }
+
+  std::shared_ptr<fcl::CollisionObjectf> MapSnapshot::originalCollisionObject() const
+  {
+    decode(original_, response_->original_octomap);
+    return original_.collision_object;
+  }
+
+  std::shared_ptr<octomap::OcTree> MapSnapshot::collisionOctree() const
+  {
+    decode(collision_, response_->collision_octomap);
+    return collision_.octree;
+  }
+
+  std::shared_ptr<fcl::CollisionObjectf> MapSnapshot::collisionCollisionObject() const
+  {
+    decode(collision_, response_->collision_octomap);
+    return collision_.collision_object;
+  }
+
+  std::shared_ptr<octomap::OcTree> MapSnapshot::elevatedSurfelOctree() const
+  {
+    decode(elevated_surfel_, response_->elevated_surfel_octomap);
+    return elevated_surfel_.octree;
+  }
+
+  std::shared_ptr<fcl::CollisionObjectf> MapSnapshot::elevatedSurfelCollisionObject() const
+  {
+    decode(elevated_surfel_, response_->elevated_surfel_octomap);
+    return elevated_surfel_.collision_object;
+  }
+
+  void MapSnapshot::decodeSurfels() const
+  {
+    std::call_once(
+      surfels_once_, [this]() {
+        elevated_surfel_poses_ = std::make_shared<geometry_msgs::msg::PoseArray>(
+          response_->elevated_surfel_poses);
+        elevated_surfel_cloud_ = pcl::PointCloud<pcl::PointSurfel>::Ptr(
+          new pcl::PointCloud<pcl::PointSurfel>);
+        fillSurfelsfromMsgPoses(*elevated_surfel_poses_, elevated_surfel_cloud_);
+        elevated_surfel_kdtree_ = std::make_shared<pcl::KdTreeFLANN<pcl::PointSurfel>>();
+        if (!elevated_surfel_cloud_->points.empty()) {
+          elevated_surfel_kdtree_->setInputCloud(elevated_surfel_cloud_);
+        }
+      });
+  }
+
+  geometry_msgs::msg::PoseArray::SharedPtr MapSnapshot::elevatedSurfelPoses() const
+  {
+    decodeSurfels();
+    return elevated_surfel_poses_;
+  }
+
+  pcl::PointCloud<pcl::PointSurfel>::Ptr MapSnapshot::elevatedSurfelCloud() const
+  {
+    decodeSurfels();
+    return elevated_surfel_cloud_;
+  }
+
+  std::shared_ptr<const pcl::KdTreeFLANN<pcl::PointSurfel>> MapSnapshot::elevatedSurfelKdTree() const
+  {
+    decodeSurfels();
+    return elevated_surfel_kdtree_;
+  }
+
+  pcl::PointCloud<pcl::PointXYZRGB>::Ptr MapSnapshot::traversableElevatedCloud() const
+  {
+    std::call_once(
+      traversable_once_, [this]() {
+        traversable_elevated_cloud_ = pcl::PointCloud<pcl::PointXYZRGB>::Ptr(
+          new pcl::PointCloud<pcl::PointXYZRGB>);
+        pcl::fromROSMsg(response_->traversable_elevated_cloud, *traversable_elevated_cloud_);
+      });
+    return traversable_elevated_cloud_;
+  }
+
+  MapSnapshotRegistry & MapSnapshotRegistry::instance()
+  {
+    static MapSnapshotRegistry registry;
+    return registry;
+  }
+
+  std::shared_ptr<const MapSnapshot> MapSnapshotRegistry::acquire(
+    MapSnapshot::Response::ConstSharedPtr response)
+  {
+    uint64_t version = mapVersion(*response);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = snapshots_.begin(); it != snapshots_.end(); ) {
+      if (it->second.expired()) {
+        it = snapshots_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    // The hash only narrows it down, the maps themselves have to match
+    auto range = snapshots_.equal_range(version);
+    for (auto it = range.first; it != range.second; ++it) {
+      auto snapshot = it->second.lock();
+      if (snapshot && (snapshot->response() == *response)) {
+        return snapshot;
+      }
+    }
+
+    auto snapshot = std::make_shared<const MapSnapshot>(std::move(response), version);
+    snapshots_.emplace(version, snapshot);
+    created_++;
+    return snapshot;
+  }
+
+  size_t MapSnapshotRegistry::created() const
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return created_;
+  }
+
+}  // namespace vox_nav_utilities
@@ -0,0 +1,405 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_utilities/octomap_builder.hpp"
+
+#include <pcl/common/point_tests.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+  namespace
+  {
+    // No key interleaves to it, 48 bits are used
+    const uint64_t kNoVoxel = std::numeric_limits<uint64_t>::max();
+
+    // Yellow points are elevated node centers, they are not part of the map
+    bool isElevatedNodeCenter(const pcl::PointXYZRGB & p)
+    {
+      return p.r && p.g;
+    }
+
+    // Obstacle points have the highest cost
+    float pointCost(const pcl::PointXYZRGB & p)
+    {
+      return p.r ? 1.0f : static_cast<float>(p.b) / 255.0f;
+    }
+
+    // Puts the bits of a 16 bit key 3 apart
+    uint64_t spreadBits(uint64_t v)
+    {
+      v &= 0xffff;
+      v = (v | v << 16) & 0x0000ff0000ffULL;
+      v = (v | v << 8) & 0x00f00f00f00fULL;
+      v = (v | v << 4) & 0x0c30c30c30c3ULL;
+      v = (v | v << 2) & 0x249249249249ULL;
+      return v;
+    }
+
+    uint64_t compactBits(uint64_t v)
+    {
+      v &= 0x249249249249ULL;
+      v = (v | v >> 2) & 0x0c30c30c30c3ULL;
+      v = (v | v >> 4) & 0x00f00f00f00fULL;
+      v = (v | v >> 8) & 0x0000ff0000ffULL;
+      v = (v | v >> 16) & 0xffffULL;
+      return v;
+    }
+
+    // Runs f(slice, begin, end) for num_threads slices of [0, n), each on its own thread
+    template<typename F>
+    void parallelFor(unsigned int num_threads, size_t n, F f)
+    {
+      std::vector<std::thread> threads;
+      for (unsigned int t = 0; t < num_threads; t++) {
+        threads.emplace_back(f, t, n * t / num_threads, n * (t + 1) / num_threads);
+      }
+      for (auto & thread : threads) {
+        thread.join();
+      }
+    }
+
+    // One sorted run per thread, then the runs are merged pairwise, the merges of a round in parallel
+    template<typename T>
+    void parallelSort(std::vector<T> & v, unsigned int num_threads)
+    {
+      std::vector<size_t> bounds(num_threads + 1);
+      for (unsigned int t = 0; t <= num_threads; t++) {
+        bounds[t] = v.size() * t / num_threads;
+      }
+      parallelFor(
+        num_threads, num_threads, [&v, &bounds](unsigned int, size_t begin, size_t end) {
+          for (size_t t = begin; t < end; t++) {
+            std::sort(v.begin() + bounds[t], v.begin() + bounds[t + 1]);
+          }
+        });
+      for (size_t width = 1; width < num_threads; width *= 2) {
+        std::vector<std::thread> merges;
+        for (size_t t = 0; t + width < num_threads; t += 2 * width) {
+          auto first = v.begin() + bounds[t];
+          auto middle = v.begin() + bounds[t + width];
+          auto last = v.begin() + bounds[std::min<size_t>(t + 2 * width, num_threads)];
+          merges.emplace_back([first, middle, last]() {std::inplace_merge(first, middle, last);});
+        }
+        for (auto & merge : merges) {
+          merge.join();
+        }
+      }
+    }
+  }  // namespace
+
+  OctomapBuilder::OctomapBuilder(const OctomapBuilderParams & params)
+  : params_(params)
+  {
+  }
+
+  uint64_t OctomapBuilder::keyToMorton(const octomap::OcTreeKey & key)
+  {
+    // x in the lowest bit of every triplet, as octomap numbers the children of a node
+    return spreadBits(key[0]) | spreadBits(key[1]) << 1 | spreadBits(key[2]) << 2;
+  }
+
+  octomap::OcTreeKey OctomapBuilder::mortonToKey(uint64_t morton)
+  {
+    return octomap::OcTreeKey(
+      static_cast<octomap::key_type>(compactBits(morton)),
+      static_cast<octomap::key_type>(compactBits(morton >> 1)),
+      static_cast<octomap::key_type>(compactBits(morton >> 2)));
+  }
+
+  unsigned int OctomapBuilder::numThreads() const
+  {
+    if (params_.num_threads > 0) {
+      return params_.num_threads;
+    }
+    return std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  void OctomapBuilder::build(const pcl::PointCloud<pcl::PointXYZRGB> & cloud)
+  {
+    occupied_.clear();
+    free_.clear();
+    const unsigned int num_threads = numThreads();
+    // Keys and rays depend on the resolution only, the tree stays empty
+    const octomap::OcTree coder(params_.resolution);
+    const auto & points = cloud.points;
+
+    // Voxel of every point, the points left out sort to the end
+    std::vector<std::pair<uint64_t, uint32_t>> keyed(points.size());
+    parallelFor(
+      num_threads, points.size(), [&](unsigned int, size_t begin, size_t end) {
+        octomap::OcTreeKey key;
+        for (size_t i = begin; i < end; i++) {
+          const auto & p = points[i];
+          keyed[i] = {kNoVoxel, static_cast<uint32_t>(i)};
+          if (pcl::isFinite(p) && !isElevatedNodeCenter(p) &&
+          coder.coordToKeyChecked(octomap::point3d(p.x, p.y, p.z), key))
+          {
+            keyed[i].first = keyToMorton(key);
+          }
+        }
+      });
+    parallelSort(keyed, num_threads);
+    keyed.erase(
+      std::lower_bound(
+        keyed.begin(), keyed.end(), std::make_pair(kNoVoxel, static_cast<uint32_t>(0))),
+      keyed.end());
+
+    // Every thread aggregates whole voxels, its slice starts at the first point of one
+    std::vector<size_t> starts(num_threads + 1, keyed.size());
+    for (unsigned int t = 0; t < num_threads; t++) {
+      size_t s = keyed.size() * t / num_threads;
+      while (s > 0 && s < keyed.size() && keyed[s].first == keyed[s - 1].first) {
+        s++;
+      }
+      starts[t] = s;
+    }
+    std::vector<std::vector<OctomapVoxel>> parts(num_threads);
+    parallelFor(
+      num_threads, num_threads, [&](unsigned int, size_t begin, size_t end) {
+        for (size_t t = begin; t < end; t++) {
+          for (size_t i = starts[t]; i < starts[t + 1]; ) {
+            size_t j = i;
+            float cost = 0.0f;
+            uint32_t r = 0, g = 0, b = 0;
+            for (; j < starts[t + 1] && keyed[j].first == keyed[i].first; j++) {
+              const auto & p = points[keyed[j].second];
+              cost = std::max(cost, pointCost(p));
+              r += p.r;
+              g += p.g;
+              b += p.b;
+            }
+            const uint32_t count = j - i;
+            // The cost is kept as the log odds, as PCL2OctomapConverter always did
+            parts[t].push_back(
+              {keyed[i].first, cost,
+                static_cast<uint8_t>(r / count), static_cast<uint8_t>(g / count),
+                static_cast<uint8_t>(b / count)});
+            i = j;
+          }
+        }
+      });
+    for (auto & part : parts) {
+      occupied_.insert(occupied_.end(), part.begin(), part.end());
+    }
+
+    if (!params_.clear_free_space) {
+      return;
+    }
+
+    // The voxels on the rays to the points, those of the points themselves stay occupied
+    const octomap::point3d origin(
+      params_.sensor_origin_x, params_.sensor_origin_y, params_.sensor_origin_z);
+    std::vector<std::vector<uint64_t>> ray_parts(num_threads);
+    parallelFor(
+      num_threads, points.size(), [&](unsigned int t, size_t begin, size_t end) {
+        octomap::KeyRay ray;
+        std::unordered_set<uint64_t> seen;
+        for (size_t i = begin; i < end; i++) {
+          const auto & p = points[i];
+          if (pcl::isFinite(p) && !isElevatedNodeCenter(p) &&
+          coder.computeRayKeys(origin, octomap::point3d(p.x, p.y, p.z), ray))
+          {
+            for (const auto & key : ray) {
+              seen.insert(keyToMorton(key));
+            }
+          }
+        }
+        ray_parts[t].assign(seen.begin(), seen.end());
+      });
+    std::vector<uint64_t> ray_codes;
+    for (auto & part : ray_parts) {
+      ray_codes.insert(ray_codes.end(), part.begin(), part.end());
+      std::vector<uint64_t>().swap(part);
+    }
+    parallelSort(ray_codes, num_threads);
+    ray_codes.erase(std::unique(ray_codes.begin(), ray_codes.end()), ray_codes.end());
+
+    // A new node hit by a miss, colors stay the ColorOcTreeNode default
+    const float free_log_odds = coder.getProbMissLog();
+    auto occupied_it = occupied_.begin();
+    for (uint64_t code : ray_codes) {
+      while (occupied_it != occupied_.end() && occupied_it->morton < code) {
+        ++occupied_it;
+      }
+      if (occupied_it == occupied_.end() || occupied_it->morton != code) {
+        free_.push_back({code, free_log_odds, 255, 255, 255});
+      }
+    }
+  }
+
+  std::shared_ptr<octomap::ColorOcTree> OctomapBuilder::makeTree(
+    const std::vector<const std::vector<OctomapVoxel> *> & voxel_lists) const
+  {
+    auto tree = std::make_shared<octomap::ColorOcTree>(params_.resolution);
+    const unsigned int depth = tree->getTreeDepth();
+    const float min_log_odds = tree->getClampingThresMinLog();
+    const float max_log_odds = tree->getClampingThresMaxLog();
+
+    // Nodes from the root to the previous leaf
+    std::vector<octomap::ColorOcTreeNode *> path(depth + 1, nullptr);
+    std::vector<size_t> next(voxel_lists.size(), 0);
+    uint64_t previous = 0;
+    bool first = true;
+    while (true) {
+      // The lists are sorted and disjoint, take the smallest head
+      const OctomapVoxel * voxel = nullptr;
+      size_t from = 0;
+      for (size_t l = 0; l < voxel_lists.size(); l++) {
+        if (next[l] < voxel_lists[l]->size() &&
+          (!voxel || (*voxel_lists[l])[next[l]].morton < voxel->morton))
+        {
+          voxel = &(*voxel_lists[l])[next[l]];
+          from = l;
+        }
+      }
+      if (!voxel) {
+        break;
+      }
+      next[from]++;
+
+      unsigned int level = 0;
+      if (first) {
+        // There is no other way to create the root, the path below it is walked as for any leaf
+        tree->setNodeValue(mortonToKey(voxel->morton), voxel->log_odds, true);
+        path[0] = tree->getRoot();
+        first = false;
+      } else {
+        // The levels above the highest differing bit triplet are shared with the previous leaf
+        const int highest_bit = 63 - __builtin_clzll(voxel->morton ^ previous);
+        level = depth - 1 - highest_bit / 3;
+      }
+      for (unsigned int i = level; i < depth; i++) {
+        const unsigned int child = (voxel->morton >> (3 * (depth - 1 - i))) & 7;
+        path[i + 1] = tree->nodeChildExists(path[i], child) ?
+          tree->getNodeChild(path[i], child) : tree->createNodeChild(path[i], child);
+      }
+      path[depth]->setLogOdds(std::min(std::max(voxel->log_odds, min_log_odds), max_log_odds));
+      path[depth]->setColor(voxel->r, voxel->g, voxel->b);
+      previous = voxel->morton;
+    }
+
+    // Inner occupancy and color once for all leaves, then identical siblings are merged
+    tree->updateInnerOccupancy();
+    tree->prune();
+    return tree;
+  }
+
+  std::shared_ptr<octomap::ColorOcTree> OctomapBuilder::tree() const
+  {
+    return makeTree({&occupied_, &free_});
+  }
+
+  std::vector<OctomapTile> OctomapBuilder::tiles() const
+  {
+    if (params_.tile_size <= 0.0) {
+      return {{0, 0, tree()}};
+    }
+
+    // Taken in order, the voxels of every tile stay sorted
+    const octomap::OcTree coder(params_.resolution);
+    std::map<std::pair<int, int>, std::pair<std::vector<OctomapVoxel>, std::vector<OctomapVoxel>>>
+    buckets;
+    for (bool occupied : {true, false}) {
+      for (const auto & voxel : occupied ? occupied_ : free_) {
+        const auto center = coder.keyToCoord(mortonToKey(voxel.morton));
+        auto & bucket = buckets[{
+            static_cast<int>(std::floor(center.x() / params_.tile_size)),
+            static_cast<int>(std::floor(center.y() / params_.tile_size))}];
+        (occupied ? bucket.first : bucket.second).push_back(voxel);
+      }
+    }
+
+    std::vector<OctomapTile> tiles;
+    std::vector<const std::pair<std::vector<OctomapVoxel>, std::vector<OctomapVoxel>> *> tile_voxels;
+    for (const auto & bucket : buckets) {
+      tiles.push_back({bucket.first.first, bucket.first.second, nullptr});
+      tile_voxels.push_back(&bucket.second);
+    }
+    const unsigned int num_threads = std::min<size_t>(numThreads(), std::max<size_t>(1, tiles.size()));
+    parallelFor(
+      num_threads, tiles.size(), [&](unsigned int, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+          tiles[i].tree = makeTree({&tile_voxels[i]->first, &tile_voxels[i]->second});
+        }
+      });
+    return tiles;
+  }
+
+  std::vector<std::string> OctomapBuilder::write(const std::string & filename) const
+  {
+    std::vector<std::string> files;
+    if (params_.tile_size <= 0.0) {
+      if (tree()->write(filename)) {
+        files.push_back(filename);
+      }
+      return files;
+    }
+    return writeTiles(filename, tiles());
+  }
+
+  std::vector<std::string> OctomapBuilder::writeTiles(
+    const std::string & filename,
+    const std::vector<OctomapTile> & tiles)
+  {
+    std::vector<std::string> files;
+    std::string stem = filename;
+    std::string extension;
+    const auto dot = filename.find_last_of('.');
+    const auto slash = filename.find_last_of('/');
+    if (dot != std::string::npos && (slash == std::string::npos || dot > slash)) {
+      stem = filename.substr(0, dot);
+      extension = filename.substr(dot);
+    }
+    for (const auto & tile : tiles) {
+      const std::string tile_filename =
+        stem + "_" + std::to_string(tile.x) + "_" + std::to_string(tile.y) + extension;
+      if (tile.tree->write(tile_filename)) {
+        files.push_back(tile_filename);
+      }
+    }
+    return files;
+  }
+
+  void insertCloudByRayCasting(
+    const pcl::PointCloud<pcl::PointXYZRGB> & cloud,
+    octomap::ColorOcTree & tree)
+  {
+    octomap::Pointcloud octocloud;
+    for (auto && i : cloud.points) {
+      if (!isElevatedNodeCenter(i)) {
+        octocloud.push_back(octomap::point3d(i.x, i.y, i.z));
+      }
+    }
+    octomap::point3d sensorOrigin(0, 0, 0);
+    tree.insertPointCloud(octocloud, sensorOrigin);
+
+    for (auto && i : cloud.points) {
+      if (!isElevatedNodeCenter(i)) {
+        auto crr_point_node = tree.coordToKey(octomap::point3d(i.x, i.y, i.z));
+        tree.setNodeValue(crr_point_node, pointCost(i), false);
+        tree.setNodeColor(crr_point_node, i.r, i.g, i.b);
+      }
+    }
+  }
+
+}  // namespace vox_nav_utilities
@@ -14,6 +14,7 @@
 
 #include "vox_nav_utilities/pcl2octomap_converter_node.hpp"
 
+#include <chrono>
 #include <memory>
 
 namespace vox_nav_utilities
@@ -36,6 +37,10 @@ namespace vox_nav_utilities
     this->declare_parameter("remove_outlier_stddev_threshold", 1.0);
     this->declare_parameter("remove_outlier_radius_search", 0.1);
     this->declare_parameter("remove_outlier_min_neighbors_in_radius", 1);
+    this->declare_parameter("use_direct_build", true);
+    this->declare_parameter("clear_free_space", false);
+    this->declare_parameter("output_tile_size", 0.0);
+    this->declare_parameter("num_threads", 0);
 
     input_pcd_filename_ = this->get_parameter("input_pcd_filename").as_string();
     output_binary_octomap_filename_ =
@@ -62,6 +67,10 @@ namespace vox_nav_utilities
     remove_outlier_radius_search_ = this->get_parameter("remove_outlier_radius_search").as_double();
     remove_outlier_min_neighbors_in_radius_ =
       this->get_parameter("remove_outlier_min_neighbors_in_radius").as_int();
+    use_direct_build_ = this->get_parameter("use_direct_build").as_bool();
+    clear_free_space_ = this->get_parameter("clear_free_space").as_bool();
+    output_tile_size_ = this->get_parameter("output_tile_size").as_double();
+    num_threads_ = this->get_parameter("num_threads").as_int();
 
     pointcloud_ = vox_nav_utilities::loadPointcloudFromPcd(input_pcd_filename_.c_str());
 
@@ -110,7 +119,7 @@ namespace vox_nav_utilities
   }
 
   void PCL2OctomapConverter::calcThresholdedNodes(
-    const octomap::ColorOcTree tree,
+    const octomap::ColorOcTree & tree,
     unsigned int & num_thresholded,
     unsigned int & num_other)
   {
@@ -129,7 +138,7 @@ namespace vox_nav_utilities
     }
   }
 
-  void PCL2OctomapConverter::outputStatistics(const octomap::ColorOcTree tree)
+  void PCL2OctomapConverter::outputStatistics(const octomap::ColorOcTree & tree)
   {
     unsigned int numThresholded, numOther;
     calcThresholdedNodes(tree, numThresholded, numOther);
@@ -150,44 +159,8 @@ namespace vox_nav_utilities
     std::cout << std::endl;
   }
 
-  void PCL2OctomapConverter::processConversion()
+  void PCL2OctomapConverter::addToMarkers(const octomap::ColorOcTree & tree)
   {
-    octomap::Pointcloud octocloud;
-    octomap::ColorOcTree tree(octomap_voxelsize_);
-
-    for (auto && i : pointcloud_->points) {
-      octomap::point3d endpoint(i.x, i.y, i.z);
-
-      // Yellow color pints are elevated Node centers, keep them out for now
-      if (!(i.r && i.g)) {
-        octocloud.push_back(endpoint);
-      }
-    }
-
-    std::cout << "Octocloud size is:" << octocloud.size() << std::endl;
-    octomap::point3d sensorOrigin(0, 0, 0);
-    tree.insertPointCloud(octocloud, sensorOrigin);
-
-    octomap::unordered_ns::unordered_multimap<octomap::OcTreeKey, double,
-      octomap::OcTreeKey::KeyHash> node_values;
-
-    for (auto && i : pointcloud_->points) {
-      octomap::point3d crr_point(i.x, i.y, i.z);
-      double cost = static_cast<double>(i.b) / static_cast<double>(255.0);
-      // Obstacle point set the value to highest cost
-      if (i.r) {
-        cost = 1.0;
-      }
-      if (!(i.r && i.g)) {
-        auto crr_point_node = tree.coordToKey(crr_point);
-        auto pair = std::pair<octomap::OcTreeKey, double>(crr_point_node, cost);
-        node_values.insert(pair);
-
-        tree.setNodeValue(crr_point_node, cost, false);
-        tree.setNodeColor(crr_point_node, i.r, i.g, i.b);
-      }
-    }
-
     auto m_treeDepth = tree.getTreeDepth();
     octomap_markers_.markers.resize(m_treeDepth + 1);
 
@@ -244,9 +217,59 @@ namespace vox_nav_utilities
           visualization_msgs::msg::Marker::DELETE;
       }
     }
+  }
 
-    outputStatistics(tree);
-    tree.write(output_binary_octomap_filename_);
+  void PCL2OctomapConverter::processConversion()
+  {
+    std::shared_ptr<octomap::ColorOcTree> tree;
+    std::vector<OctomapTile> tiles;
+    OctomapBuilderParams builder_params;
+    builder_params.resolution = octomap_voxelsize_;
+    builder_params.clear_free_space = clear_free_space_;
+    builder_params.tile_size = output_tile_size_;
+    builder_params.num_threads = num_threads_;
+    OctomapBuilder builder(builder_params);
+    const bool tiled = use_direct_build_ && output_tile_size_ > 0.0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    if (tiled) {
+      // The whole map is never built as one tree, only its tiles
+      builder.build(*pointcloud_);
+      tiles = builder.tiles();
+    } else if (use_direct_build_) {
+      builder.build(*pointcloud_);
+      tree = builder.tree();
+    } else {
+      tree = std::make_shared<octomap::ColorOcTree>(octomap_voxelsize_);
+      insertCloudByRayCasting(*pointcloud_, *tree);
+    }
+    RCLCPP_INFO(
+      get_logger(), "Converted %d points into an octomap in %.3f s",
+      static_cast<int>(pointcloud_->points.size()),
+      std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+
+    octomap_markers_.markers.clear();
+    if (tiled) {
+      for (const auto & tile : tiles) {
+        addToMarkers(*tile.tree);
+        std::cout << "Tile " << tile.x << ", " << tile.y << ":\n";
+        outputStatistics(*tile.tree);
+      }
+      auto files = OctomapBuilder::writeTiles(output_binary_octomap_filename_, tiles);
+      for (const auto & filename : files) {
+        RCLCPP_INFO(get_logger(), "Wrote %s", filename.c_str());
+      }
+      return;
+    }
+
+    addToMarkers(*tree);
+    outputStatistics(*tree);
+    if (!use_direct_build_ && output_tile_size_ > 0.0) {
+      RCLCPP_WARN(get_logger(), "output_tile_size needs use_direct_build, writing a single tree");
+    }
+    if (tree->write(output_binary_octomap_filename_)) {
+      RCLCPP_INFO(get_logger(), "Wrote %s", output_binary_octomap_filename_.c_str());
+    }
   }
 
 }   // namespace vox_nav_utilities
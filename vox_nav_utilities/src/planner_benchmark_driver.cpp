@@ -0,0 +1,433 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_utilities/planner_benchmark_driver.hpp"
+
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <ompl/tools/benchmark/MachineSpecs.h>
+#include <ompl/util/Console.h>
+#include <ompl/util/RandomNumbers.h>
+#include <ompl/util/Time.h>
+
+#include <algorithm>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace vox_nav_utilities
+{
+  namespace
+  {
+    // The log is tab separated, one line per entry
+    std::string sanitize(std::string field)
+    {
+      std::replace(field.begin(), field.end(), '\t', ' ');
+      std::replace(field.begin(), field.end(), '\n', ' ');
+      std::replace(field.begin(), field.end(), '\r', ' ');
+      return field;
+    }
+
+    std::vector<std::string> split(const std::string & line)
+    {
+      std::vector<std::string> fields;
+      std::string field;
+      std::istringstream stream(line);
+      while (std::getline(stream, field, '\t')) {
+        fields.push_back(field);
+      }
+      return fields;
+    }
+
+    std::tuple<int, std::string, int> taskKey(const PlannerBenchmarkTask & task)
+    {
+      return std::make_tuple(task.epoch, task.planner, task.run);
+    }
+
+    // FNV-1a of the name and the two numbers, std::hash may differ between builds and a benchmark
+    // may resume in another one
+    std::uint_fast32_t seedFor(const std::string & name, int a, int b)
+    {
+      std::uint32_t hash = 2166136261u;
+      auto mix = [&hash](std::uint32_t byte) {hash = (hash ^ byte) * 16777619u;};
+      for (char c : name) {
+        mix(static_cast<unsigned char>(c));
+      }
+      for (int value : {a, b}) {
+        for (int shift = 0; shift < 32; shift += 8) {
+          mix((static_cast<std::uint32_t>(value) >> shift) & 0xff);
+        }
+      }
+      // OMPL does not take 0
+      return hash ? hash : 1;
+    }
+
+    // Seeds the generator of the seeds of the RNGs created from now on. The workers are forked from a driver
+    // that has used OMPL already, without a new seed every worker would hand out the same ones
+    void reseedOmpl(std::uint_fast32_t seed)
+    {
+      // OMPL reseeds anyway, but reports it as an error once RNGs were created
+      const auto level = ompl::msg::getLogLevel();
+      ompl::msg::setLogLevel(ompl::msg::LOG_NONE);
+      ompl::RNG::setSeed(seed);
+      ompl::msg::setLogLevel(level);
+    }
+
+    std::string formatRun(
+      const PlannerBenchmarkTask & task,
+      const ompl::tools::Benchmark::RunProperties & properties)
+    {
+      std::string line = "run\t" + std::to_string(task.epoch) + "\t" + sanitize(task.planner) + "\t" +
+        std::to_string(task.run);
+      for (const auto & property : properties) {
+        line += "\t" + sanitize(property.first) + "\t" + sanitize(property.second);
+      }
+      return line + "\n";
+    }
+
+    // Gives access to the experiment Benchmark::saveResultsToFile writes
+    class MergedBenchmark : public ompl::tools::Benchmark
+    {
+    public:
+      MergedBenchmark(ompl::geometric::SimpleSetup & ss, const std::string & name)
+      : ompl::tools::Benchmark(ss, name)
+      {
+      }
+
+      CompleteExperiment & experiment() {return exp_;}
+    };
+
+    const int kAllEpochs = INT_MAX;
+  }  // namespace
+
+  PlannerBenchmarkDriver::PlannerBenchmarkDriver(const PlannerBenchmarkDriverParams & params)
+  : params_(params)
+  {
+    if (params_.results_log.empty()) {
+      throw std::invalid_argument("PlannerBenchmarkDriver needs a results log");
+    }
+    load();
+  }
+
+  bool PlannerBenchmarkDriver::isFinished(const PlannerBenchmarkTask & task) const
+  {
+    return finished_.count(taskKey(task)) > 0;
+  }
+
+  bool PlannerBenchmarkDriver::recorded(const std::string & key, std::string & value) const
+  {
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      return false;
+    }
+    value = it->second;
+    return true;
+  }
+
+  void PlannerBenchmarkDriver::record(const std::string & key, const std::string & value)
+  {
+    append("value\t" + sanitize(key) + "\t" + sanitize(value) + "\n");
+    values_[sanitize(key)] = sanitize(value);
+  }
+
+  void PlannerBenchmarkDriver::load()
+  {
+    std::ifstream log(params_.results_log, std::ios::binary);
+    if (!log) {
+      return;
+    }
+    log.seekg(log_offset_);
+    std::string contents((std::istreambuf_iterator<char>(log)), std::istreambuf_iterator<char>());
+    log.close();
+
+    size_t begin = 0;
+    for (size_t end = contents.find('\n'); end != std::string::npos; end = contents.find('\n', begin)) {
+      const auto fields = split(contents.substr(begin, end - begin));
+      begin = end + 1;
+      if (fields.size() == 3 && fields[0] == "value") {
+        values_[fields[1]] = fields[2];
+      } else if (fields.size() >= 4 && fields.size() % 2 == 0 && fields[0] == "run") {
+        PlannerBenchmarkRecord record;
+        try {
+          record.task = {std::stoi(fields[1]), fields[2], std::stoi(fields[3])};
+        } catch (const std::exception &) {
+          continue;
+        }
+        for (size_t i = 4; i < fields.size(); i += 2) {
+          record.properties[fields[i]] = fields[i + 1];
+        }
+        if (finished_.insert(taskKey(record.task)).second) {
+          runs_.push_back(record);
+        }
+      }
+    }
+    log_offset_ += begin;
+
+    // What follows the last line was cut by a crash, the next entry would be appended to it
+    if (begin < contents.size()) {
+      OMPL_WARN(
+        "Dropping %zu bytes of an unfinished entry at the end of %s", contents.size() - begin,
+        params_.results_log.c_str());
+      if (truncate(params_.results_log.c_str(), log_offset_) != 0) {
+        throw std::runtime_error("Could not truncate " + params_.results_log);
+      }
+    }
+  }
+
+  void PlannerBenchmarkDriver::append(const std::string & line) const
+  {
+    // A single write to a file opened for appending is not interleaved with those of other workers
+    int fd = open(params_.results_log.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      throw std::runtime_error("Could not open " + params_.results_log);
+    }
+    ssize_t written = write(fd, line.data(), line.size());
+    close(fd);
+    if (written != static_cast<ssize_t>(line.size())) {
+      throw std::runtime_error("Could not append to " + params_.results_log);
+    }
+  }
+
+  size_t PlannerBenchmarkDriver::run(
+    const std::vector<PlannerBenchmarkTask> & tasks,
+    const WorkerSetup & setup,
+    const RunFunction & run)
+  {
+    std::vector<PlannerBenchmarkTask> missing;
+    std::set<std::tuple<int, std::string, int>> queued;
+    for (const auto & task : tasks) {
+      if (!isFinished(task) && queued.insert(taskKey(task)).second) {
+        missing.push_back(task);
+      }
+    }
+    OMPL_INFORM(
+      "%zu of %zu benchmark runs are in %s already", tasks.size() - missing.size(), tasks.size(),
+      params_.results_log.c_str());
+
+    const unsigned int max_workers = params_.num_workers ?
+      params_.num_workers : std::max(1u, std::thread::hardware_concurrency());
+    for (int attempt = 0; attempt < params_.max_attempts && !missing.empty(); attempt++) {
+      const size_t finished_before = runs_.size();
+      const unsigned int num_workers = std::min<size_t>(max_workers, missing.size());
+
+      // Buffered output would be printed again by every worker
+      std::cout.flush();
+      std::cerr.flush();
+      std::fflush(nullptr);
+      const pid_t driver = getpid();
+      std::vector<pid_t> workers;
+      for (unsigned int w = 0; w < num_workers; w++) {
+        pid_t pid = fork();
+        if (pid == 0) {
+          // A worker must not outlive the driver, the resumed benchmark would run its tasks again
+          prctl(PR_SET_PDEATHSIG, SIGKILL);
+          if (getppid() != driver) {
+            _exit(1);
+          }
+          int code = 0;
+          try {
+            reseedOmpl(seedFor("worker", attempt, static_cast<int>(w)));
+            setup();
+            // Interleaved, so every worker gets runs of every planner
+            for (size_t i = w; i < missing.size(); i += num_workers) {
+              // A task draws the same numbers whichever worker runs it, and other ones than any other task
+              const auto & task = missing[i];
+              reseedOmpl(seedFor(task.planner, task.epoch, task.run));
+              append(formatRun(task, run(task)));
+            }
+          } catch (const std::exception & e) {
+            std::cerr << "Benchmark worker " << w << " failed: " << e.what() << std::endl;
+            code = 1;
+          }
+          // Skips the destructors of everything the driver process owns
+          _exit(code);
+        }
+        if (pid < 0) {
+          OMPL_ERROR("Could not fork benchmark worker %u", w);
+          break;
+        }
+        workers.push_back(pid);
+      }
+
+      int failed_workers = 0;
+      for (pid_t pid : workers) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        failed_workers += !WIFEXITED(status) || WEXITSTATUS(status) != 0;
+      }
+
+      load();
+      missing.erase(
+        std::remove_if(
+          missing.begin(), missing.end(),
+          [this](const PlannerBenchmarkTask & task) {return isFinished(task);}),
+        missing.end());
+      OMPL_INFORM(
+        "Benchmark pass %d: %zu runs finished, %zu left, %d of %zu workers failed", attempt,
+        runs_.size() - finished_before, missing.size(), failed_workers, workers.size());
+      if (runs_.size() == finished_before) {
+        break;
+      }
+    }
+    return missing.size();
+  }
+
+  ompl::tools::Benchmark::RunProperties runPlannerOnce(
+    ompl::geometric::SimpleSetup & ss,
+    const ompl::base::PlannerPtr & planner,
+    const ompl::tools::Benchmark::Request & request)
+  {
+    ompl::tools::Benchmark benchmark(ss, "run");
+    benchmark.addPlanner(planner);
+    ompl::tools::Benchmark::Request single_run = request;
+    single_run.runCount = 1;
+    single_run.displayProgress = false;
+    benchmark.benchmark(single_run);
+
+    const auto & experiment = benchmark.getRecordedExperimentData();
+    if (experiment.planners.empty() || experiment.planners.front().runs.empty()) {
+      return ompl::tools::Benchmark::RunProperties();
+    }
+    return experiment.planners.front().runs.front();
+  }
+
+  bool saveMergedResults(
+    ompl::geometric::SimpleSetup & ss,
+    const std::vector<std::pair<std::string, ompl::base::PlannerPtr>> & planners,
+    const std::vector<PlannerBenchmarkRecord> & runs,
+    const ompl::tools::Benchmark::Request & request,
+    const std::string & experiment_name,
+    const std::string & filename)
+  {
+    MergedBenchmark benchmark(ss, experiment_name);
+    auto & experiment = benchmark.experiment();
+    experiment.name = experiment_name;
+    experiment.maxTime = request.maxTime;
+    experiment.maxMem = request.maxMem;
+    experiment.runCount = request.runCount;
+    experiment.startTime = ompl::time::now();
+    experiment.totalDuration = 0.0;
+    std::stringstream setup_info;
+    ss.print(setup_info);
+    experiment.setupInfo = setup_info.str();
+    experiment.seed = ompl::RNG::getSeed();
+    experiment.host = ompl::machine::getHostname();
+    experiment.cpuInfo = ompl::machine::getCPUInfo();
+
+    for (const auto & planner : planners) {
+      std::vector<const PlannerBenchmarkRecord *> planner_runs;
+      for (const auto & record : runs) {
+        if (record.task.planner == planner.first) {
+          planner_runs.push_back(&record);
+        }
+      }
+      if (planner_runs.empty()) {
+        continue;
+      }
+      std::sort(
+        planner_runs.begin(), planner_runs.end(),
+        [](const PlannerBenchmarkRecord * a, const PlannerBenchmarkRecord * b) {
+          return a->task.run < b->task.run;
+        });
+
+      ompl::tools::Benchmark::PlannerExperiment planner_experiment;
+      // As Benchmark names the planners of a geometric SimpleSetup
+      planner_experiment.name = "geometric_" + planner.second->getName();
+      planner.second->params().getParams(planner_experiment.common);
+      for (const auto * record : planner_runs) {
+        planner_experiment.runs.push_back(record->properties);
+        auto time = record->properties.find("time REAL");
+        if (time != record->properties.end()) {
+          experiment.totalDuration += std::atof(time->second.c_str());
+        }
+      }
+      experiment.planners.push_back(planner_experiment);
+    }
+    return benchmark.saveResultsToFile(filename.c_str());
+  }
+
+  bool saveCsvSummary(const std::vector<PlannerBenchmarkRecord> & runs, const std::string & filename)
+  {
+    struct Summary
+    {
+      size_t runs{0};
+      // Sum and count of every numeric property
+      std::map<std::string, std::pair<double, size_t>> sums;
+    };
+    std::map<std::pair<int, std::string>, Summary> summaries;
+    std::set<std::string> columns;
+    for (const auto & record : runs) {
+      for (int epoch : {record.task.epoch, kAllEpochs}) {
+        auto & summary = summaries[{epoch, record.task.planner}];
+        summary.runs++;
+        for (const auto & property : record.properties) {
+          const auto type_begin = property.first.rfind(' ');
+          if (type_begin == std::string::npos) {
+            continue;
+          }
+          const std::string type = property.first.substr(type_begin + 1);
+          if (type != "REAL" && type != "INTEGER" && type != "BOOLEAN") {
+            continue;
+          }
+          char * end = nullptr;
+          const double value = std::strtod(property.second.c_str(), &end);
+          if (end == property.second.c_str()) {
+            continue;
+          }
+          const std::string name = property.first.substr(0, type_begin);
+          columns.insert(name);
+          summary.sums[name].first += value;
+          summary.sums[name].second++;
+        }
+      }
+    }
+
+    std::ofstream csv(filename);
+    if (!csv) {
+      return false;
+    }
+    csv << "epoch,planner,runs";
+    for (const auto & column : columns) {
+      std::string header = column;
+      std::replace(header.begin(), header.end(), ' ', '_');
+      std::replace(header.begin(), header.end(), ',', '_');
+      csv << "," << header;
+    }
+    csv << "\n";
+    for (const auto & summary : summaries) {
+      csv << (summary.first.first == kAllEpochs ? "all" : std::to_string(summary.first.first)) << "," <<
+        summary.first.second << "," << summary.second.runs;
+      for (const auto & column : columns) {
+        csv << ",";
+        auto sum = summary.second.sums.find(column);
+        if (sum != summary.second.sums.end() && sum->second.second > 0) {
+          csv << sum->second.first / sum->second.second;
+        }
+      }
+      csv << "\n";
+    }
+    return static_cast<bool>(csv);
+  }
+
+}  // namespace vox_nav_utilities
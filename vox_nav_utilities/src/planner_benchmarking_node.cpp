@@ -35,6 +35,8 @@ namespace vox_nav_utilities
     this->declare_parameter("batch_size", 10);
     this->declare_parameter("epochs", 10);
     this->declare_parameter("max_memory", 2048);
+    this->declare_parameter("num_workers", 1);
+    this->declare_parameter("results_log", "");
     this->declare_parameter("results_output_dir", "/home/user/");
     this->declare_parameter("results_file_regex", "SE2");
     this->declare_parameter("publish_a_sample_bencmark", true);
@@ -66,6 +68,8 @@ namespace vox_nav_utilities
     this->get_parameter("batch_size", batch_size_);
     this->get_parameter("epochs", epochs_);
     this->get_parameter("max_memory", max_memory_);
+    this->get_parameter("num_workers", num_workers_);
+    this->get_parameter("results_log", results_log_);
     this->get_parameter("results_output_dir", results_output_dir_);
     this->get_parameter("results_file_regex", results_file_regex_);
     this->get_parameter("publish_a_sample_bencmark", publish_a_sample_bencmark_);
@@ -168,216 +172,289 @@ namespace vox_nav_utilities
   {
     ompl::geometric::SimpleSetup ss(state_space_);
     si = ss.getSpaceInformation();
-
-    ompl::base::ScopedState<ompl::base::SE2StateSpace> random_start(state_space_),
-    random_goal(state_space_);
-
-    geometry_msgs::msg::PoseStamped start, goal;
     std::map<int, ompl::geometric::PathGeometric> paths_map;
 
-    for (int i = 0; i < epochs_; i++) {
-
-      // spin until a valid random start and goal poses are found. Also
-      // make sure that a soluion exists for generated states
-      volatile bool found_valid_random_start_goal = false;
-
-      double start_yaw, goal_yaw, nan;
-
-      while (!found_valid_random_start_goal) {
-        start_yaw = getRangedRandom(se_bounds_.minyaw, se_bounds_.maxyaw);
-        goal_yaw = getRangedRandom(se_bounds_.minyaw, se_bounds_.maxyaw);
-
-        start.pose.position.x =
-          -15; // getRangedRandom(se_bounds_.minx, se_bounds_.maxx);
-        start.pose.position.y =
-          5; // getRangedRandom(se_bounds_.miny, se_bounds_.maxy);
-        start.pose.orientation =
-          vox_nav_utilities::getMsgQuaternionfromRPY(nan, nan, start_yaw);
-
-        goal.pose.position.x =
-          40; // getRangedRandom(se_bounds_.minx, se_bounds_.maxx);
-        goal.pose.position.y =
-          -12; // getRangedRandom(se_bounds_.miny, se_bounds_.maxy);
-        goal.pose.orientation =
-          vox_nav_utilities::getMsgQuaternionfromRPY(nan, nan, goal_yaw);
-
-        random_start->setXY(start.pose.position.x, start.pose.position.y);
-        random_start->setYaw(start_yaw);
-
-        random_goal->setXY(goal.pose.position.x, goal.pose.position.y);
-        random_goal->setYaw(goal_yaw);
-
-        // the distance should be above a certain threshold
-        double distance =
-          std::sqrt(
-          std::pow(random_goal->getX() - random_start->getX(), 2) +
-          std::pow(random_goal->getY() - random_start->getY(), 2));
+    PlannerBenchmarkDriverParams driver_params;
+    driver_params.results_log = results_log_.empty() ?
+      results_output_dir_ + results_file_regex_ + "_runs.log" : results_log_;
+    driver_params.num_workers = std::max(0, num_workers_);
+    PlannerBenchmarkDriver driver(driver_params);
 
+    // Problems of all epochs first, a resumed benchmark takes them from the results log
+    std::vector<std::pair<GroundRobotPose, GroundRobotPose>> problems;
+    for (int i = 0; i < epochs_; i++) {
+      GroundRobotPose start, goal;
+      std::string recorded_problem;
+      const std::string problem_key = "problem_" + std::to_string(i);
+      if (driver.recorded(problem_key, recorded_problem)) {
+        std::istringstream problem(recorded_problem);
+        problem >> start.x >> start.y >> start.z >> start.yaw >>
+        goal.x >> goal.y >> goal.z >> goal.yaw;
         RCLCPP_INFO(
           this->get_logger(),
-          "Checking whether random generated goal start pair are valid ... ");
-
-        found_valid_random_start_goal =
-          (isStateValidSE2(random_start.get()) &&
-          isStateValidSE2(random_goal.get()) &&
-          distance > min_euclidean_dist_start_to_goal_);
-
-        if (!found_valid_random_start_goal) {
-          RCLCPP_INFO(
-            this->get_logger(),
-            "Still Looking to sample valid random start and goal states ... ");
-          continue;
-        }
-
+          "Resuming epoch %d with the start and goal states in %s", i,
+          driver_params.results_log.c_str());
+      } else {
+        sampleProblem(ss, start, goal);
+        std::ostringstream problem;
+        problem << std::setprecision(17) << start.x << " " << start.y << " " << start.z << " " <<
+          start.yaw << " " << goal.x << " " << goal.y << " " << goal.z << " " << goal.yaw;
+        driver.record(problem_key, problem.str());
         RCLCPP_INFO(
           this->get_logger(),
-          "A valid random start and goal states has been found.");
-
-        // define start & goal states
-        if ((selected_state_space_ == "REEDS") ||
-          (selected_state_space_ == "DUBINS") ||
-          (selected_state_space_ == "SE2"))
-        {
-          ss.setStartAndGoalStates(random_start, random_goal, goal_tolerance_);
-          ss.setStateValidityChecker(
-            [this](const ompl::base::State * state) {
-              return isStateValidSE2(state);
-            });
-
-        } else {
-          ompl::base::ScopedState<ompl::base::SE3StateSpace> se3_start(
-            state_space_),
-          se3_goal(state_space_);
-
-          se3_start->setXYZ(random_start->getX(), random_start->getY(), start_.z);
-          se3_start->as<ompl::base::SO3StateSpace::StateType>(1)->setAxisAngle(
-            0, 0, 1, random_start->getYaw());
+          "Created valid random start and goal states");
+      }
+      problems.emplace_back(start, goal);
+    }
 
-          se3_goal->setXYZ(random_goal->getX(), random_goal->getY(), goal_.z);
-          se3_goal->as<ompl::base::SO3StateSpace::StateType>(1)->setAxisAngle(
-            0, 0, 1, random_goal->getYaw());
+    std::vector<PlannerBenchmarkTask> tasks;
+    for (int i = 0; i < epochs_; i++) {
+      for (auto && planner_name : selected_planners_) {
+        for (int run = 0; run < batch_size_; run++) {
+          tasks.push_back({i, planner_name, run});
+        }
+      }
+    }
 
-          ss.setStartAndGoalStates(se3_start, se3_goal, goal_tolerance_);
+    ompl::tools::Benchmark::Request request(planner_timeout_, max_memory_,
+      batch_size_);
+    request.displayProgress = false;
 
-          ss.setStateValidityChecker(
-            [this](const ompl::base::State * state) {
-              return isStateValidSE3(state);
-            });
-        }
+    RCLCPP_INFO(
+      this->get_logger(),
+      "Performing actual benchmark of %d runs on %d workers, "
+      "This might take some time.", static_cast<int>(tasks.size()), num_workers_);
+
+    size_t unfinished = driver.run(
+      tasks,
+      [this]() {
+        // Every worker checks states on collision objects of its own
+        robot_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
+          robot_collision_object_->collisionGeometry());
+        original_octomap_collision_object_ = std::make_shared<fcl::CollisionObjectf>(
+          std::shared_ptr<fcl::CollisionGeometryf>(
+            std::make_shared<fcl::OcTreef>(original_octomap_octree_)));
+      },
+      [this, &problems, &request](const PlannerBenchmarkTask & task) {
+        ompl::geometric::SimpleSetup task_ss(state_space_);
+        setupProblem(task_ss, problems[task.epoch].first, problems[task.epoch].second);
+        ompl::base::PlannerPtr planner_ptr;
+        allocatePlannerbyName(planner_ptr, task.planner, task_ss.getSpaceInformation());
+        return runPlannerOnce(task_ss, planner_ptr, request);
+      });
+    if (unfinished) {
+      RCLCPP_WARN(
+        this->get_logger(),
+        "%d runs could not be finished and are left out of the results, "
+        "run the benchmark again to retry them", static_cast<int>(unfinished));
+    }
 
-        si->setStateValidityCheckingResolution(
-          1.0 /
-          state_space_->getMaximumExtent());
-        si->setup();
+    // The log may hold runs of other planners or more runs from earlier configurations
+    std::vector<PlannerBenchmarkRecord> finished_runs;
+    for (const auto & record : driver.runs()) {
+      if (record.task.epoch < epochs_ && record.task.run < batch_size_ &&
+        std::find(
+          selected_planners_.begin(), selected_planners_.end(),
+          record.task.planner) != selected_planners_.end())
+      {
+        finished_runs.push_back(record);
+      }
+    }
 
-        // create a planner for the defined space
-        ompl::base::PlannerPtr rrtstar_planner;
-        rrtstar_planner =
-          ompl::base::PlannerPtr(new ompl::geometric::PRMstar(si));
-        ss.setPlanner(rrtstar_planner);
-        RCLCPP_INFO(
-          this->get_logger(), "Checking whether a solution exists for "
-          "random start and goal states .");
-        ompl::base::PlannerStatus has_solution = ss.solve(5.0);
-
-        // if it gets to this point , that menas our random states are valid and
-        // already meets min dist requiremnets but now there also has to be a
-        // solution for this problem
-        found_valid_random_start_goal =
-          (has_solution == ompl::base::PlannerStatus::EXACT_SOLUTION);
-
-        if (found_valid_random_start_goal) {
-          RCLCPP_INFO(
-            this->get_logger(),
-            "Found valid states and a solution for the random "
-            "problem!, proceeding to actual benchmark.");
+    for (int i = 0; i < epochs_; i++) {
+      setupProblem(ss, problems[i].first, problems[i].second);
+      std::vector<std::pair<std::string, ompl::base::PlannerPtr>> planners;
+      for (auto && planner_name : selected_planners_) {
+        ompl::base::PlannerPtr planner_ptr;
+        allocatePlannerbyName(planner_ptr, planner_name, si);
+        planners.emplace_back(planner_name, planner_ptr);
+      }
+      std::vector<PlannerBenchmarkRecord> epoch_runs;
+      for (const auto & record : finished_runs) {
+        if (record.task.epoch == i) {
+          epoch_runs.push_back(record);
         }
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
       }
+      saveMergedResults(
+        ss, planners, epoch_runs, request, "benchmark",
+        results_output_dir_ + results_file_regex_ + "_" + std::to_string(i) + ".log");
+    }
+    saveCsvSummary(
+      finished_runs,
+      results_output_dir_ + results_file_regex_ + "_summary.csv");
 
-      ss.clear();
-      RCLCPP_INFO(
-        this->get_logger(),
-        "Created valid random start and goal states");
-
-      start_.x = random_start->getX();
-      start_.y = random_start->getY();
-      start_.yaw = random_start->getYaw();
-      goal_.x = random_goal->getX();
-      goal_.y = random_goal->getY();
-      goal_.yaw = random_goal->getYaw();
-
-      ompl::base::OptimizationObjectivePtr lengthObj(
-        new ompl::base::PathLengthOptimizationObjective(si));
-      ompl::base::OptimizationObjectivePtr clearObj(
-        new ompl::base::MaximizeMinClearanceObjective(si));
-
-      ompl::base::MultiOptimizationObjective * opt =
-        new ompl::base::MultiOptimizationObjective(si);
-      opt->addObjective(lengthObj, 10.0);
-      opt->addObjective(clearObj, 1.0);
-
-      ss.setOptimizationObjective(ompl::base::OptimizationObjectivePtr(opt));
-      si->setup();
-
-      ompl::tools::Benchmark benchmark(ss, "benchmark");
-      std::mutex plan_mutex;
+    RCLCPP_INFO(
+      this->get_logger(),
+      "Bencmarking results saved to given directory: %s",
+      results_output_dir_.c_str());
+
+    if (publish_a_sample_bencmark_ && !problems.empty()) {
+      start_ = problems.back().first;
+      goal_ = problems.back().second;
+      setupProblem(ss, start_, goal_);
       int index(0);
       for (auto && planner_name : selected_planners_) {
         ompl::base::PlannerPtr planner_ptr;
         allocatePlannerbyName(planner_ptr, planner_name, si);
-        benchmark.addPlanner(planner_ptr);
-
-        if (publish_a_sample_bencmark_ && i == epochs_ - 1) {
-          try {
-            std::lock_guard<std::mutex> guard(plan_mutex);
-            ompl::geometric::PathGeometric curr_path = makeAPlan(planner_ptr, ss);
-            if (curr_path.getStateCount() == 0) {
-              RCLCPP_WARN(
-                this->get_logger(),
-                "An empty path detected!, looks like %s failed to "
-                "produce a valid plan",
-                planner_name.c_str());
-            }
-            std::pair<int, ompl::geometric::PathGeometric> curr_pair(index,
-              curr_path);
-            paths_map.insert(curr_pair);
-            ss.clear();
-          } catch (const std::exception & e) {
-            std::cerr << e.what() << '\n';
+        try {
+          ompl::geometric::PathGeometric curr_path = makeAPlan(planner_ptr, ss);
+          if (curr_path.getStateCount() == 0) {
+            RCLCPP_WARN(
+              this->get_logger(),
+              "An empty path detected!, looks like %s failed to "
+              "produce a valid plan",
+              planner_name.c_str());
           }
+          std::pair<int, ompl::geometric::PathGeometric> curr_pair(index,
+            curr_path);
+          paths_map.insert(curr_pair);
+          ss.clear();
+        } catch (const std::exception & e) {
+          std::cerr << e.what() << '\n';
         }
         index++;
       }
+    }
+    return paths_map;
+  }
 
-      ompl::tools::Benchmark::Request request(planner_timeout_, max_memory_,
-        batch_size_);
-      request.displayProgress = false;
+  void PlannerBenchMarking::sampleProblem(
+    ompl::geometric::SimpleSetup & ss,
+    GroundRobotPose & start,
+    GroundRobotPose & goal)
+  {
+    // spin until a valid random start and goal poses are found. Also
+    // make sure that a soluion exists for generated states
+    volatile bool found_valid_random_start_goal = false;
+
+    while (!found_valid_random_start_goal) {
+      start.x = -15; // getRangedRandom(se_bounds_.minx, se_bounds_.maxx);
+      start.y = 5; // getRangedRandom(se_bounds_.miny, se_bounds_.maxy);
+      start.z = start_.z;
+      start.yaw = getRangedRandom(se_bounds_.minyaw, se_bounds_.maxyaw);
+
+      goal.x = 40; // getRangedRandom(se_bounds_.minx, se_bounds_.maxx);
+      goal.y = -12; // getRangedRandom(se_bounds_.miny, se_bounds_.maxy);
+      goal.z = goal_.z;
+      goal.yaw = getRangedRandom(se_bounds_.minyaw, se_bounds_.maxyaw);
+
+      // the distance should be above a certain threshold
+      double distance =
+        std::sqrt(
+        std::pow(goal.x - start.x, 2) +
+        std::pow(goal.y - start.y, 2));
 
       RCLCPP_INFO(
         this->get_logger(),
-        "Created sample plans from each planner, "
-        "Now performing actual benchmark, This might take some time.");
-
-      benchmark.benchmark(request);
+        "Checking whether random generated goal start pair are valid ... ");
 
-      benchmark.saveResultsToFile(
-        (results_output_dir_ + results_file_regex_ +
-        "_" + std::to_string(i) + ".log")
-        .c_str());
-      ss.clear();
+      setupProblem(ss, start, goal);
+      auto space_information = ss.getSpaceInformation();
+      found_valid_random_start_goal =
+        (space_information->isValid(ss.getProblemDefinition()->getStartState(0)) &&
+        space_information->isValid(
+          ss.getGoal()->as<ompl::base::GoalState>()->getState()) &&
+        distance > min_euclidean_dist_start_to_goal_);
 
-      /*b.addExperimentParameter("gt_path_length", "REAL",
-                               std::to_string(gt_plan.length()));
-      b.addExperimentParameter("gt_path_smoothness", "REAL",
-                               std::to_string(gt_plan.smoothness()));*/
+      if (!found_valid_random_start_goal) {
+        RCLCPP_INFO(
+          this->get_logger(),
+          "Still Looking to sample valid random start and goal states ... ");
+        continue;
+      }
 
       RCLCPP_INFO(
         this->get_logger(),
-        "Bencmarking results saved to given directory: %s",
-        results_output_dir_.c_str());
+        "A valid random start and goal states has been found.");
+
+      // create a planner for the defined space
+      ompl::base::PlannerPtr rrtstar_planner;
+      rrtstar_planner =
+        ompl::base::PlannerPtr(new ompl::geometric::PRMstar(space_information));
+      ss.setPlanner(rrtstar_planner);
+      RCLCPP_INFO(
+        this->get_logger(), "Checking whether a solution exists for "
+        "random start and goal states .");
+      ompl::base::PlannerStatus has_solution = ss.solve(5.0);
+
+      // if it gets to this point , that menas our random states are valid and
+      // already meets min dist requiremnets but now there also has to be a
+      // solution for this problem
+      found_valid_random_start_goal =
+        (has_solution == ompl::base::PlannerStatus::EXACT_SOLUTION);
+
+      if (found_valid_random_start_goal) {
+        RCLCPP_INFO(
+          this->get_logger(),
+          "Found valid states and a solution for the random "
+          "problem!, proceeding to actual benchmark.");
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
     }
-    return paths_map;
+    ss.clear();
+  }
+
+  void PlannerBenchMarking::setupProblem(
+    ompl::geometric::SimpleSetup & ss,
+    const GroundRobotPose & start,
+    const GroundRobotPose & goal)
+  {
+    // define start & goal states
+    if ((selected_state_space_ == "REEDS") ||
+      (selected_state_space_ == "DUBINS") ||
+      (selected_state_space_ == "SE2"))
+    {
+      ompl::base::ScopedState<ompl::base::SE2StateSpace> se2_start(state_space_),
+      se2_goal(state_space_);
+      se2_start->setXY(start.x, start.y);
+      se2_start->setYaw(start.yaw);
+      se2_goal->setXY(goal.x, goal.y);
+      se2_goal->setYaw(goal.yaw);
+
+      ss.setStartAndGoalStates(se2_start, se2_goal, goal_tolerance_);
+      ss.setStateValidityChecker(
+        [this](const ompl::base::State * state) {
+          return isStateValidSE2(state);
+        });
+
+    } else {
+      ompl::base::ScopedState<ompl::base::SE3StateSpace> se3_start(
+        state_space_),
+      se3_goal(state_space_);
+
+      se3_start->setXYZ(start.x, start.y, start.z);
+      se3_start->as<ompl::base::SO3StateSpace::StateType>(1)->setAxisAngle(
+        0, 0, 1, start.yaw);
+
+      se3_goal->setXYZ(goal.x, goal.y, goal.z);
+      se3_goal->as<ompl::base::SO3StateSpace::StateType>(1)->setAxisAngle(
+        0, 0, 1, goal.yaw);
+
+      ss.setStartAndGoalStates(se3_start, se3_goal, goal_tolerance_);
+
+      ss.setStateValidityChecker(
+        [this](const ompl::base::State * state) {
+          return isStateValidSE3(state);
+        });
+    }
+
+    auto space_information = ss.getSpaceInformation();
+    space_information->setStateValidityCheckingResolution(
+      1.0 /
+      state_space_->getMaximumExtent());
+
+    ompl::base::OptimizationObjectivePtr lengthObj(
+      new ompl::base::PathLengthOptimizationObjective(space_information));
+    ompl::base::OptimizationObjectivePtr clearObj(
+      new ompl::base::MaximizeMinClearanceObjective(space_information));
+
+    ompl::base::MultiOptimizationObjective * opt =
+      new ompl::base::MultiOptimizationObjective(space_information);
+    opt->addObjective(lengthObj, 10.0);
+    opt->addObjective(clearObj, 1.0);
+
+    ss.setOptimizationObjective(ompl::base::OptimizationObjectivePtr(opt));
+    space_information->setup();
   }
 
   bool PlannerBenchMarking::isStateValidSE2(const ompl::base::State * state)
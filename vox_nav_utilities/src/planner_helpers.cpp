@@ -176,6 +176,33 @@ void determineValidNearestGoalStart(geometry_msgs::msg::PoseStamped& nearest_val
   nearest_valid_goal = vox_nav_utilities::PCLSurfel2PoseMsg(goal_nearest_surfel);
 }
 
+void determineValidNearestGoalStart(geometry_msgs::msg::PoseStamped& nearest_valid_start,
+                                    geometry_msgs::msg::PoseStamped& nearest_valid_goal,
+                                    const geometry_msgs::msg::PoseStamped& actual_start,
+                                    const geometry_msgs::msg::PoseStamped& actual_goal,
+                                    const pcl::KdTreeFLANN<pcl::PointSurfel>& elevated_surfel_kdtree)
+{
+  auto surfels = elevated_surfel_kdtree.getInputCloud();
+  if (!surfels || surfels->points.empty())
+  {
+    return;
+  }
+  std::vector<int> nearest_index(1);
+  std::vector<float> nearest_squared_distance(1);
+
+  pcl::PointSurfel start_nearest_surfel = vox_nav_utilities::poseMsg2PCLSurfel(actual_start);
+  if (elevated_surfel_kdtree.nearestKSearch(start_nearest_surfel, 1, nearest_index, nearest_squared_distance) > 0)
+  {
+    nearest_valid_start = vox_nav_utilities::PCLSurfel2PoseMsg(surfels->points[nearest_index[0]]);
+  }
+
+  pcl::PointSurfel goal_nearest_surfel = vox_nav_utilities::poseMsg2PCLSurfel(actual_goal);
+  if (elevated_surfel_kdtree.nearestKSearch(goal_nearest_surfel, 1, nearest_index, nearest_squared_distance) > 0)
+  {
+    nearest_valid_goal = vox_nav_utilities::PCLSurfel2PoseMsg(surfels->points[nearest_index[0]]);
+  }
+}
+
 void fillSurfelsfromMsgPoses(const geometry_msgs::msg::PoseArray& poses,
                              pcl::PointCloud<pcl::PointSurfel>::Ptr& surfels)
 {
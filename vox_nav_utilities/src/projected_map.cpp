@@ -0,0 +1,372 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_utilities/projected_map.hpp"
+
+#include <ompl/base/spaces/SE2StateSpace.h>
+#include <ompl/base/spaces/SE3StateSpace.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+  namespace
+  {
+    // Stands in for infinity in the distance transform, infinity itself would make its parabolas NaN
+    const double kFar = 1e20;
+
+    // Calls f(x, y, z) for the center of every finest resolution voxel of the occupied leafs,
+    // pruned leafs cover several of them
+    template<typename F>
+    void forEachOccupiedVoxel(const octomap::OcTree & octree, F f)
+    {
+      const double resolution = octree.getResolution();
+      for (auto it = octree.begin_leafs(); it != octree.end_leafs(); ++it) {
+        if (!octree.isNodeOccupied(*it)) {
+          continue;
+        }
+        const double size = it.getSize();
+        const int n = std::max(1, static_cast<int>(std::lround(size / resolution)));
+        const double x0 = it.getX() - size / 2.0 + resolution / 2.0;
+        const double y0 = it.getY() - size / 2.0 + resolution / 2.0;
+        const double z0 = it.getZ() - size / 2.0 + resolution / 2.0;
+        for (int i = 0; i < n; i++) {
+          for (int j = 0; j < n; j++) {
+            for (int k = 0; k < n; k++) {
+              f(x0 + i * resolution, y0 + j * resolution, z0 + k * resolution);
+            }
+          }
+        }
+      }
+    }
+
+    // Squared euclidean distance transform of a sampled function along one line,
+    // Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions"
+    void distanceTransform1D(
+      const std::vector<double> & f, std::vector<double> & d,
+      std::vector<int> & v, std::vector<double> & z)
+    {
+      const int n = static_cast<int>(f.size());
+      int k = 0;
+      v[0] = 0;
+      z[0] = -std::numeric_limits<double>::infinity();
+      z[1] = std::numeric_limits<double>::infinity();
+      for (int q = 1; q < n; q++) {
+        double s = ((f[q] + static_cast<double>(q) * q) - (f[v[k]] + static_cast<double>(v[k]) * v[k])) /
+          (2.0 * q - 2.0 * v[k]);
+        while (s <= z[k]) {
+          k--;
+          s = ((f[q] + static_cast<double>(q) * q) - (f[v[k]] + static_cast<double>(v[k]) * v[k])) /
+            (2.0 * q - 2.0 * v[k]);
+        }
+        k++;
+        v[k] = q;
+        z[k] = s;
+        z[k + 1] = std::numeric_limits<double>::infinity();
+      }
+      k = 0;
+      for (int q = 0; q < n; q++) {
+        while (z[k + 1] < q) {
+          k++;
+        }
+        d[q] = static_cast<double>(q - v[k]) * (q - v[k]) + f[v[k]];
+      }
+    }
+  }  // namespace
+
+  ProjectedMap::ProjectedMap(const octomap::OcTree & octree, const ProjectedMapParams & params)
+  : params_(params),
+    resolution_(octree.getResolution())
+  {
+    const double a = params_.footprint_length / 2.0;
+    const double b = params_.footprint_width / 2.0;
+    inscribed_radius_ = std::min(a, b);
+    circumscribed_radius_ = std::hypot(a, b);
+
+    // Cell centers are on the voxel centers, the grid reaches a footprint beyond the voxels
+    double min_x, min_y, min_z, max_x, max_y, max_z;
+    octree.getMetricMin(min_x, min_y, min_z);
+    octree.getMetricMax(max_x, max_y, max_z);
+    const double pad = circumscribed_radius_ + 2.0 * resolution_;
+    origin_x_ = (std::floor((min_x - pad) / resolution_) + 0.5) * resolution_;
+    origin_y_ = (std::floor((min_y - pad) / resolution_) + 0.5) * resolution_;
+    width_ = static_cast<int>(std::ceil((max_x + pad - origin_x_) / resolution_)) + 1;
+    height_ = static_cast<int>(std::ceil((max_y + pad - origin_y_) / resolution_)) + 1;
+
+    buildColumns(octree);
+    buildDistances();
+    buildCosts();
+    buildFootprint();
+  }
+
+  int ProjectedMap::cellIndex(double x, double y) const
+  {
+    const int ix = static_cast<int>(std::floor((x - origin_x_) / resolution_ + 0.5));
+    const int iy = static_cast<int>(std::floor((y - origin_y_) / resolution_ + 0.5));
+    if (ix < 0 || iy < 0 || ix >= width_ || iy >= height_) {
+      return -1;
+    }
+    return iy * width_ + ix;
+  }
+
+  float ProjectedMap::groundHeight(double x, double y) const
+  {
+    const int i = cellIndex(x, y);
+    return i < 0 ? std::numeric_limits<float>::quiet_NaN() : ground_[i];
+  }
+
+  float ProjectedMap::topHeight(double x, double y) const
+  {
+    const int i = cellIndex(x, y);
+    return i < 0 ? std::numeric_limits<float>::quiet_NaN() : top_[i];
+  }
+
+  float ProjectedMap::obstacleHeight(double x, double y) const
+  {
+    const int i = cellIndex(x, y);
+    return i < 0 ? 0.0f : obstacle_[i];
+  }
+
+  float ProjectedMap::obstacleDistance(double x, double y) const
+  {
+    const int i = cellIndex(x, y);
+    return i < 0 ? std::numeric_limits<float>::infinity() : distance_[i];
+  }
+
+  float ProjectedMap::cost(double x, double y) const
+  {
+    const int i = cellIndex(x, y);
+    return i < 0 ? 0.0f : cost_[i];
+  }
+
+  bool ProjectedMap::isLethal(double x, double y) const
+  {
+    const int i = cellIndex(x, y);
+    return i >= 0 && lethal_[i];
+  }
+
+  bool ProjectedMap::isFootprintFree(double x, double y, double yaw) const
+  {
+    // Off the grid there is nothing within a footprint
+    const int i = cellIndex(x, y);
+    if (i < 0) {
+      return true;
+    }
+    // x, y and the lethal voxels are anywhere within their cells, half a cell diagonal each
+    const double d = distance_[i];
+    if (d - M_SQRT2 * resolution_ > circumscribed_radius_) {
+      return true;
+    }
+    if (d + M_SQRT1_2 * resolution_ < inscribed_radius_) {
+      return false;
+    }
+    const double c = std::cos(yaw);
+    const double s = std::sin(yaw);
+    for (const auto & p : footprint_points_) {
+      if (isLethal(x + c * p.first - s * p.second, y + s * p.first + c * p.second)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool ProjectedMap::isBodyAboveTerrain(double x, double y, double bottom_z) const
+  {
+    const int i = cellIndex(x, y);
+    if (i < 0) {
+      return true;
+    }
+    // The top of a voxel is half a voxel above its center
+    return bottom_z > footprint_top_[i] + resolution_ / 2.0;
+  }
+
+  void ProjectedMap::buildColumns(const octomap::OcTree & octree)
+  {
+    const size_t num_cells = static_cast<size_t>(width_) * height_;
+    ground_.assign(num_cells, std::numeric_limits<float>::infinity());
+    top_.assign(num_cells, -std::numeric_limits<float>::infinity());
+    obstacle_.assign(num_cells, 0.0f);
+
+    forEachOccupiedVoxel(
+      octree, [this](double x, double y, double z) {
+        const int i = cellIndex(x, y);
+        ground_[i] = std::min(ground_[i], static_cast<float>(z));
+        top_[i] = std::max(top_[i], static_cast<float>(z));
+      });
+    // The ground of every column is known now, overhangs above the clearance are left out
+    forEachOccupiedVoxel(
+      octree, [this](double x, double y, double z) {
+        const int i = cellIndex(x, y);
+        const float above_ground = static_cast<float>(z) - ground_[i];
+        if (above_ground <= params_.clearance_height) {
+          obstacle_[i] = std::max(obstacle_[i], above_ground);
+        }
+      });
+
+    lethal_.assign(num_cells, 0);
+    for (size_t i = 0; i < num_cells; i++) {
+      if (!std::isfinite(ground_[i])) {
+        ground_[i] = std::numeric_limits<float>::quiet_NaN();
+        top_[i] = std::numeric_limits<float>::quiet_NaN();
+      }
+      // Heights are multiples of the resolution, a step of exactly max_step_height is still driven over
+      if (obstacle_[i] > params_.max_step_height + 1e-3) {
+        lethal_[i] = 1;
+        num_lethal_cells_++;
+      }
+    }
+  }
+
+  void ProjectedMap::buildDistances()
+  {
+    const size_t num_cells = static_cast<size_t>(width_) * height_;
+    distance_.assign(num_cells, std::numeric_limits<float>::infinity());
+    if (num_lethal_cells_ == 0) {
+      return;
+    }
+
+    // Squared distances in cells, first along x then along y
+    std::vector<double> squared(num_cells);
+    for (size_t i = 0; i < num_cells; i++) {
+      squared[i] = lethal_[i] ? 0.0 : kFar;
+    }
+    const int n = std::max(width_, height_);
+    std::vector<double> f, d;
+    std::vector<int> v(n);
+    std::vector<double> z(n + 1);
+    f.resize(width_);
+    d.resize(width_);
+    for (int iy = 0; iy < height_; iy++) {
+      std::copy_n(squared.begin() + static_cast<size_t>(iy) * width_, width_, f.begin());
+      distanceTransform1D(f, d, v, z);
+      std::copy_n(d.begin(), width_, squared.begin() + static_cast<size_t>(iy) * width_);
+    }
+    f.resize(height_);
+    d.resize(height_);
+    for (int ix = 0; ix < width_; ix++) {
+      for (int iy = 0; iy < height_; iy++) {
+        f[iy] = squared[static_cast<size_t>(iy) * width_ + ix];
+      }
+      distanceTransform1D(f, d, v, z);
+      for (int iy = 0; iy < height_; iy++) {
+        squared[static_cast<size_t>(iy) * width_ + ix] = d[iy];
+      }
+    }
+
+    for (size_t i = 0; i < num_cells; i++) {
+      if (squared[i] < kFar / 2.0) {
+        distance_[i] = static_cast<float>(std::sqrt(squared[i]) * resolution_);
+      }
+    }
+  }
+
+  void ProjectedMap::buildCosts()
+  {
+    const size_t num_cells = static_cast<size_t>(width_) * height_;
+    cost_.assign(num_cells, 0.0f);
+    for (size_t i = 0; i < num_cells; i++) {
+      if (lethal_[i] || distance_[i] < inscribed_radius_) {
+        cost_[i] = 1.0f;
+        continue;
+      }
+      double step = params_.max_step_height > 0.0 ? obstacle_[i] / params_.max_step_height : 0.0;
+      double proximity = 0.0;
+      if (params_.cost_decay_distance > 0.0 && std::isfinite(distance_[i])) {
+        proximity = std::exp(-(distance_[i] - inscribed_radius_) / params_.cost_decay_distance);
+      }
+      cost_[i] = static_cast<float>(std::min(1.0, std::max(step, proximity)));
+    }
+  }
+
+  void ProjectedMap::buildFootprint()
+  {
+    // Points every half cell at most, so no cell under the footprint is stepped over
+    const double step = resolution_ / 2.0;
+    const int nx = std::max(1, static_cast<int>(std::ceil(params_.footprint_length / step)));
+    const int ny = std::max(1, static_cast<int>(std::ceil(params_.footprint_width / step)));
+    footprint_points_.clear();
+    for (int i = 0; i <= nx; i++) {
+      for (int j = 0; j <= ny; j++) {
+        footprint_points_.emplace_back(
+          -params_.footprint_length / 2.0 + i * params_.footprint_length / nx,
+          -params_.footprint_width / 2.0 + j * params_.footprint_width / ny);
+      }
+    }
+
+    // Sliding maximum of the column tops over the axis aligned footprint, along x then along y.
+    // Voxels of the cells hx, hy away still reach under a footprint centered anywhere in the cell
+    const int hx = static_cast<int>(std::ceil(params_.footprint_length / 2.0 / resolution_));
+    const int hy = static_cast<int>(std::ceil(params_.footprint_width / 2.0 / resolution_));
+    const size_t num_cells = static_cast<size_t>(width_) * height_;
+    std::vector<float> along_x(num_cells, -std::numeric_limits<float>::infinity());
+    for (int iy = 0; iy < height_; iy++) {
+      for (int ix = 0; ix < width_; ix++) {
+        float top = -std::numeric_limits<float>::infinity();
+        for (int k = std::max(0, ix - hx); k <= std::min(width_ - 1, ix + hx); k++) {
+          top = std::max(top, top_[static_cast<size_t>(iy) * width_ + k]);
+        }
+        along_x[static_cast<size_t>(iy) * width_ + ix] = top;
+      }
+    }
+    footprint_top_.assign(num_cells, -std::numeric_limits<float>::infinity());
+    for (int iy = 0; iy < height_; iy++) {
+      for (int ix = 0; ix < width_; ix++) {
+        float top = -std::numeric_limits<float>::infinity();
+        for (int k = std::max(0, iy - hy); k <= std::min(height_ - 1, iy + hy); k++) {
+          top = std::max(top, along_x[static_cast<size_t>(k) * width_ + ix]);
+        }
+        footprint_top_[static_cast<size_t>(iy) * width_ + ix] = top;
+      }
+    }
+  }
+
+  ProjectedMapCostObjective::ProjectedMapCostObjective(
+    const ompl::base::SpaceInformationPtr & si,
+    const std::shared_ptr<const ProjectedMap> & projected_map,
+    double cost_weight)
+  : ompl::base::StateCostIntegralObjective(si, true),
+    projected_map_(projected_map),
+    cost_weight_(cost_weight),
+    is_se3_(si->getStateSpace()->getType() == ompl::base::STATE_SPACE_SE3)
+  {
+    description_ = "Projected Map Cost";
+  }
+
+  ompl::base::Cost ProjectedMapCostObjective::stateCost(const ompl::base::State * s) const
+  {
+    double x, y;
+    if (is_se3_) {
+      const auto * se3_state = s->as<ompl::base::SE3StateSpace::StateType>();
+      x = se3_state->getX();
+      y = se3_state->getY();
+    } else {
+      const auto * se2_state = s->as<ompl::base::SE2StateSpace::StateType>();
+      x = se2_state->getX();
+      y = se2_state->getY();
+    }
+    return ompl::base::Cost(1.0 + cost_weight_ * projected_map_->cost(x, y));
+  }
+
+  ompl::base::Cost ProjectedMapCostObjective::motionCostHeuristic(
+    const ompl::base::State * s1,
+    const ompl::base::State * s2) const
+  {
+    return ompl::base::Cost(si_->distance(s1, s2));
+  }
+
+}  // namespace vox_nav_utilities
@@ -0,0 +1,170 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_utilities/road_graph.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+#include "vox_nav_utilities/boost_graph_utils.hpp"
+
+namespace vox_nav_utilities
+{
+  namespace
+  {
+    // Straight line distance to the goal, never more than the cost of an edge path
+    class RoadDistanceHeuristic : public boost::astar_heuristic<RoadGraph::CSRGraph, float>
+    {
+    public:
+      RoadDistanceHeuristic(const pcl::PointCloud<pcl::PointXYZRGB> & points, RoadGraph::Vertex goal)
+      : points_(points), goal_(points.points[goal].getVector3fMap())
+      {
+      }
+      float operator()(RoadGraph::Vertex u)
+      {
+        return (points_.points[u].getVector3fMap() - goal_).norm();
+      }
+
+    private:
+      const pcl::PointCloud<pcl::PointXYZRGB> & points_;
+      Eigen::Vector3f goal_;
+    };
+  }  // namespace
+
+  RoadGraph::RoadGraph(
+    const pcl::PointCloud<pcl::PointXYZRGB>::ConstPtr & road_points,
+    const RoadGraphParams & params)
+  : params_(params),
+    road_points_(road_points)
+  {
+    const auto & points = road_points_->points;
+    const int n = static_cast<int>(points.size());
+
+    // Undirected connections as (smaller, larger) index pairs
+    std::vector<std::pair<int, int>> links;
+    if (n > 0) {
+      kdtree_.setInputCloud(road_points_);
+      std::vector<int> indices;
+      std::vector<float> squared_distances;
+      for (int i = 0; i < n; i++) {
+        // The point itself is found too
+        kdtree_.radiusSearch(
+          points[i], params_.connection_radius, indices, squared_distances, params_.max_neighbors + 1);
+        for (int j : indices) {
+          if (j != i) {
+            links.emplace_back(std::min(i, j), std::max(i, j));
+          }
+        }
+      }
+    }
+    // OSM ways are written point after point, keep them connected where sampling is sparse
+    for (int i = 0; i + 1 < n; i++) {
+      const auto & a = points[i];
+      const auto & b = points[i + 1];
+      if (a.rgb == b.rgb &&
+        (a.getVector3fMap() - b.getVector3fMap()).norm() <= params_.way_link_max_distance)
+      {
+        links.emplace_back(i, i + 1);
+      }
+    }
+    std::sort(links.begin(), links.end());
+    links.erase(std::unique(links.begin(), links.end()), links.end());
+
+    std::vector<std::pair<int, int>> edges;
+    std::vector<RoadEdge> edge_costs;
+    edges.reserve(2 * links.size());
+    edge_costs.reserve(2 * links.size());
+    for (const auto & link : links) {
+      RoadEdge edge{edgeCost(link.first, link.second)};
+      edges.emplace_back(link.first, link.second);
+      edge_costs.push_back(edge);
+      edges.emplace_back(link.second, link.first);
+      edge_costs.push_back(edge);
+    }
+    graph_ = CSRGraph(
+      boost::edges_are_unsorted_multi_pass, edges.begin(), edges.end(), edge_costs.begin(), n);
+  }
+
+  float RoadGraph::edgeCost(int a, int b) const
+  {
+    const auto & pa = road_points_->points[a];
+    const auto & pb = road_points_->points[b];
+    float length = (pa.getVector3fMap() - pb.getVector3fMap()).norm();
+    return length + params_.climb_weight * std::abs(pa.z - pb.z);
+  }
+
+  int RoadGraph::snap(const Eigen::Vector3d & position) const
+  {
+    if (road_points_->points.empty()) {
+      return -1;
+    }
+    pcl::PointXYZRGB search_point;
+    search_point.x = position.x();
+    search_point.y = position.y();
+    search_point.z = position.z();
+    std::vector<int> indices(1);
+    std::vector<float> squared_distances(1);
+    if (kdtree_.nearestKSearch(search_point, 1, indices, squared_distances) < 1 ||
+      squared_distances[0] > params_.snap_max_distance * params_.snap_max_distance)
+    {
+      return -1;
+    }
+    return indices[0];
+  }
+
+  bool RoadGraph::plan(const Eigen::Vector3d & start, const Eigen::Vector3d & goal, RoadPathResult & result) const
+  {
+    result = RoadPathResult();
+    int start_vertex = snap(start);
+    int goal_vertex = snap(goal);
+    if (start_vertex < 0 || goal_vertex < 0) {
+      return false;
+    }
+
+    std::vector<Vertex> predecessors(numVertices());
+    std::vector<float> costs(numVertices());
+    auto index_map = boost::get(boost::vertex_index, graph_);
+    bool found = false;
+    try {
+      boost::astar_search(
+        graph_, start_vertex,
+        RoadDistanceHeuristic(*road_points_, goal_vertex),
+        boost::predecessor_map(boost::make_iterator_property_map(predecessors.begin(), index_map))
+        .distance_map(boost::make_iterator_property_map(costs.begin(), index_map))
+        .weight_map(boost::get(&RoadEdge::cost, graph_))
+        .visitor(custom_goal_visitor<Vertex>(goal_vertex, &result.expanded_vertices)));
+    } catch (FoundGoal) {
+      found = true;
+    }
+    if (!found) {
+      return false;
+    }
+
+    for (Vertex v = goal_vertex; ; v = predecessors[v]) {
+      result.vertices.push_back(static_cast<int>(v));
+      if (v == static_cast<Vertex>(start_vertex)) {
+        break;
+      }
+    }
+    std::reverse(result.vertices.begin(), result.vertices.end());
+    for (int v : result.vertices) {
+      result.points.push_back(road_points_->points[v].getVector3fMap().cast<double>());
+    }
+    result.cost = costs[goal_vertex];
+    return true;
+  }
+
+}  // namespace vox_nav_utilities
@@ -0,0 +1,260 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Setup time and memory of several planner plugins getting the same
+get_traversability_map response, on a synthetic terrain. "independent"
+does what setupMap did before, every plugin decodes the octomaps, copies
+them and builds its own FCL trees and surfel cloud; "shared" borrows all of
+it from the MapSnapshotRegistry. The plugins are a mix of the elevation,
+optimal elevation, elevation control, SE2 and SE3 planners, in that order,
+each taking the parts of the map it uses. Every mode runs in a forked
+process so its resident memory is measured from the same baseline. In
+shared mode the registry has to decode the map exactly once and hand every
+plugin the same trees, otherwise the benchmark exits with 1.
+Usage: map_snapshot_benchmark [num_plugins] [map_size_m] [resolution]
+*/
+
+#include <pcl_conversions/pcl_conversions.h>
+#include <octomap_msgs/conversions.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "vox_nav_utilities/map_snapshot.hpp"
+#include "vox_nav_utilities/planner_helpers.hpp"
+
+using vox_nav_utilities::MapSnapshot;
+using vox_nav_utilities::MapSnapshotRegistry;
+
+namespace
+{
+  enum class PluginKind { ELEVATION, OPTIMAL_ELEVATION, ELEVATION_CONTROL, SE2, SE3 };
+
+  // What a plugin keeps after setupMap, the members the planners have
+  struct PluginMaps
+  {
+    std::shared_ptr<const MapSnapshot> snapshot;
+    std::shared_ptr<octomap::OcTree> original_octree;
+    std::shared_ptr<octomap::OcTree> elevated_surfel_octree;
+    std::shared_ptr<fcl::CollisionObjectf> original_collision_object;
+    std::shared_ptr<fcl::CollisionObjectf> elevated_surfel_collision_object;
+    geometry_msgs::msg::PoseArray::SharedPtr elevated_surfel_poses;
+    pcl::PointCloud<pcl::PointSurfel>::Ptr elevated_surfel_cloud;
+    pcl::PointCloud<pcl::PointXYZRGB>::Ptr traversable_elevated_cloud;
+  };
+
+  double groundHeight(double x, double y)
+  {
+    return 0.5 * std::sin(0.2 * x) * std::cos(0.15 * y);
+  }
+
+  // Rolling ground with a few walls, in the layout the map server responds with
+  MapSnapshot::Response::SharedPtr makeResponse(double size, double resolution)
+  {
+    octomap::OcTree original(resolution), collision(resolution), elevated(resolution);
+    pcl::PointCloud<pcl::PointXYZRGB> traversable;
+    auto response = std::make_shared<MapSnapshot::Response>();
+    for (double x = -size / 2; x < size / 2; x += resolution) {
+      for (double y = -size / 2; y < size / 2; y += resolution) {
+        double z = groundHeight(x, y);
+        bool wall = std::fmod(std::abs(x) + 5.0, 15.0) < 0.6 && std::abs(y) > 3.0;
+        original.updateNode(x, y, z, true);
+        if (wall) {
+          for (double h = resolution; h < 1.5; h += resolution) {
+            original.updateNode(x, y, z + h, true);
+            collision.updateNode(x, y, z + h, true);
+          }
+          continue;
+        }
+        elevated.updateNode(x, y, z, true);
+        geometry_msgs::msg::Pose pose;
+        pose.position.x = x;
+        pose.position.y = y;
+        pose.position.z = z;
+        pose.orientation.w = 1.0;
+        response->elevated_surfel_poses.poses.push_back(pose);
+        pcl::PointXYZRGB point;
+        point.x = x;
+        point.y = y;
+        point.z = z;
+        point.g = 255;
+        traversable.points.push_back(point);
+      }
+    }
+    traversable.width = traversable.points.size();
+    traversable.height = 1;
+    octomap_msgs::fullMapToMsg(original, response->original_octomap);
+    octomap_msgs::fullMapToMsg(collision, response->collision_octomap);
+    octomap_msgs::fullMapToMsg(elevated, response->elevated_surfel_octomap);
+    pcl::toROSMsg(traversable, response->traversable_elevated_cloud);
+    pcl::toROSMsg(traversable, response->traversable_cloud);
+    response->is_valid = true;
+    return response;
+  }
+
+  std::shared_ptr<octomap::OcTree> decodeCopy(const octomap_msgs::msg::Octomap & msg)
+  {
+    auto raw = dynamic_cast<octomap::OcTree *>(octomap_msgs::fullMsgToMap(msg));
+    auto octree = std::make_shared<octomap::OcTree>(*raw);
+    delete raw;
+    return octree;
+  }
+
+  std::shared_ptr<fcl::CollisionObjectf> collisionObject(const std::shared_ptr<octomap::OcTree> & octree)
+  {
+    return std::make_shared<fcl::CollisionObjectf>(
+      std::shared_ptr<fcl::CollisionGeometryf>(std::make_shared<fcl::OcTreef>(octree)));
+  }
+
+  PluginMaps setupIndependent(PluginKind kind, const MapSnapshot::Response & response)
+  {
+    PluginMaps maps;
+    bool elevation = kind != PluginKind::SE2 && kind != PluginKind::SE3;
+    maps.original_octree = decodeCopy(
+      kind == PluginKind::ELEVATION_CONTROL ? response.collision_octomap : response.original_octomap);
+    maps.original_collision_object = collisionObject(maps.original_octree);
+    if (elevation) {
+      maps.elevated_surfel_octree = decodeCopy(response.elevated_surfel_octomap);
+      maps.elevated_surfel_collision_object = collisionObject(maps.elevated_surfel_octree);
+      maps.elevated_surfel_poses =
+        std::make_shared<geometry_msgs::msg::PoseArray>(response.elevated_surfel_poses);
+      maps.elevated_surfel_cloud = pcl::PointCloud<pcl::PointSurfel>::Ptr(new pcl::PointCloud<pcl::PointSurfel>);
+      vox_nav_utilities::fillSurfelsfromMsgPoses(*maps.elevated_surfel_poses, maps.elevated_surfel_cloud);
+    }
+    if (kind == PluginKind::OPTIMAL_ELEVATION) {
+      maps.traversable_elevated_cloud =
+        pcl::PointCloud<pcl::PointXYZRGB>::Ptr(new pcl::PointCloud<pcl::PointXYZRGB>);
+      pcl::fromROSMsg(response.traversable_elevated_cloud, *maps.traversable_elevated_cloud);
+    }
+    return maps;
+  }
+
+  PluginMaps setupShared(PluginKind kind, const MapSnapshot::Response::SharedPtr & response)
+  {
+    PluginMaps maps;
+    bool elevation = kind != PluginKind::SE2 && kind != PluginKind::SE3;
+    maps.snapshot = MapSnapshotRegistry::instance().acquire(response);
+    if (kind == PluginKind::ELEVATION_CONTROL) {
+      maps.original_octree = maps.snapshot->collisionOctree();
+      maps.original_collision_object = maps.snapshot->collisionCollisionObject();
+    } else {
+      maps.original_octree = maps.snapshot->originalOctree();
+      maps.original_collision_object = maps.snapshot->originalCollisionObject();
+    }
+    if (elevation) {
+      maps.elevated_surfel_octree = maps.snapshot->elevatedSurfelOctree();
+      maps.elevated_surfel_collision_object = maps.snapshot->elevatedSurfelCollisionObject();
+      maps.elevated_surfel_poses = maps.snapshot->elevatedSurfelPoses();
+      maps.elevated_surfel_cloud = maps.snapshot->elevatedSurfelCloud();
+    }
+    if (kind == PluginKind::OPTIMAL_ELEVATION) {
+      maps.traversable_elevated_cloud = maps.snapshot->traversableElevatedCloud();
+    }
+    return maps;
+  }
+
+  double residentMB()
+  {
+    std::ifstream statm("/proc/self/statm");
+    long size = 0, resident = 0;
+    statm >> size >> resident;
+    return resident * sysconf(_SC_PAGESIZE) / 1e6;
+  }
+
+  // Runs in the forked child, prints the csv row and returns the exit code
+  int runMode(bool shared, int num_plugins, double size, double resolution)
+  {
+    // Every plugin gets its own copy of the response, as each calls the service itself
+    auto response = makeResponse(size, resolution);
+    std::vector<MapSnapshot::Response::SharedPtr> responses;
+    for (int i = 0; i < num_plugins; i++) {
+      responses.push_back(std::make_shared<MapSnapshot::Response>(*response));
+    }
+    size_t original_nodes = 0;
+    {
+      auto reference = decodeCopy(response->original_octomap);
+      original_nodes = reference->size();
+    }
+
+    double rss_before = residentMB();
+    std::vector<PluginMaps> plugins;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < num_plugins; i++) {
+      auto kind = static_cast<PluginKind>(i % 5);
+      plugins.push_back(shared ? setupShared(kind, responses[i]) : setupIndependent(kind, *responses[i]));
+      // A plugin drops its response once setupMap returns
+      responses[i].reset();
+    }
+    double setup_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    double rss_after = residentMB();
+
+    int failures = 0;
+    if (shared) {
+      size_t created = MapSnapshotRegistry::instance().created();
+      for (const auto & plugin : plugins) {
+        bool same = plugin.snapshot == plugins.front().snapshot &&
+          (plugin.elevated_surfel_octree == nullptr ||
+          plugin.elevated_surfel_octree == plugins.front().elevated_surfel_octree);
+        if (!same) {
+          std::cerr << "FAILED: a plugin got its own copy of the map" << std::endl;
+          failures++;
+          break;
+        }
+      }
+      if (created != 1) {
+        std::cerr << "FAILED: the registry decoded the map " << created << " times" << std::endl;
+        failures++;
+      }
+      if (plugins.front().original_octree->size() != original_nodes) {
+        std::cerr << "FAILED: shared octree has " << plugins.front().original_octree->size() <<
+          " nodes, decoding it directly gives " << original_nodes << std::endl;
+        failures++;
+      }
+    }
+
+    std::cout << (shared ? "shared" : "independent") << "," << num_plugins << "," << original_nodes << "," <<
+      setup_ms << "," << setup_ms / num_plugins << "," << rss_after - rss_before << std::endl;
+    return failures ? 1 : 0;
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  int num_plugins = argc > 1 ? std::stoi(argv[1]) : 5;
+  double size = argc > 2 ? std::stod(argv[2]) : 80.0;
+  double resolution = argc > 3 ? std::stod(argv[3]) : 0.2;
+
+  std::cout << "mode,plugins,octomap_nodes,setup_ms,setup_ms_per_plugin,rss_mb" << std::endl;
+  int failures = 0;
+  for (bool shared : {false, true}) {
+    pid_t pid = fork();
+    if (pid == 0) {
+      _exit(runMode(shared, num_plugins, size, resolution));
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      failures++;
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,234 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Time of converting a colored cloud of the map server layout into a
+ColorOcTree, by ray casting it into the tree as PCL2OctomapConverter did
+("ray_casting") and with the OctomapBuilder ("direct") at several thread
+counts, with and without clearing free space. The cloud is a synthetic
+terrain with a few points per voxel, red pillars and yellow elevated node
+centers. The direct build has to give the same occupied voxels as ray
+casting, with free space clearing the same free voxels too, every voxel
+at least the cost ray casting gives it (the highest of its points instead
+of the last one), the same voxels whatever the number of threads, and tiles
+that together are the whole tree, otherwise the benchmark exits with 1.
+Usage: octomap_builder_benchmark [map_size_m] [resolution] [points_per_voxel] [tile_size_m]
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vox_nav_utilities/octomap_builder.hpp"
+
+using Clock = std::chrono::steady_clock;
+using vox_nav_utilities::OctomapBuilder;
+
+namespace
+{
+  double secondsSince(const Clock::time_point & t0)
+  {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+
+  // Log odds of every finest voxel of the tree, pruned leaves expanded
+  std::map<uint64_t, float> finestVoxels(const octomap::ColorOcTree & tree)
+  {
+    std::map<uint64_t, float> voxels;
+    const unsigned int depth = tree.getTreeDepth();
+    for (auto it = tree.begin_leafs(), end = tree.end_leafs(); it != end; ++it) {
+      const auto base = it.getIndexKey();
+      const unsigned int span = 1u << (depth - it.getDepth());
+      for (unsigned int dx = 0; dx < span; dx++) {
+        for (unsigned int dy = 0; dy < span; dy++) {
+          for (unsigned int dz = 0; dz < span; dz++) {
+            octomap::OcTreeKey key(base[0] + dx, base[1] + dy, base[2] + dz);
+            voxels[OctomapBuilder::keyToMorton(key)] = it->getLogOdds();
+          }
+        }
+      }
+    }
+    return voxels;
+  }
+
+  std::map<uint64_t, float> select(const std::map<uint64_t, float> & voxels, bool occupied)
+  {
+    std::map<uint64_t, float> selected;
+    for (const auto & voxel : voxels) {
+      if ((voxel.second > 0.0f) == occupied) {
+        selected.insert(voxel);
+      }
+    }
+    return selected;
+  }
+
+  bool sameVoxels(const std::map<uint64_t, float> & a, const std::map<uint64_t, float> & b)
+  {
+    if (a.size() != b.size()) {
+      return false;
+    }
+    for (auto ia = a.begin(), ib = b.begin(); ia != a.end(); ++ia, ++ib) {
+      if (ia->first != ib->first) {
+        return false;
+      }
+    }
+    return true;
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  double map_size = argc > 1 ? std::stod(argv[1]) : 40.0;
+  double resolution = argc > 2 ? std::stod(argv[2]) : 0.2;
+  int points_per_voxel = argc > 3 ? std::stoi(argv[3]) : 4;
+  double tile_size = argc > 4 ? std::stod(argv[4]) : 10.0;
+
+  // Rolling terrain, every point has a cost above 0 so its voxel is occupied
+  std::mt19937 rng(42);
+  std::uniform_real_distribution<double> jitter(0.0, resolution);
+  std::uniform_int_distribution<int> blue(1, 254);
+  std::uniform_real_distribution<double> unit(0.0, 1.0);
+  pcl::PointCloud<pcl::PointXYZRGB> cloud;
+  const int n = static_cast<int>(map_size / resolution);
+  for (int i = 0; i < n; i++) {
+    for (int j = 0; j < n; j++) {
+      for (int k = 0; k < points_per_voxel; k++) {
+        pcl::PointXYZRGB p;
+        p.x = -map_size / 2.0 + i * resolution + jitter(rng);
+        p.y = -map_size / 2.0 + j * resolution + jitter(rng);
+        p.z = 0.5 * std::sin(p.x / 5.0) * std::cos(p.y / 7.0);
+        p.b = blue(rng);
+        p.g = 255 - p.b;
+        p.r = 0;
+        double px = std::remainder(p.x, 6.0);
+        double py = std::remainder(p.y, 6.0);
+        if (px * px + py * py < 0.36) {
+          p.z += unit(rng);
+          p.r = 255;
+          p.g = 0;
+          p.b = 0;
+        } else if (unit(rng) < 0.01) {
+          p.z += 0.5;
+          p.r = 255;
+          p.g = 255;
+          p.b = 0;
+        }
+        cloud.points.push_back(p);
+      }
+    }
+  }
+  cloud.width = cloud.points.size();
+  cloud.height = 1;
+
+  std::cout << "method,threads,clear_free_space,points,seconds,points_per_s,occupied_voxels,free_voxels" <<
+    std::endl;
+  auto t0 = Clock::now();
+  octomap::ColorOcTree legacy_tree(resolution);
+  vox_nav_utilities::insertCloudByRayCasting(cloud, legacy_tree);
+  double seconds = secondsSince(t0);
+  const auto legacy_voxels = finestVoxels(legacy_tree);
+  const auto legacy_occupied = select(legacy_voxels, true);
+  const auto legacy_free = select(legacy_voxels, false);
+  std::cout << "ray_casting,1,1," << cloud.points.size() << "," << seconds << "," <<
+    cloud.points.size() / seconds << "," << legacy_occupied.size() << "," << legacy_free.size() << std::endl;
+
+  int failures = 0;
+  for (bool clear_free_space : {false, true}) {
+    std::vector<unsigned int> thread_counts{1, 2, 4};
+    if (std::thread::hardware_concurrency() > 4) {
+      thread_counts.push_back(std::thread::hardware_concurrency());
+    }
+    std::vector<vox_nav_utilities::OctomapVoxel> single_thread_voxels;
+    for (unsigned int num_threads : thread_counts) {
+      vox_nav_utilities::OctomapBuilderParams params;
+      params.resolution = resolution;
+      params.clear_free_space = clear_free_space;
+      params.tile_size = tile_size;
+      params.num_threads = num_threads;
+      OctomapBuilder builder(params);
+      t0 = Clock::now();
+      builder.build(cloud);
+      auto tree = builder.tree();
+      seconds = secondsSince(t0);
+      const auto voxels = finestVoxels(*tree);
+      const auto occupied = select(voxels, true);
+      const auto free = select(voxels, false);
+      std::cout << "direct," << num_threads << "," << clear_free_space << "," << cloud.points.size() << "," <<
+        seconds << "," << cloud.points.size() / seconds << "," << occupied.size() << "," << free.size() <<
+        std::endl;
+
+      const std::string run = std::to_string(num_threads) + " threads" +
+        (clear_free_space ? " with free space clearing" : "");
+      if (!sameVoxels(occupied, legacy_occupied)) {
+        std::cerr << "FAILED: " << occupied.size() << " occupied voxels with " << run << ", " <<
+          legacy_occupied.size() << " by ray casting" << std::endl;
+        failures++;
+      }
+      if (clear_free_space ? !sameVoxels(free, legacy_free) : !free.empty()) {
+        std::cerr << "FAILED: " << free.size() << " free voxels with " << run << ", " <<
+          (clear_free_space ? legacy_free.size() : 0) << " expected" << std::endl;
+        failures++;
+      }
+      size_t below_legacy_cost = 0;
+      for (const auto & voxel : occupied) {
+        auto legacy = legacy_occupied.find(voxel.first);
+        below_legacy_cost += legacy != legacy_occupied.end() && voxel.second < legacy->second;
+      }
+      if (below_legacy_cost) {
+        std::cerr << "FAILED: " << below_legacy_cost << " voxels below the ray casting cost with " << run <<
+          std::endl;
+        failures++;
+      }
+      if (single_thread_voxels.empty()) {
+        single_thread_voxels = builder.occupiedVoxels();
+      } else if (builder.occupiedVoxels().size() != single_thread_voxels.size() ||
+        !std::equal(
+          single_thread_voxels.begin(), single_thread_voxels.end(), builder.occupiedVoxels().begin(),
+          [](const auto & a, const auto & b) {
+            return a.morton == b.morton && a.log_odds == b.log_odds && a.r == b.r && a.g == b.g &&
+            a.b == b.b;
+          }))
+      {
+        std::cerr << "FAILED: the voxels with " << run << " differ from those with 1 thread" << std::endl;
+        failures++;
+      }
+
+      // Tiles are timed on their own, they are built from the same sorted voxels
+      t0 = Clock::now();
+      auto tiles = builder.tiles();
+      seconds = secondsSince(t0);
+      std::map<uint64_t, float> tiled_voxels;
+      for (const auto & tile : tiles) {
+        const auto tile_voxels = finestVoxels(*tile.tree);
+        tiled_voxels.insert(tile_voxels.begin(), tile_voxels.end());
+      }
+      std::cout << "direct_tiles_" << tiles.size() << "," << num_threads << "," << clear_free_space << "," <<
+        cloud.points.size() << "," << seconds << "," << cloud.points.size() / seconds << "," <<
+        select(tiled_voxels, true).size() << "," << select(tiled_voxels, false).size() << std::endl;
+      if (tiled_voxels != voxels) {
+        std::cerr << "FAILED: the " << tiles.size() << " tiles with " << run << " are not the whole tree" <<
+          std::endl;
+        failures++;
+      }
+    }
+  }
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,257 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Samples per second of the surfel valid state samplers on a synthetic grid of
+surfels with varying roll and pitch. "legacy" is what OctoCellValidStateSampler
+did before: copy the poses into a cloud, build an octree for every search area
+update, draw with std::discrete_distribution (uniform_int_distribution when
+uniform) and build a KD-tree and a random_device seeded mt19937 in every
+sampleNear through getNearstRPoints. "alias" is SurfelValidStateSampler on a
+shared cloud and KD-tree. Both weightings are run.
+The alias sampler has to draw every surfel of the search area as often as its
+weight says (chi-square test over all of them), find the same search area as a
+brute force radius query, keep sampleNear within the distance and repeat its
+draws for the same seed, otherwise the benchmark exits with 1.
+Usage: surfel_sampler_benchmark [grid_size] [resolution] [draws_per_surfel]
+*/
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "vox_nav_utilities/elevation_state_space.hpp"
+#include "vox_nav_utilities/pcl_helpers.hpp"
+#include "vox_nav_utilities/planner_helpers.hpp"
+#include "vox_nav_utilities/tf_helpers.hpp"
+
+using Weighting = ompl::base::SurfelValidStateSampler::Weighting;
+
+namespace
+{
+  double secondsSince(const std::chrono::steady_clock::time_point & t0)
+  {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+  }
+
+  const double * xyzv(const ompl::base::State * state)
+  {
+    return state->as<ompl::base::ElevationStateSpace::StateType>()->as<
+      ompl::base::RealVectorStateSpace::StateType>(1)->values;
+  }
+
+  geometry_msgs::msg::PoseStamped poseAt(double x, double y)
+  {
+    geometry_msgs::msg::PoseStamped pose;
+    pose.pose.position.x = x;
+    pose.pose.position.y = y;
+    pose.pose.orientation.w = 1.0;
+    return pose;
+  }
+
+  void printRate(
+    const std::string & backend, const std::string & weighting, const std::string & operation,
+    std::size_t calls, double seconds)
+  {
+    std::cout << backend << "," << weighting << "," << operation << "," << calls << "," << calls / seconds <<
+      std::endl;
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  int grid_size = argc > 1 ? std::stoi(argv[1]) : 400;
+  double resolution = argc > 2 ? std::stod(argv[2]) : 0.25;
+  std::size_t draws_per_surfel = argc > 3 ? std::stoul(argv[3]) : 200;
+
+  // A wavy terrain, the roll and pitch of the surfels range over +-0.5 rad
+  auto poses = std::make_shared<geometry_msgs::msg::PoseArray>();
+  for (int i = 0; i < grid_size; i++) {
+    for (int j = 0; j < grid_size; j++) {
+      geometry_msgs::msg::Pose pose;
+      pose.position.x = i * resolution;
+      pose.position.y = j * resolution;
+      pose.position.z = std::sin(i * resolution / 5.0);
+      pose.orientation = vox_nav_utilities::getMsgQuaternionfromRPY(
+        0.5 * std::sin(i * resolution / 3.0), 0.5 * std::cos(j * resolution / 4.0), 0.0);
+      poses->poses.push_back(pose);
+    }
+  }
+  double extent = (grid_size - 1) * resolution;
+  auto start = poseAt(0.3 * extent, 0.4 * extent);
+  auto goal = poseAt(0.7 * extent, 0.6 * extent);
+  const std::size_t num_samples = 1000000;
+  const std::size_t num_legacy_near = 200;
+  const double near_distance = 1.0;
+
+  auto space = std::make_shared<ompl::base::ElevationStateSpace>(
+    ompl::base::ElevationStateSpace::SE2StateType::SE2);
+  auto si = std::make_shared<ompl::base::SpaceInformation>(space);
+  auto * state = si->allocState();
+  auto * near = si->allocState();
+  near->as<ompl::base::ElevationStateSpace::StateType>()->setXYZV(0.5 * extent, 0.5 * extent, 0.0, 0.0);
+
+  std::cout << "backend,weighting,operation,calls,per_s" << std::endl;
+
+  // The shared cloud and KD-tree, made once per map as MapSnapshot does
+  auto t0 = std::chrono::steady_clock::now();
+  pcl::PointCloud<pcl::PointSurfel>::Ptr surfels(new pcl::PointCloud<pcl::PointSurfel>);
+  vox_nav_utilities::fillSurfelsfromMsgPoses(*poses, surfels);
+  auto kdtree = std::make_shared<pcl::KdTreeFLANN<pcl::PointSurfel>>();
+  kdtree->setInputCloud(surfels);
+  printRate("alias", "any", "map_setup", 1, secondsSince(t0));
+
+  int failures = 0;
+  for (auto weighting : {Weighting::UNIFORM, Weighting::TILT_COST}) {
+    std::string weighting_name = weighting == Weighting::UNIFORM ? "uniform" : "tilt_cost";
+
+    // Legacy
+    t0 = std::chrono::steady_clock::now();
+    pcl::PointCloud<pcl::PointSurfel>::Ptr legacy_surfels(new pcl::PointCloud<pcl::PointSurfel>);
+    vox_nav_utilities::fillSurfelsfromMsgPoses(*poses, legacy_surfels);
+    auto legacy_area = vox_nav_utilities::getSubCloudWithinRadius<pcl::PointSurfel>(
+      legacy_surfels, vox_nav_utilities::poseMsg2PCLSurfel(
+        vox_nav_utilities::getLinearInterpolatedPose(goal, start)),
+      vox_nav_utilities::getEuclidianDistBetweenPoses(goal, start));
+    ompl::base::SurfelValidStateSampler weights_of(si.get(), legacy_area, nullptr, weighting);
+    std::vector<double> legacy_weights;
+    for (auto && surfel : legacy_area->points) {
+      legacy_weights.push_back(weights_of.getSurfelWeight(surfel));
+    }
+    std::discrete_distribution<> legacy_distribution(legacy_weights.begin(), legacy_weights.end());
+    std::uniform_int_distribution<> legacy_uniform(0, legacy_area->points.size() - 1);
+    std::mt19937 legacy_rng(std::random_device{}());
+    printRate("legacy", weighting_name, "construct", 1, secondsSince(t0));
+
+    t0 = std::chrono::steady_clock::now();
+    double checksum = 0.0;
+    for (std::size_t i = 0; i < num_samples; i++) {
+      int index = weighting == Weighting::UNIFORM ? legacy_uniform(legacy_rng) : legacy_distribution(legacy_rng);
+      checksum += legacy_area->points[index].x;
+    }
+    printRate("legacy", weighting_name, "sample", num_samples, secondsSince(t0));
+
+    t0 = std::chrono::steady_clock::now();
+    pcl::PointSurfel near_surfel;
+    near_surfel.x = xyzv(near)[0];
+    near_surfel.y = xyzv(near)[1];
+    near_surfel.z = xyzv(near)[2];
+    for (std::size_t i = 0; i < num_legacy_near; i++) {
+      checksum += vox_nav_utilities::getNearstRPoints<pcl::PointSurfel, pcl::PointCloud<pcl::PointSurfel>::Ptr>(
+        near_distance, near_surfel, legacy_area).x;
+    }
+    printRate("legacy", weighting_name, "sample_near", num_legacy_near, secondsSince(t0));
+
+    // Alias table
+    t0 = std::chrono::steady_clock::now();
+    ompl::base::SurfelValidStateSampler sampler(si.get(), surfels, kdtree, weighting);
+    sampler.updateSearchArea(start, goal);
+    printRate("alias", weighting_name, "construct", 1, secondsSince(t0));
+
+    t0 = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < num_samples; i++) {
+      sampler.sample(state);
+      checksum += xyzv(state)[0];
+    }
+    printRate("alias", weighting_name, "sample", num_samples, secondsSince(t0));
+
+    t0 = std::chrono::steady_clock::now();
+    std::size_t far_samples = 0;
+    for (std::size_t i = 0; i < num_samples; i++) {
+      sampler.sampleNear(state, near, near_distance);
+      const double * p = xyzv(state);
+      const double * q = xyzv(near);
+      double d = std::sqrt(
+        (p[0] - q[0]) * (p[0] - q[0]) + (p[1] - q[1]) * (p[1] - q[1]) + (p[2] - q[2]) * (p[2] - q[2]));
+      far_samples += d > near_distance + 1e-6;
+    }
+    printRate("alias", weighting_name, "sample_near", num_samples, secondsSince(t0));
+    if (checksum == 0.0) {
+      std::cerr << "unexpected checksum" << std::endl;
+    }
+    if (far_samples > 0) {
+      std::cerr << "FAILED: " << far_samples << " sampleNear states are farther than " << near_distance << std::endl;
+      failures++;
+    }
+
+    // The search area is the ball having the start and goal on its diameter
+    const auto & area = sampler.getSearchArea();
+    if (area.size() != legacy_area->points.size()) {
+      std::cerr << "FAILED: the search area has " << area.size() << " surfels, a brute force query finds " <<
+        legacy_area->points.size() << std::endl;
+      failures++;
+    }
+
+    // Every surfel of the search area is drawn as often as its weight says
+    std::vector<int> area_position(surfels->points.size(), -1);
+    double weight_sum = 0.0;
+    for (std::size_t k = 0; k < area.size(); k++) {
+      area_position[area[k]] = k;
+      weight_sum += sampler.getSurfelWeight(surfels->points[area[k]]);
+    }
+    std::size_t num_draws = draws_per_surfel * area.size();
+    std::vector<std::size_t> counts(area.size(), 0);
+    std::size_t outside = 0;
+    sampler.setSeed(42);
+    for (std::size_t i = 0; i < num_draws; i++) {
+      sampler.sample(state);
+      int gi = std::lround(xyzv(state)[0] / resolution);
+      int gj = std::lround(xyzv(state)[1] / resolution);
+      int position = area_position[gi * grid_size + gj];
+      if (position < 0) {
+        outside++;
+      } else {
+        counts[position]++;
+      }
+    }
+    double chi_square = 0.0;
+    for (std::size_t k = 0; k < area.size(); k++) {
+      double expected = num_draws * sampler.getSurfelWeight(surfels->points[area[k]]) / weight_sum;
+      chi_square += (counts[k] - expected) * (counts[k] - expected) / expected;
+    }
+    double dof = area.size() - 1.0;
+    std::cout << "alias," << weighting_name << ",chi_square_per_dof," << num_draws << "," << chi_square / dof <<
+      std::endl;
+    if (outside > 0 || chi_square > dof + 6.0 * std::sqrt(2.0 * dof)) {
+      std::cerr << "FAILED: " << weighting_name << " draws do not follow the surfel weights, chi square " <<
+        chi_square << " for " << dof << " degrees of freedom, " << outside << " draws outside the search area" <<
+        std::endl;
+      failures++;
+    }
+
+    // The same seed draws the same surfels
+    std::vector<double> first, second;
+    for (auto * draws : {&first, &second}) {
+      sampler.setSeed(7);
+      for (int i = 0; i < 1000; i++) {
+        sampler.sample(state);
+        draws->push_back(xyzv(state)[0] * extent + xyzv(state)[1]);
+        sampler.sampleNear(state, near, near_distance);
+        draws->push_back(xyzv(state)[0] * extent + xyzv(state)[1]);
+      }
+    }
+    if (first != second) {
+      std::cerr << "FAILED: " << weighting_name << " draws differ for the same seed" << std::endl;
+      failures++;
+    }
+  }
+
+  si->freeState(state);
+  si->freeState(near);
+  return failures ? 1 : 0;
+}
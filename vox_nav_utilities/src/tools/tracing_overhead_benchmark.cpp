@@ -0,0 +1,151 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Cost of a VOX_NAV_TRACE_SCOPE span around a small function the size of a
+state validity check, called from several threads. "no_span" is the
+function alone, which is also what a build with VOX_NAV_TRACING_ENABLED=0
+runs, "span_disabled" has the span with tracing off at runtime and
+"span_enabled" writes every span to a trace file. The trace file must hold
+every span that was not reported as dropped, and the buffers of threads that
+exited must be released, as a thread per goal would otherwise leak one per
+goal, otherwise the benchmark exits with 1.
+Usage: tracing_overhead_benchmark [calls_per_thread] [num_threads] [trace_file]
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vox_nav_utilities/tracing.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+  std::atomic<double> g_sink{0.0};
+
+  // Roughly what checking one state against a few boxes costs
+  double work(int i)
+  {
+    double x = 0.001 * i;
+    double acc = 0.0;
+    for (int k = 0; k < 8; k++) {
+      acc += std::sqrt(x * x + k) * 0.5;
+    }
+    return acc;
+  }
+
+  double workWithSpan(int i)
+  {
+    VOX_NAV_TRACE_SCOPE("isStateValid", "benchmark");
+    return work(i);
+  }
+
+  // Seconds for all threads to finish calls_per_thread calls of f
+  template<typename F>
+  double run(F f, int calls_per_thread, int num_threads)
+  {
+    std::vector<std::thread> threads;
+    auto t0 = Clock::now();
+    for (int t = 0; t < num_threads; t++) {
+      threads.emplace_back(
+        [&f, calls_per_thread]() {
+          double acc = 0.0;
+          for (int i = 0; i < calls_per_thread; i++) {
+            acc += f(i);
+          }
+          g_sink = g_sink + acc;
+        });
+    }
+    for (auto & thread : threads) {
+      thread.join();
+    }
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+
+#if VOX_NAV_TRACING_ENABLED
+  std::size_t countEvents(const std::string & file_path)
+  {
+    std::ifstream file(file_path);
+    std::string line;
+    std::size_t events = 0;
+    while (std::getline(file, line)) {
+      if (line.find("\"ph\":\"X\"") != std::string::npos) {
+        events++;
+      }
+    }
+    return events;
+  }
+#endif
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  int calls_per_thread = argc > 1 ? std::stoi(argv[1]) : 2000000;
+  int num_threads = argc > 2 ? std::stoi(argv[2]) : 4;
+  std::string trace_file = argc > 3 ? argv[3] : "/tmp/vox_nav_tracing_overhead_benchmark.json";
+
+  // The environment switch would otherwise trace the baseline runs too
+  vox_nav_utilities::tracing::stop();
+
+  double total_calls = static_cast<double>(calls_per_thread) * num_threads;
+  double no_span = run(work, calls_per_thread, num_threads);
+  double span_disabled = run(workWithSpan, calls_per_thread, num_threads);
+
+  int failures = 0;
+  if (!vox_nav_utilities::tracing::start(trace_file)) {
+    return 1;
+  }
+  double span_enabled = run(workWithSpan, calls_per_thread, num_threads);
+
+  // Short lived threads, like the one the controller and planner servers start per goal
+  constexpr int kShortLivedThreads = 64;
+  for (int t = 0; t < kShortLivedThreads; t++) {
+    run(workWithSpan, 1, 1);
+  }
+  std::uint64_t dropped = vox_nav_utilities::tracing::droppedEvents();
+  vox_nav_utilities::tracing::stop();
+
+  std::cout << "mode,threads,calls,total_s,ns_per_call,overhead_ns_per_call,dropped" << std::endl;
+  auto print = [&](const char * mode, double seconds, std::uint64_t mode_dropped) {
+      std::cout << mode << "," << num_threads << "," << total_calls << "," << seconds << "," <<
+        seconds * 1e9 * num_threads / total_calls << "," <<
+        (seconds - no_span) * 1e9 * num_threads / total_calls << "," << mode_dropped << std::endl;
+    };
+  print("no_span", no_span, 0);
+  print("span_disabled", span_disabled, 0);
+  print("span_enabled", span_enabled, dropped);
+
+#if VOX_NAV_TRACING_ENABLED
+  if (vox_nav_utilities::tracing::threadBuffers() != 0) {
+    std::cerr << "FAILED: " << vox_nav_utilities::tracing::threadBuffers() <<
+      " buffers of exited threads were not released" << std::endl;
+    failures++;
+  }
+  std::size_t written = countEvents(trace_file);
+  std::size_t expected = static_cast<std::size_t>(total_calls) + kShortLivedThreads;
+  if (written + dropped != expected) {
+    std::cerr << "FAILED: " << written << " spans written and " << dropped << " dropped, expected " <<
+      expected << std::endl;
+    failures++;
+  }
+#endif
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,322 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "vox_nav_utilities/tracing.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace vox_nav_utilities
+{
+  namespace tracing
+  {
+    std::atomic<bool> g_enabled{false};
+
+    namespace
+    {
+      // 16k spans of 32 bytes per thread, drained every flush period
+      constexpr std::size_t kThreadBufferCapacity = 1 << 14;
+
+      void writeEscaped(std::FILE * file, const char * text)
+      {
+        for (const char * c = text; *c; c++) {
+          if (*c == '"' || *c == '\\') {
+            std::fputc('\\', file);
+          }
+          std::fputc(*c, file);
+        }
+      }
+
+      class Tracer
+      {
+      public:
+        static Tracer & instance()
+        {
+          static Tracer tracer;
+          return tracer;
+        }
+
+        ~Tracer()
+        {
+          stop();
+        }
+
+        ThreadTraceBuffer & threadBuffer()
+        {
+          // Registered on the first span of a thread, released after the thread exits
+          thread_local ThreadBufferHolder holder;
+          if (!holder.buffer) {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            holder.tracer = this;
+            holder.buffer = std::make_shared<ThreadTraceBuffer>(++last_tid_, kThreadBufferCapacity);
+            buffers_.push_back(holder.buffer);
+          }
+          return *holder.buffer;
+        }
+
+        bool start(const std::string & file_path, std::chrono::milliseconds flush_period)
+        {
+          stop();
+          std::lock_guard<std::mutex> session_lock(session_mutex_);
+          file_ = std::fopen(file_path.c_str(), "w");
+          if (!file_) {
+            std::cerr << "vox_nav tracing: could not open " << file_path << std::endl;
+            return false;
+          }
+          // Leftovers of a span that ended while the previous trace was stopped
+          drainAll(false);
+          dropped_at_start_ = totalDropped();
+          pid_ = static_cast<int>(::getpid());
+          origin_ns_ = nowNs();
+          first_event_ = true;
+          std::fputs("[\n", file_);
+          flush_period_ = flush_period;
+          stop_flusher_ = false;
+          g_enabled.store(true, std::memory_order_relaxed);
+          flusher_ = std::thread(&Tracer::flushLoop, this);
+          return true;
+        }
+
+        void stop()
+        {
+          std::lock_guard<std::mutex> session_lock(session_mutex_);
+          if (!file_) {
+            return;
+          }
+          g_enabled.store(false, std::memory_order_relaxed);
+          {
+            std::lock_guard<std::mutex> lock(flusher_mutex_);
+            stop_flusher_ = true;
+          }
+          flusher_cv_.notify_all();
+          flusher_.join();
+          drainAll(true);
+          // Chrome also loads unterminated arrays, so a crashed process still leaves a usable trace
+          std::fputs("\n]\n", file_);
+          std::fclose(file_);
+          file_ = nullptr;
+          std::uint64_t dropped = totalDropped() - dropped_at_start_;
+          if (dropped) {
+            std::cerr << "vox_nav tracing: " << dropped <<
+              " spans were dropped, thread buffers were full" << std::endl;
+          }
+        }
+
+        std::uint64_t dropped()
+        {
+          std::lock_guard<std::mutex> session_lock(session_mutex_);
+          return totalDropped() - dropped_at_start_;
+        }
+
+        std::size_t threadBuffers()
+        {
+          std::lock_guard<std::mutex> lock(registry_mutex_);
+          return buffers_.size();
+        }
+
+      private:
+        Tracer() = default;
+
+        // Lets the tracer know when the thread that owns the buffer exits, a thread per goal
+        // would otherwise add a buffer that is never freed
+        struct ThreadBufferHolder
+        {
+          Tracer * tracer{nullptr};
+          std::shared_ptr<ThreadTraceBuffer> buffer;
+
+          ~ThreadBufferHolder()
+          {
+            if (buffer) {
+              tracer->threadExited(buffer);
+            }
+          }
+        };
+
+        void threadExited(const std::shared_ptr<ThreadTraceBuffer> & buffer)
+        {
+          // The next drain writes its last spans and releases it, that is the next flush, stop()
+          // or start(). With tracing off and everything drained, nothing is left to wait for
+          buffer->markExited();
+          std::lock_guard<std::mutex> lock(registry_mutex_);
+          if (!enabled() && buffer->empty()) {
+            release(buffer);
+          }
+        }
+
+        // Called with registry_mutex_ held
+        void release(const std::shared_ptr<ThreadTraceBuffer> & buffer)
+        {
+          auto it = std::find(buffers_.begin(), buffers_.end(), buffer);
+          if (it != buffers_.end()) {
+            released_dropped_ += buffer->dropped();
+            buffers_.erase(it);
+          }
+        }
+
+        void flushLoop()
+        {
+          std::unique_lock<std::mutex> lock(flusher_mutex_);
+          while (!stop_flusher_) {
+            flusher_cv_.wait_for(lock, flush_period_, [this]() {return stop_flusher_;});
+            lock.unlock();
+            drainAll(true);
+            std::fflush(file_);
+            lock.lock();
+          }
+        }
+
+        // Only called by the flusher thread, or with the flusher stopped
+        void drainAll(bool write)
+        {
+          std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers;
+          {
+            std::lock_guard<std::mutex> lock(registry_mutex_);
+            buffers = buffers_;
+          }
+          for (auto & buffer : buffers) {
+            // Read before draining, so the drain sees every span of an exited thread
+            bool exited = buffer->exited();
+            scratch_.clear();
+            buffer->drain(scratch_);
+            if (exited) {
+              std::lock_guard<std::mutex> lock(registry_mutex_);
+              release(buffer);
+            }
+            if (!write) {
+              continue;
+            }
+            for (const auto & event : scratch_) {
+              std::fputs(first_event_ ? "" : ",\n", file_);
+              first_event_ = false;
+              std::fputs("{\"name\":\"", file_);
+              writeEscaped(file_, event.name);
+              std::fputs("\",\"cat\":\"", file_);
+              writeEscaped(file_, event.category);
+              std::fprintf(
+                file_, "\",\"ph\":\"X\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                pid_, buffer->tid(), (event.start_ns - origin_ns_) / 1e3,
+                event.duration_ns / 1e3);
+            }
+          }
+        }
+
+        std::uint64_t totalDropped()
+        {
+          std::lock_guard<std::mutex> lock(registry_mutex_);
+          std::uint64_t dropped = released_dropped_;
+          for (auto & buffer : buffers_) {
+            dropped += buffer->dropped();
+          }
+          return dropped;
+        }
+
+        std::mutex registry_mutex_;
+        std::vector<std::shared_ptr<ThreadTraceBuffer>> buffers_;
+        std::uint32_t last_tid_{0};
+        // Dropped spans of released buffers
+        std::uint64_t released_dropped_{0};
+
+        std::mutex session_mutex_;
+        std::FILE * file_{nullptr};
+        int pid_{0};
+        std::int64_t origin_ns_{0};
+        bool first_event_{true};
+        std::uint64_t dropped_at_start_{0};
+        std::vector<TraceEvent> scratch_;
+
+        std::mutex flusher_mutex_;
+        std::condition_variable flusher_cv_;
+        bool stop_flusher_{false};
+        std::chrono::milliseconds flush_period_{100};
+        std::thread flusher_;
+      };
+
+      // Every process that links the tracing library can be traced without code changes
+      struct StartFromEnvironment
+      {
+        StartFromEnvironment()
+        {
+          const char * prefix = std::getenv("VOX_NAV_TRACE_FILE");
+          if (prefix && *prefix) {
+            start(std::string(prefix) + "." + std::to_string(::getpid()) + ".json");
+          }
+        }
+      };
+      const StartFromEnvironment start_from_environment;
+    }  // namespace
+
+    ThreadTraceBuffer::ThreadTraceBuffer(std::uint32_t tid, std::size_t capacity)
+    : tid_(tid)
+    {
+      std::size_t size = 1;
+      while (size < capacity) {
+        size <<= 1;
+      }
+      mask_ = size - 1;
+      events_.resize(size);
+    }
+
+    std::size_t ThreadTraceBuffer::drain(std::vector<TraceEvent> & out)
+    {
+      std::size_t tail = tail_.load(std::memory_order_relaxed);
+      std::size_t head = head_.load(std::memory_order_acquire);
+      for (std::size_t i = tail; i != head; i++) {
+        out.push_back(events_[i & mask_]);
+      }
+      tail_.store(head, std::memory_order_release);
+      return head - tail;
+    }
+
+    bool start(const std::string & file_path, std::chrono::milliseconds flush_period)
+    {
+      return Tracer::instance().start(file_path, flush_period);
+    }
+
+    void stop()
+    {
+      Tracer::instance().stop();
+    }
+
+    std::uint64_t droppedEvents()
+    {
+      return Tracer::instance().dropped();
+    }
+
+    std::size_t threadBuffers()
+    {
+      return Tracer::instance().threadBuffers();
+    }
+
+    void record(
+      const char * name, const char * category, std::int64_t start_ns,
+      std::int64_t end_ns)
+    {
+      if (!enabled()) {
+        return;
+      }
+      Tracer::instance().threadBuffer().push(TraceEvent{name, category, start_ns, end_ns - start_ns});
+    }
+
+  }  // namespace tracing
+}  // namespace vox_nav_utilities
@@ -0,0 +1,324 @@
+// Copyright (c) 2023 Fetullah Atas, Norwegian University of Life Sciences
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+/*
+Wall time of benchmarking RRTstar and PRMstar on a 2D problem with circular
+obstacles, all runs in one ompl::tools::Benchmark as planner_benchmarking_node
+did ("sequential"), and through the PlannerBenchmarkDriver with one and with
+num_workers worker processes. Then a driver benchmark is killed once about a
+third of its runs are logged, an unfinished entry is left at the end of its
+log, and it is resumed: the runs logged before the kill have to be kept as
+they were, only the missing ones run, every run be logged exactly once. A
+worker that crashes on its first attempt of a run has to be retried, and the
+merged OMPL log and the CSV summary have to hold every run. The runs of a
+planner have to draw other random numbers from OMPL than each other, and
+the same ones with one and with num_workers workers, otherwise the test
+exits with 1.
+Usage: planner_benchmark_driver_test [runs_per_planner] [max_time_s] [num_workers] [work_dir]
+*/
+
+#include <ompl/base/spaces/RealVectorStateSpace.h>
+#include <ompl/geometric/planners/prm/PRMstar.h>
+#include <ompl/geometric/planners/rrt/RRTstar.h>
+#include <ompl/util/Console.h>
+#include <ompl/util/RandomNumbers.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "vox_nav_utilities/planner_benchmark_driver.hpp"
+
+using Clock = std::chrono::steady_clock;
+using vox_nav_utilities::PlannerBenchmarkDriver;
+using vox_nav_utilities::PlannerBenchmarkDriverParams;
+using vox_nav_utilities::PlannerBenchmarkTask;
+
+namespace
+{
+  const std::vector<std::string> kPlanners{"RRTstar", "PRMstar"};
+
+  double secondsSince(const Clock::time_point & t0)
+  {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+  }
+
+  // 10 x 10 m with a grid of circles between the start and the goal
+  std::shared_ptr<ompl::geometric::SimpleSetup> makeSetup()
+  {
+    auto space = std::make_shared<ompl::base::RealVectorStateSpace>(2);
+    space->setBounds(0.0, 10.0);
+    auto ss = std::make_shared<ompl::geometric::SimpleSetup>(space);
+    ss->setStateValidityChecker(
+      [](const ompl::base::State * state) {
+        const auto * values = state->as<ompl::base::RealVectorStateSpace::StateType>()->values;
+        for (double cx = 2.0; cx < 9.0; cx += 2.0) {
+          for (double cy = 2.0; cy < 9.0; cy += 2.0) {
+            if (std::hypot(values[0] - cx, values[1] - cy) < 0.7) {
+              return false;
+            }
+          }
+        }
+        return true;
+      });
+    ompl::base::ScopedState<> start(space), goal(space);
+    start[0] = 0.5;
+    start[1] = 0.5;
+    goal[0] = 9.5;
+    goal[1] = 9.5;
+    ss->setStartAndGoalStates(start, goal);
+    ss->getSpaceInformation()->setStateValidityCheckingResolution(0.01);
+    ss->setup();
+    return ss;
+  }
+
+  ompl::base::PlannerPtr makePlanner(const std::string & name, const ompl::base::SpaceInformationPtr & si)
+  {
+    if (name == "PRMstar") {
+      return std::make_shared<ompl::geometric::PRMstar>(si);
+    }
+    return std::make_shared<ompl::geometric::RRTstar>(si);
+  }
+
+  std::vector<PlannerBenchmarkTask> makeTasks(int runs_per_planner)
+  {
+    std::vector<PlannerBenchmarkTask> tasks;
+    for (const auto & planner : kPlanners) {
+      for (int run = 0; run < runs_per_planner; run++) {
+        tasks.push_back({0, planner, run});
+      }
+    }
+    return tasks;
+  }
+
+  std::string readFile(const std::string & filename)
+  {
+    std::ifstream file(filename, std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+  }
+
+  size_t countRunLines(const std::string & contents)
+  {
+    size_t count = 0;
+    std::istringstream lines(contents);
+    std::string line;
+    while (std::getline(lines, line)) {
+      count += line.rfind("run\t", 0) == 0;
+    }
+    return count;
+  }
+
+  // Runs the tasks with a fresh setup per run, as planner_benchmarking_node does in its workers
+  size_t runDriver(
+    const std::string & results_log, unsigned int num_workers,
+    const std::vector<PlannerBenchmarkTask> & tasks, const ompl::tools::Benchmark::Request & request,
+    const std::string & crash_marker = std::string())
+  {
+    PlannerBenchmarkDriverParams params;
+    params.results_log = results_log;
+    params.num_workers = num_workers;
+    PlannerBenchmarkDriver driver(params);
+    return driver.run(
+      tasks, []() {},
+      [&](const PlannerBenchmarkTask & task) {
+        if (!crash_marker.empty() && task.planner == kPlanners.front() && task.run == 1 &&
+        access(crash_marker.c_str(), F_OK) != 0)
+        {
+          std::ofstream(crash_marker) << "crashed once";
+          raise(SIGKILL);
+        }
+        auto ss = makeSetup();
+        return vox_nav_utilities::runPlannerOnce(
+          *ss, makePlanner(task.planner, ss->getSpaceInformation()), request);
+      });
+  }
+}  // namespace
+
+int main(int argc, char ** argv)
+{
+  int runs_per_planner = argc > 1 ? std::stoi(argv[1]) : 12;
+  double max_time = argc > 2 ? std::stod(argv[2]) : 0.2;
+  unsigned int num_workers = argc > 3 ? std::stoul(argv[3]) : std::max(2u, std::thread::hardware_concurrency());
+  std::string work_dir = argc > 4 ? argv[4] : "/tmp";
+
+  ompl::msg::setLogLevel(ompl::msg::LOG_WARN);
+  const auto tasks = makeTasks(runs_per_planner);
+  ompl::tools::Benchmark::Request request(max_time, 2048.0, runs_per_planner);
+  request.displayProgress = false;
+  const std::string prefix = work_dir + "/planner_benchmark_driver_" + std::to_string(getpid());
+  int failures = 0;
+
+  std::cout << "mode,workers,runs,seconds,runs_per_s" << std::endl;
+  {
+    auto ss = makeSetup();
+    ompl::tools::Benchmark benchmark(*ss, "sequential");
+    for (const auto & planner : kPlanners) {
+      benchmark.addPlanner(makePlanner(planner, ss->getSpaceInformation()));
+    }
+    auto t0 = Clock::now();
+    benchmark.benchmark(request);
+    double seconds = secondsSince(t0);
+    std::cout << "sequential,1," << tasks.size() << "," << seconds << "," << tasks.size() / seconds << std::endl;
+  }
+
+  for (unsigned int workers : {1u, num_workers}) {
+    const std::string log = prefix + "_" + std::to_string(workers) + ".log";
+    auto t0 = Clock::now();
+    size_t unfinished = runDriver(log, workers, tasks, request);
+    double seconds = secondsSince(t0);
+    std::cout << "driver," << workers << "," << tasks.size() << "," << seconds << "," << tasks.size() / seconds <<
+      std::endl;
+    if (unfinished || countRunLines(readFile(log)) != tasks.size()) {
+      std::cerr << "FAILED: " << unfinished << " runs unfinished, " << countRunLines(readFile(log)) <<
+        " logged with " << workers << " workers" << std::endl;
+      failures++;
+    }
+    std::remove(log.c_str());
+  }
+
+  // Kill a benchmark once about a third of its runs are logged
+  const std::string log = prefix + "_resumed.log";
+  pid_t pid = fork();
+  if (pid == 0) {
+    runDriver(log, num_workers, tasks, request);
+    _exit(0);
+  }
+  while (countRunLines(readFile(log)) < tasks.size() / 3 && waitpid(pid, nullptr, WNOHANG) == 0) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+  // The workers are killed with the driver, give them the time to go
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  const std::string before_kill = readFile(log);
+  const size_t finished_before_kill = countRunLines(before_kill);
+  std::ofstream(log, std::ios::app) << "run\t0\t" << kPlanners.front() << "\t";
+
+  auto t0 = Clock::now();
+  size_t unfinished = runDriver(log, num_workers, tasks, request);
+  double seconds = secondsSince(t0);
+  const std::string after_resume = readFile(log);
+  const size_t resumed_runs = countRunLines(after_resume) - finished_before_kill;
+  std::cout << "resumed," << num_workers << "," << resumed_runs << "," << seconds << "," <<
+    resumed_runs / seconds << std::endl;
+  if (finished_before_kill == 0 || finished_before_kill >= tasks.size()) {
+    std::cerr << "FAILED: " << finished_before_kill << " of " << tasks.size() <<
+      " runs were logged when the benchmark was killed" << std::endl;
+    failures++;
+  }
+  if (after_resume.compare(0, before_kill.size(), before_kill) != 0) {
+    std::cerr << "FAILED: the runs logged before the kill were not kept as they were" << std::endl;
+    failures++;
+  }
+  if (unfinished || countRunLines(after_resume) != tasks.size()) {
+    std::cerr << "FAILED: " << unfinished << " runs unfinished, " << countRunLines(after_resume) << " of " <<
+      tasks.size() << " logged after resuming" << std::endl;
+    failures++;
+  }
+
+  // Every run of a planner and the summary rows for the epoch and for all epochs
+  PlannerBenchmarkDriverParams params;
+  params.results_log = log;
+  PlannerBenchmarkDriver resumed(params);
+  auto ss = makeSetup();
+  std::vector<std::pair<std::string, ompl::base::PlannerPtr>> planners;
+  for (const auto & planner : kPlanners) {
+    planners.emplace_back(planner, makePlanner(planner, ss->getSpaceInformation()));
+  }
+  const std::string merged = prefix + "_merged.log";
+  const std::string summary = prefix + "_summary.csv";
+  bool saved = vox_nav_utilities::saveMergedResults(*ss, planners, resumed.runs(), request, "resumed", merged) &&
+    vox_nav_utilities::saveCsvSummary(resumed.runs(), summary);
+  const std::string runs_line = std::to_string(runs_per_planner) + " runs";
+  size_t planners_with_all_runs = 0;
+  std::istringstream merged_lines(readFile(merged));
+  for (std::string line; std::getline(merged_lines, line); ) {
+    planners_with_all_runs += line == runs_line;
+  }
+  std::istringstream summary_lines(readFile(summary));
+  size_t summary_rows = 0;
+  for (std::string line; std::getline(summary_lines, line); ) {
+    summary_rows++;
+  }
+  if (!saved || planners_with_all_runs != kPlanners.size() || summary_rows != 1 + 2 * kPlanners.size()) {
+    std::cerr << "FAILED: the merged log has " << planners_with_all_runs << " planners with " << runs_line <<
+      ", the summary " << summary_rows << " lines" << std::endl;
+    failures++;
+  }
+  std::remove(log.c_str());
+  std::remove(merged.c_str());
+  std::remove(summary.c_str());
+
+  // A worker crashing on a run loses the rest of its share, a second pass has to finish them
+  const std::string crash_log = prefix + "_crash.log";
+  const std::string crash_marker = prefix + "_crash.marker";
+  unfinished = runDriver(crash_log, num_workers, tasks, request, crash_marker);
+  if (unfinished || countRunLines(readFile(crash_log)) != tasks.size()) {
+    std::cerr << "FAILED: " << unfinished << " runs unfinished after a worker crashed" << std::endl;
+    failures++;
+  }
+  std::remove(crash_log.c_str());
+  std::remove(crash_marker.c_str());
+
+  // The workers are forked from this process, which has used OMPL's RNGs by now
+  std::map<std::pair<std::string, int>, std::string> draws_per_workers[2];
+  const unsigned int draw_workers[2] = {1u, num_workers};
+  for (int i = 0; i < 2; i++) {
+    const std::string draw_log = prefix + "_draws.log";
+    PlannerBenchmarkDriverParams draw_params;
+    draw_params.results_log = draw_log;
+    draw_params.num_workers = draw_workers[i];
+    PlannerBenchmarkDriver driver(draw_params);
+    driver.run(
+      tasks, []() {},
+      [](const PlannerBenchmarkTask &) {
+        ompl::RNG rng;
+        ompl::tools::Benchmark::RunProperties properties;
+        properties["draw INTEGER"] = std::to_string(rng.uniformInt(0, std::numeric_limits<int>::max()));
+        return properties;
+      });
+    for (const auto & record : driver.runs()) {
+      draws_per_workers[i][{record.task.planner, record.task.run}] = record.properties.at("draw INTEGER");
+    }
+    std::remove(draw_log.c_str());
+  }
+  std::set<std::string> distinct_draws;
+  for (const auto & draw : draws_per_workers[1]) {
+    distinct_draws.insert(draw.second);
+  }
+  if (distinct_draws.size() != tasks.size()) {
+    std::cerr << "FAILED: " << tasks.size() << " runs with " << num_workers << " workers drew " <<
+      distinct_draws.size() << " different numbers" << std::endl;
+    failures++;
+  }
+  if (draws_per_workers[0] != draws_per_workers[1]) {
+    std::cerr << "FAILED: the runs drew other numbers with 1 and with " << num_workers << " workers" << std::endl;
+    failures++;
+  }
+  return failures ? 1 : 0;
+}